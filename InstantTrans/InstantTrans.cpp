@@ -2,6 +2,51 @@
 //
 
 #include "MainThread.h"
+#include "core/batch/BatchTranscriber.h"
+#include "core/sim/Simulation.h"
+#include "core/sim/Soak.h"
+#include "core/sim/TranslateBench.h"
+#include "core/sim/GatewayBench.h"
+#include "core/sim/IdleBench.h"
+#include "core/sim/FlowBench.h"
+#include "core/sim/FormatCheck.h"
+#include "core/sim/IngestCheck.h"
+#include "core/sim/ModelBench.h"
+#include "core/sim/VadBench.h"
+
+#include <shellapi.h>
+#pragma comment(lib, "shell32.lib")
+
+// 命令行模式：argv[1] 为模式名，入口返回进程退出码
+struct CommandLineMode {
+    const wchar_t* name;
+    int (*run)(int argc, wchar_t** argv);
+};
+
+static const CommandLineMode kCommandLineModes[] = {
+    // 批处理：转写一个 wav 文件后退出
+    { L"--batch", RunBatchCommandLine },
+    // 虚拟时钟仿真：检查延迟预算与字幕滚动行为
+    { L"--simulate", RunSimulationCommandLine },
+    // 音频接入层自检：成簇、带抖动的合成音源，检查分块、缺口计数与空闲 CPU
+    { L"--ingest-check", RunIngestCheckCommandLine },
+    // 显示流控争用基准：多个生产者并发发布，检查生产者不等待渲染
+    { L"--flow-bench", RunFlowBenchCommandLine },
+    // 格式变化自检：把录音编码成几种格式的 wav 依次回放，检查识别跨格式变化不中断
+    { L"--format-check", RunFormatCheckCommandLine },
+    // 长时间运行测试：循环回放录音，检查内存、句柄与延迟漂移
+    { L"--soak", RunSoakCommandLine },
+    // 多路 VAD 基准：比较每路独立推理与共享拼批推理的 CPU，并检查判决一致
+    { L"--vad-bench", RunVadBenchCommandLine },
+    // 空闲回收基准：比较模型常驻与空闲卸载两种策略的空闲内存与恢复耗时
+    { L"--idle-bench", RunIdleBenchCommandLine },
+    // 模型精度基准：比较 fp32 与 int8 的加载耗时、内存、解码实时率与转写差异
+    { L"--model-bench", RunModelBenchCommandLine },
+    // 多实例网关自检：对几个限流桩检查路由、故障转移与请求不丢
+    { L"--gateway-bench", RunGatewayBenchCommandLine },
+    // 翻译后端基准：比较本地模型与网关的翻译延迟
+    { L"--translate-bench", RunTranslateBenchCommandLine },
+};
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     _In_opt_ HINSTANCE hPrevInstance,
@@ -11,6 +56,19 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     UNREFERENCED_PARAMETER(hPrevInstance);
     UNREFERENCED_PARAMETER(lpCmdLine);
 
+    // 命令行模式：不创建窗口，跑完直接退出
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv && argc > 1) {
+        for (const CommandLineMode& mode : kCommandLineModes) {
+            if (wcscmp(argv[1], mode.name) != 0) continue;
+            int code = mode.run(argc, argv);
+            LocalFree(argv);
+            return code;
+        }
+    }
+    if (argv) LocalFree(argv);
+
     //创建主线程
     MainThread thread;
 
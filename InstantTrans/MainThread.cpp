@@ -1,6 +1,8 @@
 #include "MainThread.h"
 #include "ui/MainForm.h"
 #include "Resource.h"
+#include "core/metrics/Log.h"
+#include "core/recoginize/ModelFiles.h"
 WorkerThread::WorkerThread()
     : FrameworkThread(_T("WorkerThread"), ui::kThreadWorker)
 {
@@ -29,11 +31,15 @@ MainThread::~MainThread()
 
 void MainThread::OnInit()
 {
-    //߳
+    Log::InitFromEnvironment();
+    m_metricsExporter.reset(new metrics::FileExporter(GetExeDirectory() + L"\\metrics.prom", 5000));
+    m_metricsExporter->Start();
+
+    //启动工作线程
     m_workerThread.reset(new WorkerThread);
     m_workerThread->Start();
 
-    //ʼȫԴ, ʹñļΪԴ
+    //初始化全局资源, 使用本地文件夹作为资源
     //ui::FilePath resourcePath = ui::FilePathUtil::GetCurrentModuleDirectory();
     //resourcePath += _T("resources\\");
     //ui::GlobalManager::Instance().Startup(ui::LocalFilesResParam(resourcePath));
@@ -44,9 +50,9 @@ void MainThread::OnInit()
     ui::GlobalManager::Instance().Startup(resParam);
     m_bus = std::make_shared<MessageBus>();
 
-    //ڴ
+    //在下面加入启动窗口代码
     //
-    //һĬϴӰľд
+    //创建一个默认带有阴影的居中窗口
     MainForm* window = new MainForm(m_bus.get());
     window->CreateWnd(nullptr, ui::WindowCreateParam(_T("MyDuilibApp"), true));
     window->PostQuitMsgWhenClosed(true);
@@ -60,4 +66,9 @@ void MainThread::OnCleanup()
         m_workerThread.reset(nullptr);
     }
     ui::GlobalManager::Instance().Shutdown();
+
+    if (m_metricsExporter != nullptr) {
+        m_metricsExporter->Stop();
+        m_metricsExporter.reset(nullptr);
+    }
 }
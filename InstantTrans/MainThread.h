@@ -5,7 +5,8 @@
 #include "duilib/duilib.h"
 
 #include "core/ipc/MessageBus.h"
-/** ߳
+#include "core/metrics/Metrics.h"
+/** 工作线程
 */
 class WorkerThread : public ui::FrameworkThread
 {
@@ -14,16 +15,16 @@ public:
     virtual ~WorkerThread() override;
 
 private:
-    /** ǰʼڽϢѭǰ
+    /** 运行前初始化，在进入消息循环前调用
     */
     virtual void OnInit() override;
 
-    /** ˳ʱ˳Ϣѭ
+    /** 退出时清理，在退出消息循环后调用
     */
     virtual void OnCleanup() override;
 };
 
-/** ߳
+/** 主线程
 */
 class MainThread : public ui::FrameworkThread
 {
@@ -32,20 +33,24 @@ public:
     virtual ~MainThread() override;
 
 private:
-    /** ǰʼڽϢѭǰ
+    /** 运行前初始化，在进入消息循环前调用
     */
     virtual void OnInit() override;
 
-    /** ˳ʱ˳Ϣѭ
+    /** 退出时清理，在退出消息循环后调用
     */
     virtual void OnCleanup() override;
 
 private:
-    /** ߳(Ҫ̴߳ҵ񣬿Ƴ̵߳Ĵ)
+    /** 工作线程(如果不需要多线程处理业务，可以移除工作线程的代码)
     */
     std::unique_ptr<WorkerThread> m_workerThread;
 
     std::shared_ptr<MessageBus> m_bus;
+
+    /** 定期导出 Prometheus 文本格式的指标文件
+    */
+    std::unique_ptr<metrics::FileExporter> m_metricsExporter;
 };
 
 #endif // EXAMPLES_MAIN_THREAD_H_
@@ -1,90 +1,226 @@
 #pragma once
 #include "types/types.h"
+#include "core/sim/Clock.h"
 #include <string>
 #include <mutex>
 #include <functional>
 #include <chrono>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// 显示文本：写入后不再修改，槽位与各版本快照之间按指针共享
+using DisplayText = std::shared_ptr<const std::string>;
 
 struct DisplaySlot {
-    std::string recog;
-    std::string trans;
+    DisplayText recog_text;
+    DisplayText trans_text;
     bool trans_ready = false;
     std::chrono::steady_clock::time_point last_update;
+
+    const std::string& Recog() const { return recog_text ? *recog_text : EmptyText(); }
+    const std::string& Trans() const { return trans_text ? *trans_text : EmptyText(); }
+
+    void Clear() {
+        recog_text.reset();
+        trans_text.reset();
+        trans_ready = false;
+    }
+
+private:
+    static const std::string& EmptyText() {
+        static const std::string empty;
+        return empty;
+    }
+};
+
+// 不可变的显示快照，发布后不再修改，读取方无需加锁；拷贝快照只增加文本的引用计数
+struct DisplaySnapshot {
+    DisplaySlot active;
+    DisplaySlot next;
+    uint64_t version = 0;
 };
 
 class FlowController {
 public:
-    // صʾҪ UI ʱã UI ̵߳ã
+    // 回调：当有显示需要 UI 更新时调用（会在 UI 线程调用）
+    // 回调在锁外执行，参数总是调用时刻最新发布的快照
     using UpdateCallback = std::function<void(const DisplaySlot&, const DisplaySlot&)>;
 
-    FlowController() {
-        slots_[0].last_update = slots_[1].last_update = std::chrono::steady_clock::now();
+    // active 超过此时长未更新时，next 有内容即可滚上来
+    static constexpr std::chrono::seconds kDisplayTimeout{ 10 };
+
+    explicit FlowController(Clock* clock = &Clock::System()) : clock_(clock) {
+        for (DisplaySlot& slot : slots_) slot.last_update = clock_->Now();
+        snapshot_pool_.reserve(kMaxPooledSnapshots);
+        text_pool_.reserve(kMaxPooledTexts);
+        std::atomic_store(&snapshot_, std::make_shared<const DisplaySnapshot>());
     }
 
-    // յмʶ£ǲϱ仯
+    // 收到中间识别更新（可能是不断变化）
     void OnRecognitionFragment(const std::string& text) {
-        std::lock_guard<std::mutex> lk(mutex_);
-        // ǰڶԤactive_index_ Ϊһ飨Ϸ
-        slots_[next_index_].recog = text;
-        slots_[next_index_].last_update = std::chrono::steady_clock::now();
-        // ֪ UI ˢ£շ룩
-        if (cb_) cb_(slots_[active_index_], slots_[next_index_]);
+        // 文本在锁外拷进缓冲，锁内只交换指针；被替换的旧文本随 recog 在锁外释放
+        DisplayText recog = MakeText(text);
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            // 新句子的片段不能覆盖 next 里已翻译完的上一句
+            PromoteTranslatedNext();
+            // 当前第二槽用于预备，active_index_ 为第一组（上方）
+            slots_[next_index_].recog_text.swap(recog);
+            slots_[next_index_].last_update = clock_->Now();
+            PublishLocked();
+        }
+        // 告知 UI 刷新（非最终翻译）
+        NotifyUpdate();
     }
 
-    // յӦĳʶı
+    // 收到翻译结果（对应某个完整识别文本）
     void OnTranslationReady(const std::string& recog, const std::string& trans) {
-        std::lock_guard<std::mutex> lk(mutex_);
-        //  next_index_ڶ飩
-        slots_[next_index_].recog = recog;
-        slots_[next_index_].trans = trans;
-        slots_[next_index_].trans_ready = true;
-        slots_[next_index_].last_update = std::chrono::steady_clock::now();
-
-        //  active slot ûзѳʱ򴥷 next -> active
-        MaybeAdvance();
-        if (cb_) cb_(slots_[active_index_], slots_[next_index_]);
+        DisplayText recog_text = MakeText(recog);
+        DisplayText trans_text = MakeText(trans);
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            PromoteTranslatedNext();
+            // 将翻译放入 next_index_（第二组）
+            slots_[next_index_].recog_text.swap(recog_text);
+            slots_[next_index_].trans_text.swap(trans_text);
+            slots_[next_index_].trans_ready = true;
+            slots_[next_index_].last_update = clock_->Now();
+
+            // 如果 active slot 没有翻译或已超时，则触发滚动（将 next -> active）
+            MaybeAdvance();
+            PublishLocked();
+        }
+        NotifyUpdate();
     }
 
 
     void SetUpdateCallback(UpdateCallback cb) { cb_ = std::move(cb); }
 
-    // ⲿҲʱ⣨һʱÿһΣ
+    // 外部也可以主动触发超时检测（例如一个定时器，每秒调用一次）
     void Tick() {
-        std::lock_guard<std::mutex> lk(mutex_);
-        //  active ķɻʱ next з advance
-        MaybeAdvance();
-        if (cb_) cb_(slots_[active_index_], slots_[next_index_]);
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            // 如果 active 的翻译完成或超时，且 next 有翻译就 advance
+            MaybeAdvance();
+            PublishLocked();
+        }
+        NotifyUpdate();
     }
 
-    // ȡǰʾUI ã
+    // 取最新发布的快照（UI 用），不加锁，不拷贝字符串
+    std::shared_ptr<const DisplaySnapshot> Snapshot() const {
+        return std::atomic_load(&snapshot_);
+    }
+
+    // 取当前显示（UI 用），只拷贝文本指针
     void GetSlots(DisplaySlot& outActive, DisplaySlot& outNext) {
-        std::lock_guard<std::mutex> lk(mutex_);
-        outActive = slots_[active_index_];
-        outNext = slots_[next_index_];
+        auto snap = Snapshot();
+        outActive = snap->active;
+        outNext = snap->next;
     }
 
 private:
     void MaybeAdvance() {
-        auto now = std::chrono::steady_clock::now();
-        const auto TIMEOUT = std::chrono::seconds(10); // ãʾʱ
-        // active ɷ OR active ʱ ( last_update)
+        auto now = clock_->Now();
+        // 条件：active 已完成翻译 OR active 超时 (基于 last_update)
         bool active_done = slots_[active_index_].trans_ready;
-        bool active_timeout = (now - slots_[active_index_].last_update) > TIMEOUT;
-
-        if ((active_done || active_timeout) && (slots_[next_index_].trans_ready || !slots_[next_index_].recog.empty())) {
-            //  next Ϲ
-            active_index_ = next_index_;
-            next_index_ = 1 - active_index_;
-            // µ next
-            slots_[next_index_] = DisplaySlot();
-            slots_[next_index_].last_update = std::chrono::steady_clock::now();
+        bool active_timeout = (now - slots_[active_index_].last_update) > kDisplayTimeout;
+
+        if ((active_done || active_timeout) && (slots_[next_index_].trans_ready || !slots_[next_index_].Recog().empty())) {
+            Advance(now);
         }
     }
 
+    // next 已有译文时先滚上去，否则它会在滚到 active 之前被新内容覆盖
+    void PromoteTranslatedNext() {
+        if (slots_[next_index_].trans_ready) Advance(clock_->Now());
+    }
+
+    void Advance(std::chrono::steady_clock::time_point now) {
+        // 把 next 向上滚
+        active_index_ = next_index_;
+        next_index_ = 1 - active_index_;
+        // 清空新的 next
+        slots_[next_index_].Clear();
+        slots_[next_index_].last_update = now;
+    }
+
+    // 取一个只有池本身还持有的文本缓冲写入 text，赋值复用原有容量；都被槽位、快照或读取方
+    // 持有时新建，池未满就加入池中。只在查找时短暂持有 text_mutex_，拷贝在锁外
+    DisplayText MakeText(const std::string& text) {
+        std::shared_ptr<std::string> buffer;
+        {
+            std::lock_guard<std::mutex> lk(text_mutex_);
+            for (auto& pooled : text_pool_) {
+                if (pooled.use_count() == 1) {
+                    buffer = pooled;
+                    break;
+                }
+            }
+        }
+        if (buffer) {
+            // 与最后一个读取方释放引用时的递减配对
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        else {
+            buffer = std::make_shared<std::string>();
+            buffer->reserve(kTextReserve);
+            std::lock_guard<std::mutex> lk(text_mutex_);
+            if (text_pool_.size() < kMaxPooledTexts) text_pool_.push_back(buffer);
+        }
+        buffer->assign(text);
+        return buffer;
+    }
+
+    // 在写锁内生成新版本快照并原子替换，快照只持有文本指针，锁内不拷贝字符串。
+    // 快照对象循环使用：只有池本身还持有的快照已没有读取方，可以就地改写；读取方都还持有时才新建
+    void PublishLocked() {
+        std::shared_ptr<DisplaySnapshot> snap;
+        for (auto& pooled : snapshot_pool_) {
+            if (pooled.use_count() == 1) {
+                snap = pooled;
+                break;
+            }
+        }
+        if (snap) {
+            // 与读取方释放引用时的递减配对，确保它们对旧内容的读取已经结束
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        else {
+            snap = std::make_shared<DisplaySnapshot>();
+            if (snapshot_pool_.size() < kMaxPooledSnapshots) snapshot_pool_.push_back(snap);
+        }
+        snap->active = slots_[active_index_];
+        snap->next = slots_[next_index_];
+        snap->version = ++version_;
+        std::atomic_store(&snapshot_, std::shared_ptr<const DisplaySnapshot>(std::move(snap)));
+    }
+
+    // 锁外通知渲染方；多个生产者并发时，渲染的总是最新版本
+    void NotifyUpdate() {
+        if (!cb_) return;
+        auto snap = Snapshot();
+        cb_(snap->active, snap->next);
+    }
+
+    // 预留的单行文本容量（UTF-8 字节），覆盖绝大多数识别片段与译文
+    static constexpr size_t kTextReserve = 512;
+    // 同时被读取方持有的快照很少超过两三个
+    static constexpr size_t kMaxPooledSnapshots = 4;
+    // 槽位的 4 段文本、池中各快照引用的文本与生产者手里在途的文本
+    static constexpr size_t kMaxPooledTexts = 32;
+
+    Clock* clock_;
     DisplaySlot slots_[2];
     int active_index_ = 0; // currently displayed (top slot)
     int next_index_ = 1;   // upcoming slot (bottom)
-    std::mutex mutex_;
+    uint64_t version_ = 0;
+    std::mutex mutex_;      // 只串行化生产者之间的状态修改，不覆盖渲染
+    std::shared_ptr<const DisplaySnapshot> snapshot_;
+    std::vector<std::shared_ptr<DisplaySnapshot>> snapshot_pool_;   // 只在写锁内访问
+    std::mutex text_mutex_;
+    std::vector<std::shared_ptr<std::string>> text_pool_;           // 只在 text_mutex_ 内访问
     UpdateCallback cb_;
 };
-
@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+
+// 长语音切分后的拼句：切块只保证不切断单词，不保证落在句子边界上
+// 块内最后一个句末标点之前的部分立即送翻译，其后的半句留到与下一块拼接；
+// 语音段最后一块（continues == false）总是整体送出
+class SentenceStitcher {
+public:
+    // 返回本次应送翻译的文本，为空表示全部暂存
+    std::string Push(const std::string& text, bool continues) {
+        std::string merged = held_;
+        Join(&merged, continues ? StripTrailingTerminator(text) : text);
+        held_.clear();
+
+        if (!continues) return merged;
+
+        // 块尾的标点是模型按整句补上的，不可信；只认块内部的句末标点
+        size_t boundary = LastTerminatorEnd(merged);
+        if (boundary == std::string::npos) {
+            held_ = std::move(merged);
+            return std::string();
+        }
+        held_ = merged.substr(boundary);
+        size_t first = held_.find_first_not_of(' ');
+        held_ = first == std::string::npos ? std::string() : held_.substr(first);
+        return merged.substr(0, boundary);
+    }
+
+    // 音源停止等场合丢弃半句
+    void Reset() { held_.clear(); }
+
+    bool HasPending() const { return !held_.empty(); }
+
+private:
+    // UTF-8 句末标点：ASCII . ? ! 以及全角 。？！
+    static size_t TerminatorLength(const std::string& s, size_t pos) {
+        char c = s[pos];
+        if (c == '.' || c == '?' || c == '!') return 1;
+        static const char* kWide[] = { "\xE3\x80\x82", "\xEF\xBC\x9F", "\xEF\xBC\x81" };
+        for (const char* w : kWide) {
+            if (s.compare(pos, 3, w) == 0) return 3;
+        }
+        return 0;
+    }
+
+    static size_t LastTerminatorEnd(const std::string& s) {
+        for (size_t i = s.size(); i-- > 0;) {
+            size_t n = TerminatorLength(s, i);
+            if (n > 0 && i + n <= s.size()) return i + n;
+        }
+        return std::string::npos;
+    }
+
+    static std::string StripTrailingTerminator(const std::string& s) {
+        std::string out = s;
+        while (!out.empty() && out.back() == ' ') out.pop_back();
+        if (out.size() >= 3 && TerminatorLength(out, out.size() - 3) == 3) out.resize(out.size() - 3);
+        else if (!out.empty() && TerminatorLength(out, out.size() - 1) == 1) out.pop_back();
+        return out;
+    }
+
+    // 两侧都是 ASCII 字母数字时补一个空格，中日文直接拼接
+    static void Join(std::string* out, const std::string& next) {
+        if (next.empty()) return;
+        if (!out->empty()) {
+            unsigned char a = static_cast<unsigned char>(out->back());
+            unsigned char b = static_cast<unsigned char>(next.front());
+            if (a < 0x80 && b < 0x80 && a != ' ' && b != ' ') out->push_back(' ');
+        }
+        out->append(next);
+    }
+
+    std::string held_;
+};
@@ -0,0 +1,77 @@
+#include "TranscriptStore.h"
+
+#include <algorithm>
+#include <cstring>
+
+TranscriptStore::TranscriptStore(const Options& options) : options_(options)
+{
+    if (!options_.spill_path.empty()) {
+        _wfopen_s(&spill_file_, options_.spill_path.c_str(), L"ab");
+    }
+}
+
+TranscriptStore::~TranscriptStore()
+{
+    if (spill_file_) fclose(spill_file_);
+}
+
+uint64_t TranscriptStore::Append(std::string_view recog, std::string_view trans, int64_t timestamp_ms)
+{
+    // 识别与翻译连续存放，一条记录不会跨块
+    char* p = Allocate(recog.size() + trans.size());
+    std::memcpy(p, recog.data(), recog.size());
+    std::memcpy(p + recog.size(), trans.data(), trans.size());
+    ++blocks_.back().entries;
+
+    entries_.push_back({ timestamp_ms, p,
+        static_cast<uint32_t>(recog.size()), static_cast<uint32_t>(trans.size()) });
+
+    while (blocks_.size() > 1 && BytesInMemory() > options_.max_bytes) {
+        SpillOldestBlock();
+    }
+    return TotalCount() - 1;
+}
+
+TranscriptEntryView TranscriptStore::At(size_t pos) const
+{
+    const Entry& e = entries_[pos];
+    TranscriptEntryView view;
+    view.timestamp_ms = e.timestamp_ms;
+    view.recog = std::string_view(e.recog, e.recog_len);
+    view.trans = std::string_view(e.recog + e.recog_len, e.trans_len);
+    return view;
+}
+
+char* TranscriptStore::Allocate(size_t bytes)
+{
+    if (blocks_.empty() || blocks_.back().capacity - blocks_.back().used < bytes) {
+        Block block;
+        // 超长记录单独占一个块
+        block.capacity = std::max(options_.block_bytes, bytes);
+        block.data.reset(new char[block.capacity]);
+        arena_bytes_ += block.capacity;
+        blocks_.push_back(std::move(block));
+    }
+    Block& b = blocks_.back();
+    char* p = b.data.get() + b.used;
+    b.used += bytes;
+    return p;
+}
+
+void TranscriptStore::SpillOldestBlock()
+{
+    Block& oldest = blocks_.front();
+    for (size_t i = 0; i < oldest.entries; ++i) {
+        if (spill_file_) {
+            TranscriptEntryView v = At(0);
+            fprintf(spill_file_, "%lld\t%.*s\t%.*s\n", static_cast<long long>(v.timestamp_ms),
+                static_cast<int>(v.recog.size()), v.recog.data(),
+                static_cast<int>(v.trans.size()), v.trans.data());
+        }
+        entries_.pop_front();
+        ++first_index_;
+    }
+    if (spill_file_) fflush(spill_file_);
+    arena_bytes_ -= oldest.capacity;
+    blocks_.pop_front();
+}
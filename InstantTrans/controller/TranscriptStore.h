@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 历史记录中的一条：识别文本 + 翻译文本，字符串指向 arena 内部
+struct TranscriptEntryView {
+    int64_t timestamp_ms = 0;
+    std::string_view recog;
+    std::string_view trans;
+};
+
+// 只追加的转写历史
+// 文本按块存放在 arena 中，总字节数超过上限时把最旧的块写入磁盘并释放，内存占用有上界
+// 非线程安全，只在 UI 线程使用；返回的 string_view 在下一次 Append 前有效
+class TranscriptStore {
+public:
+    struct Options {
+        size_t block_bytes = 64 * 1024;        // 每个 arena 块的大小
+        size_t max_bytes = 4 * 1024 * 1024;    // 内存中保留的文本上限
+        std::wstring spill_path;               // 溢出文件，为空则直接丢弃最旧的块
+    };
+
+    explicit TranscriptStore(const Options& options);
+    ~TranscriptStore();
+
+    TranscriptStore(const TranscriptStore&) = delete;
+    TranscriptStore& operator=(const TranscriptStore&) = delete;
+
+    // 追加一条记录，返回全局序号
+    uint64_t Append(std::string_view recog, std::string_view trans, int64_t timestamp_ms);
+
+    // 内存中第一条记录的全局序号，更早的已溢出到磁盘
+    uint64_t FirstIndex() const { return first_index_; }
+    // 内存中的记录数
+    size_t Size() const { return entries_.size(); }
+    // 全部记录数（含已溢出）
+    uint64_t TotalCount() const { return first_index_ + entries_.size(); }
+
+    // 按内存中的位置取记录（0 为最旧）
+    TranscriptEntryView At(size_t pos) const;
+
+    size_t BytesInMemory() const { return arena_bytes_; }
+    uint64_t SpilledCount() const { return first_index_; }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t capacity = 0;
+        size_t used = 0;
+        size_t entries = 0;   // 起始于该块的记录数
+    };
+
+    struct Entry {
+        int64_t timestamp_ms;
+        const char* recog;
+        uint32_t recog_len;
+        uint32_t trans_len;   // 翻译紧跟在识别文本之后
+    };
+
+    char* Allocate(size_t bytes);
+    void SpillOldestBlock();
+
+    Options options_;
+    std::deque<Block> blocks_;
+    std::deque<Entry> entries_;
+    uint64_t first_index_ = 0;
+    size_t arena_bytes_ = 0;
+    FILE* spill_file_ = nullptr;
+};
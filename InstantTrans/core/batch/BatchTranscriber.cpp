@@ -0,0 +1,382 @@
+#define NOMINMAX
+#include "BatchTranscriber.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "core/metrics/Log.h"
+#include "core/metrics/Metrics.h"
+#include "core/recoginize/FormatConverter.h"
+#include "core/recoginize/ModelFiles.h"
+#include "core/recoginize/ThreadTuning.h"
+#include "core/sim/CommandLine.h"
+
+static const int32_t kSampleRate = 16000;
+static const int32_t kVadWindow = 512;
+// 每路 VAD 至少分到的音频，太短时拼批的收益抵不过边界处的重复
+static const int64_t kMinRegionSamples = 60LL * kSampleRate;
+// 边界处裁掉重叠部分后短于最短语音的段丢弃
+static const int64_t kMinTrimmedSamples = kSampleRate / 4;
+
+BatchTranscriber::BatchTranscriber(const BatchOptions& options) : options_(options)
+{
+    if (options_.workers <= 0) options_.workers = ThreadTuning::GetLogicalCoreCount();
+    options_.batch_size = std::max(1, options_.batch_size);
+    options_.vad_streams = std::max(1, options_.vad_streams);
+    // 队列上限：保证解码线程不断粮，同时不把整个文件的语音段都堆在内存里
+    max_queued_ = static_cast<size_t>(options_.workers * options_.batch_size * 4);
+}
+
+BatchTranscriber::~BatchTranscriber()
+{
+}
+
+bool BatchTranscriber::LoadAudio(std::vector<float>* samples)
+{
+    sherpa_onnx::cxx::Wave wave = sherpa_onnx::cxx::ReadWave(WStringToUtf8(options_.input));
+    if (wave.samples.empty()) {
+        LOG_ERROR("Batch", "failed to read %s", WStringToUtf8(options_.input).c_str());
+        return false;
+    }
+    if (wave.sample_rate == kSampleRate) {
+        *samples = std::move(wave.samples);
+        return true;
+    }
+
+    // ReadWave 已混成单声道 float，只需重采样
+    FormatConverter converter(kSampleRate);
+    AudioFormat format;
+    format.sample_rate = wave.sample_rate;
+    format.channels = 1;
+    format.type = SampleType::kFloat32;
+    converter.Reset(format);
+    converter.Process(reinterpret_cast<const uint8_t*>(wave.samples.data()),
+        static_cast<uint32_t>(wave.samples.size()), false, samples);
+    return true;
+}
+
+bool BatchTranscriber::Run(BatchReport* report)
+{
+    using namespace sherpa_onnx::cxx;
+
+    auto wall_begin = std::chrono::steady_clock::now();
+
+    std::vector<float> audio;
+    if (!LoadAudio(&audio)) return false;
+
+    // 区间边界按 VAD 窗口对齐
+    const int64_t total = static_cast<int64_t>(audio.size());
+    const int64_t region_count = std::max<int64_t>(1,
+        std::min<int64_t>(options_.vad_streams, total / kMinRegionSamples));
+    std::vector<VadRegion> regions(static_cast<size_t>(region_count));
+    for (int64_t i = 0; i < region_count; ++i) {
+        regions[i].begin = total * i / region_count / kVadWindow * kVadWindow;
+        regions[i].end = i + 1 == region_count ? total : total * (i + 1) / region_count / kVadWindow * kVadWindow;
+    }
+
+    // 多路时共用一个 Silero 推理，各路同时到达的窗口拼成一批；加载失败时每路退回 sherpa-onnx 的 VAD
+    const SileroVadConfig vad_config = SpeechRecognizer::VadConfig();
+    std::shared_ptr<SileroVadEngine> vad_engine;
+    if (region_count > 1) {
+        SileroVadEngineOptions engine_options;
+        engine_options.model = vad_config.model;
+        engine_options.max_batch = static_cast<int32_t>(region_count);
+        vad_engine = std::make_shared<SileroVadEngine>(engine_options);
+        if (!vad_engine->Load()) {
+            LOG_WARN("Batch", "shared Silero VAD unavailable, each stream uses its own sherpa-onnx VAD");
+            vad_engine.reset();
+        }
+    }
+    std::vector<std::unique_ptr<VadStream>> vads;
+    for (int64_t i = 0; i < region_count; ++i) {
+        vads.push_back(std::make_unique<VadStream>(vad_config, vad_engine));
+        if (!vads.back()->Valid()) {
+            LOG_ERROR("Batch", "failed to create VAD, check silero_vad.onnx");
+            return false;
+        }
+    }
+
+    // 输出文件名取输入文件名（不含扩展名）
+    std::wstring dir = options_.output_dir;
+    std::wstring stem = options_.input;
+    size_t slash = stem.find_last_of(L"\\/");
+    if (slash != std::wstring::npos) {
+        if (dir.empty()) dir = stem.substr(0, slash);
+        stem = stem.substr(slash + 1);
+    }
+    size_t dot = stem.find_last_of(L'.');
+    if (dot != std::wstring::npos) stem = stem.substr(0, dot);
+    if (dir.empty()) dir = L".";
+
+    TranscriptWriterOptions writer_options;
+    writer_options.directory = dir;
+    writer_options.max_pending = SIZE_MAX;    // 批处理不允许丢条目
+    writer_options.fsync = FsyncPolicy::kNever;
+    writer_ = std::make_unique<TranscriptWriter>(writer_options);
+    writer_->Start(stem);
+
+    if (options_.translate) {
+        translator_ = CreateTranslationBackend(TranslationBackendFromEnvironment());
+        translator_->SetResultCallback([this](const TranslationResult& r) { OnTranslation(r); });
+        if (!translator_->Start()) {
+            LOG_WARN("Batch", "translation backend failed to start, translation disabled");
+            translator_.reset();
+        }
+    }
+
+    // 所有解码线程共享一份模型：每次 Decode 单线程，并行度来自线程数而不是 intra-op
+    OfflineRecognizer recognizer = SpeechRecognizer::CreateOfflineRecognizer(options_.recognizer, 1);
+
+    std::vector<std::thread> workers;
+    for (int32_t i = 0; i < options_.workers; ++i) {
+        workers.emplace_back(&BatchTranscriber::DecodeLoop, this, &recognizer);
+    }
+
+    std::vector<std::thread> vad_threads;
+    for (size_t i = 0; i < regions.size(); ++i) {
+        vad_threads.emplace_back(&BatchTranscriber::VadLoop, this, &audio, &regions[i], std::move(vads[i]));
+    }
+
+    // 按区间顺序取出各路的语音段交给解码队列：第一路边切边交，后面各路在前一路结束前先攒着
+    size_t segment_count = 0;
+    size_t trimmed = 0;
+    double vad_seconds = 0;
+    int64_t cut = 0;    // 已交出的最后一段的终点
+    for (VadRegion& region : regions) {
+        for (;;) {
+            Segment segment;
+            {
+                std::unique_lock<std::mutex> lock(region_mutex_);
+                region_cv_.wait(lock, [&region] { return region.done || !region.segments.empty(); });
+                if (region.segments.empty()) {
+                    vad_seconds += region.vad_seconds;
+                    break;
+                }
+                segment = std::move(region.segments.front());
+                region.segments.pop_front();
+            }
+
+            // 区间开头可能落在上一路越过边界做完的语音段里，已交出的部分裁掉
+            if (segment.begin < cut) {
+                ++trimmed;
+                size_t skip = static_cast<size_t>(std::min<int64_t>(cut - segment.begin,
+                    static_cast<int64_t>(segment.samples.size())));
+                segment.samples.erase(segment.samples.begin(), segment.samples.begin() + skip);
+                segment.begin += static_cast<int64_t>(skip);
+                if (static_cast<int64_t>(segment.samples.size()) < kMinTrimmedSamples) continue;
+            }
+            cut = segment.begin + static_cast<int64_t>(segment.samples.size());
+            segment.index = segment_count++;
+
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this] { return queue_.size() < max_queued_; });
+            queue_.push_back(std::move(segment));
+            queue_cv_.notify_all();
+        }
+    }
+    for (auto& t : vad_threads) t.join();
+    if (vad_engine) {
+        SileroVadEngineStats stats = vad_engine->Stats();
+        LOG_INFO("Batch", "vad: %lld streams, mean batch %.1f, %zu segments trimmed at region boundaries",
+            static_cast<long long>(region_count), stats.MeanBatch(), trimmed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        producer_done_ = true;
+    }
+    queue_cv_.notify_all();
+    for (auto& t : workers) t.join();
+
+    if (translator_) {
+        std::unique_lock<std::mutex> lock(trans_mutex_);
+        trans_cv_.wait(lock, [this] { return next_translation_ == submitted_translations_; });
+        lock.unlock();
+        translator_->Stop();
+    }
+    writer_->Stop();
+
+    BatchReport r;
+    r.audio_seconds = static_cast<double>(audio.size()) / kSampleRate;
+    r.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_begin).count();
+    r.vad_seconds = vad_seconds;
+    r.segments = segment_count;
+    r.workers = options_.workers;
+    r.vad_streams = static_cast<int32_t>(region_count);
+    if (report) *report = r;
+    return true;
+}
+
+void BatchTranscriber::VadLoop(const std::vector<float>* audio, VadRegion* region, std::unique_ptr<VadStream> vad)
+{
+    double seconds = 0;
+    auto collect = [&]() {
+        while (!vad->IsEmpty()) {
+            const VadSegment& seg = vad->Front();
+            Segment segment;
+            segment.begin = region->begin + seg.start;
+            // 越过终点后才开始的语音段由下一路负责
+            bool own = segment.begin < region->end;
+            if (own) segment.samples = seg.samples;
+            vad->Pop();
+            if (!own) continue;
+
+            std::lock_guard<std::mutex> lock(region_mutex_);
+            region->segments.push_back(std::move(segment));
+            region_cv_.notify_all();
+        }
+    };
+
+    const int64_t total = static_cast<int64_t>(audio->size());
+    for (int64_t pos = region->begin; pos + kVadWindow <= total; pos += kVadWindow) {
+        // 越过终点且不在语音段中即可停下
+        if (pos >= region->end && !vad->IsDetected()) break;
+        auto begin = std::chrono::steady_clock::now();
+        vad->AcceptWaveform(audio->data() + pos, kVadWindow);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        collect();
+    }
+    vad->Flush();
+    collect();
+    // 尽早注销，共享推理不再等这一路凑批
+    vad.reset();
+
+    std::lock_guard<std::mutex> lock(region_mutex_);
+    region->vad_seconds = seconds;
+    region->done = true;
+    region_cv_.notify_all();
+}
+
+void BatchTranscriber::DecodeLoop(const sherpa_onnx::cxx::OfflineRecognizer* recognizer)
+{
+    using namespace sherpa_onnx::cxx;
+
+    metrics::Histogram* decode_time = metrics::Registry::Instance().GetHistogram(
+        "instanttrans_batch_decode_seconds", "Batch mode decode time per Decode call");
+
+    std::vector<Segment> batch;
+    std::vector<OfflineStream> streams;
+    for (;;) {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this] { return producer_done_ || !queue_.empty(); });
+            if (queue_.empty()) break;
+            while (!queue_.empty() && batch.size() < static_cast<size_t>(options_.batch_size)) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+        queue_cv_.notify_all();
+
+        streams.clear();
+        for (const Segment& seg : batch) {
+            streams.push_back(recognizer->CreateStream());
+            streams.back().AcceptWaveform(kSampleRate, seg.samples.data(), static_cast<int32_t>(seg.samples.size()));
+        }
+        {
+            metrics::ScopedTimer timer(decode_time);
+            recognizer->Decode(streams.data(), static_cast<int32_t>(streams.size()));
+        }
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            RecognitionMessage msg;
+            msg.recog_text = recognizer->GetResult(&streams[i]).text;
+            msg.is_final = true;
+            msg.source_id = "batch";
+            msg.audio_begin_ms = batch[i].begin * 1000 / kSampleRate;
+            msg.audio_end_ms = (batch[i].begin + static_cast<int64_t>(batch[i].samples.size())) * 1000 / kSampleRate;
+            EmitInOrder(batch[i].index, std::move(msg));
+        }
+    }
+}
+
+void BatchTranscriber::EmitInOrder(size_t index, RecognitionMessage msg)
+{
+    std::lock_guard<std::mutex> lock(emit_mutex_);
+    finished_.emplace(index, std::move(msg));
+
+    for (auto it = finished_.find(next_emit_); it != finished_.end(); it = finished_.find(next_emit_)) {
+        writer_->Submit(it->second);
+
+        if (translator_ && !it->second.recog_text.empty()) {
+            TranslationRequest request;
+            {
+                std::lock_guard<std::mutex> trans_lock(trans_mutex_);
+                request.id = submitted_translations_++;
+                awaiting_translation_.emplace(request.id, it->second);
+            }
+            request.text = it->second.recog_text;
+            translator_->Submit(std::move(request));
+        }
+
+        finished_.erase(it);
+        ++next_emit_;
+    }
+}
+
+void BatchTranscriber::OnTranslation(const TranslationResult& result)
+{
+    {
+        std::lock_guard<std::mutex> lock(trans_mutex_);
+        translated_.emplace(result.id, result);
+        // 被合并的较早请求不会单独回调：时间轴并入本结果，自身以空译文占位
+        for (uint64_t merged : result.merged_ids) {
+            auto begin = awaiting_translation_.find(merged);
+            auto end = awaiting_translation_.find(result.id);
+            if (begin != awaiting_translation_.end() && end != awaiting_translation_.end())
+                end->second.audio_begin_ms = std::min(end->second.audio_begin_ms, begin->second.audio_begin_ms);
+            TranslationResult placeholder;
+            placeholder.id = merged;
+            translated_.emplace(merged, placeholder);
+        }
+
+        for (auto it = translated_.find(next_translation_); it != translated_.end();
+            it = translated_.find(next_translation_)) {
+            RecognitionMessage msg = std::move(awaiting_translation_[next_translation_]);
+            awaiting_translation_.erase(next_translation_);
+            msg.source_id = "translation";
+            // 批处理只请求一种目标语言
+            msg.recog_text = it->second.translations.empty() ? std::string() : it->second.translations.front().text;
+            writer_->Submit(msg);
+
+            translated_.erase(it);
+            ++next_translation_;
+        }
+    }
+    trans_cv_.notify_all();
+}
+
+// -------------------- 命令行 --------------------
+int RunBatchCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    BatchOptions options;
+    // 输入文件跟在 --batch 后面，从 argv[1] 开始解析
+    ArgParser()
+        .Option(L"--batch", &options.input)
+        .Option(L"--out", &options.output_dir)
+        .Option(L"--workers", &options.workers)
+        .Option(L"--batch-size", &options.batch_size)
+        .Option(L"--vad-streams", &options.vad_streams)
+        .Flag(L"--translate", &options.translate)
+        .Parse(argc, argv, 1);
+    if (options.input.empty()) {
+        fprintf(stderr, "usage: InstantTrans.exe --batch <file.wav> [--out <dir>] [--workers N] [--batch-size N] "
+            "[--vad-streams N] [--translate]\n");
+        return 2;
+    }
+
+    BatchTranscriber transcriber(options);
+    BatchReport report;
+    if (!transcriber.Run(&report)) return 1;
+
+    printf("[Batch] audio=%.1fs wall=%.1fs segments=%zu workers=%d vad=%.1fs x%d -> %.1f audio-hours/hour\n",
+        report.audio_seconds, report.wall_seconds, report.segments, report.workers,
+        report.vad_seconds, report.vad_streams, report.AudioHoursPerHour());
+    fflush(stdout);
+    return 0;
+}
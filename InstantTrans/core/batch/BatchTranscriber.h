@@ -0,0 +1,103 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core/recoginize/SpeechRecognize.h"
+#include "core/output/TranscriptWriter.h"
+#include "core/translate/TranslationBackend.h"
+
+struct BatchOptions {
+    std::wstring input;              // wav 文件，任意采样率/声道
+    std::wstring output_dir;         // 为空时与输入文件同目录
+    int32_t workers = 0;             // 解码线程数，0 表示逻辑核心数
+    int32_t batch_size = 4;          // 每次 Decode 合并的语音段数
+    // 整文件切成几段相邻区间并发做 VAD，各路共用一个 SileroVadEngine 拼批推理；短文件自动减少
+    int32_t vad_streams = 4;
+    bool translate = false;          // 同时提交翻译，结果写入 <name>-translation.*
+    RecognizerOptions recognizer;    // 模型精度等，与实时模式相同
+};
+
+struct BatchReport {
+    double audio_seconds = 0;
+    double wall_seconds = 0;
+    double vad_seconds = 0;          // 各路 VAD 线程的累计耗时（与解码并行）
+    size_t segments = 0;
+    int32_t workers = 0;
+    int32_t vad_streams = 0;         // 实际并发的 VAD 路数
+
+    // 每小时墙钟时间能处理的音频小时数
+    double AudioHoursPerHour() const { return wall_seconds > 0 ? audio_seconds / wall_seconds : 0; }
+};
+
+// 离线批处理转写：
+// 整文件按区间分给几路 VAD 线程并发切段，本线程按区间顺序把语音段交给解码队列；
+// N 个解码线程共享同一个识别器（Decode 为 const，ONNX Runtime 的 Run 可并发），
+// 每次批量解码多个语音段；结果按段序号重排后交给 TranscriptWriter，翻译请求随之流水提交
+class BatchTranscriber {
+public:
+    explicit BatchTranscriber(const BatchOptions& options);
+    ~BatchTranscriber();
+
+    bool Run(BatchReport* report);
+
+private:
+    struct Segment {
+        size_t index = 0;
+        int64_t begin = 0;           // 16kHz 采样序号
+        std::vector<float> samples;
+    };
+
+    // 一路 VAD 负责的区间及其切出的语音段
+    struct VadRegion {
+        int64_t begin = 0;
+        int64_t end = 0;             // 越过 end 后只把进行中的语音段做完，之后开始的段属于下一路
+        std::deque<Segment> segments;
+        bool done = false;
+        double vad_seconds = 0;
+    };
+
+    bool LoadAudio(std::vector<float>* samples);
+    void VadLoop(const std::vector<float>* audio, VadRegion* region, std::unique_ptr<VadStream> vad);
+    void DecodeLoop(const sherpa_onnx::cxx::OfflineRecognizer* recognizer);
+    void EmitInOrder(size_t index, RecognitionMessage msg);
+    void OnTranslation(const TranslationResult& result);
+
+    BatchOptions options_;
+    std::unique_ptr<TranscriptWriter> writer_;
+    std::unique_ptr<TranslationBackend> translator_;
+
+    // 各路 VAD -> 本线程
+    std::mutex region_mutex_;
+    std::condition_variable region_cv_;
+
+    // 本线程 -> 解码线程
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<Segment> queue_;
+    size_t max_queued_ = 0;
+    bool producer_done_ = false;
+
+    // 乱序完成的识别结果，按段序号依次交出
+    std::mutex emit_mutex_;
+    std::map<size_t, RecognitionMessage> finished_;
+    size_t next_emit_ = 0;
+
+    // 翻译结果同样按序写出
+    std::mutex trans_mutex_;
+    std::condition_variable trans_cv_;
+    std::map<uint64_t, TranslationResult> translated_;
+    std::map<uint64_t, RecognitionMessage> awaiting_translation_;
+    uint64_t next_translation_ = 0;
+    uint64_t submitted_translations_ = 0;
+};
+
+// 命令行入口：InstantTrans.exe --batch <file.wav> [--out <dir>] [--workers N] [--batch-size N] [--vad-streams N]
+//   [--translate]
+// 返回进程退出码
+int RunBatchCommandLine(int argc, wchar_t** argv);
@@ -1,29 +1,175 @@
 #pragma once
 #include "types/types.h"
+#include "core/metrics/Metrics.h"
 #include <windows.h>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
-// UI ԶϢ
+// UI 端自定义消息，payload 由 TakeRecognition / TakeTranslation 取回
 constexpr UINT WM_APP_RECOG = WM_APP + 1;   // payload: RecognitionMessage*
 constexpr UINT WM_APP_TRANS = WM_APP + 2;  // payload: TranslationMessage*
 
+// 投递给 UI 线程的消息对象循环使用：取回方用完后放回，字符串保留容量，
+// 稳态下投递与取回都不分配。池中最多留 kMaxPooled 个，突发时多出的照常 new / delete
+template <typename Message>
+class MessagePool {
+public:
+    static constexpr size_t kMaxPooled = 64;
+
+    struct Recycler {
+        void operator()(Message* p) const { Instance().Release(p); }
+    };
+    using Ptr = std::unique_ptr<Message, Recycler>;
+
+    static MessagePool& Instance() {
+        static MessagePool pool;
+        return pool;
+    }
+
+    Message* Acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                Message* p = free_.back();
+                free_.pop_back();
+                return p;
+            }
+        }
+        Misses()->Add();
+        return new Message();
+    }
+
+    void Release(Message* p) {
+        if (!p) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_.size() < kMaxPooled) {
+                free_.push_back(p);
+                return;
+            }
+        }
+        delete p;
+    }
+
+private:
+    MessagePool() { free_.reserve(kMaxPooled); }
+    ~MessagePool() {
+        for (Message* p : free_) delete p;
+    }
+
+    static metrics::Counter* Misses() {
+        static metrics::Counter* counter = metrics::Registry::Instance().GetCounter(
+            "instanttrans_bus_pool_misses_total", "Bus messages allocated because the pool was empty");
+        return counter;
+    }
+
+    std::mutex mutex_;
+    std::vector<Message*> free_;
+};
+
 class MessageBus {
 public:
-    // UI HWND  MainWindow ʼ
-    void SetUIWindow(HWND hwnd) { ui_hwnd_ = hwnd; }
+    using RecognitionPtr = MessagePool<RecognitionMessage>::Ptr;
+    using TranslationPtr = MessagePool<TranslationMessage>::Ptr;
+
+    // UI HWND 需在 MainWindow 初始化后设置
+    void SetUIWindow(HWND hwnd) { ui_hwnd_.store(hwnd); }
+
+    // 窗口销毁前、所有发布线程停止后在 UI 线程调用：此后不再投递，
+    // 并释放消息队列中尚未处理的消息，否则它们随窗口一起泄漏
+    void DetachUIWindow() {
+        HWND hwnd = ui_hwnd_.exchange(nullptr);
+        if (!hwnd) return;
+        MSG msg;
+        while (::PeekMessage(&msg, hwnd, WM_APP_RECOG, WM_APP_TRANS, PM_REMOVE)) {
+            if (msg.message == WM_APP_RECOG) TakeRecognition(msg.wParam);
+            else TakeTranslation(msg.wParam);
+        }
+    }
 
-    void PostRecognition(const RecognitionMessage& msg) {
-        if (!ui_hwnd_) return;
-        auto p = new RecognitionMessage(msg);
-        ::PostMessage(ui_hwnd_, WM_APP_RECOG, reinterpret_cast<WPARAM>(p), 0);
+    // UI 线程取回消息的所有权，释放时放回池中
+    static RecognitionPtr TakeRecognition(WPARAM wparam) {
+        InFlight()->Add(-1);
+        return RecognitionPtr(reinterpret_cast<RecognitionMessage*>(wparam));
+    }
+    static TranslationPtr TakeTranslation(WPARAM wparam) {
+        InFlight()->Add(-1);
+        return TranslationPtr(reinterpret_cast<TranslationMessage*>(wparam));
     }
 
-    void PostTranslation(const TranslationMessage& msg) {
-        if (!ui_hwnd_) return;
-        auto p = new TranslationMessage(msg);
-        ::PostMessage(ui_hwnd_, WM_APP_TRANS, reinterpret_cast<WPARAM>(p), 0);
+    // 识别结果的旁路订阅者（如落盘），在发布线程上同步调用
+    // 须在识别启动前注册；回调只允许做入队这类轻量操作，不能阻塞识别线程
+    using RecognitionListener = std::function<void(const RecognitionMessage&)>;
+    void AddRecognitionListener(RecognitionListener listener) {
+        recog_listeners_.push_back(std::move(listener));
+    }
+
+    // 右值版本与池中对象交换文本：不拷贝，调用方拿回上一条消息的缓冲，复用它时也不分配
+    void PostRecognition(RecognitionMessage&& msg) { PostRecognitionImpl(msg, &msg); }
+    void PostRecognition(const RecognitionMessage& msg) { PostRecognitionImpl(msg, nullptr); }
+
+    void PostTranslation(TranslationMessage&& msg) { PostTranslationImpl(msg, &msg); }
+    void PostTranslation(const TranslationMessage& msg) { PostTranslationImpl(msg, nullptr); }
+
+    // 已投递、UI 线程尚未取回的消息数
+    static metrics::Gauge* InFlight() {
+        static metrics::Gauge* gauge = metrics::Registry::Instance().GetGauge(
+            "instanttrans_bus_inflight_messages", "Messages posted to the UI thread and not yet taken");
+        return gauge;
     }
 
 private:
-    HWND ui_hwnd_ = nullptr;
+    // movable 非空时即 msg 本身，与池中对象整体交换，文本不拷贝；否则整体赋值，复用池中对象的容量。
+    // 两种方式都覆盖全部字段，结构体新增字段不会在投递时丢失
+    void PostRecognitionImpl(const RecognitionMessage& msg, RecognitionMessage* movable) {
+        for (auto& listener : recog_listeners_) listener(msg);
+        HWND hwnd = ui_hwnd_.load();
+        if (!hwnd) return;
+        auto& pool = MessagePool<RecognitionMessage>::Instance();
+        RecognitionMessage* p = pool.Acquire();
+        if (movable) {
+            std::swap(*p, *movable);
+            movable->recog_text.clear();
+        }
+        else {
+            *p = msg;
+        }
+        // 交换后 msg 已是池中旧对象的内容，之后只读 p
+        if (::PostMessage(hwnd, WM_APP_RECOG, reinterpret_cast<WPARAM>(p), 0)) {
+            InFlight()->Add(1);
+        }
+        else {
+            // 消息队列已满（默认上限 10000）或窗口已销毁：消息不会被 UI 取回
+            pool.Release(p);
+            Dropped(p->is_final ? "recog_final" : "recog_partial")->Add();
+        }
+    }
+
+    void PostTranslationImpl(const TranslationMessage& msg, TranslationMessage* movable) {
+        HWND hwnd = ui_hwnd_.load();
+        if (!hwnd) return;
+        auto& pool = MessagePool<TranslationMessage>::Instance();
+        TranslationMessage* p = pool.Acquire();
+        if (movable) std::swap(*p, *movable);
+        else *p = msg;
+        if (::PostMessage(hwnd, WM_APP_TRANS, reinterpret_cast<WPARAM>(p), 0)) {
+            InFlight()->Add(1);
+        }
+        else {
+            pool.Release(p);
+            Dropped("translation")->Add();
+        }
+    }
+
+    static metrics::Counter* Dropped(const char* kind) {
+        return metrics::Registry::Instance().GetCounter("instanttrans_bus_dropped_messages_total",
+            "Messages that could not be posted to the UI thread", std::string("kind=\"") + kind + "\"");
+    }
+
+    std::atomic<HWND> ui_hwnd_{ nullptr };
+    std::vector<RecognitionListener> recog_listeners_;
 };
@@ -0,0 +1,77 @@
+#include "AllocStats.h"
+
+#include <cstdlib>
+#include <new>
+
+#include "Metrics.h"
+
+// 替换全局分配运算符，计数走按线程分片的 Counter，每次分配只多两次 relaxed 原子加
+// Counter 没有用户定义的构造函数，静态对象在任何动态初始化之前就已清零，启动期的分配也能计入
+namespace {
+
+metrics::Counter g_allocations;
+metrics::Counter g_frees;
+metrics::Counter g_bytes;
+// 平凡类型的 thread_local 静态初始化，线程启动时即可用
+thread_local uint64_t t_allocations = 0;
+
+void* Allocate(std::size_t size)
+{
+    void* p = std::malloc(size ? size : 1);
+    if (p) {
+        g_allocations.Add();
+        g_bytes.Add(size);
+        ++t_allocations;
+    }
+    return p;
+}
+
+void Free(void* p)
+{
+    if (!p) return;
+    g_frees.Add();
+    std::free(p);
+}
+
+} // namespace
+
+namespace metrics {
+
+AllocStats GetAllocStats()
+{
+    AllocStats st;
+    // 先读释放数，并发分配时 Live 不会出现负数
+    st.frees = g_frees.Value();
+    st.allocations = g_allocations.Value();
+    st.bytes = g_bytes.Value();
+    return st;
+}
+
+uint64_t ThreadAllocations()
+{
+    return t_allocations;
+}
+
+} // namespace metrics
+
+void* operator new(std::size_t size)
+{
+    if (void* p = Allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* p = Allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+
+void operator delete(void* p) noexcept { Free(p); }
+void operator delete[](void* p) noexcept { Free(p); }
+void operator delete(void* p, std::size_t) noexcept { Free(p); }
+void operator delete[](void* p, std::size_t) noexcept { Free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { Free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { Free(p); }
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+// 全局 operator new / delete 的调用计数，用于长时间运行时发现泄漏和分配热点
+// 只统计经由 C++ 分配运算符的内存；ONNX Runtime 等库自己的分配器不在其中，由 RSS 反映
+namespace metrics {
+
+struct AllocStats {
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;          // 累计申请的字节数
+
+    uint64_t Live() const { return allocations - frees; }
+};
+
+AllocStats GetAllocStats();
+
+// 当前线程累计的分配次数，不受其它线程影响；前后相减即为一段代码的分配次数，
+// 用于检查稳态路径（如识别片段从总线到上屏）是否分配
+uint64_t ThreadAllocations();
+
+} // namespace metrics
@@ -0,0 +1,47 @@
+#include "Log.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+#include <Windows.h>
+
+namespace Log {
+
+void InitFromEnvironment()
+{
+    static const char* kNames[] = { "error", "warn", "info", "debug", "trace" };
+
+    char value[16] = { 0 };
+    size_t len = 0;
+    if (getenv_s(&len, value, sizeof(value), "INSTANTTRANS_LOG") != 0 || len == 0) return;
+    for (int i = 0; i < 5; ++i) {
+        if (_stricmp(value, kNames[i]) == 0) {
+            SetLevel(static_cast<LogLevel>(i));
+            return;
+        }
+    }
+}
+
+void Write(LogLevel level, const char* tag, const char* fmt, ...)
+{
+    static const char kLetters[] = { 'E', 'W', 'I', 'D', 'T' };
+
+    char buf[1024];
+    int n = snprintf(buf, sizeof(buf), "%c [%s] ", kLetters[static_cast<int>(level)], tag);
+    if (n < 0) return;
+
+    va_list args;
+    va_start(args, fmt);
+    int m = vsnprintf(buf + n, sizeof(buf) - n - 1, fmt, args);
+    va_end(args);
+    size_t used = m < 0 ? n : static_cast<size_t>(n + m);
+    if (used > sizeof(buf) - 2) used = sizeof(buf) - 2;   // 截断
+    buf[used] = '\n';
+    buf[used + 1] = '\0';
+
+    OutputDebugStringA(buf);
+    fputs(buf, level <= LogLevel::kWarn ? stderr : stdout);
+}
+
+} // namespace Log
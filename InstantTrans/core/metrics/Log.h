@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+
+// 分级日志：级别不够时宏直接跳过，参数不求值、不格式化
+enum class LogLevel : int {
+    kError = 0,
+    kWarn,
+    kInfo,
+    kDebug,
+    kTrace,
+};
+
+namespace Log {
+
+inline std::atomic<int>& CurrentLevel() {
+    static std::atomic<int> level{ static_cast<int>(LogLevel::kInfo) };
+    return level;
+}
+
+inline bool Enabled(LogLevel level) {
+    return static_cast<int>(level) <= CurrentLevel().load(std::memory_order_relaxed);
+}
+
+inline void SetLevel(LogLevel level) {
+    CurrentLevel().store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+// 从环境变量 INSTANTTRANS_LOG（error/warn/info/debug/trace）读取级别
+void InitFromEnvironment();
+
+// printf 风格，输出到调试器和标准输出
+void Write(LogLevel level, const char* tag, const char* fmt, ...);
+
+} // namespace Log
+
+#define IT_LOG(level, tag, ...) \
+    do { if (Log::Enabled(level)) Log::Write(level, tag, __VA_ARGS__); } while (0)
+
+#define LOG_ERROR(tag, ...) IT_LOG(LogLevel::kError, tag, __VA_ARGS__)
+#define LOG_WARN(tag, ...)  IT_LOG(LogLevel::kWarn, tag, __VA_ARGS__)
+#define LOG_INFO(tag, ...)  IT_LOG(LogLevel::kInfo, tag, __VA_ARGS__)
+#define LOG_DEBUG(tag, ...) IT_LOG(LogLevel::kDebug, tag, __VA_ARGS__)
+#define LOG_TRACE(tag, ...) IT_LOG(LogLevel::kTrace, tag, __VA_ARGS__)
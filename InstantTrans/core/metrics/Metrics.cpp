@@ -0,0 +1,256 @@
+#include "Metrics.h"
+
+#include <cstdio>
+
+#include <Windows.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace metrics {
+
+int ShardIndex()
+{
+    static std::atomic<int> next{ 0 };
+    thread_local int shard = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+}
+
+uint64_t Counter::Value() const
+{
+    uint64_t sum = 0;
+    for (const Cell& cell : cells_) sum += cell.value.load(std::memory_order_relaxed);
+    return sum;
+}
+
+// -------------------- Histogram --------------------
+Histogram::Histogram() : buckets_(new std::atomic<uint64_t>[kBuckets])
+{
+    for (int i = 0; i < kBuckets; ++i) buckets_[i].store(0, std::memory_order_relaxed);
+}
+
+int Histogram::BucketIndex(uint64_t value)
+{
+    if (value < kSubBuckets) return static_cast<int>(value);
+    if (value >= (1ull << kMaxBits)) value = (1ull << kMaxBits) - 1;
+
+#ifdef _MSC_VER
+    unsigned long msb = 0;
+    _BitScanReverse64(&msb, value);
+#else
+    int msb = 63 - __builtin_clzll(value);
+#endif
+    int shift = static_cast<int>(msb) - kSubBits;
+    int sub = static_cast<int>((value >> shift) & (kSubBuckets - 1));
+    return (shift + 1) * kSubBuckets + sub;
+}
+
+uint64_t Histogram::BucketUpperBound(int index)
+{
+    if (index < kSubBuckets) return static_cast<uint64_t>(index);
+    int shift = index / kSubBuckets - 1;
+    uint64_t sub = static_cast<uint64_t>(index % kSubBuckets);
+    return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+void Histogram::Record(uint64_t value_us)
+{
+    buckets_[BucketIndex(value_us)].fetch_add(1, std::memory_order_relaxed);
+    sum_.Add(value_us);
+}
+
+Histogram::Snapshot Histogram::Take() const
+{
+    Snapshot snap;
+    snap.buckets.resize(kBuckets);
+    for (int i = 0; i < kBuckets; ++i) {
+        snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        snap.count += snap.buckets[i];
+    }
+    snap.sum = sum_.Value();
+    return snap;
+}
+
+uint64_t Histogram::Snapshot::Percentile(double q) const
+{
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return BucketUpperBound(static_cast<int>(i));
+    }
+    return BucketUpperBound(static_cast<int>(buckets.size()) - 1);
+}
+
+Histogram::Snapshot Histogram::Snapshot::Since(const Snapshot& earlier) const
+{
+    if (earlier.buckets.size() != buckets.size()) return *this;
+    Snapshot delta;
+    delta.buckets.resize(buckets.size());
+    for (size_t i = 0; i < buckets.size(); ++i) delta.buckets[i] = buckets[i] - earlier.buckets[i];
+    delta.count = count - earlier.count;
+    delta.sum = sum - earlier.sum;
+    return delta;
+}
+
+// -------------------- Registry --------------------
+Registry& Registry::Instance()
+{
+    static Registry registry;
+    return registry;
+}
+
+Registry::Entry& Registry::GetEntry(Type type, const std::string& name, const std::string& help,
+    const std::string& labels)
+{
+    // 用不可见字符分隔，保证同名不同标签的条目在 map 中相邻
+    std::string key = name + '\x01' + labels;
+    auto it = entries_.find(key);
+    if (it != entries_.end()) return it->second;
+
+    Entry& e = entries_[key];
+    e.type = type;
+    e.name = name;
+    e.labels = labels;
+    e.help = help;
+    switch (type) {
+    case Type::kCounter: e.counter = std::make_unique<Counter>(); break;
+    case Type::kGauge: e.gauge = std::make_unique<Gauge>(); break;
+    case Type::kHistogram: e.histogram = std::make_unique<Histogram>(); break;
+    }
+    return e;
+}
+
+Counter* Registry::GetCounter(const std::string& name, const std::string& help, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return GetEntry(Type::kCounter, name, help, labels).counter.get();
+}
+
+Gauge* Registry::GetGauge(const std::string& name, const std::string& help, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return GetEntry(Type::kGauge, name, help, labels).gauge.get();
+}
+
+Histogram* Registry::GetHistogram(const std::string& name, const std::string& help, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return GetEntry(Type::kHistogram, name, help, labels).histogram.get();
+}
+
+static std::string JoinLabels(const std::string& labels, const std::string& extra)
+{
+    if (labels.empty() && extra.empty()) return "";
+    if (labels.empty()) return "{" + extra + "}";
+    if (extra.empty()) return "{" + labels + "}";
+    return "{" + labels + "," + extra + "}";
+}
+
+std::string Registry::RenderPrometheus() const
+{
+    static const double kQuantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+    out.reserve(entries_.size() * 128);
+    const std::string* last_name = nullptr;
+    char buf[128];
+
+    for (const auto& item : entries_) {
+        const Entry& e = item.second;
+        if (!last_name || *last_name != e.name) {
+            const char* type = e.type == Type::kCounter ? "counter"
+                : e.type == Type::kGauge ? "gauge" : "summary";
+            out += "# HELP " + e.name + " " + e.help + "\n";
+            out += "# TYPE " + e.name + " " + type + "\n";
+            last_name = &e.name;
+        }
+
+        switch (e.type) {
+        case Type::kCounter:
+            snprintf(buf, sizeof(buf), " %llu\n", static_cast<unsigned long long>(e.counter->Value()));
+            out += e.name + JoinLabels(e.labels, "") + buf;
+            break;
+        case Type::kGauge:
+            snprintf(buf, sizeof(buf), " %lld\n", static_cast<long long>(e.gauge->Value()));
+            out += e.name + JoinLabels(e.labels, "") + buf;
+            break;
+        case Type::kHistogram: {
+            Histogram::Snapshot snap = e.histogram->Take();
+            for (double q : kQuantiles) {
+                snprintf(buf, sizeof(buf), "quantile=\"%g\"", q);
+                std::string labels = JoinLabels(e.labels, buf);
+                snprintf(buf, sizeof(buf), " %.6f\n", snap.Percentile(q) / 1e6);
+                out += e.name + labels + buf;
+            }
+            snprintf(buf, sizeof(buf), " %.6f\n", snap.sum / 1e6);
+            out += e.name + "_sum" + JoinLabels(e.labels, "") + buf;
+            snprintf(buf, sizeof(buf), " %llu\n", static_cast<unsigned long long>(snap.count));
+            out += e.name + "_count" + JoinLabels(e.labels, "") + buf;
+            break;
+        }
+        }
+    }
+    return out;
+}
+
+// -------------------- FileExporter --------------------
+FileExporter::FileExporter(const std::wstring& path, int32_t interval_ms)
+    : path_(path), interval_ms_(interval_ms)
+{
+}
+
+FileExporter::~FileExporter()
+{
+    Stop();
+}
+
+void FileExporter::Start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stop_) return;
+    stop_ = false;
+    thread_ = std::thread(&FileExporter::Loop, this);
+}
+
+void FileExporter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) return;
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    WriteOnce();
+}
+
+bool FileExporter::WriteOnce()
+{
+    std::string text = Registry::Instance().RenderPrometheus();
+
+    // 写临时文件后原子替换，采集方不会读到半个文件
+    std::wstring tmp = path_ + L".tmp";
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, tmp.c_str(), L"wb") != 0 || !f) return false;
+    fwrite(text.data(), 1, text.size(), f);
+    fclose(f);
+    return MoveFileExW(tmp.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+}
+
+void FileExporter::Loop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        cv_.wait_for(lock, std::chrono::milliseconds(interval_ms_), [this] { return stop_; });
+        if (stop_) break;
+        lock.unlock();
+        WriteOnce();
+        lock.lock();
+    }
+}
+
+} // namespace metrics
@@ -0,0 +1,155 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 进程内指标：计数器按线程分片、直方图为对数-线性分桶，记录路径只有 relaxed 原子加
+// 指标对象由 Registry 持有且永不释放，调用方在首次使用时取指针并缓存（通常放在函数内 static）
+namespace metrics {
+
+constexpr int kShards = 16;
+
+// 当前线程的分片号，首次调用时轮流分配
+int ShardIndex();
+
+// 单调递增计数器，不同线程写不同的缓存行
+class Counter {
+public:
+    void Add(uint64_t n = 1) {
+        cells_[ShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    uint64_t Value() const;
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> value{ 0 };
+    };
+    Cell cells_[kShards];
+};
+
+// 瞬时值（队列深度等）
+class Gauge {
+public:
+    void Set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    void Add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{ 0 };
+};
+
+// 耗时直方图，单位微秒，导出时换算为秒
+// 小于 16 的值精确计数；之后每个 2 的幂区间等分 16 个子桶，相对误差不超过 1/16
+class Histogram {
+public:
+    static constexpr int kSubBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kMaxBits = 40;   // 约 12 天，足够覆盖任何耗时
+    static constexpr int kBuckets = (kMaxBits - kSubBits + 1) * kSubBuckets;
+
+    struct Snapshot {
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        // q 分位对应桶的上界
+        uint64_t Percentile(double q) const;
+        // 本快照减去更早的快照，得到这段时间内的分布
+        Snapshot Since(const Snapshot& earlier) const;
+    };
+
+    Histogram();
+
+    void Record(uint64_t value_us);
+    Snapshot Take() const;
+
+    static int BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(int index);
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+    Counter sum_;
+};
+
+// 作用域计时，析构时写入直方图
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram* histogram)
+        : histogram_(histogram), begin_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        histogram_->Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin_).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram* histogram_;
+    std::chrono::steady_clock::time_point begin_;
+};
+
+class Registry {
+public:
+    static Registry& Instance();
+
+    // 同名同标签返回同一个对象；labels 形如 kind="partial"
+    Counter* GetCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge* GetGauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram* GetHistogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    // Prometheus 文本格式；直方图按 summary 导出（分位 + _sum + _count）
+    std::string RenderPrometheus() const;
+
+private:
+    enum class Type { kCounter, kGauge, kHistogram };
+
+    struct Entry {
+        Type type;
+        std::string name;
+        std::string labels;
+        std::string help;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    Entry& GetEntry(Type type, const std::string& name, const std::string& help, const std::string& labels);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Entry> entries_;   // 同名指标导出时相邻
+};
+
+// 定期把 RenderPrometheus 的结果写入文件（先写临时文件再替换），可供 node_exporter textfile 采集
+class FileExporter {
+public:
+    FileExporter(const std::wstring& path, int32_t interval_ms);
+    ~FileExporter();
+
+    FileExporter(const FileExporter&) = delete;
+    FileExporter& operator=(const FileExporter&) = delete;
+
+    void Start();
+    void Stop();
+
+    // 立即写一次
+    bool WriteOnce();
+
+private:
+    void Loop();
+
+    std::wstring path_;
+    int32_t interval_ms_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = true;
+    std::thread thread_;
+};
+
+} // namespace metrics
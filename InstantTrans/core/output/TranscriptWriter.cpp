@@ -0,0 +1,285 @@
+#include "TranscriptWriter.h"
+
+#include <chrono>
+#include <io.h>
+
+#include <Windows.h>
+
+#include "core/metrics/Metrics.h"
+
+static const wchar_t* kExtensions[3] = { L".srt", L".vtt", L".jsonl" };
+
+// SRT 用逗号分隔毫秒，WebVTT 用点
+static void AppendTimestamp(std::string& out, int64_t ms, char separator)
+{
+    if (ms < 0) ms = 0;
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%02lld:%02lld:%02lld%c%03lld",
+        static_cast<long long>(ms / 3600000), static_cast<long long>(ms / 60000 % 60),
+        static_cast<long long>(ms / 1000 % 60), separator, static_cast<long long>(ms % 1000));
+    out += buf;
+}
+
+static void AppendJsonString(std::string& out, const std::string& s)
+{
+    out += '"';
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+// 音源标识用于文件名，替换掉路径中不允许的字符
+static std::wstring SanitizeSourceId(const std::string& source_id)
+{
+    std::wstring name;
+    for (char c : source_id) {
+        bool ok = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+            || c == '-' || c == '_' || c == '.';
+        name += ok ? static_cast<wchar_t>(c) : L'_';
+    }
+    return name.empty() ? L"default" : name;
+}
+
+TranscriptWriter::TranscriptWriter(const TranscriptWriterOptions& options) : options_(options)
+{
+}
+
+TranscriptWriter::~TranscriptWriter()
+{
+    Stop();
+}
+
+bool TranscriptWriter::Start(const std::wstring& session)
+{
+    Stop();
+    if (!options_.directory.empty()) {
+        CreateDirectoryW(options_.directory.c_str(), nullptr);
+    }
+    session_ = session;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.clear();
+        pending_.reserve(options_.wake_batch * 2);
+        stopping_ = false;
+        running_ = true;
+        stats_ = TranscriptWriterStats();
+    }
+    thread_ = std::thread(&TranscriptWriter::WriteLoop, this);
+    return true;
+}
+
+void TranscriptWriter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+
+    wchar_t buf[256];
+    swprintf(buf, 256, L"[TranscriptWriter] written=%llu dropped=%llu batches=%llu fsyncs=%llu bytes=%llu\n",
+        stats_.written, stats_.dropped, stats_.batches, stats_.fsyncs, stats_.bytes);
+    OutputDebugStringW(buf);
+}
+
+bool TranscriptWriter::Running() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_ && !stopping_;
+}
+
+void TranscriptWriter::Submit(const RecognitionMessage& msg)
+{
+    if (!msg.is_final || msg.recog_text.empty()) return;
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || stopping_) return;
+        ++stats_.submitted;
+        if (pending_.size() >= options_.max_pending) {
+            ++stats_.dropped;
+            static metrics::Counter* dropped = metrics::Registry::Instance().GetCounter(
+                "instanttrans_transcript_dropped_total", "Transcript entries dropped because the writer fell behind");
+            dropped->Add();
+            return;
+        }
+        pending_.push_back({ msg.source_id, msg.audio_begin_ms, msg.audio_end_ms, msg.recog_text });
+        wake = pending_.size() == options_.wake_batch;
+    }
+    if (wake) cv_.notify_one();
+}
+
+TranscriptWriterStats TranscriptWriter::Stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void TranscriptWriter::WriteLoop()
+{
+    std::vector<Entry> batch;
+    batch.reserve(options_.wake_batch * 2);
+    auto last_fsync = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait_for(lock, std::chrono::milliseconds(options_.batch_interval_ms), [this] {
+            return stopping_ || pending_.size() >= options_.wake_batch;
+        });
+        // 交换缓冲后立即放锁，识别线程只会和这一次 swap 竞争
+        batch.swap(pending_);
+        bool stopping = stopping_;
+        lock.unlock();
+
+        if (!batch.empty()) {
+            WriteBatch(batch);
+
+            auto now = std::chrono::steady_clock::now();
+            bool fsync = options_.fsync == FsyncPolicy::kEveryBatch
+                || (options_.fsync == FsyncPolicy::kInterval
+                    && now - last_fsync >= std::chrono::milliseconds(options_.fsync_interval_ms));
+            FlushSinks(fsync);
+            if (fsync) last_fsync = now;
+            batch.clear();
+        }
+
+        lock.lock();
+        if (stopping && pending_.empty()) break;
+    }
+    lock.unlock();
+
+    FlushSinks(options_.fsync != FsyncPolicy::kNever);
+    CloseSinks();
+}
+
+void TranscriptWriter::WriteBatch(std::vector<Entry>& batch)
+{
+    for (const Entry& e : batch) {
+        Sink& sink = GetSink(e.source_id);
+        ++sink.sequence;
+
+        if (sink.files[0]) {
+            std::string& out = sink.buffers[0];
+            out += std::to_string(sink.sequence);
+            out += '\n';
+            AppendTimestamp(out, e.begin_ms, ',');
+            out += " --> ";
+            AppendTimestamp(out, e.end_ms, ',');
+            out += '\n';
+            out += e.text;
+            out += "\n\n";
+        }
+        if (sink.files[1]) {
+            std::string& out = sink.buffers[1];
+            AppendTimestamp(out, e.begin_ms, '.');
+            out += " --> ";
+            AppendTimestamp(out, e.end_ms, '.');
+            out += '\n';
+            out += e.text;
+            out += "\n\n";
+        }
+        if (sink.files[2]) {
+            std::string& out = sink.buffers[2];
+            out += "{\"source\":";
+            AppendJsonString(out, e.source_id);
+            out += ",\"seq\":";
+            out += std::to_string(sink.sequence);
+            out += ",\"start_ms\":";
+            out += std::to_string(e.begin_ms);
+            out += ",\"end_ms\":";
+            out += std::to_string(e.end_ms);
+            out += ",\"text\":";
+            AppendJsonString(out, e.text);
+            out += "}\n";
+        }
+    }
+
+    uint64_t bytes = 0;
+    for (auto& item : sinks_) {
+        Sink& sink = item.second;
+        for (int i = 0; i < 3; ++i) {
+            if (!sink.files[i] || sink.buffers[i].empty()) continue;
+            fwrite(sink.buffers[i].data(), 1, sink.buffers[i].size(), sink.files[i]);
+            bytes += sink.buffers[i].size();
+            sink.buffers[i].clear();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.written += batch.size();
+    stats_.bytes += bytes;
+    ++stats_.batches;
+}
+
+void TranscriptWriter::FlushSinks(bool fsync)
+{
+    uint64_t fsyncs = 0;
+    for (auto& item : sinks_) {
+        for (FILE* f : item.second.files) {
+            if (!f) continue;
+            fflush(f);
+            if (fsync) {
+                FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(f))));
+                ++fsyncs;
+            }
+        }
+    }
+    if (fsyncs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.fsyncs += fsyncs;
+    }
+}
+
+TranscriptWriter::Sink& TranscriptWriter::GetSink(const std::string& source_id)
+{
+    auto it = sinks_.find(source_id);
+    if (it != sinks_.end()) return it->second;
+
+    Sink& sink = sinks_[source_id];
+    std::wstring base = options_.directory + L"\\" + session_ + L"-" + SanitizeSourceId(source_id);
+    for (int i = 0; i < 3; ++i) {
+        if (!(options_.formats & (1u << i))) continue;
+        std::wstring path = base + kExtensions[i];
+        if (_wfopen_s(&sink.files[i], path.c_str(), L"wb") != 0) {
+            sink.files[i] = nullptr;
+            OutputDebugStringW((L"[TranscriptWriter] open failed: " + path + L"\n").c_str());
+            continue;
+        }
+        if (i == 1) sink.buffers[i] = "WEBVTT\n\n";
+    }
+    return sink;
+}
+
+void TranscriptWriter::CloseSinks()
+{
+    for (auto& item : sinks_) {
+        for (FILE*& f : item.second.files) {
+            if (f) fclose(f);
+            f = nullptr;
+        }
+    }
+    sinks_.clear();
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "types/types.h"
+
+// 输出格式，可按位组合
+enum SubtitleFormat : uint32_t {
+    kSubtitleSrt = 1 << 0,
+    kSubtitleWebVtt = 1 << 1,
+    kSubtitleJsonl = 1 << 2,
+};
+
+// 何时把文件内容刷到磁盘（FlushFileBuffers）
+enum class FsyncPolicy {
+    kNever,        // 只写入系统缓存，由系统决定落盘时机
+    kInterval,     // 每隔 fsync_interval_ms 刷一次
+    kEveryBatch,   // 每批写完都刷，崩溃时最多丢失一批
+};
+
+struct TranscriptWriterOptions {
+    std::wstring directory;                   // 输出目录，不存在时自动创建
+    uint32_t formats = kSubtitleSrt | kSubtitleWebVtt | kSubtitleJsonl;
+    int32_t batch_interval_ms = 500;          // 写线程的攒批周期
+    size_t wake_batch = 64;                   // 积压达到此条数时提前唤醒写线程
+    size_t max_pending = 4096;                // 积压上限，超过时丢弃新条目，保证生产者不被拖慢
+    FsyncPolicy fsync = FsyncPolicy::kInterval;
+    int32_t fsync_interval_ms = 5000;
+};
+
+struct TranscriptWriterStats {
+    uint64_t submitted = 0;   // Submit 接收的条目
+    uint64_t written = 0;     // 已写入文件的条目
+    uint64_t dropped = 0;     // 因积压超限丢弃的条目
+    uint64_t batches = 0;     // 写线程处理的批次
+    uint64_t fsyncs = 0;      // FlushFileBuffers 调用次数
+    uint64_t bytes = 0;       // 写入的字节数（所有格式合计）
+};
+
+// 异步转写落盘：识别线程只做一次加锁入队，格式化、写文件、刷盘都在独立的写线程完成
+// 每个音源（RecognitionMessage::source_id）各自一组文件，SRT 序号各自计数
+// 文件名：<directory>\<session>-<source>.srt / .vtt / .jsonl
+class TranscriptWriter {
+public:
+    explicit TranscriptWriter(const TranscriptWriterOptions& options);
+    ~TranscriptWriter();
+
+    TranscriptWriter(const TranscriptWriter&) = delete;
+    TranscriptWriter& operator=(const TranscriptWriter&) = delete;
+
+    // 开始一次会话，session 为文件名前缀
+    bool Start(const std::wstring& session);
+    // 写完积压的条目、刷盘并关闭文件
+    void Stop();
+    // 会话已打开，Submit 的条目会落盘
+    bool Running() const;
+
+    // 任意线程调用，只接收 is_final 的结果
+    void Submit(const RecognitionMessage& msg);
+
+    TranscriptWriterStats Stats() const;
+
+private:
+    struct Entry {
+        std::string source_id;
+        int64_t begin_ms;
+        int64_t end_ms;
+        std::string text;
+    };
+
+    // 一个音源的一组输出文件
+    struct Sink {
+        FILE* files[3] = { nullptr, nullptr, nullptr };
+        std::string buffers[3];   // 本批待写入的内容，每批每个文件只调用一次 fwrite
+        uint64_t sequence = 0;
+    };
+
+    void WriteLoop();
+    void WriteBatch(std::vector<Entry>& batch);
+    void FlushSinks(bool fsync);
+    Sink& GetSink(const std::string& source_id);
+    void CloseSinks();
+
+    TranscriptWriterOptions options_;
+    std::wstring session_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Entry> pending_;
+    bool stopping_ = false;
+    bool running_ = false;
+    TranscriptWriterStats stats_;
+
+    // 以下只由写线程访问
+    std::thread thread_;
+    std::map<std::string, Sink> sinks_;
+};
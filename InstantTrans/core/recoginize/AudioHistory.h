@@ -0,0 +1,70 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 固定容量的环形音频历史，按绝对采样序号寻址
+// 写满后覆盖最旧的数据，裁剪是 O(1) 的，长时间运行内存保持不变
+class AudioHistory {
+public:
+    explicit AudioHistory(size_t capacity) : data_(capacity, 0.0f) {}
+
+    void Append(const float* samples, size_t n) {
+        const size_t cap = data_.size();
+        // 超过容量的部分只保留最后 cap 个采样
+        if (n > cap) {
+            samples += n - cap;
+            end_ += n - cap;
+            n = cap;
+        }
+        size_t pos = static_cast<size_t>(end_ % cap);
+        size_t first = std::min(n, cap - pos);
+        std::memcpy(data_.data() + pos, samples, first * sizeof(float));
+        std::memcpy(data_.data(), samples + first, (n - first) * sizeof(float));
+        end_ += n;
+    }
+
+    // 最旧的可用采样序号
+    int64_t Begin() const {
+        return std::max<int64_t>(0, end_ - static_cast<int64_t>(data_.size()));
+    }
+
+    // 最新采样之后的序号
+    int64_t End() const { return end_; }
+
+    size_t Capacity() const { return data_.size(); }
+
+    // 返回 [from, from + n) 的连续指针；跨越环尾时拷贝到 scratch（至少 n 个元素）
+    const float* Data(int64_t from, size_t n, float* scratch) const {
+        const size_t cap = data_.size();
+        size_t pos = static_cast<size_t>(from % cap);
+        if (pos + n <= cap) return data_.data() + pos;
+        CopyTo(from, from + static_cast<int64_t>(n), scratch);
+        return scratch;
+    }
+
+    // 把 [from, to) 拷贝到 out，out 的容量会被复用
+    void Read(int64_t from, int64_t to, std::vector<float>* out) const {
+        from = std::max(from, Begin());
+        to = std::min(to, end_);
+        out->resize(to > from ? static_cast<size_t>(to - from) : 0);
+        if (!out->empty()) CopyTo(from, to, out->data());
+    }
+
+    // 只重置序号，不释放内存
+    void Clear() { end_ = 0; }
+
+private:
+    void CopyTo(int64_t from, int64_t to, float* out) const {
+        const size_t cap = data_.size();
+        size_t n = static_cast<size_t>(to - from);
+        size_t pos = static_cast<size_t>(from % cap);
+        size_t first = std::min(n, cap - pos);
+        std::memcpy(out, data_.data() + pos, first * sizeof(float));
+        std::memcpy(out + first, data_.data(), (n - first) * sizeof(float));
+    }
+
+    std::vector<float> data_;
+    int64_t end_ = 0;
+};
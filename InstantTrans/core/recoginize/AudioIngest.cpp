@@ -0,0 +1,176 @@
+#include "AudioIngest.h"
+
+#include <algorithm>
+
+AudioIngestQueue::AudioIngestQueue(size_t chunk_samples, size_t max_chunks)
+    : chunk_samples_(chunk_samples), max_chunks_(max_chunks)
+{
+    assembling_.samples.reserve(chunk_samples_);
+    assembling_.silent = true;
+    overflow_metric_ = metrics::Registry::Instance().GetCounter(
+        "instanttrans_ingest_overflow_chunks_total", "Chunks dropped because the recognizer fell behind");
+}
+
+void AudioIngestQueue::Push(const float* samples, size_t n, bool silent)
+{
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.packets;
+        notify = AppendLocked(samples, n, silent);
+    }
+    if (notify) cv_.notify_one();
+}
+
+void AudioIngestQueue::MarkDiscontinuity()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.discontinuities;
+    pending_discontinuity_ = true;
+}
+
+void AudioIngestQueue::MarkGap(size_t lost_samples, size_t max_fill)
+{
+    static const float zeros[320] = { 0 };
+
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.gaps;
+        stats_.gap_samples += lost_samples;
+        pending_discontinuity_ = true;
+
+        for (size_t fill = std::min(lost_samples, max_fill); fill > 0;) {
+            size_t n = std::min(fill, sizeof(zeros) / sizeof(zeros[0]));
+            notify = AppendLocked(zeros, n, true) || notify;
+            fill -= n;
+        }
+
+        // 超出补零上限的部分不进入识别，但仍推进音频时钟
+        if (lost_samples > max_fill) {
+            if (!assembling_.samples.empty()) {
+                EmitLocked();
+                notify = true;
+            }
+            clock_samples_ += static_cast<int64_t>(lost_samples - max_fill);
+        }
+    }
+    if (notify) cv_.notify_one();
+}
+
+void AudioIngestQueue::Flush()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (assembling_.samples.empty()) return;
+        EmitLocked();
+    }
+    cv_.notify_one();
+}
+
+bool AudioIngestQueue::Pop(AudioChunk& out)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !ready_.empty() || stopped_; });
+    if (ready_.empty()) return false;
+
+    AudioChunk& front = ready_.front();
+    std::swap(out.samples, front.samples);
+    out.silent = front.silent;
+    out.discontinuity = front.discontinuity;
+    out.start_sample = front.start_sample;
+
+    // front 现在持有调用方旧的缓冲，放回池中复用
+    front.samples.clear();
+    if (front.samples.capacity() >= chunk_samples_) pool_.push_back(std::move(front.samples));
+    ready_.pop_front();
+    return true;
+}
+
+size_t AudioIngestQueue::QueuedSamples() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ready_.size() * chunk_samples_ + assembling_.samples.size();
+}
+
+void AudioIngestQueue::ReleaseBuffers()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) std::deque<AudioChunk>().swap(ready_);
+    std::vector<std::vector<float>>().swap(pool_);
+}
+
+void AudioIngestQueue::Start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = false;
+    ready_.clear();
+    assembling_.samples.clear();
+    assembling_.silent = true;
+    pending_discontinuity_ = false;
+    clock_samples_ = 0;
+    stats_ = IngestStats();
+}
+
+void AudioIngestQueue::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+}
+
+IngestStats AudioIngestQueue::Stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool AudioIngestQueue::AppendLocked(const float* samples, size_t n, bool silent)
+{
+    bool emitted = false;
+    while (n > 0) {
+        size_t take = std::min(n, chunk_samples_ - assembling_.samples.size());
+        assembling_.samples.insert(assembling_.samples.end(), samples, samples + take);
+        assembling_.silent = assembling_.silent && silent;
+        samples += take;
+        n -= take;
+
+        if (assembling_.samples.size() == chunk_samples_) {
+            EmitLocked();
+            emitted = true;
+        }
+    }
+    return emitted;
+}
+
+void AudioIngestQueue::EmitLocked()
+{
+    if (ready_.size() >= max_chunks_) {
+        // 识别线程严重落后：丢弃最旧的块，并标记下一块不连续
+        ready_.front().samples.clear();
+        pool_.push_back(std::move(ready_.front().samples));
+        ready_.pop_front();
+        ++stats_.overflow_chunks;
+        overflow_metric_->Add();
+        pending_discontinuity_ = true;
+    }
+
+    assembling_.discontinuity = pending_discontinuity_;
+    assembling_.start_sample = clock_samples_;
+    clock_samples_ += static_cast<int64_t>(assembling_.samples.size());
+    pending_discontinuity_ = false;
+    ready_.push_back(std::move(assembling_));
+    ++stats_.chunks;
+
+    assembling_ = AudioChunk();
+    if (!pool_.empty()) {
+        assembling_.samples = std::move(pool_.back());
+        pool_.pop_back();
+    }
+    else {
+        assembling_.samples.reserve(chunk_samples_);
+    }
+    assembling_.silent = true;
+}
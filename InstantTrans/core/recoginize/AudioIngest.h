@@ -0,0 +1,76 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "core/metrics/Metrics.h"
+
+// 采集线程交给识别线程的一段 16kHz 单声道音频
+struct AudioChunk {
+    std::vector<float> samples;
+    bool silent = false;         // 全部来自 AUDCLNT_BUFFERFLAGS_SILENT 数据包，内容全为 0
+    bool discontinuity = false;  // 本块之前存在丢包或设备报告的不连续
+    int64_t start_sample = 0;    // 在音频时钟上的起点：溢出丢弃和未补零的缺口也计入，保证时间戳不漂移
+};
+
+struct IngestStats {
+    uint64_t packets = 0;          // 采集端送入的数据包数
+    uint64_t chunks = 0;           // 合并后交给识别线程的块数
+    uint64_t discontinuities = 0;  // 设备报告的 DATA_DISCONTINUITY 次数
+    uint64_t gaps = 0;             // 按设备时钟检测到的缺口次数
+    uint64_t gap_samples = 0;      // 缺口总长（16kHz 采样数）
+    uint64_t overflow_chunks = 0;  // 识别线程跟不上时丢弃的块数
+};
+
+// 与平台无关的音频接入层：
+// 把采集端大小不一的数据包合并成固定长度的块，统计缺口，识别线程阻塞等待完整的块
+class AudioIngestQueue {
+public:
+    // chunk_samples: 每块的采样数（如 16kHz 下 20ms = 320）
+    // max_chunks: 队列上限，超过时丢弃最旧的块，保证采集线程永不阻塞
+    AudioIngestQueue(size_t chunk_samples, size_t max_chunks);
+
+    // 采集线程调用
+    void Push(const float* samples, size_t n, bool silent);
+    // 设备报告不连续（AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY）
+    void MarkDiscontinuity();
+    // 设备时钟检测到的缺口，不超过 max_fill 的部分补零以保持音频时钟连续
+    void MarkGap(size_t lost_samples, size_t max_fill);
+    // 把未凑满的块也交给识别线程（停止或切换音源时）
+    void Flush();
+
+    // 识别线程调用：阻塞直到有完整的块或 Stop，out 原有的缓冲会被回收复用
+    bool Pop(AudioChunk& out);
+
+    // 已排队等待识别的采样数
+    size_t QueuedSamples() const;
+
+    // 空闲时释放回收池中的块缓冲；已停止时连同未取走的块一起释放，之后的块重新分配
+    void ReleaseBuffers();
+
+    void Start();
+    void Stop();
+
+    IngestStats Stats() const;
+
+private:
+    // 追加到正在合并的块，凑满时交出，返回是否有新块
+    bool AppendLocked(const float* samples, size_t n, bool silent);
+    void EmitLocked();
+
+    const size_t chunk_samples_;
+    const size_t max_chunks_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    AudioChunk assembling_;
+    std::deque<AudioChunk> ready_;
+    std::vector<std::vector<float>> pool_;   // 回收的块缓冲，稳态下不再分配
+    bool pending_discontinuity_ = false;
+    bool stopped_ = false;
+    int64_t clock_samples_ = 0;           // 已交出（含丢弃）的采样数，即下一块的 start_sample
+    metrics::Counter* overflow_metric_;
+    IngestStats stats_;
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// 采样格式
+enum class SampleType {
+    kFloat32,
+    kInt16,
+    kInt24,    // 3 字节紧凑存放
+    kInt32,
+};
+
+struct AudioFormat {
+    int32_t sample_rate = 0;
+    int32_t channels = 0;
+    SampleType type = SampleType::kFloat32;
+
+    int32_t BytesPerSample() const {
+        switch (type) {
+        case SampleType::kInt16: return 2;
+        case SampleType::kInt24: return 3;
+        default: return 4;
+        }
+    }
+
+    bool operator==(const AudioFormat& o) const {
+        return sample_rate == o.sample_rate && channels == o.channels && type == o.type;
+    }
+    bool operator!=(const AudioFormat& o) const { return !(*this == o); }
+};
+
+// 音源读出的一个数据包，data 在 Release 之前有效
+struct AudioPacket {
+    const uint8_t* data = nullptr;
+    uint32_t frames = 0;
+    bool silent = false;          // 内容应视为全 0
+    bool discontinuity = false;   // 设备报告与上一包不连续
+    uint64_t gap_frames = 0;      // 按设备时钟推算，本包之前丢失的帧数
+    bool converted = false;       // data 已是 16kHz 单声道 float（录音回放），不经过格式转换
+};
+
+// 音源抽象：采集线程通过它读取原始数据包，可以在运行时被替换
+class AudioSource {
+public:
+    enum class ReadStatus {
+        kData,           // 读到一个数据包
+        kTimeout,        // 等待超时或被 Interrupt 唤醒
+        kFormatChanged,  // 格式或默认设备变化，需要 Close 后重新 Open
+        kLost,           // 设备失效，需要重新 Open
+    };
+
+    virtual ~AudioSource() = default;
+
+    // 打开音源，失败返回 false，由调用方决定重试
+    virtual bool Open() = 0;
+    virtual void Close() = 0;
+
+    // Open 成功后有效
+    virtual AudioFormat Format() const = 0;
+
+    // 最多等待 timeout_ms 读取一个数据包
+    virtual ReadStatus Read(AudioPacket& packet, int32_t timeout_ms) = 0;
+    virtual void Release(const AudioPacket& packet) = 0;
+
+    // 可从其它线程调用，让阻塞中的 Read 立即返回
+    virtual void Interrupt() = 0;
+
+    virtual std::wstring Name() const = 0;
+};
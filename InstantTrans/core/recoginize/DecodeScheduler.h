@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#include "AudioHistory.h"
+#include "SpeechSplitter.h"
+#include "core/sim/Clock.h"
+
+// 语音段内的解码时机：何时在停顿处切出一块先出最终结果、何时做片段解码。
+// RecognizeLoop 按 RecognizerOptions::clock 驱动；--simulate 用同一个类按虚拟时钟驱动，两边的切块与片段节奏一致
+class DecodeScheduler {
+public:
+    explicit DecodeScheduler(const SpeechSplitter::Options& split) : splitter_(split) {}
+
+    // VAD 检测到语音；begin 为含预录的起点（历史序号）
+    void OnSpeechStart(int64_t begin, Clock::time_point now) {
+        active_ = true;
+        split_ = false;
+        begin_ = begin;
+        last_decode_ = now;
+    }
+    // VAD 吐出语音段，段尾的最终结果已出
+    void OnSpeechEnd() { active_ = false; }
+
+    bool Active() const { return active_; }
+    // 当前语音段（含预录）中尚未出最终结果部分的起点
+    int64_t SpeechBegin() const { return begin_; }
+    // 当前语音段已切出过块，段尾只解码剩余部分
+    bool Split() const { return split_; }
+
+    // 在 [SpeechBegin, history.End()) 中找切点；切出的块解码完成后调用 OnCut
+    SpeechSplitter::Cut FindCut(const AudioHistory& history, int32_t sample_rate, float* scratch) const {
+        SpeechSplitter::Cut cut = splitter_.FindCut(history, begin_, history.End(), sample_rate, scratch);
+        if (cut.pos <= begin_) cut.pos = -1;
+        return cut;
+    }
+    void OnCut(int64_t pos, Clock::time_point now) {
+        begin_ = pos;
+        split_ = true;
+        last_decode_ = now;
+    }
+
+    // 片段解码间隔从上次解码完成算起，解码慢时节奏自动放缓
+    bool PartialDue(int32_t interval_ms, Clock::time_point now) const {
+        return active_ && std::chrono::duration_cast<std::chrono::milliseconds>(now - last_decode_).count() > interval_ms;
+    }
+    void OnPartialDecoded(Clock::time_point now) { last_decode_ = now; }
+
+private:
+    SpeechSplitter splitter_;
+    bool active_ = false;
+    bool split_ = false;
+    int64_t begin_ = 0;
+    Clock::time_point last_decode_{};
+};
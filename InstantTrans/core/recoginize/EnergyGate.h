@@ -0,0 +1,100 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ENERGY_GATE_SSE2 1
+#endif
+
+// Silero VAD 之前的廉价能量门限
+// 明显静音时跳过神经网络 VAD；打开/关闭使用不同阈值并带拖尾，避免语音起始被截断
+class EnergyGate {
+public:
+    struct Options {
+        float open_dbfs = -50.0f;      // 窗口能量高于此值时打开
+        float close_dbfs = -60.0f;     // 连续低于此值 hangover_windows 个窗口后关闭
+        int32_t hangover_windows = 16; // 512 点窗口下约 0.5 s，需大于 VAD 的 min_silence_duration
+        int32_t preroll_windows = 8;   // 打开时补送给 VAD 的历史窗口数
+    };
+
+    enum class Decision {
+        kSkip,   // 门限关闭，不送 VAD
+        kFeed,   // 门限打开，正常送 VAD
+        kOpen,   // 本窗口触发打开，调用方应先补送 preroll 窗口
+    };
+
+    EnergyGate() : EnergyGate(Options()) {}
+
+    explicit EnergyGate(const Options& opt) : opt_(opt) {
+        open_threshold_ = DbfsToMeanSquare(opt.open_dbfs);
+        close_threshold_ = DbfsToMeanSquare(opt.close_dbfs);
+    }
+
+    // known_silent: 窗口完全来自 AUDCLNT_BUFFERFLAGS_SILENT 数据包，无需计算能量
+    // vad_active: VAD 仍处于语音段中时不允许关闭，保证段尾的静音能送达 VAD
+    Decision Process(const float* window, int32_t n, bool known_silent, bool vad_active) {
+        float level = known_silent ? 0.0f : MeanSquare(window, n);
+
+        if (!open_) {
+            if (level >= open_threshold_) {
+                open_ = true;
+                quiet_windows_ = 0;
+                return Decision::kOpen;
+            }
+            return Decision::kSkip;
+        }
+
+        if (level < close_threshold_ && !vad_active) {
+            if (++quiet_windows_ > opt_.hangover_windows) {
+                open_ = false;
+                return Decision::kSkip;
+            }
+        }
+        else {
+            quiet_windows_ = 0;
+        }
+        return Decision::kFeed;
+    }
+
+    void Reset() {
+        open_ = false;
+        quiet_windows_ = 0;
+    }
+
+    bool IsOpen() const { return open_; }
+    int32_t PrerollWindows() const { return opt_.preroll_windows; }
+
+    // 均方能量，SSE2 下每次处理 8 个采样
+    static float MeanSquare(const float* x, int32_t n) {
+        if (n <= 0) return 0.0f;
+        int32_t i = 0;
+        float sum = 0.0f;
+#ifdef ENERGY_GATE_SSE2
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (; i + 8 <= n; i += 8) {
+            __m128 a = _mm_loadu_ps(x + i);
+            __m128 b = _mm_loadu_ps(x + i + 4);
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(a, a));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(b, b));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, _mm_add_ps(acc0, acc1));
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+        for (; i < n; ++i) sum += x[i] * x[i];
+        return sum / n;
+    }
+
+    static float DbfsToMeanSquare(float dbfs) {
+        return std::pow(10.0f, dbfs / 10.0f);
+    }
+
+private:
+    Options opt_;
+    float open_threshold_ = 0.0f;
+    float close_threshold_ = 0.0f;
+    bool open_ = false;
+    int32_t quiet_windows_ = 0;
+};
@@ -0,0 +1,95 @@
+#include "FormatConverter.h"
+
+#include <cstring>
+
+void FormatConverter::Reset(const AudioFormat& in_format)
+{
+    in_ = in_format;
+    step_ = in_.sample_rate > 0 ? static_cast<double>(in_.sample_rate) / out_rate_ : 1.0;
+    position_ = 0.0;
+    last_ = 0.0f;
+}
+
+uint64_t FormatConverter::ToOutputSamples(uint64_t frames) const
+{
+    if (in_.sample_rate <= 0) return 0;
+    return frames * out_rate_ / in_.sample_rate;
+}
+
+void FormatConverter::Process(const uint8_t* data, uint32_t frames, bool silent, std::vector<float>* out)
+{
+    out->clear();
+    if (frames == 0 || in_.channels <= 0) return;
+
+    Downmix(data, frames, silent);
+    Resample(out);
+}
+
+void FormatConverter::Downmix(const uint8_t* data, uint32_t frames, bool silent)
+{
+    mono_.assign(frames, 0.0f);
+    if (silent) return;
+
+    const int32_t channels = in_.channels;
+    const float scale = 1.0f / channels;
+    const size_t frame_bytes = static_cast<size_t>(in_.BytesPerSample()) * channels;
+
+    for (uint32_t i = 0; i < frames; ++i) {
+        const uint8_t* frame = data + i * frame_bytes;
+        float sum = 0.0f;
+        for (int32_t ch = 0; ch < channels; ++ch) {
+            switch (in_.type) {
+            case SampleType::kFloat32: {
+                float v;
+                std::memcpy(&v, frame + ch * 4, 4);
+                sum += v;
+                break;
+            }
+            case SampleType::kInt16: {
+                int16_t v;
+                std::memcpy(&v, frame + ch * 2, 2);
+                sum += v / 32768.0f;
+                break;
+            }
+            case SampleType::kInt24: {
+                const uint8_t* p = frame + ch * 3;
+                // 先按无符号拼到高 24 位，再转有符号，避免移入符号位
+                uint32_t u = (static_cast<uint32_t>(p[2]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+                    | (static_cast<uint32_t>(p[0]) << 8);
+                sum += (static_cast<int32_t>(u) >> 8) / 8388608.0f;
+                break;
+            }
+            case SampleType::kInt32: {
+                int32_t v;
+                std::memcpy(&v, frame + ch * 4, 4);
+                sum += v / 2147483648.0f;
+                break;
+            }
+            }
+        }
+        mono_[i] = sum * scale;
+    }
+}
+
+void FormatConverter::Resample(std::vector<float>* out)
+{
+    const int64_t n = static_cast<int64_t>(mono_.size());
+    if (in_.sample_rate == out_rate_) {
+        out->assign(mono_.begin(), mono_.end());
+        last_ = mono_.back();
+        return;
+    }
+
+    // 只在两侧采样都已到达时输出；position_ 落在 [-1, 0) 时左侧取上一包的末尾
+    out->reserve(static_cast<size_t>(n / step_) + 2);
+    while (position_ < n - 1) {
+        int64_t i = static_cast<int64_t>(position_ < 0 ? -1 : position_);
+        double frac = position_ - i;
+        float s0 = i < 0 ? last_ : mono_[i];
+        float s1 = mono_[i + 1];
+        out->push_back(static_cast<float>(s0 + frac * (s1 - s0)));
+        position_ += step_;
+    }
+    position_ -= n;
+    last_ = mono_.back();
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "AudioSource.h"
+
+// 任意输入格式 -> 单声道 float -> 目标采样率
+// 线性插值重采样的相位和上一包末尾采样跨包保留，包边界处没有断点
+class FormatConverter {
+public:
+    explicit FormatConverter(int32_t out_rate) : out_rate_(out_rate) {}
+
+    // 格式变化时在包边界调用，丢弃所有重采样状态
+    void Reset(const AudioFormat& in_format);
+
+    const AudioFormat& InputFormat() const { return in_; }
+
+    // 转换一个数据包，结果覆盖写入 out（容量复用）
+    void Process(const uint8_t* data, uint32_t frames, bool silent, std::vector<float>* out);
+
+    // 把 frames 个输入帧换算为输出采样数
+    uint64_t ToOutputSamples(uint64_t frames) const;
+
+private:
+    void Downmix(const uint8_t* data, uint32_t frames, bool silent);
+    void Resample(std::vector<float>* out);
+
+    int32_t out_rate_;
+    AudioFormat in_;
+    double step_ = 1.0;        // 每个输出采样前进的输入采样数
+    double position_ = 0.0;    // 下一个输出采样在当前包中的位置，可为 [-1, 0)
+    float last_ = 0.0f;        // 上一包最后一个单声道采样
+    std::vector<float> mono_;
+};
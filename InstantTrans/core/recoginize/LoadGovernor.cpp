@@ -0,0 +1,102 @@
+#define NOMINMAX
+#include "LoadGovernor.h"
+
+#include <algorithm>
+#include <string>
+
+#include "core/metrics/Log.h"
+
+static const int64_t kSampleRate = 16000;
+
+LoadGovernor::LoadGovernor(const Options& opt) : opt_(opt)
+{
+    auto& registry = metrics::Registry::Instance();
+    level_gauge_ = registry.GetGauge("instanttrans_load_level", "Load governor level (0 normal, 1 slow partials, 2 no partials, 3 light model)");
+    rtf_gauge_ = registry.GetGauge("instanttrans_load_rtf_permille", "Recognizer real-time factor, busy time per audio time x1000");
+    lag_gauge_ = registry.GetGauge("instanttrans_load_lag_milliseconds", "Audio waiting in the ingest queue");
+    for (int i = 0; i < 4; ++i) {
+        std::string labels = std::string("to=\"") + LevelName(static_cast<Level>(i)) + "\"";
+        transitions_[i] = registry.GetCounter("instanttrans_load_transitions_total", "Load governor level changes", labels);
+    }
+    level_gauge_->Set(0);
+}
+
+const char* LoadGovernor::LevelName(Level level)
+{
+    switch (level) {
+    case Level::kSlowPartials: return "slow_partials";
+    case Level::kNoPartials: return "no_partials";
+    case Level::kLightModel: return "light_model";
+    default: return "normal";
+    }
+}
+
+bool LoadGovernor::OnChunk(std::chrono::steady_clock::duration busy, size_t audio_samples, size_t lag_samples,
+    std::chrono::steady_clock::time_point now)
+{
+    window_busy_ += std::chrono::duration<double>(busy).count();
+    window_samples_ += audio_samples;
+    // 只把超出重载积压（取排空过程中的最低点）的部分算作积压
+    reload_lag_samples_ = std::min(reload_lag_samples_, lag_samples);
+    lag_samples -= reload_lag_samples_;
+    lag_samples_ = lag_samples;
+
+    const int64_t lag_ms = static_cast<int64_t>(lag_samples) * 1000 / kSampleRate;
+    lag_gauge_->Set(lag_ms);
+
+    if (window_samples_ * 1000 >= static_cast<size_t>(opt_.window_ms * kSampleRate)) {
+        float rtf = static_cast<float>(window_busy_ * kSampleRate / window_samples_);
+        rtf_ = have_rtf_ ? rtf_ + opt_.ewma_alpha * (rtf - rtf_) : rtf;
+        have_rtf_ = true;
+        rtf_gauge_->Set(static_cast<int64_t>(rtf_ * 1000));
+        window_busy_ = 0;
+        window_samples_ = 0;
+    }
+
+    bool overloaded = rtf_ > opt_.overload_rtf || lag_ms > opt_.overload_lag_ms;
+    bool idle = rtf_ < opt_.recover_rtf && lag_ms < opt_.recover_lag_ms;
+
+    if (overloaded != overloaded_) {
+        overloaded_ = overloaded;
+        overload_since_ = now;
+    }
+    if (idle != idle_) {
+        idle_ = idle;
+        idle_since_ = now;
+    }
+
+    if (now < hold_until_) return false;
+
+    // 每次变化后都要重新满足持续时间，一次只走一级
+    auto since = [&](std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(now - std::max(t, last_change_)).count();
+    };
+
+    if (overloaded_ && level_ < opt_.max_level && since(overload_since_) >= opt_.escalate_after_ms) {
+        Transition(static_cast<Level>(static_cast<int>(level_) + 1), now);
+        return true;
+    }
+    if (idle_ && level_ > Level::kNormal && since(idle_since_) >= opt_.recover_after_ms) {
+        Transition(static_cast<Level>(static_cast<int>(level_) - 1), now);
+        return true;
+    }
+    return false;
+}
+
+void LoadGovernor::OnModelReloaded(size_t lag_samples, std::chrono::steady_clock::time_point now, bool swapped)
+{
+    reload_lag_samples_ = lag_samples;
+    if (swapped) hold_until_ = now + std::chrono::milliseconds(opt_.swap_hold_ms);
+    LOG_INFO("Load", "model reloaded, backlog_ms=%lld%s", static_cast<long long>(lag_samples * 1000 / kSampleRate),
+        swapped ? ", holding level" : "");
+}
+
+void LoadGovernor::Transition(Level to, std::chrono::steady_clock::time_point now)
+{
+    LOG_INFO("Load", "%s -> %s (rtf=%.2f lag_ms=%lld)", LevelName(level_), LevelName(to), rtf_,
+        static_cast<long long>(lag_samples_ * 1000 / kSampleRate));
+    level_ = to;
+    last_change_ = now;
+    level_gauge_->Set(static_cast<int64_t>(to));
+    transitions_[static_cast<int>(to)]->Add();
+}
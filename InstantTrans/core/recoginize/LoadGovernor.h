@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#include "core/metrics/Metrics.h"
+
+// 过载保护：跟踪识别线程的实时率（处理耗时 / 消耗的音频时长）和接入队列积压，
+// 逐级降级，负载回落后逐级恢复。升级快、降级慢，避免在阈值附近来回抖动
+class LoadGovernor {
+public:
+    enum class Level {
+        kNormal = 0,        // 正常片段解码频率
+        kSlowPartials,      // 降低片段解码频率
+        kNoPartials,        // 只出最终结果
+        kLightModel,        // 同时换用更轻的模型
+    };
+
+    struct Options {
+        float overload_rtf = 0.85f;      // 实时率高于此值视为过载
+        float recover_rtf = 0.5f;        // 实时率低于此值且无积压才允许恢复
+        int32_t overload_lag_ms = 1000;  // 队列积压超过此值视为过载
+        int32_t recover_lag_ms = 200;
+        int32_t escalate_after_ms = 2000;   // 过载持续多久升一级
+        int32_t recover_after_ms = 10000;   // 空闲持续多久降一级
+        int32_t window_ms = 1000;        // 每消耗这么多音频计算一次实时率
+        float ewma_alpha = 0.3f;
+        int32_t normal_partial_ms = 200;
+        int32_t slow_partial_ms = 800;
+        int32_t swap_hold_ms = 30000;    // 换模型后至少保持这么久才再升降级，避免在两种模型间来回切换
+        Level max_level = Level::kLightModel;
+    };
+
+    LoadGovernor() : LoadGovernor(Options()) {}
+    explicit LoadGovernor(const Options& opt);
+
+    // 识别线程每处理完一个块调用：busy 为本块的处理耗时（不含等待数据），
+    // audio_samples 为本块的 16kHz 采样数，lag_samples 为处理完时队列里的积压
+    // 返回 true 表示级别发生了变化
+    bool OnChunk(std::chrono::steady_clock::duration busy, size_t audio_samples, size_t lag_samples,
+        std::chrono::steady_clock::time_point now);
+
+    // 识别线程重新加载模型后调用：加载期间积压在队列里的音频不是解码过载造成的，排空前不计入积压；
+    // swapped 表示按级别换了模型，此后 swap_hold_ms 内不再升降级
+    void OnModelReloaded(size_t lag_samples, std::chrono::steady_clock::time_point now, bool swapped);
+
+    Level CurrentLevel() const { return level_; }
+    float Rtf() const { return rtf_; }
+
+    bool PartialsEnabled() const { return level_ < Level::kNoPartials; }
+    int32_t PartialIntervalMs() const {
+        return level_ == Level::kNormal ? opt_.normal_partial_ms : opt_.slow_partial_ms;
+    }
+    bool WantsLightModel() const { return level_ >= Level::kLightModel; }
+
+    static const char* LevelName(Level level);
+
+private:
+    void Transition(Level to, std::chrono::steady_clock::time_point now);
+
+    Options opt_;
+    Level level_ = Level::kNormal;
+    float rtf_ = 0.0f;
+    bool have_rtf_ = false;
+
+    double window_busy_ = 0;      // 当前窗口累计的处理秒数
+    size_t window_samples_ = 0;
+    size_t lag_samples_ = 0;
+    size_t reload_lag_samples_ = 0;   // 重载留下的积压，随排空下调，归零后失效
+    std::chrono::steady_clock::time_point hold_until_{};
+
+    // 过载/空闲状态开始的时刻，状态中断时清零
+    std::chrono::steady_clock::time_point overload_since_{};
+    std::chrono::steady_clock::time_point idle_since_{};
+    bool overloaded_ = false;
+    bool idle_ = false;
+    std::chrono::steady_clock::time_point last_change_{};
+
+    metrics::Gauge* level_gauge_;
+    metrics::Gauge* rtf_gauge_;
+    metrics::Gauge* lag_gauge_;
+    metrics::Counter* transitions_[4];
+};
@@ -0,0 +1,141 @@
+#include "ModelFiles.h"
+
+#include <psapi.h>
+
+#pragma comment(lib, "psapi.lib")
+
+static const wchar_t* kSenseVoiceDir = L"\\sherpa-onnx-sense-voice-zh-en-ja-ko-yue-2024-07-17";
+
+std::wstring GetExeDirectory()
+{
+    TCHAR exePath[MAX_PATH] = { 0 };
+    DWORD size = GetModuleFileName(nullptr, exePath, MAX_PATH);
+    if (size == 0) {
+        return L"";
+    }
+
+    std::wstring pathStr(exePath);
+
+    // 找最后一个反斜杠，去掉文件名
+    size_t pos = pathStr.find_last_of(L"\\/");
+    if (pos != std::wstring::npos) {
+        pathStr = pathStr.substr(0, pos);
+    }
+
+    return pathStr;
+}
+
+std::string WStringToUtf8(const std::wstring& wstr)
+{
+    if (wstr.empty()) return std::string();
+
+    // 第一次调用计算所需缓冲区大小
+    int size_needed = WideCharToMultiByte(
+        CP_UTF8,                // 转为 UTF-8
+        0,                      // 默认转换标志
+        wstr.c_str(),           // 输入的 UTF-16 字符串
+        (int)wstr.size(),       // 输入长度
+        nullptr,                // 不需要输出缓冲区
+        0,
+        nullptr,
+        nullptr
+    );
+
+    std::string result(size_needed, 0);
+
+    // 第二次调用进行实际转换
+    WideCharToMultiByte(
+        CP_UTF8,
+        0,
+        wstr.c_str(),
+        (int)wstr.size(),
+        &result[0],
+        size_needed,
+        nullptr,
+        nullptr
+    );
+
+    return result;
+}
+
+void Utf8ToWStringInto(const std::string& text, std::wstring* out)
+{
+    int n = text.empty() ? 0 : MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    out->resize(static_cast<size_t>(n));
+    if (n > 0) MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &(*out)[0], n);
+}
+
+SenseVoiceModelPaths ResolveSenseVoiceModel(ModelPrecision precision)
+{
+    std::wstring dir = GetExeDirectory() + kSenseVoiceDir;
+
+    SenseVoiceModelPaths paths;
+    paths.tokens = dir + L"\\tokens.txt";
+    paths.model = dir + L"\\model.onnx";
+    paths.precision = ModelPrecision::kFp32;
+
+    if (precision == ModelPrecision::kInt8) {
+        std::wstring int8_model = dir + L"\\model.int8.onnx";
+        if (GetFileAttributesW(int8_model.c_str()) != INVALID_FILE_ATTRIBUTES) {
+            paths.model = int8_model;
+            paths.precision = ModelPrecision::kInt8;
+        }
+        else {
+            OutputDebugStringW(L"[Model] model.int8.onnx not found, falling back to fp32\n");
+        }
+    }
+    return paths;
+}
+
+size_t GetProcessRss()
+{
+    PROCESS_MEMORY_COUNTERS pmc = { 0 };
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return pmc.WorkingSetSize;
+}
+
+bool MappedFile::Open(const std::wstring& path)
+{
+    Close();
+
+    file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+        Close();
+        return false;
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+        Close();
+        return false;
+    }
+
+    view_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (!view_) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (view_) { UnmapViewOfFile(view_); view_ = nullptr; }
+    if (mapping_) { CloseHandle(mapping_); mapping_ = nullptr; }
+    if (file_ != INVALID_HANDLE_VALUE) { CloseHandle(file_); file_ = INVALID_HANDLE_VALUE; }
+    size_ = 0;
+}
+
+void MappedFile::Prefetch()
+{
+    if (!view_) return;
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<void*>(view_);
+    range.NumberOfBytes = size_;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
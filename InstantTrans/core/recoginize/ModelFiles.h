@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include <Windows.h>
+
+// 模型精度：int8 为动态量化版本，体积约为 fp32 的 1/4
+enum class ModelPrecision {
+    kFp32,
+    kInt8,
+};
+
+struct SenseVoiceModelPaths {
+    std::wstring model;
+    std::wstring tokens;
+    ModelPrecision precision = ModelPrecision::kFp32;
+};
+
+std::wstring GetExeDirectory();
+
+std::string WStringToUtf8(const std::wstring& wstr);
+
+// 转换到 out 原有的缓冲里，容量够用时不分配；显示路径逐帧转换用
+void Utf8ToWStringInto(const std::string& text, std::wstring* out);
+
+// 解析 SenseVoice 模型路径；请求 int8 但 model.int8.onnx 不存在时回退到 fp32
+SenseVoiceModelPaths ResolveSenseVoiceModel(ModelPrecision precision);
+
+// 当前进程的工作集大小（字节）
+size_t GetProcessRss();
+
+// 只读映射的模型文件，仅用作加载前的预取
+// sherpa-onnx 只接受文件路径，映射并预取后其读取直接命中页缓存；ONNX Runtime 仍把权重读进自己的内存，
+// 映射在加载后即关闭，各进程、各识别器之间不共享权重页
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::wstring& path);
+    void Close();
+
+    // 异步把整个文件读入页缓存
+    void Prefetch();
+
+    const void* Data() const { return view_; }
+    size_t Size() const { return size_; }
+
+private:
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+    const void* view_ = nullptr;
+    size_t size_ = 0;
+};
@@ -0,0 +1,131 @@
+#define NOMINMAX
+#include "ReplaySource.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <Windows.h>
+
+#include "ModelFiles.h"
+#include "core/metrics/Log.h"
+
+// 每个数据包 10ms，与 WASAPI 的典型包长相当，接入层的合并行为不受包长影响
+static const size_t kPacketSamples = recording::kSampleRate / 100;
+
+ReplaySource::ReplaySource(const std::wstring& path, const ReplayOptions& options)
+    : path_(path), options_(options)
+{
+}
+
+bool ReplaySource::Open()
+{
+    // Close 不丢弃回放位置，重新打开时接着上次的位置继续
+    if (opened_once_) return true;
+    if (!reader_.Open(path_)) {
+        LOG_WARN("Replay", "cannot open recording %s", WStringToUtf8(path_).c_str());
+        return false;
+    }
+    opened_once_ = true;
+    if (options_.start_ms > 0) reader_.Seek(options_.start_ms * recording::kSampleRate / 1000);
+    LOG_INFO("Replay", "replaying %s: %zu chunks, speed %.2f",
+        WStringToUtf8(path_).c_str(), reader_.Index().size(), options_.speed);
+    return true;
+}
+
+void ReplaySource::Close()
+{
+}
+
+AudioFormat ReplaySource::Format() const
+{
+    AudioFormat format;
+    format.sample_rate = recording::kSampleRate;
+    format.channels = 1;
+    format.type = SampleType::kFloat32;
+    return format;
+}
+
+AudioSource::ReadStatus ReplaySource::Read(AudioPacket& packet, int32_t timeout_ms)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (finished_) {
+        WaitUntil(now + std::chrono::milliseconds(timeout_ms), timeout_ms);
+        return ReadStatus::kTimeout;
+    }
+
+    if (!have_chunk_) {
+        bool rewound = false;
+        if (!reader_.Next(&chunk_)) {
+            if (options_.loop) {
+                reader_.Seek(options_.start_ms * recording::kSampleRate / 1000);
+                rewound = reader_.Next(&chunk_);
+            }
+            if (!rewound) {
+                finished_ = true;
+                LOG_INFO("Replay", "replay finished");
+                return ReadStatus::kTimeout;
+            }
+            ++loops_;
+            chunk_.flags |= recording::kChunkDiscontinuity;
+        }
+        // 首块或重新从头开始时，以此刻作为回放时间零点
+        if (rewound || base_time_ == std::chrono::steady_clock::time_point()) {
+            base_time_ = now;
+            base_us_ = chunk_.capture_us;
+        }
+        have_chunk_ = true;
+        chunk_pos_ = 0;
+    }
+
+    // 按录制时的采集时间定节奏
+    if (options_.speed > 0) {
+        int64_t us = chunk_.capture_us - base_us_
+            + static_cast<int64_t>(chunk_pos_) * 1000000 / recording::kSampleRate;
+        auto due = base_time_ + std::chrono::microseconds(static_cast<int64_t>(us / options_.speed));
+        if (due > now && !WaitUntil(due, timeout_ms)) return ReadStatus::kTimeout;
+    }
+
+    packet = AudioPacket();
+    size_t frames = std::min(kPacketSamples, chunk_.samples.size() - chunk_pos_);
+    packet.data = reinterpret_cast<const uint8_t*>(chunk_.samples.data() + chunk_pos_);
+    packet.frames = static_cast<uint32_t>(frames);
+    packet.silent = (chunk_.flags & recording::kChunkSilent) != 0;
+    packet.converted = true;
+    if (chunk_pos_ == 0) {
+        // 只含标记的块交出一个空包，只带不连续与缺口
+        packet.discontinuity = (chunk_.flags & recording::kChunkDiscontinuity) != 0;
+        packet.gap_frames = chunk_.gap_samples;
+    }
+    chunk_pos_ += frames;
+    if (chunk_pos_ >= chunk_.samples.size()) have_chunk_ = false;
+    return ReadStatus::kData;
+}
+
+void ReplaySource::Interrupt()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        interrupted_ = true;
+    }
+    cv_.notify_all();
+}
+
+bool ReplaySource::WaitUntil(std::chrono::steady_clock::time_point due, int32_t timeout_ms)
+{
+    auto limit = std::min(due, std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms));
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_until(lock, limit, [this] { return interrupted_; });
+    if (interrupted_) {
+        interrupted_ = false;
+        return false;
+    }
+    return std::chrono::steady_clock::now() >= due;
+}
+
+std::wstring ReplayPathFromEnvironment()
+{
+    wchar_t value[MAX_PATH] = { 0 };
+    size_t len = 0;
+    if (_wgetenv_s(&len, value, MAX_PATH, L"INSTANTTRANS_REPLAY") != 0 || len == 0) return std::wstring();
+    return value;
+}
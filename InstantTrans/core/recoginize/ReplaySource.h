@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include "AudioSource.h"
+#include "SessionRecorder.h"
+
+struct ReplayOptions {
+    // 1 按录制时的采集节奏回放，2 为两倍速；<= 0 不等待，尽快送出（识别跟不上时接入层会丢块）
+    double speed = 1.0;
+    // 从录音的第几毫秒（音频时钟）开始
+    int64_t start_ms = 0;
+    // 到结尾后回到起点继续，衔接处标记不连续；用于长时间运行测试
+    bool loop = false;
+};
+
+// 回放 SessionRecorder 的录音：交出的数据包已是 16kHz 单声道 float，跳过格式转换，
+// 不连续标记与缺口按录制时的顺序重现，接入层收到的采样与录制时逐位一致
+// 不循环时，回放结束后 Read 一直返回 kTimeout
+class ReplaySource : public AudioSource {
+public:
+    explicit ReplaySource(const std::wstring& path, const ReplayOptions& options = ReplayOptions());
+
+    bool Open() override;
+    void Close() override;
+    AudioFormat Format() const override;
+    ReadStatus Read(AudioPacket& packet, int32_t timeout_ms) override;
+    void Release(const AudioPacket& packet) override {}
+    void Interrupt() override;
+    std::wstring Name() const override { return L"replay:" + path_; }
+
+    bool Finished() const { return finished_; }
+    // 已经从头重放的次数，可从其它线程读取
+    uint64_t Loops() const { return loops_.load(std::memory_order_relaxed); }
+
+private:
+    // 等到 due 或被打断，返回是否到期
+    bool WaitUntil(std::chrono::steady_clock::time_point due, int32_t timeout_ms);
+
+    std::wstring path_;
+    ReplayOptions options_;
+    recording::Reader reader_;
+    recording::Chunk chunk_;
+    size_t chunk_pos_ = 0;       // 当前块中下一个要交出的采样
+    bool have_chunk_ = false;
+    bool finished_ = false;
+    std::atomic<uint64_t> loops_{ 0 };
+
+    // 回放时间零点：录音中的 base_us_ 对应 base_time_
+    std::chrono::steady_clock::time_point base_time_;
+    int64_t base_us_ = 0;
+    bool opened_once_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool interrupted_ = false;
+};
+
+// 环境变量 INSTANTTRANS_REPLAY 指定的录音文件，未设置时为空
+std::wstring ReplayPathFromEnvironment();
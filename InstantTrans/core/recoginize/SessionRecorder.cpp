@@ -0,0 +1,528 @@
+#define NOMINMAX
+#include "SessionRecorder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <Windows.h>
+
+#include "core/metrics/Log.h"
+
+namespace recording {
+
+// 文件内整数一律小端，与 x86 / ARM 上的 Windows 一致，直接按内存布局读写
+namespace {
+
+const char kFileMagic[8] = { 'I', 'T', 'R', 'E', 'C', 0, 0, 0 };
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kChunkTag = 0x4B435449;   // "ITCK"
+constexpr uint32_t kIndexTag = 0x58495449;   // "ITIX"
+constexpr size_t kFileHeaderSize = 32;
+constexpr size_t kChunkHeaderSize = 40;
+constexpr size_t kIndexEntrySize = 24;
+constexpr size_t kTrailerSize = 16;
+
+template <typename T>
+void Put(std::string* out, T v) { out->append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+template <typename T>
+T Get(const uint8_t* p) { T v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+uint32_t Bits(float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+float FromBits(uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+
+// 乘 2 是精确的，编译器是否融合乘加结果都相同，编码端与解码端的预测值逐位一致
+float Predict(const float* x, size_t i, int32_t order)
+{
+    if (order == 0 || i == 0) return 0.0f;
+    if (order == 1 || i == 1) return x[i - 1];
+    return static_cast<float>(2.0 * x[i - 1] - x[i - 2]);
+}
+
+struct ChunkHeader {
+    uint32_t flags = 0;
+    int64_t start_sample = 0;
+    int64_t capture_us = 0;
+    uint32_t samples = 0;
+    uint32_t payload_bytes = 0;
+    uint64_t gap_samples = 0;
+};
+
+void PutChunkHeader(std::string* out, const ChunkHeader& h)
+{
+    Put(out, kChunkTag);
+    Put(out, h.flags);
+    Put(out, h.start_sample);
+    Put(out, h.capture_us);
+    Put(out, h.samples);
+    Put(out, h.payload_bytes);
+    Put(out, h.gap_samples);
+}
+
+bool ParseChunkHeader(const uint8_t* p, ChunkHeader* h)
+{
+    if (Get<uint32_t>(p) != kChunkTag) return false;
+    h->flags = Get<uint32_t>(p + 4);
+    h->start_sample = Get<int64_t>(p + 8);
+    h->capture_us = Get<int64_t>(p + 16);
+    h->samples = Get<uint32_t>(p + 24);
+    h->payload_bytes = Get<uint32_t>(p + 28);
+    h->gap_samples = Get<uint64_t>(p + 32);
+    return true;
+}
+
+} // namespace
+
+void EncodeSamples(const float* samples, size_t n, int32_t order, std::string* out)
+{
+    out->clear();
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t r = Bits(samples[i]) ^ Bits(Predict(samples, i, order));
+        while (r >= 0x80) {
+            out->push_back(static_cast<char>((r & 0x7F) | 0x80));
+            r >>= 7;
+        }
+        out->push_back(static_cast<char>(r));
+    }
+}
+
+bool DecodeSamples(const uint8_t* data, size_t size, int32_t order, size_t n, std::vector<float>* out)
+{
+    out->resize(n);
+    float* x = out->data();
+    size_t pos = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t r = 0;
+        for (int32_t shift = 0;; shift += 7) {
+            if (pos >= size || shift > 28) return false;
+            uint8_t b = data[pos++];
+            r |= static_cast<uint32_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        x[i] = FromBits(r ^ Bits(Predict(x, i, order)));
+    }
+    return pos == size;
+}
+
+bool Reader::Open(const std::wstring& path)
+{
+    Close();
+    if (_wfopen_s(&file_, path.c_str(), L"rb") != 0 || !file_) {
+        file_ = nullptr;
+        return false;
+    }
+
+    uint8_t header[kFileHeaderSize];
+    if (fread(header, 1, sizeof(header), file_) != sizeof(header)
+        || std::memcmp(header, kFileMagic, sizeof(kFileMagic)) != 0
+        || Get<uint32_t>(header + 8) != kVersion
+        || Get<uint32_t>(header + 12) != static_cast<uint32_t>(kSampleRate)) {
+        Close();
+        return false;
+    }
+    start_unix_ms_ = Get<int64_t>(header + 24);
+
+    _fseeki64(file_, 0, SEEK_END);
+    int64_t file_size = _ftelli64(file_);
+    if (!ReadIndex(file_size)) ScanIndex();
+    next_ = 0;
+    return true;
+}
+
+void Reader::Close()
+{
+    if (file_) fclose(file_);
+    file_ = nullptr;
+    index_.clear();
+    next_ = 0;
+}
+
+bool Reader::ReadIndex(int64_t file_size)
+{
+    if (file_size < static_cast<int64_t>(kFileHeaderSize + kTrailerSize)) return false;
+
+    uint8_t trailer[kTrailerSize];
+    _fseeki64(file_, file_size - static_cast<int64_t>(kTrailerSize), SEEK_SET);
+    if (fread(trailer, 1, sizeof(trailer), file_) != sizeof(trailer)) return false;
+    uint64_t index_offset = Get<uint64_t>(trailer);
+    uint32_t count = Get<uint32_t>(trailer + 8);
+    if (Get<uint32_t>(trailer + 12) != kIndexTag
+        || index_offset + static_cast<uint64_t>(count) * kIndexEntrySize + kTrailerSize
+            != static_cast<uint64_t>(file_size)) return false;
+
+    std::vector<uint8_t> raw(static_cast<size_t>(count) * kIndexEntrySize);
+    _fseeki64(file_, static_cast<int64_t>(index_offset), SEEK_SET);
+    if (!raw.empty() && fread(raw.data(), 1, raw.size(), file_) != raw.size()) return false;
+
+    index_.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* p = raw.data() + static_cast<size_t>(i) * kIndexEntrySize;
+        index_[i].start_sample = Get<int64_t>(p);
+        index_[i].capture_us = Get<int64_t>(p + 8);
+        index_[i].offset = Get<uint64_t>(p + 16);
+    }
+    return true;
+}
+
+void Reader::ScanIndex()
+{
+    // 录制未正常结束：从第一块起顺着块头往后走，遇到截断或损坏的块为止
+    index_.clear();
+    uint64_t offset = kFileHeaderSize;
+    uint8_t raw[kChunkHeaderSize];
+    ChunkHeader h;
+    while (true) {
+        _fseeki64(file_, static_cast<int64_t>(offset), SEEK_SET);
+        if (fread(raw, 1, sizeof(raw), file_) != sizeof(raw) || !ParseChunkHeader(raw, &h)) break;
+        uint64_t next = offset + kChunkHeaderSize + h.payload_bytes;
+        // 确认载荷完整
+        if (h.payload_bytes > 0) {
+            _fseeki64(file_, static_cast<int64_t>(next - 1), SEEK_SET);
+            if (fgetc(file_) == EOF) break;
+        }
+        index_.push_back(IndexEntry{ h.start_sample, h.capture_us, offset });
+        offset = next;
+    }
+    LOG_WARN("Recording", "no index, recovered %zu chunks by scanning", index_.size());
+}
+
+void Reader::Seek(int64_t sample)
+{
+    auto it = std::upper_bound(index_.begin(), index_.end(), sample,
+        [](int64_t s, const IndexEntry& e) { return s < e.start_sample; });
+    next_ = it == index_.begin() ? 0 : static_cast<size_t>(it - index_.begin()) - 1;
+}
+
+bool Reader::Next(Chunk* chunk)
+{
+    if (!file_ || next_ >= index_.size()) return false;
+
+    uint8_t raw[kChunkHeaderSize];
+    ChunkHeader h;
+    _fseeki64(file_, static_cast<int64_t>(index_[next_].offset), SEEK_SET);
+    if (fread(raw, 1, sizeof(raw), file_) != sizeof(raw) || !ParseChunkHeader(raw, &h)) return false;
+
+    payload_.resize(h.payload_bytes);
+    if (h.payload_bytes > 0 && fread(&payload_[0], 1, payload_.size(), file_) != payload_.size()) return false;
+
+    chunk->flags = h.flags;
+    chunk->start_sample = h.start_sample;
+    chunk->capture_us = h.capture_us;
+    chunk->gap_samples = h.gap_samples;
+    if (h.flags & kChunkZeros) {
+        chunk->samples.assign(h.samples, 0.0f);
+    }
+    else {
+        int32_t order = static_cast<int32_t>((h.flags >> kChunkOrderShift) & 3);
+        if (!DecodeSamples(reinterpret_cast<const uint8_t*>(payload_.data()), payload_.size(),
+                order, h.samples, &chunk->samples)) {
+            LOG_WARN("Recording", "corrupt chunk at offset %llu",
+                static_cast<unsigned long long>(index_[next_].offset));
+            return false;
+        }
+    }
+    ++next_;
+    return true;
+}
+
+} // namespace recording
+
+using namespace recording;
+
+SessionRecorder::SessionRecorder(const SessionRecorderOptions& options)
+    : options_(options)
+{
+    chunk_samples_ = static_cast<size_t>(kSampleRate) * options_.chunk_ms / 1000;
+    size_t ring = 1;
+    while (ring < static_cast<size_t>(kSampleRate) * options_.ring_ms / 1000) ring <<= 1;
+    ring_.resize(ring);
+    mask_ = ring - 1;
+
+    auto& registry = metrics::Registry::Instance();
+    bytes_metric_ = registry.GetCounter("instanttrans_recorder_bytes_total", "Bytes written to session recordings");
+    dropped_metric_ = registry.GetCounter("instanttrans_recorder_dropped_samples_total",
+        "Samples the recorder dropped because its writer fell behind");
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    Stop();
+}
+
+bool SessionRecorder::Start(const std::wstring& path)
+{
+    Stop();
+    if (_wfopen_s(&file_, path.c_str(), L"wb") != 0 || !file_) {
+        file_ = nullptr;
+        LOG_WARN("Recorder", "cannot create recording file");
+        return false;
+    }
+
+    std::string header(kFileMagic, sizeof(kFileMagic));
+    Put(&header, kVersion);
+    Put(&header, static_cast<uint32_t>(kSampleRate));
+    Put(&header, static_cast<uint32_t>(1));
+    Put(&header, static_cast<uint32_t>(0));
+    Put(&header, static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()));
+    fwrite(header.data(), 1, header.size(), file_);
+    offset_ = header.size();
+
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    overflowed_.store(false, std::memory_order_relaxed);
+    dropped_samples_.store(0, std::memory_order_relaxed);
+    clock_samples_ = 0;
+    pending_ = Chunk();
+    pending_open_ = false;
+    index_.clear();
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_ = SessionRecorderStats();
+        stats_.bytes = offset_;
+    }
+    started_ = std::chrono::steady_clock::now();
+    stopping_ = false;
+    thread_ = std::thread(&SessionRecorder::WriteLoop, this);
+    active_.store(true, std::memory_order_release);
+    return true;
+}
+
+void SessionRecorder::Stop()
+{
+    if (!thread_.joinable()) return;
+    active_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+
+    CloseChunk();
+    WriteIndex();
+    fclose(file_);
+    file_ = nullptr;
+
+    SessionRecorderStats st = Stats();
+    LOG_INFO("Recorder", "samples=%llu chunks=%llu bytes=%llu (%.2fx) dropped=%llu",
+        static_cast<unsigned long long>(st.samples), static_cast<unsigned long long>(st.chunks),
+        static_cast<unsigned long long>(st.bytes),
+        st.bytes > 0 ? st.samples * 4.0 / st.bytes : 0.0,
+        static_cast<unsigned long long>(st.dropped_samples));
+}
+
+void SessionRecorder::OnSamples(const float* samples, size_t n, bool silent)
+{
+    if (n == 0) return;
+    Produce(silent ? kSilentSamples : kSamples, static_cast<uint32_t>(n), samples);
+}
+
+void SessionRecorder::OnDiscontinuity()
+{
+    Produce(kDiscontinuity, 0, nullptr);
+}
+
+void SessionRecorder::OnGap(uint64_t lost_samples)
+{
+    if (lost_samples == 0) return;
+    Produce(kGap, static_cast<uint32_t>(std::min<uint64_t>(lost_samples, UINT32_MAX)), nullptr);
+}
+
+SessionRecorderStats SessionRecorder::Stats() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    SessionRecorderStats st = stats_;
+    st.dropped_samples = dropped_samples_.load(std::memory_order_relaxed);
+    return st;
+}
+
+bool SessionRecorder::Produce(RecordKind kind, uint32_t count, const float* samples)
+{
+    if (!active_.load(std::memory_order_acquire)) return false;
+
+    const size_t words = kHeaderWords + (samples ? count : 0);
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    if (words > ring_.size() - (head - tail)) {
+        // 写线程跟不上：丢弃本条，下一条记录带上丢弃标记
+        overflowed_.store(true, std::memory_order_relaxed);
+        if (samples) {
+            dropped_samples_.fetch_add(count, std::memory_order_relaxed);
+            dropped_metric_->Add(count);
+        }
+        return false;
+    }
+
+    const uint32_t dropped = overflowed_.exchange(false, std::memory_order_relaxed) ? 1u : 0u;
+    const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started_).count();
+    const uint32_t header[kHeaderWords] = { kind | (dropped << 8), count,
+        static_cast<uint32_t>(us), static_cast<uint32_t>(static_cast<uint64_t>(us) >> 32) };
+    for (size_t i = 0; i < kHeaderWords; ++i) ring_[(head + i) & mask_] = header[i];
+    if (samples) {
+        for (uint32_t i = 0; i < count; ++i) ring_[(head + kHeaderWords + i) & mask_] = Bits(samples[i]);
+    }
+    head_.store(head + words, std::memory_order_release);
+    return true;
+}
+
+void SessionRecorder::WriteLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait_for(lock, std::chrono::milliseconds(options_.poll_interval_ms), [this] { return stopping_; });
+        bool stopping = stopping_;
+        lock.unlock();
+        Drain();
+        if (file_) fflush(file_);
+        lock.lock();
+        if (stopping) break;
+    }
+}
+
+bool SessionRecorder::Drain()
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    if (tail == head) return false;
+
+    while (tail != head) {
+        const uint32_t word0 = ring_[tail & mask_];
+        const uint32_t count = ring_[(tail + 1) & mask_];
+        const int64_t us = static_cast<int64_t>(ring_[(tail + 2) & mask_]
+            | static_cast<uint64_t>(ring_[(tail + 3) & mask_]) << 32);
+        const uint32_t kind = word0 & 0xFF;
+
+        if (word0 >> 8) {
+            CloseChunk();
+            pending_.flags |= kChunkDropped | kChunkDiscontinuity;
+            pending_.capture_us = us;
+            pending_open_ = true;
+        }
+        Consume(kind, count, us, tail + kHeaderWords);
+
+        tail += kHeaderWords + (kind == kSamples || kind == kSilentSamples ? count : 0);
+        tail_.store(tail, std::memory_order_release);
+    }
+    return true;
+}
+
+void SessionRecorder::Consume(uint32_t kind, uint32_t count, int64_t capture_us, size_t pos)
+{
+    switch (kind) {
+    case kDiscontinuity:
+        if (!pending_.samples.empty()) CloseChunk();
+        if (!pending_open_) pending_.capture_us = capture_us;
+        pending_.flags |= kChunkDiscontinuity;
+        pending_open_ = true;
+        return;
+
+    case kGap:
+        // 每个缺口单独成块，回放时逐个交给 MarkGap，补零上限的效果与录制时相同
+        if (!pending_.samples.empty() || pending_.gap_samples > 0) CloseChunk();
+        if (!pending_open_) pending_.capture_us = capture_us;
+        pending_.gap_samples = count;
+        clock_samples_ += count;
+        pending_open_ = true;
+        return;
+
+    default: {
+        const bool silent = kind == kSilentSamples;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!pending_.samples.empty() && ((pending_.flags & kChunkSilent) != 0) != silent) CloseChunk();
+            if (pending_.samples.empty()) {
+                pending_.start_sample = clock_samples_;
+                pending_.capture_us = capture_us + static_cast<int64_t>(i) * 1000000 / kSampleRate;
+                if (silent) pending_.flags |= kChunkSilent;
+                pending_open_ = true;
+            }
+            pending_.samples.push_back(FromBits(ring_[(pos + i) & mask_]));
+            if (pending_.samples.size() >= chunk_samples_) CloseChunk();
+        }
+        return;
+    }
+    }
+}
+
+void SessionRecorder::CloseChunk()
+{
+    if (!pending_open_ || !file_) return;
+
+    ChunkHeader h;
+    h.flags = pending_.flags;
+    h.start_sample = pending_.samples.empty() ? clock_samples_ : pending_.start_sample;
+    h.capture_us = pending_.capture_us;
+    h.samples = static_cast<uint32_t>(pending_.samples.size());
+    h.gap_samples = pending_.gap_samples;
+
+    const float* x = pending_.samples.data();
+    const size_t n = pending_.samples.size();
+    bool zeros = std::all_of(pending_.samples.begin(), pending_.samples.end(),
+        [](float v) { return Bits(v) == 0; });
+    best_.clear();
+    if (zeros) {
+        h.flags |= kChunkZeros;
+    }
+    else {
+        int32_t best_order = 0;
+        EncodeSamples(x, n, 0, &best_);
+        for (int32_t order = 1; order <= 2; ++order) {
+            EncodeSamples(x, n, order, &buffer_);
+            if (buffer_.size() < best_.size()) {
+                best_.swap(buffer_);
+                best_order = order;
+            }
+        }
+        h.flags |= static_cast<uint32_t>(best_order) << kChunkOrderShift;
+    }
+    h.payload_bytes = static_cast<uint32_t>(best_.size());
+
+    buffer_.clear();
+    PutChunkHeader(&buffer_, h);
+    fwrite(buffer_.data(), 1, buffer_.size(), file_);
+    if (!best_.empty()) fwrite(best_.data(), 1, best_.size(), file_);
+    index_.push_back(IndexEntry{ h.start_sample, h.capture_us, offset_ });
+
+    const uint64_t bytes = buffer_.size() + best_.size();
+    offset_ += bytes;
+    clock_samples_ += static_cast<int64_t>(n);
+    bytes_metric_->Add(bytes);
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.samples += n;
+        ++stats_.chunks;
+        stats_.bytes += bytes;
+    }
+
+    pending_.flags = 0;
+    pending_.gap_samples = 0;
+    pending_.samples.clear();
+    pending_open_ = false;
+}
+
+void SessionRecorder::WriteIndex()
+{
+    buffer_.clear();
+    for (const IndexEntry& e : index_) {
+        Put(&buffer_, e.start_sample);
+        Put(&buffer_, e.capture_us);
+        Put(&buffer_, e.offset);
+    }
+    Put(&buffer_, offset_);
+    Put(&buffer_, static_cast<uint32_t>(index_.size()));
+    Put(&buffer_, kIndexTag);
+    fwrite(buffer_.data(), 1, buffer_.size(), file_);
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.bytes += buffer_.size();
+}
+
+bool RecordingEnabledFromEnvironment()
+{
+    char value[16] = { 0 };
+    size_t len = 0;
+    return getenv_s(&len, value, sizeof(value), "INSTANTTRANS_RECORD") == 0 && len > 0
+        && value[0] != '\0' && std::strcmp(value, "0") != 0;
+}
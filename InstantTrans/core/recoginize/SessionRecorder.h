@@ -0,0 +1,167 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/metrics/Metrics.h"
+
+// 会话录音文件（.itrec）：采集线程转换后的 16kHz 单声道 float 流，按块无损压缩，文件尾带索引
+//   文件头  "ITREC" 版本、采样率、声道数、开始录制的 UTC 毫秒
+//   块      "ITCK" 标志、音频时钟起点、采集时间（录制开始后的微秒）、采样数、块前缺口、载荷
+//   索引    每块的音频时钟起点 / 采集时间 / 文件偏移，末尾 "ITIX" 条数与索引偏移
+// 进程异常退出时没有索引，读取端顺序扫描各块重建
+namespace recording {
+
+constexpr int32_t kSampleRate = 16000;
+
+enum ChunkFlags : uint32_t {
+    kChunkSilent = 1 << 0,          // 全部来自静音包（AudioChunk::silent 的来源）
+    kChunkDiscontinuity = 1 << 1,   // 块前设备报告不连续
+    kChunkDropped = 1 << 2,         // 块前有数据因录音跟不上被丢弃，此处回放不再逐位一致
+    kChunkZeros = 1 << 3,           // 采样全为 +0.0，无载荷
+    kChunkOrderShift = 8,           // bit 8-9：预测阶数 0/1/2
+};
+
+// 解码后的一块
+struct Chunk {
+    uint32_t flags = 0;
+    int64_t start_sample = 0;       // 音频时钟起点，缺口已计入
+    int64_t capture_us = 0;         // 首个采样送到采集线程的时刻，相对录制开始
+    uint64_t gap_samples = 0;       // 块前的缺口（AudioIngestQueue::MarkGap 的参数）
+    std::vector<float> samples;
+};
+
+struct IndexEntry {
+    int64_t start_sample = 0;
+    int64_t capture_us = 0;
+    uint64_t offset = 0;
+};
+
+// 无损编码：按阶数 0/1/2 做线性预测，实际值与预测值的位模式异或后写 varint。
+// 相邻采样越接近，异或结果的高位零越多，varint 越短；每块选字节数最少的阶数
+void EncodeSamples(const float* samples, size_t n, int32_t order, std::string* out);
+bool DecodeSamples(const uint8_t* data, size_t size, int32_t order, size_t n, std::vector<float>* out);
+
+// 顺序或按音频时钟定位读取录音文件
+class Reader {
+public:
+    ~Reader() { Close(); }
+
+    bool Open(const std::wstring& path);
+    void Close();
+
+    // 开始录制时的 UTC 毫秒
+    int64_t StartUnixMs() const { return start_unix_ms_; }
+    const std::vector<IndexEntry>& Index() const { return index_; }
+
+    // 定位到包含 sample 的块，此后 Next 从该块开始
+    void Seek(int64_t sample);
+    // 读出下一块，文件结束或块损坏时返回 false
+    bool Next(Chunk* chunk);
+
+private:
+    bool ReadIndex(int64_t file_size);
+    void ScanIndex();
+    bool ReadChunkAt(uint64_t offset, Chunk* chunk, uint64_t* next_offset);
+
+    FILE* file_ = nullptr;
+    int64_t start_unix_ms_ = 0;
+    std::vector<IndexEntry> index_;
+    size_t next_ = 0;
+    std::string payload_;
+};
+
+} // namespace recording
+
+struct SessionRecorderOptions {
+    int32_t ring_ms = 4000;           // 采集线程与写线程之间的交接缓冲时长
+    int32_t chunk_ms = 1000;          // 每块的最长时长
+    int32_t poll_interval_ms = 50;    // 写线程取数据的周期
+};
+
+struct SessionRecorderStats {
+    uint64_t samples = 0;             // 写入的采样数
+    uint64_t chunks = 0;
+    uint64_t bytes = 0;               // 文件字节数
+    uint64_t dropped_samples = 0;     // 交接缓冲满时丢弃的采样数
+};
+
+// 会话录音：采集线程经无锁单生产者/单消费者环形缓冲交出数据，不加锁、不分配、不阻塞；
+// 写线程按块压缩写入 .itrec，供 ReplaySource 逐位一致地回放
+// Start / Stop 须在采集线程之外、且采集线程未运行时调用
+class SessionRecorder {
+public:
+    explicit SessionRecorder(const SessionRecorderOptions& options = SessionRecorderOptions());
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder&) = delete;
+    SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+    bool Start(const std::wstring& path);
+    // 写完交接缓冲中的数据，写入索引并关闭文件
+    void Stop();
+
+    bool Recording() const { return active_.load(std::memory_order_relaxed); }
+
+    // 以下由采集线程调用，与送入 AudioIngestQueue 的调用一一对应
+    void OnSamples(const float* samples, size_t n, bool silent);
+    void OnDiscontinuity();
+    void OnGap(uint64_t lost_samples);
+
+    SessionRecorderStats Stats() const;
+
+private:
+    // 交接缓冲中的一条记录：4 个字头，其后为 count 个采样的位模式
+    enum RecordKind : uint32_t { kSamples, kSilentSamples, kDiscontinuity, kGap };
+    static constexpr size_t kHeaderWords = 4;
+
+    bool Produce(RecordKind kind, uint32_t count, const float* samples);
+    void WriteLoop();
+    // 取出交接缓冲中的全部记录，返回是否取到
+    bool Drain();
+    void Consume(uint32_t kind, uint32_t count, int64_t capture_us, size_t pos);
+    void CloseChunk();
+    void WriteIndex();
+
+    SessionRecorderOptions options_;
+    size_t chunk_samples_;
+
+    // 环形缓冲：容量为 2 的幂，head_ 只由采集线程写，tail_ 只由写线程写
+    std::vector<uint32_t> ring_;
+    size_t mask_ = 0;
+    std::atomic<size_t> head_{ 0 };
+    std::atomic<size_t> tail_{ 0 };
+    std::atomic<bool> active_{ false };
+    std::atomic<bool> overflowed_{ false };
+    std::atomic<uint64_t> dropped_samples_{ 0 };
+    std::chrono::steady_clock::time_point started_;
+
+    // 以下只由写线程访问
+    FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    int64_t clock_samples_ = 0;
+    recording::Chunk pending_;
+    bool pending_open_ = false;
+    std::string buffer_;
+    std::string best_;
+    std::vector<recording::IndexEntry> index_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    SessionRecorderStats stats_;
+    mutable std::mutex stats_mutex_;
+
+    metrics::Counter* bytes_metric_;
+    metrics::Counter* dropped_metric_;
+};
+
+// 环境变量 INSTANTTRANS_RECORD 非空且不为 0 时录制每次会话的音频
+bool RecordingEnabledFromEnvironment();
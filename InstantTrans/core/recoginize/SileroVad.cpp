@@ -0,0 +1,358 @@
+#define NOMINMAX
+#include "SileroVad.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+#include <onnxruntime_cxx_api.h>
+
+#include "ModelFiles.h"
+#include "core/metrics/Log.h"
+
+// sherpa-onnx 在缓冲超过 max_speech_duration 后改用的判决参数
+static const float kLongSpeechThreshold = 0.9f;
+static const float kLongSpeechMinSilence = 0.1f;
+// Silero 在语音段内允许概率回落的幅度
+static const float kSpeechHysteresis = 0.15f;
+
+// -------------------- SileroVadEngine --------------------
+
+SileroVadEngine::SileroVadEngine(const SileroVadEngineOptions& options)
+    : options_(options)
+{
+    options_.max_batch = std::max(1, options_.max_batch);
+    auto& registry = metrics::Registry::Instance();
+    batches_metric_ = registry.GetCounter("instanttrans_vad_batches_total", "Batched Silero VAD inference runs");
+    windows_metric_ = registry.GetCounter("instanttrans_vad_batched_windows_total", "VAD windows evaluated by the shared engine");
+}
+
+SileroVadEngine::~SileroVadEngine() = default;
+
+bool SileroVadEngine::Load()
+{
+    try {
+        env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "InstantTransVAD");
+        Ort::SessionOptions session_options;
+        session_options.SetIntraOpNumThreads(options_.intra_threads);
+        session_options.SetInterOpNumThreads(1);
+        session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        session_ = std::make_unique<Ort::Session>(*env_, options_.model.c_str(), session_options);
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        std::set<std::string> inputs;
+        for (size_t i = 0; i < session_->GetInputCount(); ++i)
+            inputs.insert(session_->GetInputNameAllocated(i, allocator).get());
+        if (inputs != std::set<std::string>{ "input", "sr", "h", "c" }) {
+            LOG_WARN("VAD", "%s is not a Silero v4 model, shared engine disabled", WStringToUtf8(options_.model).c_str());
+            session_.reset();
+            return false;
+        }
+    }
+    catch (const Ort::Exception& e) {
+        LOG_ERROR("VAD", "failed to load %s: %s", WStringToUtf8(options_.model).c_str(), e.what());
+        session_.reset();
+        return false;
+    }
+    LOG_INFO("VAD", "Silero engine loaded: max_batch=%d gather=%dms",
+        options_.max_batch, options_.gather_ms);
+    return true;
+}
+
+void SileroVadEngine::Register(State* state)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.push_back(state);
+}
+
+void SileroVadEngine::Unregister(State* state)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.erase(std::remove(streams_.begin(), streams_.end(), state), streams_.end());
+}
+
+size_t SileroVadEngine::ExpectedLocked(std::chrono::steady_clock::time_point now) const
+{
+    const auto active = std::chrono::milliseconds(options_.active_ms);
+    size_t n = 0;
+    for (const State* s : streams_) {
+        if (now - s->last_window <= active) ++n;
+    }
+    return std::min(std::max<size_t>(n, 1), static_cast<size_t>(options_.max_batch));
+}
+
+float SileroVadEngine::Infer(State* state, const float* window)
+{
+    Request req;
+    req.state = state;
+    req.window = window;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    state->last_window = std::chrono::steady_clock::now();
+    pending_.push_back(&req);
+    arrive_cv_.notify_one();
+
+    while (!req.done) {
+        if (running_) {
+            done_cv_.wait(lock);
+            continue;
+        }
+        // 本线程替当前排队的窗口推理：等到活跃的流都已送来窗口、批已满或超时
+        running_ = true;
+        auto now = std::chrono::steady_clock::now();
+        const size_t expected = ExpectedLocked(now);
+        arrive_cv_.wait_until(lock, now + std::chrono::milliseconds(options_.gather_ms),
+            [&] { return pending_.size() >= expected; });
+
+        const size_t n = std::min(pending_.size(), static_cast<size_t>(options_.max_batch));
+        batch_.assign(pending_.begin(), pending_.begin() + n);
+        pending_.erase(pending_.begin(), pending_.begin() + n);
+        lock.unlock();
+
+        RunBatch(batch_);
+
+        lock.lock();
+        for (Request* r : batch_) r->done = true;
+        ++stats_.batches;
+        stats_.windows += n;
+        running_ = false;
+        done_cv_.notify_all();
+    }
+    return req.prob;
+}
+
+void SileroVadEngine::RunBatch(const std::vector<Request*>& batch)
+{
+    batches_metric_->Add();
+    windows_metric_->Add(batch.size());
+
+    // 至少两行，见类注释；补的行输入与状态全为零，结果丢弃
+    const size_t rows = std::max<size_t>(2, batch.size());
+    input_.assign(rows * kWindowSize, 0.0f);
+    h_.assign(2 * rows * kHiddenSize, 0.0f);
+    c_.assign(2 * rows * kHiddenSize, 0.0f);
+    for (size_t b = 0; b < batch.size(); ++b) {
+        std::memcpy(&input_[b * kWindowSize], batch[b]->window, kWindowSize * sizeof(float));
+        for (size_t layer = 0; layer < 2; ++layer) {
+            size_t offset = (layer * rows + b) * kHiddenSize;
+            std::memcpy(&h_[offset], batch[b]->state->h + layer * kHiddenSize, kHiddenSize * sizeof(float));
+            std::memcpy(&c_[offset], batch[b]->state->c + layer * kHiddenSize, kHiddenSize * sizeof(float));
+        }
+    }
+
+    try {
+        Ort::MemoryInfo memory = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        const int64_t input_shape[2] = { static_cast<int64_t>(rows), kWindowSize };
+        const int64_t state_shape[3] = { 2, static_cast<int64_t>(rows), kHiddenSize };
+        Ort::Value inputs[4] = {
+            Ort::Value::CreateTensor<float>(memory, input_.data(), input_.size(), input_shape, 2),
+            Ort::Value::CreateTensor<int64_t>(memory, &sample_rate_, 1, nullptr, 0),
+            Ort::Value::CreateTensor<float>(memory, h_.data(), h_.size(), state_shape, 3),
+            Ort::Value::CreateTensor<float>(memory, c_.data(), c_.size(), state_shape, 3),
+        };
+        static const char* kInputNames[] = { "input", "sr", "h", "c" };
+        static const char* kOutputNames[] = { "output", "hn", "cn" };
+        auto outputs = session_->Run(Ort::RunOptions{ nullptr }, kInputNames, inputs, 4, kOutputNames, 3);
+
+        const float* prob = outputs[0].GetTensorData<float>();
+        const float* hn = outputs[1].GetTensorData<float>();
+        const float* cn = outputs[2].GetTensorData<float>();
+        for (size_t b = 0; b < batch.size(); ++b) {
+            batch[b]->prob = prob[b];
+            for (size_t layer = 0; layer < 2; ++layer) {
+                size_t offset = (layer * rows + b) * kHiddenSize;
+                std::memcpy(batch[b]->state->h + layer * kHiddenSize, hn + offset, kHiddenSize * sizeof(float));
+                std::memcpy(batch[b]->state->c + layer * kHiddenSize, cn + offset, kHiddenSize * sizeof(float));
+            }
+        }
+    }
+    catch (const Ort::Exception& e) {
+        // 概率按 0 处理，这一窗判为静音，状态保持不变
+        LOG_ERROR("VAD", "batched inference failed: %s", e.what());
+        for (Request* r : batch) r->prob = 0;
+    }
+}
+
+SileroVadEngineStats SileroVadEngine::Stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// -------------------- VadStream --------------------
+
+sherpa_onnx::cxx::VoiceActivityDetector CreateSherpaVad(const SileroVadConfig& config)
+{
+    using namespace sherpa_onnx::cxx;
+
+    VadModelConfig vad_config;
+    vad_config.silero_vad.model = WStringToUtf8(config.model);
+    vad_config.silero_vad.threshold = config.threshold;
+    vad_config.silero_vad.min_silence_duration = config.min_silence_duration;
+    vad_config.silero_vad.min_speech_duration = config.min_speech_duration;
+    vad_config.silero_vad.max_speech_duration = config.max_speech_duration;
+    vad_config.sample_rate = config.sample_rate;
+    vad_config.debug = false;
+    return VoiceActivityDetector::Create(vad_config, config.buffer_seconds);
+}
+
+VadStream::VadStream(const SileroVadConfig& config, std::shared_ptr<SileroVadEngine> engine)
+    : config_(config),
+    engine_(engine && engine->Loaded() ? std::move(engine) : nullptr),
+    threshold_(config.threshold),
+    min_silence_samples_(static_cast<int64_t>(config.sample_rate * config.min_silence_duration)),
+    min_speech_samples_(static_cast<int64_t>(config.sample_rate * config.min_speech_duration)),
+    max_utterance_samples_(static_cast<int64_t>(config.sample_rate * config.max_speech_duration)),
+    buffer_(engine_ ? static_cast<size_t>(config.buffer_seconds * config.sample_rate) : 1)
+{
+    if (engine_) engine_->Register(&state_);
+    else sherpa_ = std::make_unique<sherpa_onnx::cxx::VoiceActivityDetector>(CreateSherpaVad(config_));
+}
+
+VadStream::~VadStream()
+{
+    if (engine_) engine_->Unregister(&state_);
+}
+
+bool VadStream::Valid() const
+{
+    return !sherpa_ || sherpa_->Get() != nullptr;
+}
+
+void VadStream::AcceptWaveform(const float* samples, int32_t n)
+{
+    if (sherpa_) {
+        sherpa_->AcceptWaveform(samples, n);
+        return;
+    }
+
+    if (Size() > max_utterance_samples_) {
+        threshold_ = kLongSpeechThreshold;
+        min_silence_samples_ = static_cast<int64_t>(config_.sample_rate * kLongSpeechMinSilence);
+    }
+    else {
+        threshold_ = config_.threshold;
+        min_silence_samples_ = static_cast<int64_t>(config_.sample_rate * config_.min_silence_duration);
+    }
+
+    // 调用方通常每次恰好送一个窗口，此时不经过 last_
+    const float* p = samples;
+    size_t count = static_cast<size_t>(n);
+    if (!last_.empty()) {
+        last_.insert(last_.end(), samples, samples + n);
+        p = last_.data();
+        count = last_.size();
+    }
+    const size_t window = SileroVadEngine::kWindowSize;
+    if (count < window) {
+        if (p == samples) last_.assign(samples, samples + n);
+        return;
+    }
+
+    bool is_speech = false;
+    size_t pos = 0;
+    for (; pos + window <= count; pos += window) {
+        buffer_.Append(p + pos, window);
+        bool speech = IsSpeech(p + pos);
+        is_speech = is_speech || speech;
+    }
+    if (p == samples) last_.assign(samples + pos, samples + n);
+    else last_.erase(last_.begin(), last_.begin() + pos);
+
+    const int64_t keep = 2 * SileroVadEngine::kWindowSize + min_speech_samples_;
+    if (is_speech) {
+        // 起点回推两个窗口加最短语音时长，补上触发前的部分
+        if (start_ == -1) start_ = std::max(buffer_.End() - keep, Head());
+    }
+    else {
+        if (start_ != -1 && Size() > 0) PushSegment(buffer_.End() - min_silence_samples_);
+        if (start_ == -1) head_ = std::max(Head(), buffer_.End() - keep);
+        start_ = -1;
+    }
+}
+
+bool VadStream::IsSpeech(const float* window)
+{
+    float prob = engine_->Infer(&state_, window);
+    current_sample_ += SileroVadEngine::kWindowSize;
+
+    if (prob > threshold_ && temp_end_ != 0) temp_end_ = 0;
+
+    if (prob > threshold_ && temp_start_ == 0) {
+        // 开始说话，但要持续满最短语音时长才算
+        temp_start_ = current_sample_;
+        return false;
+    }
+    if (prob > threshold_ && temp_start_ != 0 && !triggered_) {
+        if (current_sample_ - temp_start_ < min_speech_samples_) return false;
+        triggered_ = true;
+        return true;
+    }
+    if (prob < threshold_ && !triggered_) {
+        temp_start_ = 0;
+        temp_end_ = 0;
+        return false;
+    }
+    if (prob > threshold_ - kSpeechHysteresis && triggered_) return true;
+    if (prob < threshold_ && triggered_) {
+        if (temp_end_ == 0) temp_end_ = current_sample_;
+        // 尾部静音未满时仍算在语音段内
+        if (current_sample_ - temp_end_ < min_silence_samples_) return true;
+        temp_start_ = 0;
+        temp_end_ = 0;
+        triggered_ = false;
+        return false;
+    }
+    return false;
+}
+
+void VadStream::PushSegment(int64_t end)
+{
+    if (end > start_) {
+        VadSegment segment;
+        segment.start = start_;
+        buffer_.Read(start_, end, &segment.samples);
+        segments_.push_back(std::move(segment));
+    }
+    head_ = std::max(Head(), end);
+}
+
+bool VadStream::IsDetected() const
+{
+    return sherpa_ ? sherpa_->IsDetected() : start_ != -1;
+}
+
+bool VadStream::IsEmpty() const
+{
+    return sherpa_ ? sherpa_->IsEmpty() : segments_.empty();
+}
+
+const VadSegment& VadStream::Front()
+{
+    if (sherpa_) {
+        auto segment = sherpa_->Front();
+        sherpa_front_.start = segment.start;
+        sherpa_front_.samples = std::move(segment.samples);
+        return sherpa_front_;
+    }
+    return segments_.front();
+}
+
+void VadStream::Pop()
+{
+    if (sherpa_) sherpa_->Pop();
+    else segments_.pop_front();
+}
+
+void VadStream::Flush()
+{
+    if (sherpa_) {
+        sherpa_->Flush();
+        return;
+    }
+    if (start_ == -1 || Size() == 0) return;
+    const int64_t end = buffer_.End() - min_silence_samples_;
+    if (end <= start_) return;
+    PushSegment(end);
+    start_ = -1;
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AudioHistory.h"
+#include "cxx-api.h"
+#include "core/metrics/Metrics.h"
+
+namespace Ort {
+struct Env;
+struct Session;
+}
+
+// Silero VAD 的判决参数，实时识别与批处理共用
+struct SileroVadConfig {
+    std::wstring model;                  // silero_vad.onnx
+    float threshold = 0.7f;
+    float min_silence_duration = 0.15f;  // 秒
+    float min_speech_duration = 0.25f;
+    float max_speech_duration = 8.0f;    // 缓冲超过此长度后收紧门限，促使语音段尽快结束
+    float buffer_seconds = 20.0f;
+    int32_t sample_rate = 16000;
+};
+
+struct SileroVadEngineOptions {
+    std::wstring model;
+    int32_t max_batch = 32;
+    // 先到的线程等其它流的窗口凑批的最长时间；窗口周期 32ms，等得越久批越大，VAD 判决越晚
+    int32_t gather_ms = 8;
+    // 最近这么久内送过窗口的流才计入应到数，被能量门限挡住的流不拖慢凑批
+    int32_t active_ms = 100;
+    int32_t intra_threads = 1;
+};
+
+struct SileroVadEngineStats {
+    uint64_t windows = 0;
+    uint64_t batches = 0;
+
+    double MeanBatch() const { return batches > 0 ? static_cast<double>(windows) / batches : 0; }
+};
+
+// 多路音源共用的 Silero v4 推理（输入 input / sr / h / c）：各流的循环状态由流自己保存，
+// 同时到达的窗口拼成一批做一次 Run，单次调用的固定开销按批摊薄。
+// 多个识别线程可并发调用 Infer：没有推理在进行时，先到的线程在 gather_ms 内等其它流，然后替整批推理。
+// 一批只有一个窗口时补一行零输入：ONNX Runtime 对 batch=1 走另一条矩阵乘路径，末位舍入不同；
+// 补齐后每个流的概率与它和哪些流同批无关，与单独运行逐位一致
+class SileroVadEngine {
+public:
+    static constexpr int32_t kWindowSize = 512;
+    static constexpr int32_t kHiddenSize = 64;
+    static constexpr int32_t kStateSize = 2 * kHiddenSize;   // [2, batch, 64] 中属于一个流的部分
+
+    // 一个流的循环状态，由 VadStream 持有并在构造 / 析构时注册 / 注销
+    struct State {
+        float h[kStateSize] = {};
+        float c[kStateSize] = {};
+        std::chrono::steady_clock::time_point last_window;
+    };
+
+    explicit SileroVadEngine(const SileroVadEngineOptions& options);
+    ~SileroVadEngine();
+
+    SileroVadEngine(const SileroVadEngine&) = delete;
+    SileroVadEngine& operator=(const SileroVadEngine&) = delete;
+
+    // 加载模型；文件缺失或输入不是 Silero v4 时返回 false
+    bool Load();
+    bool Loaded() const { return session_ != nullptr; }
+
+    void Register(State* state);
+    void Unregister(State* state);
+
+    // 推理一个 kWindowSize 采样的窗口，更新 state，返回语音概率
+    float Infer(State* state, const float* window);
+
+    SileroVadEngineStats Stats() const;
+
+private:
+    struct Request {
+        State* state = nullptr;
+        const float* window = nullptr;
+        float prob = 0;
+        bool done = false;
+    };
+
+    size_t ExpectedLocked(std::chrono::steady_clock::time_point now) const;
+    void RunBatch(const std::vector<Request*>& batch);
+
+    SileroVadEngineOptions options_;
+    std::unique_ptr<Ort::Env> env_;
+    std::unique_ptr<Ort::Session> session_;
+    int64_t sample_rate_ = 16000;
+
+    // 拼批缓冲，只由当前推理的线程使用，容量复用
+    std::vector<float> input_;
+    std::vector<float> h_;
+    std::vector<float> c_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable arrive_cv_;   // 新窗口到达，唤醒凑批中的线程
+    std::condition_variable done_cv_;     // 一批推理结束
+    std::vector<Request*> pending_;
+    std::vector<Request*> batch_;
+    bool running_ = false;                // 已有线程在凑批或推理
+    std::vector<State*> streams_;
+    SileroVadEngineStats stats_;
+
+    metrics::Counter* batches_metric_;
+    metrics::Counter* windows_metric_;
+};
+
+struct VadSegment {
+    int64_t start = 0;
+    std::vector<float> samples;
+};
+
+// 一路音源的 VAD，接口与判决逻辑同 sherpa_onnx::cxx::VoiceActivityDetector：
+// 起止滞回、最短语音、尾部静音，缓冲超过 max_speech_duration 后门限收紧到 0.9、尾部静音缩到 0.1s。
+// 推理交给共享的 SileroVadEngine；engine 为空或未加载时退回 sherpa-onnx 自带的 VAD
+class VadStream {
+public:
+    VadStream(const SileroVadConfig& config, std::shared_ptr<SileroVadEngine> engine = nullptr);
+    ~VadStream();
+
+    VadStream(const VadStream&) = delete;
+    VadStream& operator=(const VadStream&) = delete;
+
+    // 退回 sherpa-onnx 时模型加载失败返回 false
+    bool Valid() const;
+    bool Batched() const { return sherpa_ == nullptr; }
+
+    void AcceptWaveform(const float* samples, int32_t n);
+    bool IsDetected() const;
+    bool IsEmpty() const;
+    const VadSegment& Front();
+    void Pop();
+    // 输入结束：仍在语音段中时把已有部分作为一段交出
+    void Flush();
+
+private:
+    bool IsSpeech(const float* window);
+    int64_t Head() const { return std::max(head_, buffer_.Begin()); }
+    int64_t Size() const { return buffer_.End() - Head(); }
+    void PushSegment(int64_t end);
+
+    SileroVadConfig config_;
+    std::shared_ptr<SileroVadEngine> engine_;
+    std::unique_ptr<sherpa_onnx::cxx::VoiceActivityDetector> sherpa_;
+    VadSegment sherpa_front_;
+
+    SileroVadEngine::State state_;
+
+    // Silero 逐窗判决
+    float threshold_;
+    int64_t min_silence_samples_;
+    int64_t min_speech_samples_;
+    int64_t max_utterance_samples_;
+    int64_t current_sample_ = 0;
+    int64_t temp_start_ = 0;
+    int64_t temp_end_ = 0;
+    bool triggered_ = false;
+
+    // 语音段切分
+    std::vector<float> last_;            // 不足一个窗口的尾巴
+    AudioHistory buffer_;
+    int64_t head_ = 0;                   // 缓冲中仍需保留的最早采样
+    int64_t start_ = -1;                 // 当前语音段起点，-1 表示不在语音段中
+    std::deque<VadSegment> segments_;
+};
+
+// 按 config 创建 sherpa-onnx 的 VAD，加载失败时 Get() 为空
+sherpa_onnx::cxx::VoiceActivityDetector CreateSherpaVad(const SileroVadConfig& config);
@@ -5,38 +5,83 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <condition_variable>
 #include <iostream>
 #include <mutex>
 
+#include <avrt.h>
+
 #include "sherpa-display.h"
+#include "ThreadTuning.h"
+#include "EnergyGate.h"
+#include "AudioHistory.h"
+#include "DecodeScheduler.h"
+#include "LoadGovernor.h"
+#include "FormatConverter.h"
+#include "WasapiLoopbackSource.h"
+#include "ModelFiles.h"
+#include "core/metrics/AllocStats.h"
+#include "core/metrics/Log.h"
 
 #pragma comment(lib, "ole32.lib")
 #pragma comment(lib, "oleaut32.lib")
 #pragma comment(lib, "uuid.lib")
+#pragma comment(lib, "avrt.lib")
 
-std::mutex mutex;
-std::condition_variable condition_variable;
+// 块长与采集周期参与除法和队列容量计算，超出范围时夹到边界
+static RecognizerOptions ClampOptions(RecognizerOptions options)
+{
+    auto clamp = [](int32_t* value, int32_t lo, int32_t hi, const char* name) {
+        int32_t clamped = std::clamp(*value, lo, hi);
+        if (clamped != *value) LOG_WARN("Recognizer", "%s=%d out of range [%d, %d], using %d", name, *value, lo, hi, clamped);
+        *value = clamped;
+    };
+    clamp(&options.chunk_ms, 10, 200, "chunk_ms");
+    clamp(&options.capture_period_ms, 1, 100, "capture_period_ms");
+    return options;
+}
 
-SpeechRecognizer::SpeechRecognizer(MessageBus* bus) :bus_(bus)
+SpeechRecognizer::SpeechRecognizer(MessageBus* bus, const RecognizerOptions& options)
+    :bus_(bus), options_(ClampOptions(options)),
+    ingest_(16000 * options_.chunk_ms / 1000, 30 * 1000 / options_.chunk_ms)
 {
-	
+    auto& registry = metrics::Registry::Instance();
+    source_switches_ = registry.GetCounter("instanttrans_capture_source_switches_total", "Audio source switches");
+    format_changes_ = registry.GetCounter("instanttrans_capture_format_changes_total", "Input format changes after reopen");
+    device_losses_ = registry.GetCounter("instanttrans_capture_device_losses_total", "Capture device losses");
+    lost_ms_ = registry.GetCounter("instanttrans_capture_lost_milliseconds_total", "Audio lost while switching or reopening");
+    model_loaded_ = registry.GetGauge("instanttrans_model_loaded", "Whether the recognition model is resident");
+    idle_rss_ = registry.GetGauge("instanttrans_idle_rss_bytes", "Process working set after the last idle reclamation");
+    model_unloads_ = registry.GetCounter("instanttrans_model_unloads_total", "Recognition model unloads by the idle policy");
+    resume_time_ = registry.GetHistogram("instanttrans_model_resume_seconds", "Time to reload the recognition model after an idle unload");
+
+    int32_t cores = ThreadTuning::GetLogicalCoreCount();
+    capture_core_ = (options_.capture_core >= 0 && options_.capture_core < cores)
+        ? options_.capture_core : cores - 1;
+    // 单核机器不做绑定
+    if (cores < 2) options_.pin_threads = false;
 }
 
 SpeechRecognizer::~SpeechRecognizer()
 {
 	Stop();
+    CancelIdleUnload();
 }
 
 void SpeechRecognizer::Start()
 {
+    CancelIdleUnload();
    
-    // ¼߳
+    // 启动录音线程
     stop = false;
+    ingest_.Start();
+    if (!recording_path_.empty()) recorder_.Start(recording_path_);
     capture_thread = std::thread(&SpeechRecognizer::CaptureLoop, this);
 
-    //std::cout << "Started! Please speak (Ctrl+C ֹͣ)\n";
+    //std::cout << "Started! Please speak (Ctrl+C 停止)\n";
 
     recognize_thread = std::thread(&SpeechRecognizer::RecognizeLoop, this);
 
@@ -49,28 +94,141 @@ void SpeechRecognizer::Stop()
     {
         stop = true;
 
-        if (audio_client)
-            audio_client->Stop();  // Ҫ
-
-        condition_variable.notify_all();
+        {
+            std::lock_guard<std::mutex> lock(source_mutex_);
+            if (active_source_) active_source_->Interrupt();  // 重要！
+        }
+        ingest_.Stop();
 
         if (capture_thread.joinable())
             capture_thread.join();
         if (recognize_thread.joinable())
             recognize_thread.join();
+        recorder_.Stop();
 
-        
+        // 识别线程的缓冲已随线程释放；模型保留到 stopped_unload_ms 之后，期间再 Start 直接复用
+        if (options_.idle_trim_ms > 0) {
+            ingest_.ReleaseBuffers();
+            RecordIdleRss("stopped, working buffers released");
+        }
+        ScheduleIdleUnload();
     }
 }
 
-// -------------------- WASAPI ¼߳ --------------------
+void SpeechRecognizer::SwitchSource(std::unique_ptr<AudioSource> source)
+{
+    std::lock_guard<std::mutex> lock(source_mutex_);
+    pending_source_ = std::move(source);
+    if (active_source_) active_source_->Interrupt();
+}
+
+CaptureStats SpeechRecognizer::GetCaptureStats() const
+{
+    std::lock_guard<std::mutex> lock(capture_mutex_);
+    return capture_stats_;
+}
+
+void SpeechRecognizer::CountCapture(uint64_t CaptureStats::*field, metrics::Counter* metric, uint64_t n)
+{
+    metric->Add(n);
+    std::lock_guard<std::mutex> lock(capture_mutex_);
+    capture_stats_.*field += n;
+}
+
+IdleStats SpeechRecognizer::GetIdleStats() const
+{
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    return idle_stats_;
+}
+
+// -------------------- 空闲回收 --------------------
+void SpeechRecognizer::LoadRecognizer(bool light_model)
+{
+    RecognizerOptions model_options = options_;
+    if (light_model) model_options.model_precision = ModelPrecision::kInt8;
+    int32_t threads = options_.num_threads > 0 ? options_.num_threads : tuned_threads_;
+
+    auto begin = std::chrono::steady_clock::now();
+    auto recognizer = std::make_unique<sherpa_onnx::cxx::OfflineRecognizer>(
+        threads > 0 ? CreateOfflineRecognizer(model_options, threads) : AutoTuneRecognizer());
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+
+    bool resumed = false;
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        recognizer_ = std::move(recognizer);
+        recognizer_light_ = light_model;
+        idle_stats_.model_loaded = true;
+        if (unloaded_) {
+            unloaded_ = false;
+            resumed = true;
+            ++idle_stats_.resumes;
+            idle_stats_.last_resume_ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+        }
+    }
+    model_loaded_->Set(1);
+    if (resumed) {
+        resume_time_->Record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+        LOG_INFO("Idle", "model resumed in %lld ms",
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()));
+    }
+}
+
+void SpeechRecognizer::UnloadRecognizer(const char* reason)
+{
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        if (!recognizer_) return;
+        recognizer_.reset();
+        unloaded_ = true;
+        idle_stats_.model_loaded = false;
+        ++idle_stats_.unloads;
+    }
+    model_loaded_->Set(0);
+    model_unloads_->Add();
+    RecordIdleRss(reason);
+}
+
+void SpeechRecognizer::RecordIdleRss(const char* what)
+{
+    size_t rss = GetProcessRss();
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_stats_.idle_rss = rss;
+    }
+    idle_rss_->Set(static_cast<int64_t>(rss));
+    LOG_INFO("Idle", "%s: rss_mb=%.1f", what, rss / 1048576.0);
+}
+
+void SpeechRecognizer::ScheduleIdleUnload()
+{
+    if (options_.stopped_unload_ms <= 0 || !recognizer_) return;
+    idle_cancel_ = false;
+    idle_thread_ = std::thread([this] {
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        if (idle_cv_.wait_for(lock, std::chrono::milliseconds(options_.stopped_unload_ms),
+            [this] { return idle_cancel_; })) return;
+        lock.unlock();
+        UnloadRecognizer("stopped, model unloaded");
+    });
+}
+
+void SpeechRecognizer::CancelIdleUnload()
+{
+    if (!idle_thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_cancel_ = true;
+    }
+    idle_cv_.notify_all();
+    idle_thread_.join();
+}
+
+// -------------------- 采集线程 --------------------
 void SpeechRecognizer::CaptureLoop() {
     OutputDebugStringW(L"[CaptureLoop] thread started\n");
 
-    // ȷԱָʼ (ڹ캯Ҳ)
-    IMMDeviceEnumerator* device_enum = nullptr;
-    IMMDevice* loopback_device = nullptr;
-
     HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
     {
         wchar_t buf[256];
@@ -78,239 +236,446 @@ void SpeechRecognizer::CaptureLoop() {
         OutputDebugStringW(buf);
     }
     if (FAILED(hr)) {
-        //  RPC_E_CHANGED_MODE¼Լ/˳
+        // 如果返回 RPC_E_CHANGED_MODE，记录并尝试继续/退出
         OutputDebugStringW(L"[CaptureLoop] CoInitializeEx FAILED, abort CaptureLoop\n");
         return;
     }
-    
-    try {
-  
-        hr = CoCreateInstance(
-            __uuidof(MMDeviceEnumerator),
-            nullptr,
-            CLSCTX_ALL,
-            __uuidof(IMMDeviceEnumerator),
-            reinterpret_cast<void**>(&device_enum)
-        );
-
-        {
-            wchar_t buf[256];
-            swprintf(buf, 256, L"[CaptureLoop] CoCreateInstance hr=0x%08X\n", hr);
-            OutputDebugStringW(buf);
-        }
-
-        if (FAILED(hr) || device_enum == nullptr) {
-            OutputDebugStringW(L"[CaptureLoop] CoCreateInstance failed or returned null\n");
-            CoUninitialize();
-            return;
-        }
-    }
-    catch (...) {
-        OutputDebugStringW(L"[CaptureLoop] unknown exception\n");
-        if (loopback_device) { loopback_device->Release(); loopback_device = nullptr; }
-        if (device_enum) { device_enum->Release(); device_enum = nullptr; }
-        CoUninitialize();
-        return;
-    }
 
-    hr = device_enum->GetDefaultAudioEndpoint(eRender, eConsole, &loopback_device);
-    if (FAILED(hr)) throw std::runtime_error("GetDefaultAudioEndpoint failed");
+    if (options_.pin_threads)
+        ThreadTuning::PinCurrentThread(ThreadTuning::CaptureMask(capture_core_), L"CaptureLoop");
 
-    IPropertyStore* prop_store = nullptr;
-    hr = loopback_device->OpenPropertyStore(STGM_READ, &prop_store);
-    if (SUCCEEDED(hr)) {
-        PROPVARIANT prop_var;
-        PropVariantInit(&prop_var);
-        if (SUCCEEDED(prop_store->GetValue(PKEY_Device_FriendlyName, &prop_var))) {
-            std::wcout << L"ʹ豸: " << prop_var.pwszVal << std::endl;
-        }
-        PropVariantClear(&prop_var);
-        prop_store->Release();
+    HANDLE mmcss = nullptr;
+    if (options_.boost_capture_priority) {
+        DWORD task_index = 0;
+        mmcss = AvSetMmThreadCharacteristicsW(L"Audio", &task_index);
+        if (!mmcss) SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
     }
 
-    audio_client = nullptr;
-    hr = loopback_device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr,
-        reinterpret_cast<void**>(&audio_client));
-    if (FAILED(hr)) throw std::runtime_error("Activate(IAudioClient) failed");
-
-    WAVEFORMATEX* mix_format = nullptr;
-    hr = audio_client->GetMixFormat(&mix_format);
-    if (FAILED(hr)) throw std::runtime_error("GetMixFormat failed");
-
-    bool is_float = false;
-    if (mix_format->wFormatTag == WAVE_FORMAT_IEEE_FLOAT) is_float = true;
-    else if (mix_format->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
-        WAVEFORMATEXTENSIBLE* wfex = reinterpret_cast<WAVEFORMATEXTENSIBLE*>(mix_format);
-        if (wfex->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) is_float = true;
+    std::unique_ptr<AudioSource> source;
+    {
+        std::lock_guard<std::mutex> lock(source_mutex_);
+        source = pending_source_ ? std::move(pending_source_) : std::make_unique<WasapiLoopbackSource>();
+        active_source_ = source.get();
     }
 
-    hr = audio_client->Initialize(
-        AUDCLNT_SHAREMODE_SHARED,
-        AUDCLNT_STREAMFLAGS_LOOPBACK,
-        0, 0,
-        mix_format, nullptr
-    );
-    if (FAILED(hr)) throw std::runtime_error("AudioClient Initialize failed");
-
-    IAudioCaptureClient* capture_client = nullptr;
-    hr = audio_client->GetService(__uuidof(IAudioCaptureClient),
-        reinterpret_cast<void**>(&capture_client));
-    if (FAILED(hr)) throw std::runtime_error("GetService(IAudioCaptureClient) failed");
+    FormatConverter converter(16000);
+    std::vector<float> converted;
+    bool opened = false;
+    bool interrupted = false;   // 音源切换/格式变化后，重新打开前的音频视为丢失
+    auto interrupted_at = std::chrono::steady_clock::now();
 
-    hr = audio_client->Start();
-    if (FAILED(hr)) throw std::runtime_error("AudioClient Start failed");
+    auto begin_interruption = [&]() {
+        if (!interrupted) {
+            interrupted = true;
+            interrupted_at = std::chrono::steady_clock::now();
+        }
+    };
 
     while (!stop) {
-        UINT32 num_frames = 0;
-        BYTE* data = nullptr;
-        DWORD flags = 0;
-        hr = capture_client->GetBuffer(&data, &num_frames, &flags, nullptr, nullptr);
-        if (SUCCEEDED(hr) && num_frames > 0) {
-            size_t in_samples = num_frames * mix_format->nChannels;
-            std::vector<float> float_buffer(in_samples, 0.0f);
-
-            if (!(flags & AUDCLNT_BUFFERFLAGS_SILENT)) {
-                if (is_float) {
-                    float* f = reinterpret_cast<float*>(data);
-                    for (size_t i = 0; i < in_samples; ++i) float_buffer[i] = f[i];
-                }
-                else { // PCM16 -> float
-                    short* s = reinterpret_cast<short*>(data);
-                    for (size_t i = 0; i < in_samples; ++i) float_buffer[i] = s[i] / 32768.0f;
-                }
+        // 音源切换只发生在包边界：当前包已经完整交给接入层
+        std::unique_ptr<AudioSource> next;
+        {
+            std::lock_guard<std::mutex> lock(source_mutex_);
+            if (pending_source_) {
+                next = std::move(pending_source_);
+                active_source_ = next.get();
             }
+        }
+        if (next) {
+            if (opened) source->Close();
+            source = std::move(next);
+            opened = false;
+            CountCapture(&CaptureStats::source_switches, source_switches_);
+            begin_interruption();
+        }
 
-            // ˫ƽ -> 
-            std::vector<float> mono_buffer(num_frames, 0.0f);
-            for (UINT32 i = 0; i < num_frames; ++i) {
-                float sum = 0.0f;
-                for (int ch = 0; ch < mix_format->nChannels; ++ch) {
-                    sum += float_buffer[i * mix_format->nChannels + ch];
-                }
-                mono_buffer[i] = sum / mix_format->nChannels;
+        if (!opened) {
+            if (!source->Open()) {
+                // 设备暂不可用（如正在切换），稍后重试
+                begin_interruption();
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                continue;
             }
+            opened = true;
+
+            // 在块边界重建转换/重采样状态，VAD 与识别状态不受影响
+            if (converter.InputFormat() != source->Format() && converter.InputFormat().sample_rate > 0)
+                CountCapture(&CaptureStats::format_changes, format_changes_);
+            converter.Reset(source->Format());
+
+            if (interrupted) {
+                interrupted = false;
+                auto lost = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - interrupted_at).count();
+                CountCapture(&CaptureStats::lost_ms, lost_ms_, static_cast<uint64_t>(lost));
+                // 中断期间补零（最多 1 秒），保持音频时钟连续
+                ingest_.MarkGap(static_cast<size_t>(lost * 16), 16000);
+                recorder_.OnGap(static_cast<uint64_t>(lost * 16));
+
+                wchar_t buf[256];
+                swprintf(buf, 256, L"[CaptureLoop] source reopened: %s, lost %lld ms\n",
+                    source->Name().c_str(), static_cast<long long>(lost));
+                OutputDebugStringW(buf);
+            }
+        }
 
-            // ² 16kHz
-            auto resampled = ResampleLinear(mono_buffer.data(), mono_buffer.size(),
-                mix_format->nSamplesPerSec, 16000);
+        AudioPacket packet;
+        auto status = source->Read(packet, options_.capture_period_ms);
+        if (status == AudioSource::ReadStatus::kTimeout) continue;
+
+        if (status != AudioSource::ReadStatus::kData) {
+            // 默认设备切换视同音源切换；共享模式下格式变化表现为设备失效，重新打开时再统计格式变化
+            if (status == AudioSource::ReadStatus::kFormatChanged)
+                CountCapture(&CaptureStats::source_switches, source_switches_);
+            else
+                CountCapture(&CaptureStats::device_losses, device_losses_);
+            source->Close();
+            opened = false;
+            begin_interruption();
+            continue;
+        }
 
-            {
-                std::lock_guard<std::mutex> lock(mutex);
-                samples_queue.emplace(std::move(resampled));
-            }
-            condition_variable.notify_one();
+        if (packet.discontinuity) {
+            ingest_.MarkDiscontinuity();
+            recorder_.OnDiscontinuity();
+        }
+        // 设备时钟跳变说明有数据包丢失，1 秒以内的缺口补零以保持音频时钟连续
+        if (packet.gap_frames > 0) {
+            uint64_t gap = converter.ToOutputSamples(packet.gap_frames);
+            ingest_.MarkGap(static_cast<size_t>(gap), 16000);
+            recorder_.OnGap(gap);
+        }
 
-            capture_client->ReleaseBuffer(num_frames);
+        // 合并成固定长度的块后交给识别线程，录音在写线程上压缩落盘
+        if (packet.converted) {
+            const float* samples = reinterpret_cast<const float*>(packet.data);
+            ingest_.Push(samples, packet.frames, packet.silent);
+            recorder_.OnSamples(samples, packet.frames, packet.silent);
+            source->Release(packet);
+        }
+        else {
+            converter.Process(packet.data, packet.frames, packet.silent, &converted);
+            source->Release(packet);
+            ingest_.Push(converted.data(), converted.size(), packet.silent);
+            recorder_.OnSamples(converted.data(), converted.size(), packet.silent);
         }
-        //Sleep(10);
     }
 
-    audio_client->Stop();
-    if (capture_client) capture_client->Release();
-    if (audio_client) audio_client->Release();
-    CoTaskMemFree(mix_format);
-}
+    ingest_.Flush();
+    {
+        IngestStats st = ingest_.Stats();
+        wchar_t buf[256];
+        swprintf(buf, 256, L"[CaptureLoop] packets=%llu chunks=%llu discontinuities=%llu gaps=%llu gap_ms=%llu overflow=%llu\n",
+            st.packets, st.chunks, st.discontinuities, st.gaps, st.gap_samples / 16, st.overflow_chunks);
+        OutputDebugStringW(buf);
+        CaptureStats capture = GetCaptureStats();
+        swprintf(buf, 256, L"[CaptureLoop] switches=%llu format_changes=%llu device_losses=%llu lost_ms=%llu\n",
+            capture.source_switches, capture.format_changes, capture.device_losses, capture.lost_ms);
+        OutputDebugStringW(buf);
+    }
+
+    if (mmcss) AvRevertMmThreadCharacteristics(mmcss);
 
-// -------------------- ² --------------------
-std::vector<float> SpeechRecognizer::ResampleLinear(const float* in_samples, size_t in_len, int in_rate, int out_rate) {
-    if (in_rate == out_rate) return std::vector<float>(in_samples, in_samples + in_len);
-
-    size_t out_len = static_cast<size_t>(in_len * out_rate / in_rate);
-    std::vector<float> out(out_len);
-
-    double ratio = static_cast<double>(in_len - 1) / (out_len - 1);
-    for (size_t i = 0; i < out_len; ++i) {
-        double idx = i * ratio;
-        size_t idx_int = static_cast<size_t>(idx);
-        double frac = idx - idx_int;
-        float s1 = in_samples[idx_int];
-        float s2 = (idx_int + 1 < in_len) ? in_samples[idx_int + 1] : s1;
-        out[i] = static_cast<float>(s1 + frac * (s2 - s1));
+    {
+        std::lock_guard<std::mutex> lock(source_mutex_);
+        active_source_ = nullptr;
     }
-    return out;
+    if (opened) source->Close();
+    source.reset();
+    CoUninitialize();
 }
 
 void SpeechRecognizer::RecognizeLoop()
 {
     using namespace sherpa_onnx::cxx;
 
-    auto vad = CreateVad();
-    auto recognizer = CreateOfflineRecognizer();
+    if (options_.pin_threads)
+        ThreadTuning::PinCurrentThread(ThreadTuning::DecodeMask(capture_core_), L"RecognizeLoop");
+
+    VadStream vad(VadConfig(), options_.vad_engine);
+    if (!vad.Valid()) {
+        std::cerr << "Failed to create VAD. Please check your config\n";
+        exit(-1);
+    }
+    // 上次 Stop 留下的模型直接复用；停止前换成了轻量模型的，换回配置的精度
+    if (!recognizer_ || recognizer_light_) LoadRecognizer(false);
 
     float sample_rate = 16000;
     int32_t window_size = 512; // samples
 
-    int32_t offset = 0;
-    std::vector<float> buffer;
-    bool speech_started = false;
-    auto started_time = std::chrono::steady_clock::now();
+    // 环形历史：最长语音段 + 预录 + 余量，长时间运行内存恒定
+    AudioHistory history(static_cast<size_t>(sample_rate * (kMaxSpeechSeconds + 2)));
+    const int64_t preroll = static_cast<int64_t>(sample_rate * options_.preroll_ms / 1000);
+
+    int64_t vad_pos = 0;        // 下一个待处理的 VAD 窗口起点（绝对序号）
+    int64_t fed_until = 0;      // 已送入 VAD 的位置
+    int64_t silent_from = 0;    // 从此处起的采样全部来自静音包
+    int64_t clock_skew = 0;     // 音频时钟与历史序号之差，队列溢出丢块时增大
+    Clock& clock = *options_.clock;
     //SherpaDisplay display;
 
+    auto& registry = metrics::Registry::Instance();
+    metrics::Histogram* vad_time = registry.GetHistogram("instanttrans_vad_window_seconds", "Silero VAD time per 512-sample window");
+    metrics::Histogram* decode_partial = registry.GetHistogram("instanttrans_decode_seconds", "Offline decode time", "kind=\"partial\"");
+    metrics::Histogram* decode_final = registry.GetHistogram("instanttrans_decode_seconds", "Offline decode time", "kind=\"final\"");
+    metrics::Counter* gate_skipped = registry.GetCounter("instanttrans_vad_windows_total", "VAD windows by energy gate decision", "gate=\"skip\"");
+    metrics::Counter* gate_fed = registry.GetCounter("instanttrans_vad_windows_total", "VAD windows by energy gate decision", "gate=\"feed\"");
+    metrics::Counter* gate_silent = registry.GetCounter("instanttrans_vad_silent_fast_path_total", "Windows from silent packets that skipped the energy computation");
+    metrics::Counter* partials = registry.GetCounter("instanttrans_recognition_results_total", "Recognition results posted", "kind=\"partial\"");
+    metrics::Counter* finals = registry.GetCounter("instanttrans_recognition_results_total", "Recognition results posted", "kind=\"final\"");
+    metrics::Counter* partial_post_allocs = registry.GetCounter("instanttrans_partial_post_allocations_total",
+        "Heap allocations on the recognizer thread while handing partial results to the bus");
+    metrics::Counter* finals_reused = registry.GetCounter("instanttrans_final_decodes_total", "Final results by decode path", "path=\"reused\"");
+    metrics::Counter* finals_decoded = registry.GetCounter("instanttrans_final_decodes_total", "Final results by decode path", "path=\"decoded\"");
+    metrics::Counter* reused_ms = registry.GetCounter("instanttrans_final_reused_audio_milliseconds_total", "Audio whose final decode was skipped by reusing a partial");
+    metrics::Counter* splits_valley = registry.GetCounter("instanttrans_speech_splits_total", "Long speech segments split before the VAD end", "kind=\"valley\"");
+    metrics::Counter* splits_forced = registry.GetCounter("instanttrans_speech_splits_total", "Long speech segments split before the VAD end", "kind=\"forced\"");
+    metrics::Gauge* queued = registry.GetGauge("instanttrans_ingest_queued_samples", "16kHz samples waiting for the recognizer");
+
+    EnergyGate gate;
+    SpeechSplitter::Options split_options;
+    split_options.target_ms = options_.split_target_ms;
+    split_options.max_ms = options_.split_max_ms;
+    DecodeScheduler scheduler(split_options);
+
+    // 过载时逐级降级；已经是 int8 模型时没有更轻的模型可换，最多停到只出最终结果
+    LoadGovernor::Options load_options;
+    if (options_.model_precision == ModelPrecision::kInt8)
+        load_options.max_level = LoadGovernor::Level::kNoPartials;
+    LoadGovernor governor(load_options);
+    bool light_model = false;
+    std::vector<float> window_scratch(window_size);
+    std::vector<float> decode_buffer;
+    decode_buffer.reserve(history.Capacity());
+
+    // 空闲回收：持续无语音时先释放工作缓冲，再卸载模型；检测到语音时重新加载
+    auto last_speech = std::chrono::steady_clock::now();
+    bool buffers_released = false;
+
+    // 历史序号换算为音频时钟毫秒
+    auto audio_ms = [&](int64_t pos) {
+        return (pos + clock_skew) * 1000 / static_cast<int64_t>(sample_rate);
+    };
+    const int64_t min_silence = static_cast<int64_t>(sample_rate * kMinSilenceSeconds);
+
+    // 最近一次片段解码覆盖的区间（历史序号）及结果，语音段结束时用于复用
+    struct PartialDecode {
+        bool valid = false;
+        int64_t begin = 0;
+        int64_t end = 0;
+        std::string text;
+    } last_partial;
+
+    // 发往总线的消息只有这一个：右值投递后换回上一条消息的文本缓冲，稳态下片段不再分配字符串
+    RecognitionMessage message;
+    message.recog_text.reserve(512);
+    last_partial.text.reserve(512);
+    auto post = [&](bool is_final, bool continues, int64_t begin, int64_t end) {
+        message.ts = clock.Now();
+        message.is_final = is_final;
+        message.continues = continues;
+        message.source_id = options_.source_id;
+        message.audio_begin_ms = audio_ms(begin);
+        message.audio_end_ms = audio_ms(end);
+        bus_->PostRecognition(std::move(message));
+    };
+
+    const int64_t reuse_tolerance = static_cast<int64_t>(sample_rate * options_.final_reuse_ms / 1000);
+    const float quiet_level = EnergyGate::DbfsToMeanSquare(EnergyGate::Options().close_dbfs);
+    // [from, to) 仍在历史中且每个窗口都低于关闭门限
+    auto is_quiet = [&](int64_t from, int64_t to) {
+        if (from < history.Begin() || to > history.End()) return false;
+        for (; from < to; from += window_size) {
+            int32_t n = static_cast<int32_t>(std::min<int64_t>(window_size, to - from));
+            if (EnergyGate::MeanSquare(history.Data(from, n, window_scratch.data()), n) >= quiet_level)
+                return false;
+        }
+        return true;
+    };
+    // 片段解码与语音段只差一小段静音时，两次解码的输入在语音上等价
+    auto partial_covers = [&](int64_t segment_begin, int64_t segment_end) {
+        if (!last_partial.valid || reuse_tolerance <= 0) return false;
+        if (std::abs(last_partial.begin - segment_begin) > reuse_tolerance
+            || std::abs(last_partial.end - segment_end) > reuse_tolerance) return false;
+        return is_quiet(std::min(last_partial.begin, segment_begin), std::max(last_partial.begin, segment_begin))
+            && is_quiet(std::min(last_partial.end, segment_end), std::max(last_partial.end, segment_end));
+    };
+
+    AudioChunk chunk;
     while (!stop) {
-        {
-            std::unique_lock<std::mutex> lock(mutex);
-            while (samples_queue.empty() && !stop) {
-                condition_variable.wait(lock);
+        if (!ingest_.Pop(chunk)) break;
+        auto busy_begin = std::chrono::steady_clock::now();
+        queued->Set(static_cast<int64_t>(ingest_.QueuedSamples()));
+
+        clock_skew = chunk.start_sample - history.End();
+        history.Append(chunk.samples.data(), chunk.samples.size());
+        if (!chunk.silent) silent_from = history.End();
+
+        // 识别线程落后超过历史容量时，跳过已被覆盖的数据
+        vad_pos = std::max(vad_pos, history.Begin());
+
+        // VAD：能量门限关闭时跳过 Silero 推理；不用门限时每个窗口都送 VAD
+        for (; vad_pos + window_size <= history.End(); vad_pos += window_size) {
+            const float* window = history.Data(vad_pos, window_size, window_scratch.data());
+            auto decision = EnergyGate::Decision::kFeed;
+            if (options_.energy_gate) {
+                bool known_silent = vad_pos >= silent_from;
+                if (known_silent) gate_silent->Add();
+                decision = gate.Process(window, window_size, known_silent, vad.IsDetected());
+            }
+            if (decision == EnergyGate::Decision::kSkip) {
+                gate_skipped->Add();
+                continue;
+            }
+            gate_fed->Add();
+
+            if (decision == EnergyGate::Decision::kOpen) {
+                // 补送门限关闭期间的历史窗口，避免截断语音起始
+                int64_t from = std::max({ history.Begin(), fed_until,
+                    vad_pos - static_cast<int64_t>(gate.PrerollWindows()) * window_size });
+                for (; from + window_size <= vad_pos; from += window_size) {
+                    vad.AcceptWaveform(history.Data(from, window_size, window_scratch.data()), window_size);
+                }
+                window = history.Data(vad_pos, window_size, window_scratch.data());
             }
 
-            const auto& s = samples_queue.front();
-            buffer.insert(buffer.end(), s.begin(), s.end());
-            samples_queue.pop();
+            {
+                metrics::ScopedTimer timer(vad_time);
+                vad.AcceptWaveform(window, window_size);
+            }
+            fed_until = vad_pos + window_size;
+            if (!scheduler.Active() && vad.IsDetected()) {
+                last_partial.valid = false;
+                scheduler.OnSpeechStart(std::max(history.Begin(), vad_pos - preroll), clock.Now());
+            }
         }
 
-        // VAD
-        for (; offset + window_size < buffer.size(); offset += window_size) {
-            vad.AcceptWaveform(buffer.data() + offset, window_size);
-            if (!speech_started && vad.IsDetected()) {
-                speech_started = true;
-                started_time = std::chrono::steady_clock::now();
+        if (scheduler.Active() || !vad.IsEmpty()) {
+            last_speech = std::chrono::steady_clock::now();
+            if (!recognizer_) {
+                // 语音起点已在历史中，加载期间到达的音频由接入队列缓冲；加载耗时与其积压都不计入负载
+                LoadRecognizer(light_model);
+                busy_begin = std::chrono::steady_clock::now();
+                governor.OnModelReloaded(ingest_.QueuedSamples(), busy_begin, false);
             }
+            if (buffers_released) {
+                decode_buffer.reserve(history.Capacity());
+                buffers_released = false;
+            }
+        }
+        else {
+            auto idle_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - last_speech).count();
+            if (!buffers_released && options_.idle_trim_ms > 0 && idle_ms >= options_.idle_trim_ms) {
+                std::vector<float>().swap(decode_buffer);
+                ingest_.ReleaseBuffers();
+                buffers_released = true;
+                RecordIdleRss("idle, working buffers released");
+            }
+            if (recognizer_ && options_.idle_unload_ms > 0 && idle_ms >= options_.idle_unload_ms)
+                UnloadRecognizer("idle, model unloaded");
         }
 
-        if (!speech_started) {
-            if (buffer.size() > 10 * window_size) {
-                offset -= buffer.size() - 10 * window_size;
-                buffer = { buffer.end() - 10 * window_size, buffer.end() };
+        // 长语音：在停顿处切出一块直接出最终结果，说话人继续时不必等到段尾
+        if (scheduler.Active() && vad.IsEmpty()) {
+            SpeechSplitter::Cut cut = scheduler.FindCut(history, static_cast<int32_t>(sample_rate),
+                window_scratch.data());
+            if (cut.pos >= 0) {
+                const int64_t speech_begin = scheduler.SpeechBegin();
+                history.Read(speech_begin, cut.pos, &decode_buffer);
+
+                OfflineStream stream = recognizer_->CreateStream();
+                stream.AcceptWaveform(sample_rate, decode_buffer.data(), decode_buffer.size());
+                {
+                    metrics::ScopedTimer timer(decode_final);
+                    recognizer_->Decode(&stream);
+                }
+
+                // 拷贝而不是接管临时结果的缓冲，总线上循环的缓冲保持预留的容量
+                OfflineRecognizerResult result = recognizer_->GetResult(&stream);
+                message.recog_text = result.text;
+                post(true, true, speech_begin, cut.pos);
+                finals->Add();
+                finals_decoded->Add();
+                (cut.forced ? splits_forced : splits_valley)->Add();
+
+                last_partial.valid = false;
+                scheduler.OnCut(cut.pos, clock.Now());
             }
         }
 
-        auto current_time = std::chrono::steady_clock::now();
-        const float elapsed_seconds =
-            std::chrono::duration_cast<std::chrono::milliseconds>(current_time -
-                started_time)
-            .count() /
-            1000.;
-
-        if (speech_started && elapsed_seconds > 0.2) {
-            OfflineStream stream = recognizer.CreateStream();
-            stream.AcceptWaveform(sample_rate, buffer.data(), buffer.size());
-            recognizer.Decode(&stream);
-
-            OfflineRecognizerResult result = recognizer.GetResult(&stream);
-            
-            RecognitionMessage msg;
-            msg.recog_text = result.text;
-            msg.is_final = false;
-            bus_->PostRecognition(msg);
-
-            started_time = std::chrono::steady_clock::now();
+        // VAD 已经吐出完整语音段时不再做片段解码，直接进入下面的最终解码
+        if (governor.PartialsEnabled() && scheduler.PartialDue(governor.PartialIntervalMs(), clock.Now())
+            && vad.IsEmpty()) {
+            const int64_t speech_begin = scheduler.SpeechBegin();
+            const int64_t decode_end = history.End();
+            history.Read(speech_begin, decode_end, &decode_buffer);
+
+            OfflineStream stream = recognizer_->CreateStream();
+            stream.AcceptWaveform(sample_rate, decode_buffer.data(), decode_buffer.size());
+            {
+                metrics::ScopedTimer timer(decode_partial);
+                recognizer_->Decode(&stream);
+            }
+
+            // 结果文本由 sherpa-onnx 分配；此后到上屏的路径只在已有容量内复制，识别线程这一段的分配单独计数
+            OfflineRecognizerResult result = recognizer_->GetResult(&stream);
+            uint64_t allocs_before = metrics::ThreadAllocations();
+            last_partial.valid = true;
+            last_partial.begin = speech_begin;
+            last_partial.end = decode_end;
+            last_partial.text = result.text;
+
+            message.recog_text = result.text;
+            post(false, false, speech_begin, decode_end);
+            uint64_t allocs = metrics::ThreadAllocations() - allocs_before;
+            if (allocs > 0) {
+                partial_post_allocs_.fetch_add(allocs);
+                partial_post_allocs->Add(allocs);
+            }
+            partials->Add();
+
+            scheduler.OnPartialDecoded(clock.Now());
         }
 
         while (!vad.IsEmpty()) {
             auto segment = vad.Front();
             vad.Pop();
 
-            OfflineStream stream = recognizer.CreateStream();
-            stream.AcceptWaveform(sample_rate, segment.samples.data(),
-                segment.samples.size());
-            recognizer.Decode(&stream);
+            // VAD 在尾部静音满 min_silence 后才吐出语音段，段尾按此回推
+            int64_t segment_end = std::max<int64_t>(0, fed_until - min_silence);
+            int64_t segment_begin = std::max<int64_t>(0,
+                segment_end - static_cast<int64_t>(segment.samples.size()));
+            if (scheduler.Split()) {
+                // 前面的块已经出过结果，只剩最后一个切点之后的部分
+                segment_begin = std::min(scheduler.SpeechBegin(), segment_end);
+                history.Read(segment_begin, segment_end, &decode_buffer);
+            }
+            const std::vector<float>& samples = scheduler.Split() ? decode_buffer : segment.samples;
+
+            message.recog_text.clear();
+            if (partial_covers(segment_begin, segment_end)) {
+                // 片段解码已覆盖同一段语音，省掉一次完整解码
+                message.recog_text = last_partial.text;
+                finals_reused->Add();
+                reused_ms->Add(static_cast<uint64_t>(samples.size() * 1000 / static_cast<size_t>(sample_rate)));
+            }
+            else if (!samples.empty()) {
+                OfflineStream stream = recognizer_->CreateStream();
+                stream.AcceptWaveform(sample_rate, samples.data(),
+                    samples.size());
+                {
+                    metrics::ScopedTimer timer(decode_final);
+                    recognizer_->Decode(&stream);
+                }
+                OfflineRecognizerResult result = recognizer_->GetResult(&stream);
+                message.recog_text = result.text;
+                finals_decoded->Add();
+            }
+            last_partial.valid = false;
 
-            OfflineRecognizerResult result = recognizer.GetResult(&stream);
-            
-            RecognitionMessage msg;
-            msg.recog_text = result.text;
-            msg.is_final = true;
-            bus_->PostRecognition(msg);
+            post(true, false, segment_begin, segment_end);
+            finals->Add();
 
             // send to queue
             //{
@@ -321,105 +686,56 @@ void SpeechRecognizer::RecognizeLoop()
 
             //display.Display();
 
-            buffer.clear();
-            offset = 0;
-            speech_started = false;
+            scheduler.OnSpeechEnd();
         }
-    }
-}
-
-std::wstring GetExeDirectory()
-{
-    TCHAR exePath[MAX_PATH] = { 0 };
-    DWORD size = GetModuleFileName(nullptr, exePath, MAX_PATH);
-    if (size == 0) {
-        return L"";
-    }
-
-    std::wstring pathStr(exePath);
 
-    // һбܣȥļ
-    size_t pos = pathStr.find_last_of(L"\\/");
-    if (pos != std::wstring::npos) {
-        pathStr = pathStr.substr(0, pos);
+        const auto busy_end = std::chrono::steady_clock::now();
+        if (governor.OnChunk(busy_end - busy_begin, chunk.samples.size(), ingest_.QueuedSamples(), busy_end)
+            && governor.WantsLightModel() != light_model) {
+            // 换模型会阻塞数秒，积压由接入队列吸收，不计入负载；恢复时换回配置的精度
+            light_model = governor.WantsLightModel();
+            LoadRecognizer(light_model);
+            last_partial.valid = false;
+            governor.OnModelReloaded(ingest_.QueuedSamples(), std::chrono::steady_clock::now(), true);
+        }
     }
-
-    return pathStr;
-}
-
-std::string WStringToUtf8(const std::wstring& wstr)
-{
-    if (wstr.empty()) return std::string();
-
-    // һεü軺С
-    int size_needed = WideCharToMultiByte(
-        CP_UTF8,                // תΪ UTF-8
-        0,                      // Ĭת־
-        wstr.c_str(),           //  UTF-16 ַ
-        (int)wstr.size(),       // 볤
-        nullptr,                // Ҫ
-        0,
-        nullptr,
-        nullptr
-    );
-
-    std::string result(size_needed, 0);
-
-    // ڶεýʵת
-    WideCharToMultiByte(
-        CP_UTF8,
-        0,
-        wstr.c_str(),
-        (int)wstr.size(),
-        &result[0],
-        size_needed,
-        nullptr,
-        nullptr
-    );
-
-    return result;
 }
 
 // -------------------- Sherpa-ONNX VAD & Recognizer --------------------
-sherpa_onnx::cxx::VoiceActivityDetector SpeechRecognizer::CreateVad() {
-    using namespace sherpa_onnx::cxx;
-
-    std::wstring parentPath = GetExeDirectory();
-    std::wstring onnxPath = parentPath + L"\\silero_vad.onnx";
-
-    VadModelConfig config;
-    config.silero_vad.model = WStringToUtf8(onnxPath);
-    config.silero_vad.threshold = 0.7;
-    config.silero_vad.min_silence_duration = 0.15;
-    config.silero_vad.min_speech_duration = 0.25;
-    config.silero_vad.max_speech_duration = 8;
+SileroVadConfig SpeechRecognizer::VadConfig() {
+    SileroVadConfig config;
+    config.model = GetExeDirectory() + L"\\silero_vad.onnx";
+    config.threshold = 0.7f;
+    config.min_silence_duration = kMinSilenceSeconds;
+    config.min_speech_duration = 0.25f;
+    config.max_speech_duration = kMaxSpeechSeconds;
+    config.buffer_seconds = 20;
     config.sample_rate = 16000;
-    config.debug = false;
-
-    VoiceActivityDetector vad = VoiceActivityDetector::Create(config, 20);
-    if (!vad.Get()) {
-        std::cerr << "Failed to create VAD. Please check your config\n";
-        exit(-1);
-    }
-    return vad;
+    return config;
 }
 
-sherpa_onnx::cxx::OfflineRecognizer SpeechRecognizer::CreateOfflineRecognizer() {
+sherpa_onnx::cxx::OfflineRecognizer SpeechRecognizer::CreateOfflineRecognizer(const RecognizerOptions& options,
+    int32_t num_threads) {
     using namespace sherpa_onnx::cxx;
 
-    std::wstring parentPath = GetExeDirectory();
-    std::wstring modelPath = parentPath + L"\\sherpa-onnx-sense-voice-zh-en-ja-ko-yue-2024-07-17\\model.onnx";
-    std::wstring tokensPath = parentPath + L"\\sherpa-onnx-sense-voice-zh-en-ja-ko-yue-2024-07-17\\tokens.txt";
+    SenseVoiceModelPaths paths = ResolveSenseVoiceModel(options.model_precision);
     OfflineRecognizerConfig config;
     config.model_config.sense_voice.model =
-        WStringToUtf8(modelPath);
+        WStringToUtf8(paths.model);
     config.model_config.sense_voice.use_itn = true;
     config.model_config.sense_voice.language = "ja";
     config.model_config.tokens =
-       WStringToUtf8(tokensPath);
-    config.model_config.num_threads = 2;
+       WStringToUtf8(paths.tokens);
+    config.model_config.num_threads = num_threads;
     config.model_config.debug = false;
 
+    // 先映射并预取模型文件，sherpa-onnx 按路径读取时直接命中页缓存；加载完即关闭映射
+    MappedFile mapping;
+    if (options.map_model && mapping.Open(paths.model)) mapping.Prefetch();
+
+    size_t rss_before = GetProcessRss();
+    auto load_begin = std::chrono::steady_clock::now();
+
     std::cout << "Loading model\n";
     OfflineRecognizer recognizer = OfflineRecognizer::Create(config);
     if (!recognizer.Get()) {
@@ -427,5 +743,68 @@ sherpa_onnx::cxx::OfflineRecognizer SpeechRecognizer::CreateOfflineRecognizer()
         exit(-1);
     }
     std::cout << "Loading model done\n";
+
+    auto load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - load_begin).count();
+    size_t rss_after = GetProcessRss();
+
+    wchar_t buf[256];
+    swprintf(buf, 256, L"[Model] precision=%s num_threads=%d load_ms=%lld rss_mb=%.1f (+%.1f)\n",
+        paths.precision == ModelPrecision::kInt8 ? L"int8" : L"fp32", num_threads,
+        static_cast<long long>(load_ms), rss_after / 1048576.0,
+        (rss_after > rss_before ? rss_after - rss_before : 0) / 1048576.0);
+    OutputDebugStringW(buf);
+    std::wcout << buf;
+
     return recognizer;
-}
\ No newline at end of file
+}
+
+sherpa_onnx::cxx::OfflineRecognizer SpeechRecognizer::AutoTuneRecognizer() {
+    using namespace sherpa_onnx::cxx;
+
+    const int32_t sample_rate = 16000;
+    const float clip_seconds = 3.0f;
+    std::vector<float> clip = ThreadTuning::MakeCalibrationClip(sample_rate, clip_seconds);
+
+    auto measure = [&](OfflineRecognizer& r) {
+        // 第一次解码包含 ONNX Runtime 的预热开销，不计入
+        double best = 1e9;
+        for (int i = 0; i < 3; ++i) {
+            auto begin = std::chrono::steady_clock::now();
+            OfflineStream stream = r.CreateStream();
+            stream.AcceptWaveform(sample_rate, clip.data(), static_cast<int32_t>(clip.size()));
+            r.Decode(&stream);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            if (i > 0) best = std::min(best, seconds);
+        }
+        return static_cast<float>(best / clip_seconds);
+    };
+
+    std::vector<int32_t> candidates =
+        ThreadTuning::CandidateThreadCounts(ThreadTuning::GetLogicalCoreCount());
+
+    int32_t best_threads = candidates.front();
+    OfflineRecognizer best = CreateOfflineRecognizer(options_, best_threads);
+    float best_rtf = measure(best);
+
+    for (size_t i = 1; i < candidates.size() && !stop; ++i) {
+        OfflineRecognizer r = CreateOfflineRecognizer(options_, candidates[i]);
+        float rtf = measure(r);
+        std::cout << "[Tuning] num_threads=" << candidates[i] << " rtf=" << rtf << "\n";
+        // 收益不足 10% 时认为已到拐点，继续加线程只会和采集/VAD 抢核心
+        if (rtf > best_rtf * 0.9f) break;
+        best = std::move(r);
+        best_rtf = rtf;
+        best_threads = candidates[i];
+    }
+
+    tuned_threads_ = best_threads;
+
+    wchar_t buf[256];
+    swprintf(buf, 256, L"[Tuning] chosen num_threads=%d rtf=%.3f capture_core=%d pinned=%d\n",
+        best_threads, best_rtf, capture_core_, options_.pin_threads ? 1 : 0);
+    OutputDebugStringW(buf);
+    std::wcout << buf;
+
+    return best;
+}
@@ -1,11 +1,21 @@
 #pragma once
-#include <queue>
+#include <string>
 #include <vector>
 
 #include "core/ipc/MessageBus.h"
+#include "AudioIngest.h"
+#include "AudioSource.h"
+#include "ModelFiles.h"
+#include "SessionRecorder.h"
+#include "SileroVad.h"
+#include "core/metrics/Metrics.h"
+#include "core/sim/Clock.h"
 #include <thread>
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
 
 #include <Windows.h>
 #include <objbase.h>
@@ -15,33 +25,156 @@
 #include <cstdint>
 #include "cxx-api.h"
 
+struct RecognizerOptions {
+    // ONNX intra-op 线程数，<= 0 表示启动时用校准片段自动选择
+    int32_t num_threads = 0;
+    // 固定线程亲和性：采集线程独占一个核心，识别线程使用其余核心。
+    // 默认关闭：与其它进程争用时绑定反而让线程等在被占的核心上，由宿主在实测有收益时开启
+    bool pin_threads = false;
+    // 采集线程绑定的核心，为进程可用核心中的序号，-1 表示最后一个可用核心
+    int32_t capture_core = -1;
+    // 将采集线程注册为 MMCSS "Audio" 任务以提升调度优先级
+    bool boost_capture_priority = true;
+    // 语音起始前额外带入识别的预录时长
+    int32_t preroll_ms = 320;
+    // 采集线程等待数据就绪的最长周期，取值 1..100
+    int32_t capture_period_ms = 10;
+    // 交给识别线程的固定块长，取值 10..200
+    int32_t chunk_ms = 20;
+    // VAD 之前用能量门限跳过明显静音的窗口；关闭时每个窗口都送 Silero（--idle-bench 对比两者的静音 CPU）
+    bool energy_gate = true;
+    // 识别模型精度；int8 需显式开启（--model-bench 对比两者），文件缺失时自动回退 fp32
+    ModelPrecision model_precision = ModelPrecision::kFp32;
+    // 加载前映射并预取模型文件
+    bool map_model = true;
+    // 语音段结束时，若最近一次片段解码与该段的边界差不超过此值且差异部分为静音，直接复用片段结果；0 表示关闭
+    int32_t final_reuse_ms = 200;
+    // 语音段超过此长度后在词间停顿处切出一块先出最终结果；0 表示关闭
+    int32_t split_target_ms = 3000;
+    // 超过此长度仍无停顿时强制切分，需小于 kMaxSpeechSeconds
+    int32_t split_max_ms = 6000;
+    // 写入识别消息的音源标识，多路音源同时落盘时用于区分输出文件
+    std::string source_id = "loopback";
+    // 多路音源共用的 Silero 推理，各路窗口拼批；为空时每路使用 sherpa-onnx 自带的 VAD
+    std::shared_ptr<SileroVadEngine> vad_engine;
+    // 运行中持续无语音超过此时长时释放工作缓冲（解码缓冲、接入队列的回收池）；Stop 时立即释放；0 表示关闭
+    int32_t idle_trim_ms = 10000;
+    // 运行中持续无语音超过此时长卸载识别模型，只保留 VAD；检测到语音时重新映射模型文件，
+    // 页缓存仍热时加载不读盘。0 表示模型常驻，由宿主按需开启
+    int32_t idle_unload_ms = 0;
+    // Stop 后超过此时长卸载识别模型，期间再 Start 直接复用；0 表示模型常驻
+    int32_t stopped_unload_ms = 0;
+    // 片段解码间隔与消息时间戳的时钟；处理耗时（负载控制）始终按真实时间计
+    Clock* clock = &Clock::System();
+};
+
+struct CaptureStats {
+    uint64_t source_switches = 0;   // SwitchSource 或默认设备变化触发的切换次数
+    uint64_t format_changes = 0;    // 重新打开后输入格式变化、重建转换状态的次数
+    uint64_t device_losses = 0;     // 设备失效次数
+    uint64_t lost_ms = 0;           // 切换/重建期间丢失的音频时长
+};
+
+struct IdleStats {
+    bool model_loaded = false;
+    uint64_t unloads = 0;          // 空闲超时卸载模型的次数，含运行中与 Stop 后
+    uint64_t resumes = 0;          // 卸载后重新加载的次数
+    int64_t last_resume_ms = 0;    // 最近一次重新加载的耗时
+    size_t idle_rss = 0;           // 最近一次回收后的进程工作集（字节）
+};
+
 class SpeechRecognizer {
 public:
-    SpeechRecognizer(MessageBus* bus);
+    SpeechRecognizer(MessageBus* bus, const RecognizerOptions& options = RecognizerOptions());
     ~SpeechRecognizer();
 
     void Start();
 
     void Stop();
 
+    // 运行中切换音源，在下一个包边界生效；识别状态保持不变
+    void SwitchSource(std::unique_ptr<AudioSource> source);
+
+    CaptureStats GetCaptureStats() const;
+
+    IdleStats GetIdleStats() const;
+
+    // 识别线程把片段交给总线（复制文本、旁路订阅者、取池中消息、投递）时的累计堆分配次数；
+    // 解码与取结果在 sherpa-onnx 内部分配，不计入
+    uint64_t PartialPostAllocations() const { return partial_post_allocs_.load(); }
+
+    // 下次 Start 起把采集到的 16kHz 音频录到 path，空串表示不录
+    void SetRecordingPath(const std::wstring& path) { recording_path_ = path; }
+
+    const std::string& SourceId() const { return options_.source_id; }
+
+    // 实时与批处理模式共用的模型配置
+    static sherpa_onnx::cxx::OfflineRecognizer CreateOfflineRecognizer(const RecognizerOptions& options,
+        int32_t num_threads);
+
+    // VadStream 的判决参数，实时与批处理模式共用
+    static SileroVadConfig VadConfig();
+
+    // 与 VAD 配置中的 max_speech_duration / min_silence_duration 一致
+    static constexpr float kMaxSpeechSeconds = 8.0f;
+    static constexpr float kMinSilenceSeconds = 0.15f;
+
 private:
     void RecognizeLoop();
 
     void CaptureLoop();
 
-    sherpa_onnx::cxx::OfflineRecognizer CreateOfflineRecognizer();
+    // 在校准片段上测量不同线程数的实时率，返回最快的识别器
+    sherpa_onnx::cxx::OfflineRecognizer AutoTuneRecognizer();
 
-    sherpa_onnx::cxx::VoiceActivityDetector CreateVad();
-
-    std::vector<float> ResampleLinear(const float* in_samples, size_t in_len, int in_rate, int out_rate);
+    // 按当前精度创建 recognizer_；被空闲策略卸载过时计为一次恢复
+    void LoadRecognizer(bool light_model);
+    void UnloadRecognizer(const char* reason);
+    // 回收之后记录进程工作集
+    void RecordIdleRss(const char* what);
+    // Stop 后等待 stopped_unload_ms 卸载模型，Start 时取消
+    void ScheduleIdleUnload();
+    void CancelIdleUnload();
 
     std::thread capture_thread;
     std::thread recognize_thread;
 
     MessageBus* bus_;
+    RecognizerOptions options_;
+    int32_t capture_core_ = -1;
+    int32_t tuned_threads_ = 0;   // 自动校准结果，重新 Start 时复用
+
+    // 跨 Start / Stop 保留的识别模型：运行时只由识别线程改动，停止后只由空闲线程改动
+    std::unique_ptr<sherpa_onnx::cxx::OfflineRecognizer> recognizer_;
+    bool recognizer_light_ = false;
+    bool unloaded_ = false;       // 模型被空闲策略卸载，下次加载计为恢复
+    mutable std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    std::thread idle_thread_;
+    bool idle_cancel_ = false;
+    IdleStats idle_stats_;
+    std::atomic<uint64_t> partial_post_allocs_{ 0 };
    
-    IAudioClient* audio_client = nullptr;
     bool stop = true;
-    std::queue<std::vector<float>> samples_queue;
+    AudioIngestQueue ingest_;
+    SessionRecorder recorder_;   // 与 ingest_ 收到的调用一一对应
+    std::wstring recording_path_;
+
+    std::mutex source_mutex_;
+    std::unique_ptr<AudioSource> pending_source_;
+    AudioSource* active_source_ = nullptr;   // 由采集线程持有，Stop 时用于打断阻塞读
+
+    // 采集统计同时计入本实例与全局指标；全局指标是进程内所有识别器的累计，GetCaptureStats 只返回本实例
+    void CountCapture(uint64_t CaptureStats::*field, metrics::Counter* metric, uint64_t n = 1);
+    mutable std::mutex capture_mutex_;
+    CaptureStats capture_stats_;
+    metrics::Counter* source_switches_;
+    metrics::Counter* format_changes_;
+    metrics::Counter* device_losses_;
+    metrics::Counter* lost_ms_;
+    metrics::Gauge* model_loaded_;
+    metrics::Gauge* idle_rss_;
+    metrics::Counter* model_unloads_;
+    metrics::Histogram* resume_time_;
 
 };
@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+#include "AudioHistory.h"
+#include "EnergyGate.h"
+
+// 长语音切分：语音段超过目标长度后，在能量谷（词间停顿）处切出一块先行解码，
+// 说话人仍在继续时就能给出最终结果，最终结果延迟不再随语音段长度增长
+class SpeechSplitter {
+public:
+    struct Options {
+        int32_t target_ms = 3000;        // 当前块超过此长度开始找切点
+        int32_t max_ms = 6000;           // 超过此长度仍无合格停顿时，在最低能量处强制切分（需小于 VAD 的最长语音段）
+        int32_t min_chunk_ms = 1000;     // 切出的块不短于此长度
+        int32_t guard_ms = 200;          // 不在最新的这段音频里切：后续音频未知，可能是词中间
+        int32_t frame_ms = 20;           // 能量分析帧长
+        int32_t min_valley_frames = 3;   // 合格停顿至少持续的帧数
+        float valley_ratio = 0.1f;       // 停顿能量上限：相对块内平均能量（约 -10 dB）
+    };
+
+    struct Cut {
+        int64_t pos = -1;                // 切点（历史序号），-1 表示不切
+        bool forced = false;             // 未找到合格停顿，按最低能量强制切分
+    };
+
+    SpeechSplitter() : SpeechSplitter(Options()) {}
+
+    explicit SpeechSplitter(const Options& opt) : opt_(opt) {
+        quiet_level_ = EnergyGate::DbfsToMeanSquare(EnergyGate::Options().close_dbfs);
+    }
+
+    // 在 [begin, end) 中找切点；scratch 至少能容纳一帧
+    Cut FindCut(const AudioHistory& history, int64_t begin, int64_t end, int32_t sample_rate, float* scratch) const {
+        Cut cut;
+        const int64_t frame = static_cast<int64_t>(sample_rate) * opt_.frame_ms / 1000;
+        const int64_t length = end - begin;
+        if (opt_.target_ms <= 0 || frame <= 0) return cut;
+        if (length * 1000 < static_cast<int64_t>(opt_.target_ms) * sample_rate) return cut;
+        begin = std::max(begin, history.Begin());
+
+        const int64_t search_begin = begin + static_cast<int64_t>(sample_rate) * opt_.min_chunk_ms / 1000;
+        const int64_t search_end = end - static_cast<int64_t>(sample_rate) * opt_.guard_ms / 1000;
+        if (search_end - search_begin < frame) return cut;
+
+        auto energy = [&](int64_t pos) {
+            int32_t n = static_cast<int32_t>(frame);
+            return EnergyGate::MeanSquare(history.Data(pos, n, scratch), n);
+        };
+
+        // 块内平均能量作为参考，停顿阈值随说话人音量自适应
+        double total = 0;
+        int64_t frames = 0;
+        for (int64_t pos = begin; pos + frame <= end; pos += frame, ++frames) total += energy(pos);
+        const float threshold = std::max(quiet_level_,
+            static_cast<float>(total / std::max<int64_t>(1, frames)) * opt_.valley_ratio);
+
+        // 取最深的合格停顿，深度相同时取靠后的，尽量让块长
+        float best_level = 0.0f;
+        int64_t run_begin = -1;
+        double run_sum = 0;
+        float min_level = 0.0f;
+        int64_t min_pos = -1;
+        auto close_run = [&](int64_t run_end) {
+            int64_t run_frames = (run_end - run_begin) / frame;
+            if (run_begin >= 0 && run_frames >= opt_.min_valley_frames) {
+                float level = static_cast<float>(run_sum / run_frames);
+                if (cut.pos < 0 || level <= best_level) {
+                    best_level = level;
+                    cut.pos = run_begin + (run_end - run_begin) / 2;
+                }
+            }
+            run_begin = -1;
+            run_sum = 0;
+        };
+
+        int64_t pos = search_begin;
+        for (; pos + frame <= search_end; pos += frame) {
+            float level = energy(pos);
+            if (min_pos < 0 || level <= min_level) {
+                min_level = level;
+                min_pos = pos + frame / 2;
+            }
+            if (level < threshold) {
+                if (run_begin < 0) run_begin = pos;
+                run_sum += level;
+            }
+            else if (run_begin >= 0) {
+                close_run(pos);
+            }
+        }
+        if (run_begin >= 0) close_run(pos);
+
+        if (cut.pos < 0 && length * 1000 >= static_cast<int64_t>(opt_.max_ms) * sample_rate) {
+            cut.pos = min_pos;
+            cut.forced = true;
+        }
+        return cut;
+    }
+
+private:
+    Options opt_;
+    float quiet_level_ = 0.0f;
+};
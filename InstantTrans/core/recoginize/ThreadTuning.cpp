@@ -0,0 +1,85 @@
+#define NOMINMAX
+#include "ThreadTuning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace ThreadTuning {
+
+    // 进程可用核心的掩码；取不到时按处理器数假定为低位连续的核心
+    static DWORD_PTR ProcessMask() {
+        DWORD_PTR process_mask = 0, system_mask = 0;
+        if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) && process_mask != 0)
+            return process_mask;
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        int32_t cores = std::max<int32_t>(1, std::min<int32_t>(info.dwNumberOfProcessors, 64));
+        return cores >= 64 ? ~static_cast<DWORD_PTR>(0) : ((static_cast<DWORD_PTR>(1) << cores) - 1);
+    }
+
+    int32_t GetLogicalCoreCount() {
+        int32_t count = 0;
+        for (DWORD_PTR mask = ProcessMask(); mask; mask &= mask - 1) ++count;
+        return count;
+    }
+
+    DWORD_PTR CaptureMask(int32_t capture_core) {
+        // 进程掩码可能不连续（如被作业对象或启动参数限制），按置位的顺序取第 capture_core 个
+        DWORD_PTR mask = ProcessMask();
+        for (int32_t i = 0; mask; mask &= mask - 1, ++i) {
+            if (i == capture_core) return mask & (~mask + 1);
+        }
+        return 0;
+    }
+
+    DWORD_PTR DecodeMask(int32_t capture_core) {
+        DWORD_PTR all = ProcessMask();
+        DWORD_PTR mask = all & ~CaptureMask(capture_core);
+        // 单核机器上没有可让出的核心，退回全部核心
+        return mask ? mask : all;
+    }
+
+    void PinCurrentThread(DWORD_PTR mask, const wchar_t* tag) {
+        wchar_t buf[256];
+        if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+            swprintf(buf, 256, L"[%s] SetThreadAffinityMask failed, err=%lu\n", tag, GetLastError());
+        }
+        else {
+            swprintf(buf, 256, L"[%s] pinned to mask=0x%llX\n", tag, static_cast<unsigned long long>(mask));
+        }
+        OutputDebugStringW(buf);
+    }
+
+    std::vector<int32_t> CandidateThreadCounts(int32_t cores) {
+        // 为采集线程和 UI 线程预留一个核心
+        int32_t usable = std::max(1, cores - 1);
+
+        std::vector<int32_t> candidates;
+        for (int32_t n : { 1, 2, 3, 4, 6, 8 }) {
+            if (n <= usable) candidates.push_back(n);
+        }
+        if (candidates.back() != usable && usable < 8) candidates.push_back(usable);
+        return candidates;
+    }
+
+    std::vector<float> MakeCalibrationClip(int32_t sample_rate, float seconds) {
+        const double pi = 3.14159265358979323846;
+        size_t n = static_cast<size_t>(sample_rate * seconds);
+        std::vector<float> clip(n);
+
+        std::mt19937 rng(12345);
+        std::normal_distribution<float> noise(0.0f, 0.02f);
+        for (size_t i = 0; i < n; ++i) {
+            double t = static_cast<double>(i) / sample_rate;
+            // 约 4 Hz 的音节包络，基频在 120~220 Hz 之间缓慢变化
+            double envelope = 0.5 * (1.0 - std::cos(2 * pi * 4.0 * t));
+            double f0 = 170.0 + 50.0 * std::sin(2 * pi * 0.7 * t);
+            double voiced = 0.0;
+            for (int h = 1; h <= 5; ++h) voiced += std::sin(2 * pi * f0 * h * t) / h;
+            clip[i] = static_cast<float>(0.2 * envelope * voiced) + noise(rng);
+        }
+        return clip;
+    }
+}
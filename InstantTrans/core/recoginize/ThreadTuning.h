@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <Windows.h>
+
+// 推理线程数校准与线程亲和性工具
+namespace ThreadTuning {
+
+    // 当前进程可用的逻辑核心数（最多 64，受 DWORD_PTR 掩码宽度限制）
+    int32_t GetLogicalCoreCount();
+
+    // 采集线程独占的核心掩码；capture_core 为进程亲和性掩码中第几个可用核心，越界时返回 0
+    DWORD_PTR CaptureMask(int32_t capture_core);
+
+    // 识别线程使用的核心掩码（进程可用核心中除采集核心外的全部）
+    DWORD_PTR DecodeMask(int32_t capture_core);
+
+    // 将当前线程绑定到指定掩码，失败时只打印日志，不影响运行
+    void PinCurrentThread(DWORD_PTR mask, const wchar_t* tag);
+
+    // 自动校准时尝试的 intra-op 线程数，已剔除采集线程占用的核心
+    std::vector<int32_t> CandidateThreadCounts(int32_t cores);
+
+    // 生成校准用的合成音频（谐波 + 噪声，按音节包络调制）
+    // SenseVoice 是非自回归 CTC 模型，解码耗时只与音频长度相关，合成片段足够代表真实语音
+    std::vector<float> MakeCalibrationClip(int32_t sample_rate, float seconds);
+}
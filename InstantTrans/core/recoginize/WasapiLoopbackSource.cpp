@@ -0,0 +1,234 @@
+#include "WasapiLoopbackSource.h"
+
+#include <functiondiscoverykeys_devpkey.h>
+#include <cstdio>
+#include <iostream>
+
+#pragma comment(lib, "ole32.lib")
+#pragma comment(lib, "oleaut32.lib")
+#pragma comment(lib, "uuid.lib")
+
+// 默认输出设备变化通知，只置位标志并唤醒采集线程
+class WasapiLoopbackSource::DeviceNotifier : public IMMNotificationClient {
+public:
+    DeviceNotifier(std::atomic<bool>* changed, HANDLE event) : changed_(changed), event_(event) {}
+
+    ULONG STDMETHODCALLTYPE AddRef() override { return InterlockedIncrement(&ref_); }
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG ref = InterlockedDecrement(&ref_);
+        if (ref == 0) delete this;
+        return ref;
+    }
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppv) override {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IMMNotificationClient)) {
+            *ppv = static_cast<IMMNotificationClient*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR) override {
+        if (flow == eRender && role == eConsole) {
+            changed_->store(true);
+            SetEvent(event_);
+        }
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR, DWORD) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR, const PROPERTYKEY) override { return S_OK; }
+
+private:
+    LONG ref_ = 1;
+    std::atomic<bool>* changed_;
+    HANDLE event_;
+};
+
+WasapiLoopbackSource::WasapiLoopbackSource()
+{
+    event_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+}
+
+WasapiLoopbackSource::~WasapiLoopbackSource()
+{
+    Close();
+    if (device_enum_) {
+        if (notifier_) device_enum_->UnregisterEndpointNotificationCallback(notifier_);
+        device_enum_->Release();
+        device_enum_ = nullptr;
+    }
+    if (notifier_) {
+        notifier_->Release();
+        notifier_ = nullptr;
+    }
+    if (event_) CloseHandle(event_);
+}
+
+bool WasapiLoopbackSource::Open()
+{
+    HRESULT hr = S_OK;
+    if (!device_enum_) {
+        hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+            __uuidof(IMMDeviceEnumerator), reinterpret_cast<void**>(&device_enum_));
+        if (FAILED(hr) || !device_enum_) {
+            OutputDebugStringW(L"[Loopback] CoCreateInstance(MMDeviceEnumerator) failed\n");
+            device_enum_ = nullptr;
+            return false;
+        }
+        notifier_ = new DeviceNotifier(&default_changed_, event_);
+        device_enum_->RegisterEndpointNotificationCallback(notifier_);
+    }
+    default_changed_ = false;
+
+    hr = device_enum_->GetDefaultAudioEndpoint(eRender, eConsole, &device_);
+    if (FAILED(hr)) {
+        OutputDebugStringW(L"[Loopback] GetDefaultAudioEndpoint failed\n");
+        Close();
+        return false;
+    }
+
+    IPropertyStore* prop_store = nullptr;
+    if (SUCCEEDED(device_->OpenPropertyStore(STGM_READ, &prop_store))) {
+        PROPVARIANT prop_var;
+        PropVariantInit(&prop_var);
+        if (SUCCEEDED(prop_store->GetValue(PKEY_Device_FriendlyName, &prop_var)) && prop_var.pwszVal) {
+            name_ = prop_var.pwszVal;
+            std::wcout << L"使用设备: " << name_ << std::endl;
+        }
+        PropVariantClear(&prop_var);
+        prop_store->Release();
+    }
+
+    hr = device_->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr,
+        reinterpret_cast<void**>(&audio_client_));
+    if (FAILED(hr)) {
+        OutputDebugStringW(L"[Loopback] Activate(IAudioClient) failed\n");
+        Close();
+        return false;
+    }
+
+    WAVEFORMATEX* mix_format = nullptr;
+    hr = audio_client_->GetMixFormat(&mix_format);
+    if (FAILED(hr) || !ParseFormat(mix_format)) {
+        OutputDebugStringW(L"[Loopback] GetMixFormat failed or format unsupported\n");
+        if (mix_format) CoTaskMemFree(mix_format);
+        Close();
+        return false;
+    }
+
+    // 事件驱动：有数据时唤醒采集线程；部分系统上回环流不触发事件，等待超时即退化为定时轮询
+    hr = audio_client_->Initialize(AUDCLNT_SHAREMODE_SHARED,
+        AUDCLNT_STREAMFLAGS_LOOPBACK | AUDCLNT_STREAMFLAGS_EVENTCALLBACK, 0, 0, mix_format, nullptr);
+    if (SUCCEEDED(hr)) {
+        audio_client_->SetEventHandle(event_);
+    }
+    else {
+        hr = audio_client_->Initialize(AUDCLNT_SHAREMODE_SHARED,
+            AUDCLNT_STREAMFLAGS_LOOPBACK, 0, 0, mix_format, nullptr);
+    }
+    CoTaskMemFree(mix_format);
+    if (FAILED(hr)) {
+        OutputDebugStringW(L"[Loopback] AudioClient Initialize failed\n");
+        Close();
+        return false;
+    }
+
+    hr = audio_client_->GetService(__uuidof(IAudioCaptureClient),
+        reinterpret_cast<void**>(&capture_client_));
+    if (FAILED(hr) || FAILED(audio_client_->Start())) {
+        OutputDebugStringW(L"[Loopback] GetService/Start failed\n");
+        Close();
+        return false;
+    }
+
+    has_position_ = false;
+
+    wchar_t buf[256];
+    swprintf(buf, 256, L"[Loopback] opened rate=%d channels=%d bytes=%d\n",
+        format_.sample_rate, format_.channels, format_.BytesPerSample());
+    OutputDebugStringW(buf);
+    return true;
+}
+
+void WasapiLoopbackSource::Close()
+{
+    if (audio_client_) audio_client_->Stop();
+    if (capture_client_) { capture_client_->Release(); capture_client_ = nullptr; }
+    if (audio_client_) { audio_client_->Release(); audio_client_ = nullptr; }
+    if (device_) { device_->Release(); device_ = nullptr; }
+}
+
+AudioSource::ReadStatus WasapiLoopbackSource::Read(AudioPacket& packet, int32_t timeout_ms)
+{
+    if (!capture_client_) return ReadStatus::kLost;
+    if (default_changed_.exchange(false)) return ReadStatus::kFormatChanged;
+
+    UINT32 next_frames = 0;
+    HRESULT hr = capture_client_->GetNextPacketSize(&next_frames);
+    if (FAILED(hr)) return ReadStatus::kLost;
+
+    if (next_frames == 0) {
+        // 阻塞等待数据就绪或周期到期，无音频时不占用 CPU
+        WaitForSingleObject(event_, timeout_ms);
+        if (default_changed_.exchange(false)) return ReadStatus::kFormatChanged;
+
+        hr = capture_client_->GetNextPacketSize(&next_frames);
+        if (FAILED(hr)) return ReadStatus::kLost;
+        if (next_frames == 0) return ReadStatus::kTimeout;
+    }
+
+    BYTE* data = nullptr;
+    UINT32 frames = 0;
+    DWORD flags = 0;
+    UINT64 device_position = 0;
+    hr = capture_client_->GetBuffer(&data, &frames, &flags, &device_position, nullptr);
+    if (FAILED(hr)) return ReadStatus::kLost;
+    if (hr == AUDCLNT_S_BUFFER_EMPTY) return ReadStatus::kTimeout;
+
+    packet.data = data;
+    packet.frames = frames;
+    packet.silent = (flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0;
+    packet.discontinuity = (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) != 0;
+    packet.gap_frames = (has_position_ && device_position > expected_position_)
+        ? device_position - expected_position_ : 0;
+
+    expected_position_ = device_position + frames;
+    has_position_ = true;
+    return ReadStatus::kData;
+}
+
+void WasapiLoopbackSource::Release(const AudioPacket& packet)
+{
+    if (capture_client_) capture_client_->ReleaseBuffer(packet.frames);
+}
+
+void WasapiLoopbackSource::Interrupt()
+{
+    if (event_) SetEvent(event_);
+}
+
+bool WasapiLoopbackSource::ParseFormat(const WAVEFORMATEX* wfx)
+{
+    if (!wfx) return false;
+
+    bool is_float = wfx->wFormatTag == WAVE_FORMAT_IEEE_FLOAT;
+    bool is_pcm = wfx->wFormatTag == WAVE_FORMAT_PCM;
+    if (wfx->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+        auto wfex = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(wfx);
+        is_float = wfex->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+        is_pcm = wfex->SubFormat == KSDATAFORMAT_SUBTYPE_PCM;
+    }
+
+    format_.sample_rate = static_cast<int32_t>(wfx->nSamplesPerSec);
+    format_.channels = wfx->nChannels;
+    if (is_float && wfx->wBitsPerSample == 32) format_.type = SampleType::kFloat32;
+    else if (is_pcm && wfx->wBitsPerSample == 16) format_.type = SampleType::kInt16;
+    else if (is_pcm && wfx->wBitsPerSample == 24) format_.type = SampleType::kInt24;
+    else if (is_pcm && wfx->wBitsPerSample == 32) format_.type = SampleType::kInt32;
+    else return false;
+
+    return format_.channels > 0 && format_.sample_rate > 0;
+}
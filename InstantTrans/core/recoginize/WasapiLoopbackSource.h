@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <string>
+
+#include <Windows.h>
+#include <objbase.h>
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+
+#include "AudioSource.h"
+
+// 系统默认输出设备的 WASAPI 回环采集
+// 默认设备切换时 Read 返回 kFormatChanged，设备失效时返回 kLost，由调用方重新 Open
+class WasapiLoopbackSource : public AudioSource {
+public:
+    WasapiLoopbackSource();
+    ~WasapiLoopbackSource() override;
+
+    bool Open() override;
+    void Close() override;
+    AudioFormat Format() const override { return format_; }
+    ReadStatus Read(AudioPacket& packet, int32_t timeout_ms) override;
+    void Release(const AudioPacket& packet) override;
+    void Interrupt() override;
+    std::wstring Name() const override { return name_; }
+
+private:
+    class DeviceNotifier;
+
+    bool ParseFormat(const WAVEFORMATEX* wfx);
+
+    HANDLE event_ = nullptr;
+    IMMDeviceEnumerator* device_enum_ = nullptr;
+    IMMDevice* device_ = nullptr;
+    IAudioClient* audio_client_ = nullptr;
+    IAudioCaptureClient* capture_client_ = nullptr;
+    DeviceNotifier* notifier_ = nullptr;
+
+    AudioFormat format_;
+    std::wstring name_ = L"loopback";
+    std::atomic<bool> default_changed_{ false };
+    UINT64 expected_position_ = 0;
+    bool has_position_ = false;
+};
@@ -0,0 +1,140 @@
+#define NOMINMAX
+#include "WavScriptSource.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "ModelFiles.h"
+#include "core/metrics/Log.h"
+
+// 每个数据包 10ms，与 WASAPI 的典型包长相当
+static const int32_t kPacketMs = 10;
+
+static uint16_t ReadU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+static uint32_t ReadU32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+        | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+WavScriptSource::WavScriptSource(std::vector<std::wstring> files) : files_(std::move(files))
+{
+}
+
+bool WavScriptSource::Open()
+{
+    // Close 不丢弃回放位置，重新打开时接着放当前文件
+    if (loaded_) return true;
+    if (index_ >= files_.size()) return true;
+    return Load();
+}
+
+bool WavScriptSource::Load()
+{
+    const std::wstring& path = files_[index_];
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (file.size() < 12 || memcmp(file.data(), "RIFF", 4) != 0 || memcmp(file.data() + 8, "WAVE", 4) != 0) {
+        LOG_WARN("WavScript", "not a wav file: %s", WStringToUtf8(path).c_str());
+        return false;
+    }
+
+    AudioFormat format;
+    bool have_format = false;
+    for (size_t pos = 12; pos + 8 <= file.size();) {
+        const uint8_t* chunk = file.data() + pos;
+        const size_t size = ReadU32(chunk + 4);
+        const size_t body = pos + 8;
+        if (body + size > file.size()) break;
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            uint16_t tag = ReadU16(chunk + 8);
+            // WAVE_FORMAT_EXTENSIBLE 的子格式 GUID 前两字节即格式标签
+            if (tag == 0xFFFE && size >= 40) tag = ReadU16(chunk + 8 + 24);
+            const uint16_t bits = ReadU16(chunk + 8 + 14);
+            format.channels = ReadU16(chunk + 8 + 2);
+            format.sample_rate = static_cast<int32_t>(ReadU32(chunk + 8 + 4));
+            if (tag == 3 && bits == 32) format.type = SampleType::kFloat32;
+            else if (tag == 1 && bits == 16) format.type = SampleType::kInt16;
+            else if (tag == 1 && bits == 24) format.type = SampleType::kInt24;
+            else if (tag == 1 && bits == 32) format.type = SampleType::kInt32;
+            else break;
+            have_format = true;
+        }
+        else if (memcmp(chunk, "data", 4) == 0 && have_format) {
+            data_.assign(file.begin() + body, file.begin() + body + size);
+            format_ = format;
+            frame_bytes_ = static_cast<size_t>(format.BytesPerSample()) * format.channels;
+            frame_pos_ = 0;
+            timing_ = false;
+            loaded_ = true;
+            LOG_INFO("WavScript", "%s: %d Hz, %d ch, %zu frames", WStringToUtf8(path).c_str(),
+                format.sample_rate, format.channels, data_.size() / frame_bytes_);
+            return true;
+        }
+        pos = body + size + (size & 1);
+    }
+    LOG_WARN("WavScript", "unsupported wav format: %s", WStringToUtf8(path).c_str());
+    return false;
+}
+
+AudioSource::ReadStatus WavScriptSource::Read(AudioPacket& packet, int32_t timeout_ms)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t frames = loaded_ ? data_.size() / frame_bytes_ : 0;
+    if (finished_ || frame_pos_ >= frames) {
+        if (!finished_ && loaded_) {
+            // 当前文件放完：切到下一个，格式不同时要求重新打开
+            AudioFormat previous = format_;
+            loaded_ = false;
+            if (++index_ < files_.size() && Load()) {
+                if (format_ == previous) return ReadStatus::kTimeout;
+                ++format_changes_;
+                return ReadStatus::kFormatChanged;
+            }
+            finished_ = true;
+            LOG_INFO("WavScript", "script finished, %zu format changes", format_changes_.load());
+        }
+        WaitUntil(now + std::chrono::milliseconds(timeout_ms), timeout_ms);
+        return ReadStatus::kTimeout;
+    }
+
+    // 每个文件从第一次读取开始计时，按采样率定节奏
+    if (!timing_) {
+        base_time_ = now;
+        timing_ = true;
+    }
+    const auto due = base_time_ + std::chrono::microseconds(
+        static_cast<int64_t>(frame_pos_ * 1000000 / static_cast<uint64_t>(format_.sample_rate)));
+    if (due > now && !WaitUntil(due, timeout_ms)) return ReadStatus::kTimeout;
+
+    const uint64_t n = std::min<uint64_t>(frames - frame_pos_,
+        static_cast<uint64_t>(format_.sample_rate) * kPacketMs / 1000);
+    packet = AudioPacket();
+    packet.data = data_.data() + frame_pos_ * frame_bytes_;
+    packet.frames = static_cast<uint32_t>(n);
+    frame_pos_ += n;
+    return ReadStatus::kData;
+}
+
+void WavScriptSource::Interrupt()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        interrupted_ = true;
+    }
+    cv_.notify_all();
+}
+
+bool WavScriptSource::WaitUntil(std::chrono::steady_clock::time_point due, int32_t timeout_ms)
+{
+    auto limit = std::min(due, std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms));
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_until(lock, limit, [this] { return interrupted_; });
+    if (interrupted_) {
+        interrupted_ = false;
+        return false;
+    }
+    return std::chrono::steady_clock::now() >= due;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AudioSource.h"
+
+// 按顺序实时回放一组 wav 文件，各文件的采样率、声道数与采样格式可以不同（PCM 16/24/32 位、32 位浮点）：
+// 交出未经转换的原始数据包，切到格式不同的下一个文件时 Read 返回 kFormatChanged，
+// 由采集线程 Close 后重新 Open，走与设备格式变化相同的路径。全部放完后 Read 一直返回 kTimeout
+class WavScriptSource : public AudioSource {
+public:
+    explicit WavScriptSource(std::vector<std::wstring> files);
+
+    bool Open() override;
+    void Close() override {}
+    AudioFormat Format() const override { return format_; }
+    ReadStatus Read(AudioPacket& packet, int32_t timeout_ms) override;
+    void Release(const AudioPacket& packet) override {}
+    void Interrupt() override;
+    std::wstring Name() const override { return L"wav-script"; }
+
+    // 可从其它线程读取
+    bool Finished() const { return finished_.load(); }
+    size_t FormatChanges() const { return format_changes_.load(); }
+
+private:
+    // 读入 files_[index_]，解析失败返回 false
+    bool Load();
+    bool WaitUntil(std::chrono::steady_clock::time_point due, int32_t timeout_ms);
+
+    std::vector<std::wstring> files_;
+    size_t index_ = 0;
+    bool loaded_ = false;
+    AudioFormat format_;
+    std::vector<uint8_t> data_;      // 当前文件的 data 块
+    size_t frame_bytes_ = 0;
+    uint64_t frame_pos_ = 0;
+
+    // 当前文件的回放时间零点，每个文件重新计时
+    std::chrono::steady_clock::time_point base_time_;
+    bool timing_ = false;
+
+    std::atomic<bool> finished_{ false };
+    std::atomic<size_t> format_changes_{ 0 };
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool interrupted_ = false;
+};
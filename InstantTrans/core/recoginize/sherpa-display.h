@@ -54,7 +54,7 @@ class SherpaDisplay {
 
   static std::string GetCurrentDateTime() {
     std::ostringstream os;
-    auto t = std::time(nullptr);  // ȡǰʱ
+    auto t = std::time(nullptr);  // 获取当前时间戳
     std::tm tm{};
     localtime_s(&tm, &t);
     os << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
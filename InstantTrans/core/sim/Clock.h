@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// 时钟抽象：流控超时、片段解码间隔、翻译截止时间等计时逻辑经由它取时间，
+// 仿真时换成 VirtualClock，由事件循环推进，数小时的会话可在数秒内确定性地跑完
+class Clock {
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+    using duration = std::chrono::steady_clock::duration;
+
+    virtual ~Clock() = default;
+    virtual time_point Now() const = 0;
+    virtual void SleepFor(duration d) = 0;
+
+    // 进程内共享的系统时钟
+    static Clock& System();
+};
+
+class SystemClock : public Clock {
+public:
+    time_point Now() const override { return std::chrono::steady_clock::now(); }
+    void SleepFor(duration d) override { std::this_thread::sleep_for(d); }
+};
+
+inline Clock& Clock::System()
+{
+    static SystemClock clock;
+    return clock;
+}
+
+// 只由调用方推进的时钟；SleepFor 直接把时间往前拨
+// 起点避开 time_point{}，后者在截止时间等字段里表示“未设置”
+class VirtualClock : public Clock {
+public:
+    time_point Now() const override {
+        return time_point(std::chrono::hours(1)) + duration(offset_.load(std::memory_order_acquire));
+    }
+    void SleepFor(duration d) override { Advance(d); }
+
+    void Advance(duration d) { offset_.fetch_add(d.count(), std::memory_order_acq_rel); }
+
+    // 推进到 t，t 早于当前时间时不动
+    void AdvanceTo(time_point t) {
+        duration d = t - Now();
+        if (d > duration::zero()) Advance(d);
+    }
+
+private:
+    std::atomic<duration::rep> offset_{ 0 };
+};
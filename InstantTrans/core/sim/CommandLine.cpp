@@ -0,0 +1,97 @@
+#include "CommandLine.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+#include <Windows.h>
+
+#include "core/metrics/Log.h"
+
+void AttachParentConsole()
+{
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE* f = nullptr;
+        freopen_s(&f, "CONOUT$", "w", stdout);
+        freopen_s(&f, "CONOUT$", "w", stderr);
+    }
+    Log::InitFromEnvironment();
+}
+
+void CheckReport::Violation(const char* fmt, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    violations.push_back(line);
+}
+
+int PrintVerdict(const char* tag, const CheckReport& report)
+{
+    for (const std::string& v : report.violations) printf("[%s] FAIL: %s\n", tag, v.c_str());
+    printf("[%s] %s\n", tag, report.Passed() ? "PASS" : "FAIL");
+    fflush(stdout);
+    return report.Passed() ? 0 : 1;
+}
+
+ArgParser& ArgParser::Option(const wchar_t* name, int32_t* value)
+{
+    return Option(name, [value](const wchar_t* s) { *value = _wtoi(s); });
+}
+
+ArgParser& ArgParser::Option(const wchar_t* name, int64_t* value)
+{
+    return Option(name, [value](const wchar_t* s) { *value = _wtoi64(s); });
+}
+
+ArgParser& ArgParser::Option(const wchar_t* name, uint32_t* value)
+{
+    return Option(name, [value](const wchar_t* s) { *value = static_cast<uint32_t>(_wtoi(s)); });
+}
+
+ArgParser& ArgParser::Option(const wchar_t* name, double* value)
+{
+    return Option(name, [value](const wchar_t* s) { *value = _wtof(s); });
+}
+
+ArgParser& ArgParser::Option(const wchar_t* name, std::wstring* value)
+{
+    return Option(name, [value](const wchar_t* s) { *value = s; });
+}
+
+ArgParser& ArgParser::Option(const wchar_t* name, std::function<void(const wchar_t*)> handler)
+{
+    entries_.push_back({ name, true, std::move(handler) });
+    return *this;
+}
+
+ArgParser& ArgParser::Flag(const wchar_t* name, bool* value)
+{
+    entries_.push_back({ name, false, [value](const wchar_t*) { *value = true; } });
+    return *this;
+}
+
+ArgParser& ArgParser::Positional(std::wstring* value)
+{
+    positional_ = value;
+    return *this;
+}
+
+void ArgParser::Parse(int argc, wchar_t** argv, int first) const
+{
+    for (int i = first; i < argc; ++i) {
+        std::wstring arg = argv[i];
+        if (arg.compare(0, 2, L"--") != 0) {
+            if (positional_) *positional_ = arg;
+            continue;
+        }
+        for (const Entry& e : entries_) {
+            if (e.name != arg) continue;
+            if (!e.has_value) e.handler(nullptr);
+            else if (i + 1 < argc) e.handler(argv[++i]);
+            break;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// 各命令行模式（--simulate、--soak、各 bench 与自检）的公共部分：
+// 挂到父控制台、解析选项、输出检查结论
+
+// 窗口程序没有控制台：挂到启动它的命令行窗口上输出，并按环境变量初始化日志
+void AttachParentConsole();
+
+// 检查报告的公共部分：违反预算或约束的条目，为空即通过
+struct CheckReport {
+    std::vector<std::string> violations;
+    bool Passed() const { return violations.empty(); }
+    // printf 风格追加一条
+    void Violation(const char* fmt, ...);
+};
+
+// 输出各条违反项与 "[tag] PASS/FAIL"，返回退出码：通过为 0，否则为 1
+int PrintVerdict(const char* tag, const CheckReport& report);
+
+// 选项表：带值选项写成 "--name value"，值不合法时按 _wtoi/_wtof 的规则取 0；
+// 未登记的选项忽略，不以 -- 开头的参数交给 Positional
+class ArgParser {
+public:
+    ArgParser& Option(const wchar_t* name, int32_t* value);
+    ArgParser& Option(const wchar_t* name, int64_t* value);
+    ArgParser& Option(const wchar_t* name, uint32_t* value);
+    ArgParser& Option(const wchar_t* name, double* value);
+    ArgParser& Option(const wchar_t* name, std::wstring* value);
+    ArgParser& Option(const wchar_t* name, std::function<void(const wchar_t*)> handler);
+    // 不带值的开关，出现即为 true
+    ArgParser& Flag(const wchar_t* name, bool* value);
+    ArgParser& Positional(std::wstring* value);
+
+    // argv[1] 是模式名，选项从 argv[first] 开始
+    void Parse(int argc, wchar_t** argv, int first = 2) const;
+
+private:
+    struct Entry {
+        std::wstring name;
+        bool has_value;
+        std::function<void(const wchar_t*)> handler;
+    };
+
+    std::vector<Entry> entries_;
+    std::wstring* positional_ = nullptr;
+};
@@ -0,0 +1,165 @@
+#define NOMINMAX
+#include "FlowBench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include <Windows.h>
+
+#include "controller/FlowController.h"
+#include "core/metrics/Log.h"
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+int64_t Percentile(std::vector<int64_t> v, double p)
+{
+    if (v.empty()) return 0;
+    size_t k = std::min(v.size() - 1, static_cast<size_t>(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+// 生产者写入的文本由同一个字符重复组成，长度与字符随序号变化，读到混杂的字符即说明缓冲被并发改写
+void FillText(uint64_t seq, std::string* text)
+{
+    text->assign(16 + seq % 400, static_cast<char>('a' + seq % 26));
+}
+
+bool Uniform(const std::string& text)
+{
+    return text.empty() || std::all_of(text.begin(), text.end(), [&](char c) { return c == text[0]; });
+}
+
+} // namespace
+
+void RunFlowBench(const FlowBenchOptions& options, FlowBenchReport* report)
+{
+    *report = FlowBenchReport();
+    FlowController flow;
+    std::atomic<bool> stop{ false };
+    // 回调只记下有新版本，渲染在渲染线程上按帧进行，与 UI 线程按消息合并刷新一致
+    std::atomic<uint64_t> notified{ 0 };
+    flow.SetUpdateCallback([&notified](const DisplaySlot&, const DisplaySlot&) {
+        notified.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    std::thread renderer([&] {
+        uint64_t last_version = 0;
+        std::string copies[4];
+        while (!stop.load()) {
+            auto snap = flow.Snapshot();
+            const std::string* texts[4] = { &snap->active.Recog(), &snap->active.Trans(),
+                &snap->next.Recog(), &snap->next.Trans() };
+            bool torn = false;
+            for (int i = 0; i < 4; ++i) {
+                copies[i] = *texts[i];
+                torn |= !Uniform(copies[i]);
+            }
+            // 持有快照占用一帧，期间生产者继续发布新版本
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.render_ms));
+            for (int i = 0; i < 4; ++i) torn |= *texts[i] != copies[i];
+
+            ++report->frames;
+            if (torn) ++report->torn_frames;
+            if (snap->version < last_version) ++report->version_regressions;
+            else if (snap->version > last_version) ++report->versions_seen;
+            last_version = snap->version;
+        }
+    });
+
+    std::atomic<uint64_t> calls{ 0 };
+    std::vector<std::vector<int64_t>> call_us(options.producers);
+    std::vector<std::thread> producers;
+    const auto begin = SteadyClock::now();
+    for (int32_t p = 0; p < options.producers; ++p) {
+        producers.emplace_back([&, p] {
+            std::vector<int64_t>& samples = call_us[p];
+            samples.reserve(1 << 20);
+            uint64_t n = 0;
+            // 样本写满后只计调用数，不再扩容
+            auto record = [&](SteadyClock::time_point t0) {
+                ++n;
+                if (samples.size() < samples.capacity())
+                    samples.push_back(std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - t0).count());
+            };
+            std::string recog, trans;
+            for (uint64_t seq = static_cast<uint64_t>(p) * 7919; !stop.load(); ++seq) {
+                FillText(seq, &recog);
+                auto t0 = SteadyClock::now();
+                flow.OnRecognitionFragment(recog);
+                record(t0);
+                if (seq % options.translation_every == 0) {
+                    FillText(seq + 13, &trans);
+                    t0 = SteadyClock::now();
+                    flow.OnTranslationReady(recog, trans);
+                    record(t0);
+                }
+                if (seq % options.tick_every == 0) {
+                    t0 = SteadyClock::now();
+                    flow.Tick();
+                    record(t0);
+                }
+            }
+            calls.fetch_add(n);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    stop.store(true);
+    for (std::thread& t : producers) t.join();
+    renderer.join();
+    const double elapsed = std::chrono::duration<double>(SteadyClock::now() - begin).count();
+
+    std::vector<int64_t> all;
+    for (const auto& v : call_us) all.insert(all.end(), v.begin(), v.end());
+    report->calls = calls.load();
+    report->calls_per_second = report->calls / elapsed;
+    report->call_p50_us = Percentile(all, 0.50);
+    report->call_p99_us = Percentile(all, 0.99);
+    report->call_max_us = all.empty() ? 0 : *std::max_element(all.begin(), all.end());
+    LOG_INFO("FlowBench", "%d producers: %llu calls, %llu notifications, %llu frames",
+        options.producers, static_cast<unsigned long long>(report->calls),
+        static_cast<unsigned long long>(notified.load()), static_cast<unsigned long long>(report->frames));
+
+    if (report->frames == 0 || report->versions_seen < 2) report->Violation("renderer saw no progress");
+    if (report->torn_frames > 0)
+        report->Violation("%llu frames saw text rewritten while held", static_cast<unsigned long long>(report->torn_frames));
+    if (report->version_regressions > 0)
+        report->Violation("%llu frames saw an older version", static_cast<unsigned long long>(report->version_regressions));
+    if (report->call_p99_us > options.max_call_p99_us)
+        report->Violation("producer call p99 %lld us, limit %lld us (render %d ms)",
+            static_cast<long long>(report->call_p99_us), static_cast<long long>(options.max_call_p99_us),
+            options.render_ms);
+}
+
+int RunFlowBenchCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    FlowBenchOptions options;
+    ArgParser()
+        .Option(L"--producers", &options.producers)
+        .Option(L"--seconds", &options.seconds)
+        .Option(L"--render-ms", &options.render_ms)
+        .Option(L"--max-p99-us", &options.max_call_p99_us)
+        .Parse(argc, argv);
+    if (options.producers <= 0 || options.seconds <= 0 || options.render_ms < 0) {
+        printf("usage: InstantTrans.exe --flow-bench [--producers N] [--seconds S] [--render-ms M] [--max-p99-us U]\n");
+        return 2;
+    }
+
+    FlowBenchReport r;
+    RunFlowBench(options, &r);
+    printf("[FlowBench] producers=%d calls=%llu (%.0f/s) p50=%lldus p99=%lldus max=%lldus\n", options.producers,
+        static_cast<unsigned long long>(r.calls), r.calls_per_second, static_cast<long long>(r.call_p50_us),
+        static_cast<long long>(r.call_p99_us), static_cast<long long>(r.call_max_us));
+    printf("[FlowBench] frames=%llu versions=%llu torn=%llu regressions=%llu\n",
+        static_cast<unsigned long long>(r.frames), static_cast<unsigned long long>(r.versions_seen),
+        static_cast<unsigned long long>(r.torn_frames), static_cast<unsigned long long>(r.version_regressions));
+    return PrintVerdict("FlowBench", r);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 显示流控争用基准：多个生产者线程并发调用 FlowController 的片段/译文/Tick 接口，
+// 渲染线程持有快照逐帧“渲染”（读取文本并占用 render_ms），检查：
+//   生产者的调用耗时不随渲染耗时增长，即生产者不等待渲染方；
+//   渲染方看到的版本号单调，持有期间快照中的文本没有被改写（缓冲复用正确）：
+//
+//   InstantTrans.exe --flow-bench --producers 8 --seconds 10 --render-ms 8
+struct FlowBenchOptions {
+    int32_t producers = 8;
+    double seconds = 10.0;
+    int32_t render_ms = 8;           // 每帧渲染占用快照的时长
+    int32_t translation_every = 8;   // 每个生产者每隔多少次片段送一次译文
+    int32_t tick_every = 32;         // 每隔多少次片段调用一次 Tick
+    int64_t max_call_p99_us = 1000;
+};
+
+struct FlowBenchReport : CheckReport {
+    uint64_t calls = 0;              // 生产者调用总数
+    double calls_per_second = 0;
+    int64_t call_p50_us = 0;
+    int64_t call_p99_us = 0;
+    int64_t call_max_us = 0;
+    uint64_t frames = 0;             // 渲染帧数
+    uint64_t versions_seen = 0;      // 渲染方看到的不同版本数
+    uint64_t version_regressions = 0;
+    uint64_t torn_frames = 0;        // 持有期间文本被改写或内容不一致的帧
+};
+
+void RunFlowBench(const FlowBenchOptions& options, FlowBenchReport* report);
+
+// 命令行入口：InstantTrans.exe --flow-bench [--producers N] [--seconds S] [--render-ms M]
+// 全部检查通过返回 0，否则返回 1
+int RunFlowBenchCommandLine(int argc, wchar_t** argv);
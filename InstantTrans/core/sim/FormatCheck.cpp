@@ -0,0 +1,226 @@
+#define NOMINMAX
+#include "FormatCheck.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <Windows.h>
+
+#include "core/ipc/MessageBus.h"
+#include "core/metrics/Log.h"
+#include "core/recoginize/ModelFiles.h"
+#include "core/recoginize/SessionRecorder.h"
+#include "core/recoginize/SpeechRecognize.h"
+#include "core/recoginize/WavScriptSource.h"
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+// 相邻两项都不同，覆盖采样率、声道数与四种采样格式
+const AudioFormat kFormats[] = {
+    { 48000, 2, SampleType::kFloat32 },
+    { 44100, 1, SampleType::kInt16 },
+    { 96000, 6, SampleType::kInt24 },
+    { 16000, 1, SampleType::kInt32 },
+    { 22050, 2, SampleType::kInt24 },
+};
+
+std::string FormatName(const AudioFormat& f)
+{
+    const char* type = f.type == SampleType::kFloat32 ? "f32"
+        : f.type == SampleType::kInt16 ? "s16" : f.type == SampleType::kInt24 ? "s24" : "s32";
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%dHz/%dch/%s", f.sample_rate, f.channels, type);
+    return buf;
+}
+
+void Put16(std::vector<uint8_t>* out, uint32_t v) { out->push_back(v & 0xFF); out->push_back((v >> 8) & 0xFF); }
+void Put32(std::vector<uint8_t>* out, uint32_t v) { Put16(out, v & 0xFFFF); Put16(out, v >> 16); }
+
+// 16kHz 单声道线性插值到目标采样率，复制到各声道后按格式编码
+bool WriteWav(const std::wstring& path, const AudioFormat& format, const float* samples, size_t n)
+{
+    const size_t frames = static_cast<size_t>(static_cast<uint64_t>(n) * format.sample_rate / recording::kSampleRate);
+    std::vector<uint8_t> data;
+    data.reserve(frames * format.channels * format.BytesPerSample());
+    for (size_t i = 0; i < frames; ++i) {
+        double pos = static_cast<double>(i) * recording::kSampleRate / format.sample_rate;
+        size_t k = std::min(static_cast<size_t>(pos), n - 1);
+        double frac = pos - k;
+        float v = static_cast<float>(samples[k] + (k + 1 < n ? frac * (samples[k + 1] - samples[k]) : 0));
+        v = std::max(-1.0f, std::min(1.0f, v));
+        for (int32_t ch = 0; ch < format.channels; ++ch) {
+            switch (format.type) {
+            case SampleType::kFloat32: {
+                uint32_t bits;
+                memcpy(&bits, &v, 4);
+                Put32(&data, bits);
+                break;
+            }
+            case SampleType::kInt16:
+                Put16(&data, static_cast<uint16_t>(static_cast<int16_t>(std::lround(v * 32767.0f))));
+                break;
+            case SampleType::kInt24: {
+                uint32_t s = static_cast<uint32_t>(static_cast<int32_t>(std::lround(v * 8388607.0)));
+                data.push_back(s & 0xFF);
+                data.push_back((s >> 8) & 0xFF);
+                data.push_back((s >> 16) & 0xFF);
+                break;
+            }
+            case SampleType::kInt32:
+                Put32(&data, static_cast<uint32_t>(static_cast<int32_t>(std::lround(v * 2147483520.0))));
+                break;
+            }
+        }
+    }
+
+    const uint32_t block = static_cast<uint32_t>(format.channels * format.BytesPerSample());
+    std::vector<uint8_t> header;
+    header.insert(header.end(), { 'R', 'I', 'F', 'F' });
+    Put32(&header, static_cast<uint32_t>(36 + data.size()));
+    header.insert(header.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+    Put32(&header, 16);
+    Put16(&header, format.type == SampleType::kFloat32 ? 3 : 1);
+    Put16(&header, static_cast<uint32_t>(format.channels));
+    Put32(&header, static_cast<uint32_t>(format.sample_rate));
+    Put32(&header, static_cast<uint32_t>(format.sample_rate) * block);
+    Put16(&header, block);
+    Put16(&header, static_cast<uint32_t>(format.BytesPerSample() * 8));
+    header.insert(header.end(), { 'd', 'a', 't', 'a' });
+    Put32(&header, static_cast<uint32_t>(data.size()));
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+} // namespace
+
+bool RunFormatCheck(const FormatCheckOptions& options, FormatCheckReport* report)
+{
+    *report = FormatCheckReport();
+    const size_t segments = sizeof(kFormats) / sizeof(kFormats[0]);
+    const size_t segment_samples = static_cast<size_t>(options.segment_seconds * recording::kSampleRate);
+
+    std::vector<float> audio;
+    recording::Reader reader;
+    if (!reader.Open(options.recording)) {
+        LOG_ERROR("FormatCheck", "cannot open recording %s", WStringToUtf8(options.recording).c_str());
+        return false;
+    }
+    recording::Chunk chunk;
+    while (audio.size() < segments * segment_samples && reader.Next(&chunk))
+        audio.insert(audio.end(), chunk.samples.begin(), chunk.samples.end());
+    if (audio.size() < segments * segment_samples) {
+        LOG_ERROR("FormatCheck", "recording shorter than %zu segments of %.1f s", segments, options.segment_seconds);
+        return false;
+    }
+
+    std::wstring dir = options.work_dir;
+    if (dir.empty()) {
+        wchar_t temp[MAX_PATH] = { 0 };
+        GetTempPathW(MAX_PATH, temp);
+        dir = temp;
+    }
+    if (!dir.empty() && dir.back() != L'\\') dir += L'\\';
+    std::vector<std::wstring> files;
+    for (size_t i = 0; i < segments; ++i) {
+        files.push_back(dir + L"instanttrans-format-check-" + std::to_wstring(i) + L".wav");
+        if (!WriteWav(files.back(), kFormats[i], audio.data() + i * segment_samples, segment_samples)) {
+            LOG_ERROR("FormatCheck", "cannot write %s", WStringToUtf8(files.back()).c_str());
+            return false;
+        }
+        report->segments.push_back({ FormatName(kFormats[i]), 0 });
+    }
+
+    MessageBus bus;
+    std::mutex mutex;
+    std::vector<int64_t> result_ms;   // 各识别结果的音频时钟终点
+    bus.AddRecognitionListener([&](const RecognitionMessage& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        result_ms.push_back(msg.audio_end_ms);
+    });
+
+    auto script = std::make_unique<WavScriptSource>(files);
+    WavScriptSource* source = script.get();
+    SpeechRecognizer recognizer(&bus);
+    recognizer.SwitchSource(std::move(script));
+    recognizer.Start();
+    const auto limit = SteadyClock::now()
+        + std::chrono::duration<double>(segments * options.segment_seconds * 2 + 300);
+    while (!source->Finished() && SteadyClock::now() < limit)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::this_thread::sleep_for(std::chrono::seconds(options.drain_seconds));
+    recognizer.Stop();
+    for (const std::wstring& f : files) DeleteFileW(f.c_str());
+
+    CaptureStats capture = recognizer.GetCaptureStats();
+    report->format_changes = capture.format_changes;
+    report->device_losses = capture.device_losses;
+    report->lost_ms = capture.lost_ms;
+
+    // 第 i 段在音频时钟上的起点最多比名义位置晚 i 次补零；只数肯定属于本段的区间
+    const int64_t segment_ms = static_cast<int64_t>(options.segment_seconds * 1000);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < segments; ++i) {
+            const int64_t begin = static_cast<int64_t>(i) * (segment_ms + options.max_gap_ms);
+            const int64_t end = static_cast<int64_t>(i + 1) * segment_ms;
+            report->segments[i].results = static_cast<uint64_t>(std::count_if(result_ms.begin(), result_ms.end(),
+                [&](int64_t ms) { return ms > begin && ms <= end; }));
+        }
+    }
+
+    if (!source->Finished()) report->Violation("script did not finish, capture stalled?");
+    if (capture.format_changes != segments - 1)
+        report->Violation("%llu format changes counted, %zu scripted",
+            static_cast<unsigned long long>(capture.format_changes), segments - 1);
+    if (capture.device_losses > 0)
+        report->Violation("%llu format changes handled as device loss",
+            static_cast<unsigned long long>(capture.device_losses));
+    if (capture.lost_ms > static_cast<uint64_t>(options.max_gap_ms) * (segments - 1))
+        report->Violation("lost %llu ms over %zu changes, limit %d ms each",
+            static_cast<unsigned long long>(capture.lost_ms), segments - 1, options.max_gap_ms);
+    for (const FormatCheckSegment& s : report->segments) {
+        if (s.results == 0) report->Violation("%s: no recognition output", s.format.c_str());
+    }
+    return true;
+}
+
+int RunFormatCheckCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    FormatCheckOptions options;
+    ArgParser()
+        .Option(L"--segment-seconds", &options.segment_seconds)
+        .Option(L"--max-gap-ms", &options.max_gap_ms)
+        .Positional(&options.recording)
+        .Parse(argc, argv);
+    if (options.recording.empty() || options.segment_seconds <= 0 || options.max_gap_ms < 0) {
+        printf("usage: InstantTrans.exe --format-check <recording.itrec> [--segment-seconds S] [--max-gap-ms M]\n");
+        return 2;
+    }
+
+    FormatCheckReport r;
+    if (!RunFormatCheck(options, &r)) {
+        printf("[FormatCheck] cannot prepare the scripted wav files\n");
+        return 2;
+    }
+
+    for (const FormatCheckSegment& s : r.segments)
+        printf("[FormatCheck] %-18s results=%llu\n", s.format.c_str(), static_cast<unsigned long long>(s.results));
+    printf("[FormatCheck] format_changes=%llu device_losses=%llu lost_ms=%llu\n",
+        static_cast<unsigned long long>(r.format_changes), static_cast<unsigned long long>(r.device_losses),
+        static_cast<unsigned long long>(r.lost_ms));
+    return PrintVerdict("FormatCheck", r);
+}
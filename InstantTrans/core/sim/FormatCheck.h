@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 格式变化自检：把一段录音依次编码成几种采样率/声道数/采样格式的 wav，由 WavScriptSource 连续回放给
+// 运行中的 SpeechRecognizer，每换一个文件触发一次格式变化，检查：
+//   每次变化都按格式变化重建了转换状态，没有被当成设备失效；
+//   每次变化丢失的音频不超过 max_gap_ms；
+//   识别在每一段里都有输出，VAD 与识别状态没有因为格式变化中断：
+//
+//   InstantTrans.exe --format-check session.itrec --segment-seconds 10
+struct FormatCheckOptions {
+    std::wstring recording;          // SessionRecorder 录下的 .itrec，需含语音
+    double segment_seconds = 10.0;   // 每种格式的时长
+    int32_t max_gap_ms = 200;        // 每次格式变化允许丢失的音频
+    int32_t drain_seconds = 5;       // 放完后等待识别追上
+    std::wstring work_dir;           // 生成 wav 的目录；为空时用临时目录
+};
+
+struct FormatCheckSegment {
+    std::string format;              // 如 "48000Hz/2ch/f32"
+    uint64_t results = 0;            // 音频时钟落在本段内的识别结果数（含片段）
+};
+
+struct FormatCheckReport : CheckReport {
+    std::vector<FormatCheckSegment> segments;
+    uint64_t format_changes = 0;     // CaptureStats::format_changes
+    uint64_t device_losses = 0;
+    uint64_t lost_ms = 0;
+};
+
+// 录音读取或 wav 写入失败返回 false
+bool RunFormatCheck(const FormatCheckOptions& options, FormatCheckReport* report);
+
+// 命令行入口：InstantTrans.exe --format-check <recording.itrec> [--segment-seconds S] [--max-gap-ms M]
+// 全部检查通过返回 0，否则返回 1
+int RunFormatCheckCommandLine(int argc, wchar_t** argv);
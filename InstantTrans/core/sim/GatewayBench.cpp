@@ -0,0 +1,141 @@
+#define NOMINMAX
+#include "GatewayBench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include <Windows.h>
+
+#include "core/metrics/Log.h"
+#include "core/translate/WebSocketBackend.h"
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+int64_t Percentile(std::vector<int64_t> v, double p)
+{
+    if (v.empty()) return 0;
+    size_t k = std::min(v.size() - 1, static_cast<size_t>(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+} // namespace
+
+bool RunGatewayBench(const GatewayBenchOptions& options, GatewayBenchReport* report)
+{
+    *report = GatewayBenchReport();
+    WebSocketOptions ws_options;
+    ws_options.urls = GatewayUrlsFromEnvironment();
+    ws_options.rate_per_sec = options.rate_per_sec;
+    ws_options.burst = std::max(4.0, options.rate_per_sec);
+    WebSocketBackend backend(ws_options);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_set<uint64_t> pending;
+    std::vector<int64_t> latency_ms;
+    backend.SetResultCallback([&](const TranslationResult& result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // 合并的请求只回调一次，较早的 id 列在 merged_ids 里
+        uint64_t n = 1 + result.merged_ids.size();
+        pending.erase(result.id);
+        for (uint64_t id : result.merged_ids) pending.erase(id);
+        if (result.ok) {
+            report->ok += n;
+            latency_ms.push_back(result.latency_us / 1000);
+        }
+        else {
+            report->failed += n;
+        }
+        cv.notify_all();
+    });
+    if (!backend.Start()) return false;
+
+    for (int32_t i = 0; i < options.requests; ++i) {
+        TranslationRequest request;
+        request.id = static_cast<uint64_t>(i) + 1;
+        request.text = "gateway bench sentence " + std::to_string(i);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.insert(request.id);
+        }
+        backend.Submit(std::move(request));
+        ++report->submitted;
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.interval_ms));
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait_for(lock, std::chrono::milliseconds(options.drain_ms), [&] { return pending.empty(); });
+        report->lost = pending.size();
+    }
+    backend.Stop();
+
+    for (const WebSocketBackend::EndpointStats& s : backend.GetEndpointStats())
+        report->endpoints.push_back({ s.url, s.sent, s.answered, s.failed_over, s.ewma_ms });
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        report->latency_p50_ms = Percentile(latency_ms, 0.50);
+        report->latency_p95_ms = Percentile(latency_ms, 0.95);
+    }
+
+    if (report->lost > 0)
+        report->Violation("%llu requests never called back", static_cast<unsigned long long>(report->lost));
+    if (report->failed > options.max_fail_ratio * report->submitted)
+        report->Violation("%llu of %llu requests failed (limit %.1f%%)", static_cast<unsigned long long>(report->failed),
+            static_cast<unsigned long long>(report->submitted), options.max_fail_ratio * 100);
+    for (const GatewayBenchEndpoint& ep : report->endpoints) {
+        if (ep.answered == 0) report->Violation("%s never answered, was it probed?", ep.url.c_str());
+    }
+    // 路由按延迟加权：最快的实例应当比最慢的实例分到更多请求
+    if (report->endpoints.size() >= 2) {
+        auto by_ewma = [](const GatewayBenchEndpoint& a, const GatewayBenchEndpoint& b) { return a.ewma_ms < b.ewma_ms; };
+        const GatewayBenchEndpoint& fast = *std::min_element(report->endpoints.begin(), report->endpoints.end(), by_ewma);
+        const GatewayBenchEndpoint& slow = *std::max_element(report->endpoints.begin(), report->endpoints.end(), by_ewma);
+        if (fast.ewma_ms < slow.ewma_ms && fast.answered <= slow.answered)
+            report->Violation("%s (%.0f ms) answered %llu, not more than %s (%.0f ms) with %llu", fast.url.c_str(),
+                fast.ewma_ms, static_cast<unsigned long long>(fast.answered), slow.url.c_str(), slow.ewma_ms,
+                static_cast<unsigned long long>(slow.answered));
+    }
+    return true;
+}
+
+int RunGatewayBenchCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    GatewayBenchOptions options;
+    ArgParser()
+        .Option(L"--requests", &options.requests)
+        .Option(L"--interval-ms", &options.interval_ms)
+        .Option(L"--rate", &options.rate_per_sec)
+        .Parse(argc, argv);
+    if (options.requests <= 0 || options.interval_ms < 0 || options.rate_per_sec <= 0) {
+        printf("usage: InstantTrans.exe --gateway-bench [--requests N] [--interval-ms M] [--rate R]\n");
+        return 2;
+    }
+
+    GatewayBenchReport r;
+    if (!RunGatewayBench(options, &r)) {
+        printf("[GatewayBench] no gateway configured, set INSTANTTRANS_GATEWAYS\n");
+        return 2;
+    }
+
+    printf("[GatewayBench] submitted=%llu ok=%llu failed=%llu lost=%llu latency p50=%lldms p95=%lldms\n",
+        static_cast<unsigned long long>(r.submitted), static_cast<unsigned long long>(r.ok),
+        static_cast<unsigned long long>(r.failed), static_cast<unsigned long long>(r.lost),
+        static_cast<long long>(r.latency_p50_ms), static_cast<long long>(r.latency_p95_ms));
+    printf("[GatewayBench] %-28s %6s %9s %12s %9s\n", "endpoint", "sent", "answered", "failed over", "ewma(ms)");
+    for (const GatewayBenchEndpoint& ep : r.endpoints) {
+        printf("[GatewayBench] %-28s %6llu %9llu %12llu %9.0f\n", ep.url.c_str(),
+            static_cast<unsigned long long>(ep.sent), static_cast<unsigned long long>(ep.answered),
+            static_cast<unsigned long long>(ep.failed_over), ep.ewma_ms);
+    }
+    return PrintVerdict("GatewayBench", r);
+}
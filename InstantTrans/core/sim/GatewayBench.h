@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 多实例网关自检：对 INSTANTTRANS_GATEWAYS 指向的几个桩按固定节奏提交翻译请求，检查
+// 没有请求丢失、失败比例在阈值内、每个实例都被探测过、延迟最低的实例分到的请求多于最高的实例：
+//
+//   go run ./cmd/ratelimit-stub -addr :8081 -rate 100 -burst 100 -latency 100ms
+//   go run ./cmd/ratelimit-stub -addr :8082 -rate 100 -burst 100 -latency 400ms -jitter 200ms
+//   go run ./cmd/ratelimit-stub -addr :8083 -rate 100 -burst 100 -latency 100ms -drop 0.05
+//   set INSTANTTRANS_GATEWAYS=ws://127.0.0.1:8081/ws,ws://127.0.0.1:8082/ws,ws://127.0.0.1:8083/ws
+//   InstantTrans.exe --gateway-bench --requests 300
+struct GatewayBenchOptions {
+    int32_t requests = 300;
+    int32_t interval_ms = 50;        // 提交间隔
+    double rate_per_sec = 30.0;      // WebSocketOptions::rate_per_sec，需低于各桩 -rate 之和
+    double max_fail_ratio = 0.01;    // 两次尝试都落在故障实例上的请求
+    int32_t drain_ms = 30000;        // 全部提交后等待结果的上限
+};
+
+struct GatewayBenchEndpoint {
+    std::string url;
+    uint64_t sent = 0;
+    uint64_t answered = 0;
+    uint64_t failed_over = 0;
+    double ewma_ms = 0;
+};
+
+struct GatewayBenchReport : CheckReport {
+    std::vector<GatewayBenchEndpoint> endpoints;
+    uint64_t submitted = 0;
+    uint64_t ok = 0;
+    uint64_t failed = 0;
+    uint64_t lost = 0;               // drain_ms 内没有回调的请求
+    int64_t latency_p50_ms = 0;
+    int64_t latency_p95_ms = 0;
+};
+
+// 网关地址列表为空或后端无法启动时返回 false
+bool RunGatewayBench(const GatewayBenchOptions& options, GatewayBenchReport* report);
+
+// 命令行入口：InstantTrans.exe --gateway-bench [--requests N] [--interval-ms M] [--rate R]
+// 满足上述检查时返回 0，否则返回 1
+int RunGatewayBenchCommandLine(int argc, wchar_t** argv);
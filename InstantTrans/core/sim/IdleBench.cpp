@@ -0,0 +1,280 @@
+#define NOMINMAX
+#include "IdleBench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <Windows.h>
+
+#include "core/ipc/MessageBus.h"
+#include "core/metrics/Log.h"
+#include "core/recoginize/AudioSource.h"
+#include "core/recoginize/ModelFiles.h"
+#include "core/recoginize/ReplaySource.h"
+#include "core/recoginize/SpeechRecognize.h"
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Start 之后等模型可用的上限，包含首轮的线程数自动校准
+const auto kLoadTimeout = std::chrono::seconds(300);
+
+template <typename T>
+T Median(std::vector<T> v)
+{
+    if (v.empty()) return T();
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+void SleepSeconds(double seconds)
+{
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+int64_t ProcessCpu100ns()
+{
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0;
+    auto ticks = [](const FILETIME& t) {
+        return (static_cast<int64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return ticks(kernel) + ticks(user);
+}
+
+// 按实时节奏交出约 -75 dBFS 的底噪，低于能量门限的关闭阈值；
+// 数据包不标记静音，门限需要逐窗口计算能量，与真实设备的安静底噪一致
+class QuietSource : public AudioSource {
+public:
+    bool Open() override {
+        if (begin_ == SteadyClock::time_point()) begin_ = SteadyClock::now();
+        return true;
+    }
+    void Close() override {}
+
+    AudioFormat Format() const override {
+        AudioFormat format;
+        format.sample_rate = kSampleRate;
+        format.channels = 1;
+        format.type = SampleType::kFloat32;
+        return format;
+    }
+
+    ReadStatus Read(AudioPacket& packet, int32_t timeout_ms) override {
+        auto due = begin_ + std::chrono::microseconds(sent_ * 1000000 / kSampleRate);
+        auto limit = std::min(due, SteadyClock::now() + std::chrono::milliseconds(timeout_ms));
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_until(lock, limit, [this] { return interrupted_; });
+            if (interrupted_) {
+                interrupted_ = false;
+                return ReadStatus::kTimeout;
+            }
+        }
+        if (SteadyClock::now() < due) return ReadStatus::kTimeout;
+
+        for (float& s : samples_) {
+            seed_ = seed_ * 1664525u + 1013904223u;
+            s = (static_cast<int32_t>((seed_ >> 16) & 0xFFFF) - 32768) / 32768.0f * 3e-4f;
+        }
+        packet = AudioPacket();
+        packet.data = reinterpret_cast<const uint8_t*>(samples_);
+        packet.frames = kPacketSamples;
+        packet.converted = true;
+        sent_ += kPacketSamples;
+        return ReadStatus::kData;
+    }
+    void Release(const AudioPacket&) override {}
+
+    void Interrupt() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            interrupted_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    std::wstring Name() const override { return L"quiet"; }
+
+private:
+    static const int32_t kSampleRate = 16000;
+    static const uint32_t kPacketSamples = kSampleRate / 100;
+
+    float samples_[kPacketSamples];
+    uint32_t seed_ = 1;
+    int64_t sent_ = 0;
+    SteadyClock::time_point begin_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool interrupted_ = false;
+};
+
+// 静音输入下运行中的进程 CPU（占一个核心的百分比），模型未就绪时返回 -1
+double SilentCpuPercent(const IdleBenchOptions& options, bool energy_gate)
+{
+    MessageBus bus;
+    RecognizerOptions recognizer_options;
+    recognizer_options.energy_gate = energy_gate;
+    recognizer_options.idle_unload_ms = 0;
+    // 不在测量期间释放缓冲，两种设置只差 VAD 前的门限
+    recognizer_options.idle_trim_ms = 0;
+    SpeechRecognizer recognizer(&bus, recognizer_options);
+    recognizer.SwitchSource(std::make_unique<QuietSource>());
+
+    const auto begin = SteadyClock::now();
+    recognizer.Start();
+    while (!recognizer.GetIdleStats().model_loaded) {
+        if (SteadyClock::now() - begin > kLoadTimeout) {
+            recognizer.Stop();
+            return -1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // 等启动时的加载与校准平息后再计
+    SleepSeconds(1.0);
+
+    const int64_t cpu_before = ProcessCpu100ns();
+    const auto measure_begin = SteadyClock::now();
+    SleepSeconds(options.silent_seconds);
+    const double wall = std::chrono::duration<double>(SteadyClock::now() - measure_begin).count();
+    const double percent = (ProcessCpu100ns() - cpu_before) / 1e7 / wall * 100;
+    recognizer.Stop();
+    LOG_INFO("IdleBench", "silent input, energy gate %s: cpu=%.2f%%", energy_gate ? "on" : "off", percent);
+    return percent;
+}
+
+bool RunPolicy(const IdleBenchOptions& options, const std::string& policy, IdleBenchResult* result)
+{
+    MessageBus bus;
+    std::atomic<uint64_t> results{ 0 };
+    bus.AddRecognitionListener([&results](const RecognitionMessage&) { results.fetch_add(1); });
+
+    RecognizerOptions recognizer_options;
+    // 只测 Stop 后的卸载：运行中不卸载，录音里的长停顿不会让 unloads 虚高或拖慢识别
+    recognizer_options.idle_unload_ms = 0;
+    recognizer_options.stopped_unload_ms = policy == "unload" ? options.unload_ms : 0;
+    SpeechRecognizer recognizer(&bus, recognizer_options);
+
+    std::vector<int64_t> resume_ms;
+    std::vector<double> active_rss, idle_rss;
+    for (int32_t cycle = 0; cycle < options.cycles; ++cycle) {
+        ReplayOptions replay_options;
+        replay_options.loop = true;
+        replay_options.start_ms = static_cast<int64_t>(cycle * options.active_seconds * 1000);
+        recognizer.SwitchSource(std::make_unique<ReplaySource>(options.recording, replay_options));
+
+        const auto begin = SteadyClock::now();
+        recognizer.Start();
+        while (!recognizer.GetIdleStats().model_loaded) {
+            if (SteadyClock::now() - begin > kLoadTimeout) {
+                recognizer.Stop();
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        int64_t ready_ms = std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - begin).count();
+        if (cycle == 0) result->first_load_ms = ready_ms;
+        else resume_ms.push_back(ready_ms);
+
+        SleepSeconds(options.active_seconds);
+        active_rss.push_back(GetProcessRss() / 1048576.0);
+        recognizer.Stop();
+
+        SleepSeconds(options.idle_seconds);
+        idle_rss.push_back(GetProcessRss() / 1048576.0);
+        LOG_INFO("IdleBench", "%s cycle %d: ready=%lldms active_rss=%.1fMB idle_rss=%.1fMB",
+            policy.c_str(), cycle, static_cast<long long>(ready_ms), active_rss.back(), idle_rss.back());
+    }
+
+    result->policy = policy;
+    result->resume_p50_ms = Median(resume_ms);
+    result->resume_max_ms = resume_ms.empty() ? 0 : *std::max_element(resume_ms.begin(), resume_ms.end());
+    result->active_rss_mb = Median(active_rss);
+    result->idle_rss_mb = Median(idle_rss);
+    result->unloads = recognizer.GetIdleStats().unloads;
+    result->results = results.load();
+    return true;
+}
+
+} // namespace
+
+bool RunIdleBench(const IdleBenchOptions& options, IdleBenchReport* report)
+{
+    *report = IdleBenchReport();
+    for (const char* policy : { "keep", "unload" }) {
+        IdleBenchResult result;
+        if (!RunPolicy(options, policy, &result)) {
+            LOG_ERROR("IdleBench", "%s: model did not become ready", policy);
+            return false;
+        }
+        report->results.push_back(result);
+    }
+
+    report->silent_cpu_gate_on = SilentCpuPercent(options, true);
+    report->silent_cpu_gate_off = SilentCpuPercent(options, false);
+    if (report->silent_cpu_gate_on < 0 || report->silent_cpu_gate_off < 0) {
+        LOG_ERROR("IdleBench", "silent input: model did not become ready");
+        return false;
+    }
+
+    const IdleBenchResult& keep = report->results[0];
+    const IdleBenchResult& unload = report->results[1];
+    for (const IdleBenchResult& r : report->results) {
+        if (r.results == 0) report->Violation("%s: no recognition result, check the recording", r.policy.c_str());
+    }
+    if (unload.unloads < static_cast<uint64_t>(options.cycles))
+        report->Violation("unload: model unloaded %llu times in %d cycles, idle_seconds too short?",
+            static_cast<unsigned long long>(unload.unloads), options.cycles);
+    if (unload.idle_rss_mb >= keep.idle_rss_mb)
+        report->Violation("unload: idle RSS %.1f MB is not below keep %.1f MB", unload.idle_rss_mb, keep.idle_rss_mb);
+    if (report->silent_cpu_gate_on >= report->silent_cpu_gate_off)
+        report->Violation("silent input: CPU %.2f%% with the energy gate is not below %.2f%% without it",
+            report->silent_cpu_gate_on, report->silent_cpu_gate_off);
+    return true;
+}
+
+int RunIdleBenchCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    IdleBenchOptions options;
+    ArgParser()
+        .Option(L"--cycles", &options.cycles)
+        .Option(L"--active-seconds", &options.active_seconds)
+        .Option(L"--idle-seconds", &options.idle_seconds)
+        .Option(L"--unload-ms", &options.unload_ms)
+        .Option(L"--silent-seconds", &options.silent_seconds)
+        .Positional(&options.recording)
+        .Parse(argc, argv);
+    if (options.recording.empty() || options.cycles < 2 || options.unload_ms <= 0 || options.silent_seconds <= 0) {
+        printf("usage: InstantTrans.exe --idle-bench <recording.itrec> [--cycles N] [--active-seconds S] "
+            "[--idle-seconds S] [--unload-ms M] [--silent-seconds S]\n");
+        return 2;
+    }
+
+    IdleBenchReport r;
+    if (!RunIdleBench(options, &r)) {
+        printf("[IdleBench] recognizer did not start\n");
+        return 2;
+    }
+
+    printf("[IdleBench] %7s %10s %10s %10s %11s %9s %8s\n", "policy", "first(ms)", "resume p50", "resume max",
+        "active(MB)", "idle(MB)", "unloads");
+    for (const IdleBenchResult& x : r.results) {
+        printf("[IdleBench] %7s %10lld %10lld %10lld %11.1f %9.1f %8llu\n", x.policy.c_str(),
+            static_cast<long long>(x.first_load_ms), static_cast<long long>(x.resume_p50_ms),
+            static_cast<long long>(x.resume_max_ms), x.active_rss_mb, x.idle_rss_mb,
+            static_cast<unsigned long long>(x.unloads));
+    }
+    printf("[IdleBench] silent input cpu: energy gate on=%.2f%% off=%.2f%%\n",
+        r.silent_cpu_gate_on, r.silent_cpu_gate_off);
+    return PrintVerdict("IdleBench", r);
+}
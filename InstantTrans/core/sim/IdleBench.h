@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 空闲回收基准：反复“回放识别一段 -> Stop -> 空闲 -> Start”，比较两种空闲策略下的
+// 空闲工作集与恢复耗时（Start 到识别模型可用）：
+//   keep     模型常驻，只释放工作缓冲
+//   unload   Stop 后超过 unload_ms 卸载模型，Start 时从页缓存中的模型文件重新加载
+// 另外以低于能量门限的底噪持续输入，比较能量门限开、关时运行中的进程 CPU
+//
+//   InstantTrans.exe --idle-bench session.itrec --cycles 5 --idle-seconds 10
+struct IdleBenchOptions {
+    std::wstring recording;          // SessionRecorder 录下的 .itrec，各轮从不同位置开始回放
+    int32_t cycles = 5;              // 每种策略的轮数；第一轮的加载计为首次加载，不计入恢复
+    double active_seconds = 20.0;
+    double idle_seconds = 10.0;      // 需大于 unload_ms
+    int32_t unload_ms = 2000;        // unload 策略的 RecognizerOptions::stopped_unload_ms
+    double silent_seconds = 10.0;    // 静音输入时每种门限设置测 CPU 的时长
+};
+
+struct IdleBenchResult {
+    std::string policy;
+    int64_t first_load_ms = 0;
+    int64_t resume_p50_ms = 0;
+    int64_t resume_max_ms = 0;
+    double active_rss_mb = 0;        // 各轮 Stop 前的工作集中位数
+    double idle_rss_mb = 0;          // 各轮空闲结束时的工作集中位数
+    uint64_t unloads = 0;
+    uint64_t results = 0;            // 收到的识别结果数，确认每轮确实在识别
+};
+
+struct IdleBenchReport : CheckReport {
+    std::vector<IdleBenchResult> results;
+    // 静音输入时的进程 CPU（占一个核心的百分比）
+    double silent_cpu_gate_on = 0;
+    double silent_cpu_gate_off = 0;
+};
+
+bool RunIdleBench(const IdleBenchOptions& options, IdleBenchReport* report);
+
+// 命令行入口：InstantTrans.exe --idle-bench <recording.itrec> [--cycles N] [--active-seconds S]
+//   [--idle-seconds S] [--unload-ms M] [--silent-seconds S]
+// unload 策略每轮都卸载了模型、空闲工作集低于 keep，且能量门限降低了静音 CPU 时返回 0，否则返回 1
+int RunIdleBenchCommandLine(int argc, wchar_t** argv);
@@ -0,0 +1,270 @@
+#define NOMINMAX
+#include "IngestCheck.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include <Windows.h>
+
+#include "core/metrics/Log.h"
+#include "core/recoginize/AudioIngest.h"
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+const int32_t kSampleRate = 16000;
+const size_t kMaxFill = kSampleRate;   // 与 CaptureLoop 一致：缺口最多补零 1 秒
+
+// 设备时钟上第 pos 个采样的值，非零，便于区分补零
+float Pattern(int64_t pos)
+{
+    return static_cast<float>(1 + pos % 997);
+}
+
+int64_t ProcessCpu100ns()
+{
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0;
+    auto ticks = [](const FILETIME& t) {
+        return (static_cast<int64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return ticks(kernel) + ticks(user);
+}
+
+int64_t Percentile(std::vector<int64_t> v, double p)
+{
+    if (v.empty()) return 0;
+    size_t k = std::min(v.size() - 1, static_cast<size_t>(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+// 生产端记录的事实，消费端据此校验
+struct Timeline {
+    std::mutex mutex;
+    std::vector<std::pair<int64_t, int64_t>> zeros;              // 补零或静音的 [begin, end)
+    std::vector<std::pair<int64_t, SteadyClock::time_point>> pushes;   // 每次交付（含补零）结束的位置与交付时刻
+    int64_t skipped = 0;             // 超出补零上限、只推进时钟的采样数
+
+    bool IsZero(int64_t pos) {
+        for (const auto& r : zeros) {
+            if (pos >= r.first && pos < r.second) return true;
+        }
+        return false;
+    }
+};
+
+// 合成设备：按墙钟计算应交付的采样，成簇交付；输出注入的缺口、不连续次数与交付的包数
+void Produce(const IngestCheckOptions& options, AudioIngestQueue* queue, Timeline* timeline,
+    uint64_t* gaps, uint64_t* discontinuities, uint64_t* packets)
+{
+    std::mt19937 rng(options.seed);
+    std::uniform_int_distribution<int32_t> burst(1, std::max(1, options.burst));
+    std::uniform_int_distribution<int32_t> jitter(0, std::max(0, options.jitter_ms));
+
+    const int64_t packet = static_cast<int64_t>(kSampleRate) * options.packet_ms / 1000;
+    const int64_t total = static_cast<int64_t>(options.seconds * kSampleRate);
+    const int64_t gap_every = static_cast<int64_t>(kSampleRate) * options.gap_every_ms / 1000;
+    const int64_t discontinuity_every = static_cast<int64_t>(kSampleRate) * options.discontinuity_every_ms / 1000;
+    const int64_t long_gap_at = total / 2;
+    std::vector<float> buf(static_cast<size_t>(packet));
+
+    int64_t pos = 0;                 // 设备时钟
+    int64_t next_gap = gap_every;
+    int64_t next_discontinuity = discontinuity_every;
+    bool long_gap_done = false;
+    uint64_t packet_index = 0;
+    const auto begin = SteadyClock::now();
+    while (pos < total) {
+        // 模拟设备事件迟到：睡过 1..burst 个周期再加抖动，醒来后把到期的包一次交付
+        std::this_thread::sleep_for(std::chrono::milliseconds(burst(rng) * options.packet_ms + jitter(rng)));
+        const int64_t due = std::min(total,
+            std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - begin).count()
+            * kSampleRate / 1000000);
+
+        while (pos + packet <= due) {
+            int64_t lost = 0;
+            if (!long_gap_done && pos >= long_gap_at) {
+                long_gap_done = true;
+                lost = static_cast<int64_t>(kSampleRate) * options.long_gap_ms / 1000;
+            }
+            else if (gap_every > 0 && pos >= next_gap) {
+                next_gap += gap_every;
+                lost = static_cast<int64_t>(kSampleRate) * options.gap_ms / 1000;
+            }
+            if (lost > 0) {
+                const int64_t fill = std::min<int64_t>(lost, kMaxFill);
+                {
+                    std::lock_guard<std::mutex> lock(timeline->mutex);
+                    timeline->zeros.emplace_back(pos, pos + fill);
+                    timeline->skipped += lost - fill;
+                    timeline->pushes.emplace_back(pos + fill, SteadyClock::now());
+                }
+                queue->MarkGap(static_cast<size_t>(lost), kMaxFill);
+                pos += lost;
+                ++*gaps;
+                continue;
+            }
+            if (discontinuity_every > 0 && pos >= next_discontinuity) {
+                next_discontinuity += discontinuity_every;
+                queue->MarkDiscontinuity();
+                ++*discontinuities;
+            }
+
+            const bool silent = options.silent_every > 0 && ++packet_index % options.silent_every == 0;
+            for (int64_t i = 0; i < packet; ++i) buf[static_cast<size_t>(i)] = silent ? 0.0f : Pattern(pos + i);
+            {
+                // 先记下再交付，消费端取到块时一定能找到对应的记录
+                std::lock_guard<std::mutex> lock(timeline->mutex);
+                if (silent) timeline->zeros.emplace_back(pos, pos + packet);
+                timeline->pushes.emplace_back(pos + packet, SteadyClock::now());
+            }
+            queue->Push(buf.data(), buf.size(), silent);
+            pos += packet;
+            ++*packets;
+        }
+    }
+}
+
+} // namespace
+
+void RunIngestCheck(const IngestCheckOptions& options, IngestCheckReport* report)
+{
+    *report = IngestCheckReport();
+    const size_t chunk = static_cast<size_t>(kSampleRate) * options.chunk_ms / 1000;
+    AudioIngestQueue queue(chunk, 30 * 1000 / options.chunk_ms);
+    queue.Start();
+
+    Timeline timeline;
+    std::vector<int64_t> latency_us;
+    int64_t expected_start = 0;
+    int64_t jumped = 0;
+    uint64_t silent_mismatches = 0;
+    std::mutex idle_mutex;
+    SteadyClock::time_point last_pop = SteadyClock::now();
+
+    std::thread consumer([&] {
+        AudioChunk c;
+        size_t push_cursor = 0;
+        while (queue.Pop(c)) {
+            const auto popped = SteadyClock::now();
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex);
+                last_pop = popped;
+            }
+            ++report->chunks;
+            if (c.samples.size() != chunk) ++report->short_chunks;
+            if (c.start_sample > expected_start) jumped += c.start_sample - expected_start;
+            else if (c.start_sample < expected_start) report->mismatched_samples += c.samples.size();
+            expected_start = c.start_sample + static_cast<int64_t>(c.samples.size());
+
+            std::lock_guard<std::mutex> lock(timeline.mutex);
+            bool all_zero = true;
+            for (size_t i = 0; i < c.samples.size(); ++i) {
+                // 超出补零上限的缺口也推进音频时钟，时钟位置即设备位置
+                const int64_t clock_pos = c.start_sample + static_cast<int64_t>(i);
+                const float v = c.samples[i];
+                if (v != 0.0f) all_zero = false;
+                const bool ok = v == Pattern(clock_pos) || (v == 0.0f && timeline.IsZero(clock_pos));
+                if (!ok) ++report->mismatched_samples;
+            }
+            if (c.silent && !all_zero) ++silent_mismatches;
+
+            // 凑满本块的那次交付到被取走的时间；Flush 交出的末块不计
+            const int64_t end = expected_start;
+            while (push_cursor < timeline.pushes.size() && timeline.pushes[push_cursor].first < end) ++push_cursor;
+            if (push_cursor < timeline.pushes.size() && c.samples.size() == chunk)
+                latency_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                    popped - timeline.pushes[push_cursor].second).count());
+        }
+    });
+
+    uint64_t gaps = 0, discontinuities = 0, packets = 0;
+    Produce(options, &queue, &timeline, &gaps, &discontinuities, &packets);
+
+    // 交付结束后消费线程应阻塞在 Pop 上
+    const int64_t cpu_before = ProcessCpu100ns();
+    const auto idle_begin = SteadyClock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.idle_seconds));
+    const double idle_wall = std::chrono::duration<double>(SteadyClock::now() - idle_begin).count();
+    report->idle_cpu_percent = (ProcessCpu100ns() - cpu_before) / 1e7 / idle_wall * 100;
+
+    queue.Flush();
+    // 等消费线程取完 Flush 交出的块再停止
+    for (;;) {
+        if (queue.QueuedSamples() == 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    queue.Stop();
+    consumer.join();
+
+    IngestStats stats = queue.Stats();
+    report->packets = stats.packets;
+    report->gaps = stats.gaps;
+    report->discontinuities = stats.discontinuities;
+    report->latency_p50_us = Percentile(latency_us, 0.50);
+    report->latency_p99_us = Percentile(latency_us, 0.99);
+    report->latency_max_us = Percentile(latency_us, 1.0);
+
+    if (report->mismatched_samples > 0)
+        report->Violation("%llu samples out of place", static_cast<unsigned long long>(report->mismatched_samples));
+    if (silent_mismatches > 0)
+        report->Violation("%llu chunks flagged silent carry audio", static_cast<unsigned long long>(silent_mismatches));
+    if (jumped != timeline.skipped)
+        report->Violation("audio clock jumped %lld samples, expected %lld", static_cast<long long>(jumped),
+            static_cast<long long>(timeline.skipped));
+    if (stats.packets != packets)
+        report->Violation("%llu packets counted, %llu pushed", static_cast<unsigned long long>(stats.packets),
+            static_cast<unsigned long long>(packets));
+    if (stats.gaps != gaps)
+        report->Violation("%llu gaps counted, %llu injected", static_cast<unsigned long long>(stats.gaps),
+            static_cast<unsigned long long>(gaps));
+    if (stats.discontinuities != discontinuities)
+        report->Violation("%llu discontinuities counted, %llu injected",
+            static_cast<unsigned long long>(stats.discontinuities), static_cast<unsigned long long>(discontinuities));
+    if (stats.overflow_chunks > 0)
+        report->Violation("%llu chunks dropped although the consumer kept up",
+            static_cast<unsigned long long>(stats.overflow_chunks));
+    // 只有长缺口截断和最后的 Flush 会交出未满的块
+    if (report->short_chunks > 2)
+        report->Violation("%llu short chunks", static_cast<unsigned long long>(report->short_chunks));
+    if (report->latency_p99_us > options.max_latency_p99_us)
+        report->Violation("chunk latency p99 %lld us over %lld us", static_cast<long long>(report->latency_p99_us),
+            static_cast<long long>(options.max_latency_p99_us));
+    if (report->idle_cpu_percent > options.max_idle_cpu_percent)
+        report->Violation("idle CPU %.2f%% over %.2f%%", report->idle_cpu_percent, options.max_idle_cpu_percent);
+}
+
+int RunIngestCheckCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    IngestCheckOptions options;
+    ArgParser()
+        .Option(L"--seconds", &options.seconds)
+        .Option(L"--burst", &options.burst)
+        .Option(L"--jitter-ms", &options.jitter_ms)
+        .Option(L"--seed", &options.seed)
+        .Parse(argc, argv);
+    if (options.seconds <= 0 || options.burst <= 0 || options.jitter_ms < 0) {
+        printf("usage: InstantTrans.exe --ingest-check [--seconds S] [--burst N] [--jitter-ms M] [--seed N]\n");
+        return 2;
+    }
+
+    IngestCheckReport r;
+    RunIngestCheck(options, &r);
+    printf("[IngestCheck] packets=%llu chunks=%llu short=%llu gaps=%llu discontinuities=%llu\n",
+        static_cast<unsigned long long>(r.packets), static_cast<unsigned long long>(r.chunks),
+        static_cast<unsigned long long>(r.short_chunks), static_cast<unsigned long long>(r.gaps),
+        static_cast<unsigned long long>(r.discontinuities));
+    printf("[IngestCheck] chunk latency p50=%lldus p99=%lldus max=%lldus idle_cpu=%.2f%%\n",
+        static_cast<long long>(r.latency_p50_us), static_cast<long long>(r.latency_p99_us),
+        static_cast<long long>(r.latency_max_us), r.idle_cpu_percent);
+    return PrintVerdict("IngestCheck", r);
+}
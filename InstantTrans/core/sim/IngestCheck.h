@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 音频接入层自检：合成的“设备”按实时节奏产生 16kHz 音频，但以成簇、带抖动的数据包交付，
+// 期间注入缺口（含超过补零上限的长缺口）、不连续标记与静音包，经 AudioIngestQueue 交给消费线程，检查：
+//   每个采样都按音频时钟落在正确位置（缺口补零，超出上限的部分只推进时钟），块长固定；
+//   缺口、不连续与丢弃的计数与注入一致；块从凑满到被取走的延迟稳定；
+//   没有数据时消费线程阻塞等待，不占 CPU：
+//
+//   InstantTrans.exe --ingest-check --seconds 10 --burst 8 --jitter-ms 15
+struct IngestCheckOptions {
+    double seconds = 10.0;
+    int32_t chunk_ms = 20;
+    int32_t packet_ms = 10;          // 设备周期
+    int32_t burst = 8;               // 一次唤醒最多交付的包数，按 1..burst 随机
+    int32_t jitter_ms = 15;          // 唤醒时刻的随机抖动
+    int32_t gap_every_ms = 2000;     // 每隔这么久丢一段音频
+    int32_t gap_ms = 60;
+    int32_t long_gap_ms = 1500;      // 中途一次超过补零上限（1 秒）的长缺口
+    int32_t discontinuity_every_ms = 3000;
+    int32_t silent_every = 25;       // 每隔多少个包交付一个静音包
+    double idle_seconds = 1.0;       // 交付结束后的空闲观察时长
+    uint32_t seed = 1;
+
+    int64_t max_latency_p99_us = 5000;
+    double max_idle_cpu_percent = 1.0;
+};
+
+struct IngestCheckReport : CheckReport {
+    uint64_t packets = 0;
+    uint64_t chunks = 0;
+    uint64_t short_chunks = 0;       // 长缺口与 Flush 交出的未满块
+    uint64_t gaps = 0;
+    uint64_t discontinuities = 0;
+    uint64_t mismatched_samples = 0;
+    int64_t latency_p50_us = 0;
+    int64_t latency_p99_us = 0;
+    int64_t latency_max_us = 0;
+    double idle_cpu_percent = 0;
+};
+
+void RunIngestCheck(const IngestCheckOptions& options, IngestCheckReport* report);
+
+// 命令行入口：InstantTrans.exe --ingest-check [--seconds S] [--burst N] [--jitter-ms M] [--seed N]
+// 全部检查通过返回 0，否则返回 1
+int RunIngestCheckCommandLine(int argc, wchar_t** argv);
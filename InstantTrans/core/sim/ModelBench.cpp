@@ -0,0 +1,216 @@
+#define NOMINMAX
+#include "ModelBench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include <Windows.h>
+
+#include "core/metrics/Log.h"
+#include "core/recoginize/ModelFiles.h"
+#include "core/recoginize/SessionRecorder.h"
+#include "core/recoginize/SpeechRecognize.h"
+#include "core/recoginize/ThreadTuning.h"
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+template <typename T>
+T Median(std::vector<T> v)
+{
+    if (v.empty()) return T();
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+std::vector<float> LoadAudio(const ModelBenchOptions& options)
+{
+    const size_t max_samples = static_cast<size_t>(options.seconds * recording::kSampleRate);
+    if (options.recording.empty())
+        return ThreadTuning::MakeCalibrationClip(recording::kSampleRate, static_cast<float>(options.seconds));
+
+    std::vector<float> audio;
+    recording::Reader reader;
+    if (!reader.Open(options.recording)) {
+        LOG_ERROR("ModelBench", "cannot open recording %s", WStringToUtf8(options.recording).c_str());
+        return audio;
+    }
+    recording::Chunk chunk;
+    while (audio.size() < max_samples && reader.Next(&chunk))
+        audio.insert(audio.end(), chunk.samples.begin(), chunk.samples.end());
+    if (audio.size() > max_samples) audio.resize(max_samples);
+    return audio;
+}
+
+// 按 segment_ms 切块逐段解码，返回耗时（秒）；texts 不为空时收集各段的转写
+double DecodeAll(const sherpa_onnx::cxx::OfflineRecognizer& recognizer, const std::vector<float>& audio,
+    size_t segment, std::vector<std::string>* texts)
+{
+    auto begin = SteadyClock::now();
+    for (size_t pos = 0; pos < audio.size(); pos += segment) {
+        size_t n = std::min(segment, audio.size() - pos);
+        sherpa_onnx::cxx::OfflineStream stream = recognizer.CreateStream();
+        stream.AcceptWaveform(recording::kSampleRate, audio.data() + pos, static_cast<int32_t>(n));
+        recognizer.Decode(&stream);
+        std::string text = recognizer.GetResult(&stream).text;
+        if (texts) texts->push_back(std::move(text));
+    }
+    return std::chrono::duration<double>(SteadyClock::now() - begin).count();
+}
+
+// 按 UTF-8 码点切分，中日文逐字比较；空白不计
+std::vector<uint32_t> Codepoints(const std::string& text)
+{
+    std::vector<uint32_t> out;
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        size_t len = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        uint32_t cp = len == 1 ? c : c & (0xFF >> (len + 1));
+        for (size_t k = 1; k < len && i + k < text.size(); ++k)
+            cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+        if (cp != ' ' && cp != '\t') out.push_back(cp);
+        i += len;
+    }
+    return out;
+}
+
+// 两段码点序列的编辑距离，增删改各计 1
+size_t EditDistance(const std::vector<uint32_t>& ref, const std::vector<uint32_t>& hyp)
+{
+    std::vector<size_t> prev(hyp.size() + 1), cur(hyp.size() + 1);
+    for (size_t j = 0; j <= hyp.size(); ++j) prev[j] = j;
+    for (size_t i = 1; i <= ref.size(); ++i) {
+        cur[0] = i;
+        for (size_t j = 1; j <= hyp.size(); ++j)
+            cur[j] = std::min({ prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + (ref[i - 1] == hyp[j - 1] ? 0 : 1) });
+        prev.swap(cur);
+    }
+    return prev[hyp.size()];
+}
+
+// 同一切块的转写逐段对齐，错误率 = 编辑距离之和 / 参照字符数；参照为空时返回 0
+double CharErrorRate(const std::vector<std::string>& reference, const std::vector<std::string>& hypothesis)
+{
+    size_t errors = 0;
+    size_t chars = 0;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        std::vector<uint32_t> ref = Codepoints(reference[i]);
+        std::vector<uint32_t> hyp = i < hypothesis.size() ? Codepoints(hypothesis[i]) : std::vector<uint32_t>();
+        errors += EditDistance(ref, hyp);
+        chars += ref.size();
+    }
+    return chars > 0 ? static_cast<double>(errors) / chars : 0;
+}
+
+void RunPrecision(const ModelBenchOptions& options, ModelPrecision precision, int32_t threads,
+    const std::vector<float>& audio, ModelBenchResult* result, std::vector<std::string>* texts)
+{
+    RecognizerOptions recognizer_options;
+    recognizer_options.model_precision = precision;
+    result->precision = precision == ModelPrecision::kInt8 ? "int8" : "fp32";
+
+    const size_t segment = static_cast<size_t>(options.segment_ms) * recording::kSampleRate / 1000;
+    std::vector<int64_t> load_ms;
+    std::vector<double> rss_mb;
+    for (int32_t i = 0; i < options.loads; ++i) {
+        size_t rss_before = GetProcessRss();
+        auto begin = SteadyClock::now();
+        sherpa_onnx::cxx::OfflineRecognizer recognizer =
+            SpeechRecognizer::CreateOfflineRecognizer(recognizer_options, threads);
+        load_ms.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(SteadyClock::now() - begin).count());
+        size_t rss_after = GetProcessRss();
+        rss_mb.push_back((rss_after > rss_before ? rss_after - rss_before : 0) / 1048576.0);
+
+        // 只在最后一次加载后测解码；首段先解一遍，ONNX Runtime 的预热不计入
+        if (i + 1 == options.loads) {
+            std::vector<float> warmup(audio.begin(), audio.begin() + std::min(segment, audio.size()));
+            DecodeAll(recognizer, warmup, segment, nullptr);
+            double seconds = DecodeAll(recognizer, audio, segment, texts);
+            result->rtf = seconds * recording::kSampleRate / audio.size();
+            for (const std::string& text : *texts) result->chars += Codepoints(text).size();
+        }
+    }
+
+    result->first_load_ms = load_ms.front();
+    result->warm_load_ms = Median(std::vector<int64_t>(load_ms.begin() + 1, load_ms.end()));
+    result->rss_mb = Median(rss_mb);
+    LOG_INFO("ModelBench", "%s: first=%lldms warm=%lldms rss=+%.1fMB rtf=%.3f", result->precision.c_str(),
+        static_cast<long long>(result->first_load_ms), static_cast<long long>(result->warm_load_ms),
+        result->rss_mb, result->rtf);
+}
+
+} // namespace
+
+bool RunModelBench(const ModelBenchOptions& options, ModelBenchReport* report)
+{
+    *report = ModelBenchReport();
+    const std::vector<float> audio = LoadAudio(options);
+    if (audio.empty()) return false;
+
+    int32_t threads = options.threads;
+    if (threads <= 0) {
+        std::vector<int32_t> candidates = ThreadTuning::CandidateThreadCounts(ThreadTuning::GetLogicalCoreCount());
+        threads = *std::max_element(candidates.begin(), candidates.end());
+    }
+
+    ModelBenchResult fp32;
+    std::vector<std::string> fp32_texts;
+    RunPrecision(options, ModelPrecision::kFp32, threads, audio, &fp32, &fp32_texts);
+    report->results.push_back(fp32);
+
+    // int8 文件缺失时 ResolveSenseVoiceModel 会回退到 fp32，这里不重复测
+    if (ResolveSenseVoiceModel(ModelPrecision::kInt8).precision != ModelPrecision::kInt8) {
+        report->Violation("model.int8.onnx not found next to model.onnx");
+        return true;
+    }
+    ModelBenchResult int8;
+    std::vector<std::string> int8_texts;
+    RunPrecision(options, ModelPrecision::kInt8, threads, audio, &int8, &int8_texts);
+    int8.cer = CharErrorRate(fp32_texts, int8_texts);
+    report->results.push_back(int8);
+
+    for (const ModelBenchResult& r : report->results) {
+        if (r.chars == 0) report->Violation("%s: no recognition result, check the audio", r.precision.c_str());
+    }
+    if (int8.rtf >= fp32.rtf) report->Violation("int8 rtf %.3f is not below fp32 %.3f", int8.rtf, fp32.rtf);
+    if (int8.cer > options.max_cer)
+        report->Violation("int8 cer %.2f%% against fp32 exceeds %.2f%%", int8.cer * 100, options.max_cer * 100);
+    return true;
+}
+
+int RunModelBenchCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    ModelBenchOptions options;
+    ArgParser()
+        .Option(L"--threads", &options.threads)
+        .Option(L"--loads", &options.loads)
+        .Option(L"--seconds", &options.seconds)
+        .Option(L"--segment-ms", &options.segment_ms)
+        .Option(L"--max-cer", &options.max_cer)
+        .Positional(&options.recording)
+        .Parse(argc, argv);
+    if (options.loads < 2 || options.seconds <= 0 || options.segment_ms <= 0 || options.max_cer < 0) {
+        printf("usage: InstantTrans.exe --model-bench [recording.itrec] [--threads N] [--loads N] "
+            "[--seconds S] [--segment-ms M] [--max-cer R]\n");
+        return 2;
+    }
+
+    ModelBenchReport r;
+    if (!RunModelBench(options, &r)) {
+        printf("[ModelBench] cannot load audio\n");
+        return 2;
+    }
+
+    printf("[ModelBench] %9s %10s %10s %9s %7s %7s %8s\n", "precision", "first(ms)", "warm(ms)", "rss(MB)", "rtf",
+        "cer(%)", "chars");
+    for (const ModelBenchResult& x : r.results) {
+        printf("[ModelBench] %9s %10lld %10lld %9.1f %7.3f %7.2f %8llu\n", x.precision.c_str(),
+            static_cast<long long>(x.first_load_ms), static_cast<long long>(x.warm_load_ms), x.rss_mb, x.rtf,
+            x.cer * 100, static_cast<unsigned long long>(x.chars));
+    }
+    return PrintVerdict("ModelBench", r);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 模型精度基准：分别加载 fp32 与 int8 的 SenseVoice，测加载耗时、加载后工作集增量与解码实时率；
+// 同一段音频按语音段长度切块依次解码，与实时识别的单段解码一致；int8 的转写以 fp32 为参照算字符错误率：
+//
+//   InstantTrans.exe --model-bench session.itrec --threads 4 --loads 3
+struct ModelBenchOptions {
+    std::wstring recording;          // SessionRecorder 录下的 .itrec；为空时用合成的校准片段
+    int32_t threads = 0;             // intra-op 线程数，<= 0 时取候选线程数中最大的一个
+    int32_t loads = 3;               // 每种精度加载的次数；第一次可能要读盘，其后命中页缓存
+    double seconds = 60.0;           // 参与解码的音频时长
+    int32_t segment_ms = 5000;       // 每次解码的音频长度
+    double max_cer = 0.05;           // int8 相对 fp32 转写的字符错误率上限
+};
+
+struct ModelBenchResult {
+    std::string precision;
+    int64_t first_load_ms = 0;
+    int64_t warm_load_ms = 0;        // 其后各次加载的中位数
+    double rss_mb = 0;               // 加载后工作集增量的中位数
+    double rtf = 0;                  // 解码耗时 / 音频时长，不含首次解码的预热
+    uint64_t chars = 0;              // 识别出的字符数，确认确实在识别
+    double cer = 0;                  // 相对 fp32 转写的字符错误率，fp32 自身为 0
+};
+
+struct ModelBenchReport : CheckReport {
+    std::vector<ModelBenchResult> results;
+};
+
+// 音频读取失败返回 false
+bool RunModelBench(const ModelBenchOptions& options, ModelBenchReport* report);
+
+// 命令行入口：InstantTrans.exe --model-bench [recording.itrec] [--threads N] [--loads N] [--seconds S]
+//   [--segment-ms M] [--max-cer R]
+// 两种精度都能加载、都有识别结果、int8 解码快于 fp32 且字符错误率不超过上限时返回 0，否则返回 1
+int RunModelBenchCommandLine(int argc, wchar_t** argv);
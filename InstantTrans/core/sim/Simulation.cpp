@@ -0,0 +1,596 @@
+#define NOMINMAX
+#include "Simulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <queue>
+#include <random>
+#include <unordered_map>
+
+#include <Windows.h>
+
+#include "Clock.h"
+#include "controller/FlowController.h"
+#include "controller/SentenceStitcher.h"
+#include "core/metrics/AllocStats.h"
+#include "core/metrics/Log.h"
+#include "core/recoginize/DecodeScheduler.h"
+#include "core/recoginize/LoadGovernor.h"
+#include "core/translate/DispatchQueue.h"
+#include "core/translate/TranslationFanout.h"
+
+namespace {
+
+using Ms = std::chrono::milliseconds;
+
+// 按时间顺序执行的事件队列，同一时刻按加入顺序执行
+class EventLoop {
+public:
+    explicit EventLoop(VirtualClock* clock) : clock_(clock) {}
+
+    void At(Clock::time_point at, std::function<void()> fn) { events_.push({ at, seq_++, std::move(fn) }); }
+    void After(Clock::duration d, std::function<void()> fn) { At(clock_->Now() + d, std::move(fn)); }
+
+    void RunUntil(Clock::time_point until) {
+        while (!events_.empty() && events_.top().at <= until) {
+            Event e = std::move(const_cast<Event&>(events_.top()));
+            events_.pop();
+            clock_->AdvanceTo(e.at);
+            e.fn();
+        }
+    }
+
+private:
+    struct Event {
+        Clock::time_point at;
+        uint64_t seq;
+        std::function<void()> fn;
+        bool operator>(const Event& other) const {
+            return at != other.at ? at > other.at : seq > other.seq;
+        }
+    };
+
+    VirtualClock* clock_;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    uint64_t seq_ = 0;
+};
+
+// 脚本化翻译后端：延迟 = 基础 + 均匀抖动，偶发长尾；在途数受窗口限制，其余在 DispatchQueue 里排队
+class ScriptedTranslator : public TranslationBackend {
+public:
+    ScriptedTranslator(EventLoop* loop, VirtualClock* clock, const SimulationOptions& options, std::mt19937* rng)
+        : loop_(loop), options_(options), rng_(rng) {
+        SetClock(clock);
+    }
+
+    bool Start() override { return true; }
+    void Stop() override { LogShedStats(); }
+    const char* Name() const override { return "sim"; }
+
+    void Submit(TranslationRequest request) override {
+        CountSubmitted();
+        queue_.Push({ std::move(request) });
+        Pump();
+    }
+
+private:
+    struct Pending {
+        TranslationRequest request;
+    };
+
+    void Pump() {
+        queue_.ShedExpired(clock_->Now(), [this](Pending&& p) { Drop(p.request, {}, "expired"); },
+            [this](const Pending& p) { CountDemoted(p.request); });
+        while (in_flight_ < options_.translate_window && !queue_.Empty()) {
+            Pending p = queue_.PopFront();
+            int32_t ms = options_.translate_base_ms
+                + std::uniform_int_distribution<int32_t>(0, options_.translate_jitter_ms)(*rng_);
+            if (std::bernoulli_distribution(options_.translate_spike_ratio)(*rng_)) ms += options_.translate_spike_ms;
+            ++in_flight_;
+            loop_->After(Ms(ms), [this, p]() {
+                --in_flight_;
+                TranslationResult result;
+                result.id = p.request.id;
+                result.source_text = p.request.text;
+                result.ok = true;
+                for (const std::string& lang : p.request.langs_to)
+                    result.translations.push_back({ lang, "[" + lang + "] " + p.request.text });
+                Deliver(result, p.request);
+                Pump();
+            });
+        }
+    }
+
+    EventLoop* loop_;
+    const SimulationOptions& options_;
+    std::mt19937* rng_;
+    DispatchQueue<Pending> queue_;
+    int32_t in_flight_ = 0;
+};
+
+struct Utterance {
+    int64_t begin_ms;
+    int64_t end_ms;
+    std::vector<std::string> words;
+    std::vector<std::pair<int64_t, int64_t>> voiced_ms;   // 每个词的发声区间
+};
+
+std::vector<Utterance> GenerateScript(const SimulationOptions& options, std::mt19937* rng)
+{
+    static const char* kWords[] = { "the", "model", "latency", "budget", "we", "should", "measure",
+        "every", "stage", "of", "pipeline", "before", "shipping", "translation", "audio", "speaker",
+        "meeting", "slide", "question", "answer", "results", "quarter", "team", "next" };
+    static const char* kPhrases[] = { "thank you", "next slide please", "any questions",
+        "can you hear me", "let me share my screen" };
+
+    std::vector<Utterance> script;
+    const int64_t total_ms = static_cast<int64_t>(options.hours * 3600 * 1000);
+    std::uniform_int_distribution<int32_t> pause(options.pause_min_ms, options.pause_max_ms);
+    std::uniform_int_distribution<int32_t> length(options.utterance_min_ms, options.utterance_max_ms);
+    std::uniform_int_distribution<size_t> word(0, sizeof(kWords) / sizeof(kWords[0]) - 1);
+    std::uniform_int_distribution<size_t> phrase(0, sizeof(kPhrases) / sizeof(kPhrases[0]) - 1);
+    std::bernoulli_distribution repeat(options.repeat_ratio);
+    std::bernoulli_distribution gap_after(options.word_gap_ratio);
+
+    for (int64_t t = pause(*rng); t < total_ms; t += pause(*rng)) {
+        Utterance u;
+        u.begin_ms = t;
+        if (repeat(*rng)) {
+            std::string text = kPhrases[phrase(*rng)];
+            for (size_t pos = 0; pos != std::string::npos;) {
+                size_t space = text.find(' ', pos);
+                u.words.push_back(text.substr(pos, space == std::string::npos ? space : space - pos));
+                pos = space == std::string::npos ? space : space + 1;
+            }
+            u.end_ms = t + static_cast<int64_t>(u.words.size() * 1000 / options.words_per_second);
+        }
+        else {
+            u.end_ms = t + length(*rng);
+            size_t n = std::max<size_t>(1, static_cast<size_t>((u.end_ms - t) * options.words_per_second / 1000));
+            for (size_t i = 0; i < n; ++i) u.words.push_back(kWords[word(*rng)]);
+        }
+        // 词均匀分布；部分词后留停顿，其余连读，长句里可能找不到停顿而强制切分
+        const int64_t slot = (u.end_ms - u.begin_ms) / static_cast<int64_t>(u.words.size());
+        for (size_t i = 0; i < u.words.size(); ++i) {
+            int64_t begin = u.begin_ms + slot * static_cast<int64_t>(i);
+            if (i + 1 == u.words.size()) {
+                u.voiced_ms.emplace_back(begin, u.end_ms);
+                break;
+            }
+            int64_t gap = gap_after(*rng) ? std::min<int64_t>(options.word_gap_ms, slot / 3) : 0;
+            u.voiced_ms.emplace_back(begin, begin + slot - gap);
+        }
+        t = u.end_ms;
+        script.push_back(std::move(u));
+    }
+    return script;
+}
+
+int64_t Percentile(std::vector<int64_t> values, double q)
+{
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(q * values.size());
+    return values[std::min(index, values.size() - 1)];
+}
+
+// 识别线程的仿真：按脚本合成 16kHz 音频，每 chunk_ms 到达一块，与 RecognizeLoop 一样写入 AudioHistory，
+// 由同一个 DecodeScheduler（切块、片段节奏）和 LoadGovernor（片段间隔）在虚拟时钟上决定何时解码。
+// 只有模型被替换：VAD 按脚本判断语音起止，尾部静音满 min_silence 后吐出语音段；
+// 解码耗时按 decode_rtf 计入识别线程的忙碌时间，文本取发声中点落在解码区间内的脚本词。
+// 忙碌期间到达的块排队等待，积压与接入队列一样计入负载
+class ScriptedRecognizer {
+public:
+    using PostFn = std::function<void(Clock::time_point at, RecognitionMessage msg, int64_t speech_end_ms)>;
+
+    ScriptedRecognizer(EventLoop* loop, VirtualClock* clock, const SimulationOptions& options,
+        const std::vector<Utterance>* script, PostFn post)
+        : loop_(loop), clock_(clock), options_(options), script_(script), post_(std::move(post)),
+        history_(static_cast<size_t>(kSampleRate) * kHistorySeconds), scheduler_(SplitOptions(options)),
+        governor_(GovernorOptions(options)), start_(clock->Now()) {
+        chunk_samples_ = kSampleRate * options.chunk_ms / 1000;
+        chunk_.resize(static_cast<size_t>(chunk_samples_));
+        scratch_.resize(static_cast<size_t>(kSampleRate) * kHistorySeconds);
+        preroll_ = static_cast<int64_t>(kSampleRate) * options.preroll_ms / 1000;
+        min_silence_ = static_cast<int64_t>(kSampleRate) * options.min_silence_ms / 1000;
+
+        // 160Hz 的三次谐波作为“发声”，-80 dBFS 左右的噪声作为停顿
+        for (int32_t i = 0; i < kTonePeriod; ++i) {
+            double phase = 2 * 3.14159265358979 * i / kTonePeriod;
+            tone_[i] = static_cast<float>(0.6 * std::sin(phase) + 0.3 * std::sin(2 * phase) + 0.1 * std::sin(3 * phase));
+        }
+        uint32_t seed = options.seed;
+        for (float& x : noise_) {
+            seed = seed * 1664525u + 1013904223u;
+            x = (static_cast<float>(seed >> 8) / 16777216.0f - 0.5f) * 2e-4f;
+        }
+    }
+
+    // 音频按实时节奏到达，直到 until
+    void Start(Clock::time_point until) {
+        until_ = until;
+        loop_->At(start_ + Ms(options_.chunk_ms), [this] { OnArrival(); });
+    }
+
+private:
+    static const int32_t kSampleRate = 16000;
+    static const int32_t kHistorySeconds = 10;   // 与 RecognizeLoop 一致：最长语音段 + 余量
+    static const int32_t kTonePeriod = 100;
+    static const int32_t kNoiseSize = 4096;
+    static const int32_t kRampSamples = 320;     // 发声的起落各 20ms
+
+    static SpeechSplitter::Options SplitOptions(const SimulationOptions& options) {
+        SpeechSplitter::Options split;
+        split.target_ms = options.split_target_ms;
+        split.max_ms = options.split_max_ms;
+        return split;
+    }
+
+    // 仿真只有一个模型，最多降到只出最终结果
+    static LoadGovernor::Options GovernorOptions(const SimulationOptions& options) {
+        LoadGovernor::Options governor;
+        governor.normal_partial_ms = options.partial_interval_ms;
+        governor.max_level = LoadGovernor::Level::kNoPartials;
+        return governor;
+    }
+
+    static int64_t MsToSample(int64_t ms) { return ms * kSampleRate / 1000; }
+    static int64_t SampleToMs(int64_t pos) { return pos * 1000 / kSampleRate; }
+
+    void OnArrival() {
+        ++arrived_;
+        Clock::time_point next = clock_->Now() + Ms(options_.chunk_ms);
+        if (next <= until_) loop_->At(next, [this] { OnArrival(); });
+        Process();
+    }
+
+    // 识别线程忙时直接返回，忙完后由自己安排的事件接着处理积压
+    void Process() {
+        if (clock_->Now() < busy_until_) return;
+        while (processed_ < arrived_) {
+            Clock::time_point done = ProcessChunk(clock_->Now());
+            if (done > clock_->Now()) {
+                busy_until_ = done;
+                loop_->At(done, [this] { Process(); });
+                return;
+            }
+        }
+    }
+
+    // 与 RecognizeLoop 的一次循环相同：先切块，再片段解码，VAD 吐出语音段时出段尾的最终结果
+    Clock::time_point ProcessChunk(Clock::time_point t) {
+        const Clock::time_point begin = t;
+        Synthesize(processed_ * chunk_samples_);
+        ++processed_;
+        history_.Append(chunk_.data(), chunk_.size());
+        const int64_t fed_until = history_.End();
+
+        const Utterance* u = cursor_ < script_->size() ? &(*script_)[cursor_] : nullptr;
+        bool segment_ready = false;
+        if (u && fed_until > MsToSample(u->begin_ms)) {
+            if (!scheduler_.Active())
+                scheduler_.OnSpeechStart(std::max(history_.Begin(), MsToSample(u->begin_ms) - preroll_), t);
+            segment_ready = fed_until >= MsToSample(u->end_ms) + min_silence_;
+        }
+
+        if (scheduler_.Active() && !segment_ready) {
+            SpeechSplitter::Cut cut = scheduler_.FindCut(history_, kSampleRate, scratch_.data());
+            if (cut.pos >= 0) {
+                const int64_t speech_begin = scheduler_.SpeechBegin();
+                t += DecodeTime(speech_begin, cut.pos);
+                Emit(t, *u, true, true, speech_begin, cut.pos, -1);
+                scheduler_.OnCut(cut.pos, t);
+            }
+        }
+
+        if (governor_.PartialsEnabled() && scheduler_.PartialDue(governor_.PartialIntervalMs(), t) && !segment_ready) {
+            const int64_t speech_begin = scheduler_.SpeechBegin();
+            t += DecodeTime(speech_begin, fed_until);
+            Emit(t, *u, false, false, speech_begin, fed_until, -1);
+            scheduler_.OnPartialDecoded(t);
+        }
+
+        if (segment_ready) {
+            // VAD 在尾部静音满 min_silence 后才吐出语音段，段尾按此回推
+            const int64_t segment_end = fed_until - min_silence_;
+            const int64_t segment_begin = scheduler_.Split()
+                ? std::min(scheduler_.SpeechBegin(), segment_end) : MsToSample(u->begin_ms);
+            t += DecodeTime(segment_begin, segment_end);
+            Emit(t, *u, true, false, segment_begin, segment_end, u->end_ms);
+            scheduler_.OnSpeechEnd();
+            ++cursor_;
+        }
+
+        governor_.OnChunk(t - begin, static_cast<size_t>(chunk_samples_),
+            static_cast<size_t>((arrived_ - processed_) * chunk_samples_), t);
+        return t;
+    }
+
+    Clock::duration DecodeTime(int64_t begin, int64_t end) const {
+        return Ms(static_cast<int64_t>(SampleToMs(end - begin) * options_.decode_rtf));
+    }
+
+    void Emit(Clock::time_point at, const Utterance& u, bool is_final, bool continues, int64_t begin, int64_t end,
+        int64_t speech_end_ms) {
+        RecognitionMessage msg;
+        msg.is_final = is_final;
+        msg.continues = continues;
+        for (size_t i = 0; i < u.words.size(); ++i) {
+            int64_t mid = MsToSample((u.voiced_ms[i].first + u.voiced_ms[i].second) / 2);
+            if (mid < begin || mid >= end) continue;
+            if (!msg.recog_text.empty()) msg.recog_text += ' ';
+            msg.recog_text += u.words[i];
+        }
+        if (is_final && !continues && !msg.recog_text.empty()) msg.recog_text += ".";
+        msg.audio_begin_ms = SampleToMs(begin);
+        msg.audio_end_ms = SampleToMs(end);
+        post_(at, std::move(msg), speech_end_ms);
+    }
+
+    void Synthesize(int64_t from) {
+        for (int64_t i = 0; i < chunk_samples_; ++i) {
+            const int64_t n = from + i;
+            float s = noise_[n % kNoiseSize];
+            // 跳过已经结束的词
+            while (synth_utterance_ < script_->size()) {
+                const Utterance& u = (*script_)[synth_utterance_];
+                if (synth_word_ >= u.voiced_ms.size()) {
+                    ++synth_utterance_;
+                    synth_word_ = 0;
+                }
+                else if (MsToSample(u.voiced_ms[synth_word_].second) <= n) {
+                    ++synth_word_;
+                }
+                else {
+                    break;
+                }
+            }
+            if (synth_utterance_ < script_->size()) {
+                const auto& span = (*script_)[synth_utterance_].voiced_ms[synth_word_];
+                const int64_t b = MsToSample(span.first);
+                const int64_t e = MsToSample(span.second);
+                if (n >= b) {
+                    float ramp = static_cast<float>(std::min(n - b, e - n)) / kRampSamples;
+                    s += 0.3f * std::min(1.0f, ramp) * tone_[n % kTonePeriod];
+                }
+            }
+            chunk_[static_cast<size_t>(i)] = s;
+        }
+    }
+
+    EventLoop* loop_;
+    VirtualClock* clock_;
+    const SimulationOptions& options_;
+    const std::vector<Utterance>* script_;
+    PostFn post_;
+    AudioHistory history_;
+    DecodeScheduler scheduler_;
+    LoadGovernor governor_;
+    Clock::time_point start_;
+    Clock::time_point until_{};
+    Clock::time_point busy_until_{};
+
+    int64_t chunk_samples_ = 0;
+    int64_t preroll_ = 0;
+    int64_t min_silence_ = 0;
+    int64_t arrived_ = 0;            // 已到达的块数
+    int64_t processed_ = 0;          // 已处理的块数，差值即积压
+    size_t cursor_ = 0;              // VAD 当前所在的语句
+    size_t synth_utterance_ = 0;
+    size_t synth_word_ = 0;
+    std::vector<float> chunk_;
+    std::vector<float> scratch_;
+    float tone_[kTonePeriod];
+    float noise_[kNoiseSize];
+};
+
+// 仿真会话：与 MainForm 相同的拼句 -> 扇出 -> 显示链路，识别消息来自 ScriptedRecognizer
+class Session {
+public:
+    Session(const SimulationOptions& options, SimulationReport* report)
+        : options_(options), report_(report), rng_(options.seed), loop_(&clock_),
+        translator_(&loop_, &clock_, options, &rng_), flow_(&clock_) {
+        start_ = clock_.Now();
+
+        TranslationFanout::Options fanout_options;
+        fanout_ = std::make_unique<TranslationFanout>(&translator_, fanout_options);
+        fanout_->Subscribe(fanout_->Languages().front(), [this](const LanguageResult& r) { OnTranslation(r); });
+        flow_.SetUpdateCallback([this](const DisplaySlot& active, const DisplaySlot& next) { OnDisplay(active, next); });
+        last_active_update_ = flow_.Snapshot()->active.last_update;
+        next_trans_.reserve(512);
+    }
+
+    void Run() {
+        script_ = GenerateScript(options_, &rng_);
+        report_->utterances = script_.size();
+
+        const auto end = start_ + Ms(static_cast<int64_t>(options_.hours * 3600 * 1000));
+        for (auto t = start_ + Ms(options_.tick_ms); t <= end + Ms(30000); t += Ms(options_.tick_ms))
+            loop_.At(t, [this] { flow_.Tick(); });
+
+        ScriptedRecognizer recognizer(&loop_, &clock_, options_, &script_,
+            [this](Clock::time_point at, RecognitionMessage msg, int64_t speech_end_ms) {
+                Post(at, std::move(msg), speech_end_ms);
+            });
+        recognizer.Start(end + Ms(30000));
+
+        translator_.Start();
+        loop_.RunUntil(end + Ms(30000));
+        translator_.Stop();
+        report_->simulated_seconds = std::chrono::duration<double>(clock_.Now() - start_).count();
+
+        TranslationBackend::ShedStats shed = translator_.GetShedStats();
+        report_->requests = static_cast<size_t>(shed.submitted);
+        report_->shed = static_cast<size_t>(shed.dropped + shed.demoted + shed.late);
+        report_->final_p50_ms = Percentile(final_ms_, 0.50);
+        report_->final_p95_ms = Percentile(final_ms_, 0.95);
+        report_->final_max_ms = Percentile(final_ms_, 1.0);
+        report_->display_p50_ms = Percentile(display_ms_, 0.50);
+        report_->display_p95_ms = Percentile(display_ms_, 0.95);
+        report_->display_p99_ms = Percentile(display_ms_, 0.99);
+        report_->display_max_ms = Percentile(display_ms_, 1.0);
+    }
+
+private:
+    // 识别结果在解码完成的时刻 at 到达；speech_end_ms >= 0 时为语音段的最后一块，记录出最终结果的延迟
+    void Post(Clock::time_point at, RecognitionMessage msg, int64_t speech_end_ms) {
+        loop_.At(at, [this, msg, speech_end_ms]() mutable {
+            msg.ts = clock_.Now();
+            if (speech_end_ms >= 0) final_ms_.push_back(NowMs() - speech_end_ms);
+            OnRecognition(msg);
+        });
+    }
+
+    int64_t NowMs() const { return std::chrono::duration_cast<Ms>(clock_.Now() - start_).count(); }
+
+    void OnRecognition(const RecognitionMessage& msg) {
+        if (!msg.is_final) {
+            ++report_->partials;
+            uint64_t allocs_before = metrics::ThreadAllocations();
+            flow_.OnRecognitionFragment(msg.recog_text);
+            if (NowMs() >= options_.alloc_warmup_s * 1000LL)
+                report_->partial_allocs += metrics::ThreadAllocations() - allocs_before;
+            return;
+        }
+        ++report_->finals;
+        std::string text = stitcher_.Push(msg.recog_text, msg.continues);
+        if (text.empty()) return;
+
+        TranslationRequest request;
+        request.id = ++next_request_id_;
+        request.text = std::move(text);
+        request.deadline = clock_.Now() + FlowController::kDisplayTimeout;
+        request.display_only = true;   // 仿真不落盘
+        speech_end_[request.id] = msg.audio_end_ms;
+        fanout_->Submit(std::move(request));
+    }
+
+    void OnTranslation(const LanguageResult& r) {
+        auto it = speech_end_.find(r.id);
+        if (it == speech_end_.end()) return;
+        int64_t speech_end_ms = it->second;
+        speech_end_.erase(it);
+        if (!r.ok || r.late) return;
+
+        ++report_->shown;
+        if (r.cached) ++report_->cache_hits;
+        display_ms_.push_back(NowMs() - speech_end_ms);
+        flow_.OnTranslationReady(r.source_text, r.text);
+    }
+
+    // active 的 last_update 只在滚动时改变；满足滚动条件的时刻与实际滚动时刻之差即为停滞
+    void OnDisplay(const DisplaySlot& active, const DisplaySlot& next) {
+        Clock::time_point now = clock_.Now();
+        bool advanced = active.last_update != last_active_update_;
+        // next 里的译文没滚上去就被换掉，观众在上方永远看不到它
+        if (!advanced && next_trans_ready_ && next.Trans() != next_trans_) ++report_->lost;
+        next_trans_ready_ = next.trans_ready;
+        next_trans_ = next.Trans();
+
+        if (advanced) {
+            Clock::time_point content_since = has_next_content_ ? next_content_since_ : now;
+            Clock::time_point eligible = last_active_ready_ ? content_since
+                : std::max(last_active_update_ + FlowController::kDisplayTimeout, content_since);
+            if (now > eligible)
+                report_->max_stall_ms = std::max<int64_t>(report_->max_stall_ms,
+                    std::chrono::duration_cast<Ms>(now - eligible).count());
+            ++report_->advances;
+            last_active_update_ = active.last_update;
+            last_active_ready_ = active.trans_ready;
+            has_next_content_ = false;
+        }
+        bool next_has_content = next.trans_ready || !next.Recog().empty();
+        if (next_has_content && !has_next_content_) next_content_since_ = now;
+        has_next_content_ = next_has_content;
+    }
+
+    const SimulationOptions& options_;
+    SimulationReport* report_;
+    std::mt19937 rng_;
+    VirtualClock clock_;
+    EventLoop loop_;
+    ScriptedTranslator translator_;
+    FlowController flow_;
+    SentenceStitcher stitcher_;
+    std::unique_ptr<TranslationFanout> fanout_;
+    Clock::time_point start_;
+    std::vector<Utterance> script_;
+
+    uint64_t next_request_id_ = 0;
+    std::unordered_map<uint64_t, int64_t> speech_end_;
+    std::vector<int64_t> final_ms_;
+    std::vector<int64_t> display_ms_;
+
+    Clock::time_point last_active_update_{};
+    bool last_active_ready_ = false;
+    bool has_next_content_ = false;
+    Clock::time_point next_content_since_{};
+    bool next_trans_ready_ = false;
+    std::string next_trans_;
+};
+
+} // namespace
+
+bool RunSimulation(const SimulationOptions& options, SimulationReport* report)
+{
+    *report = SimulationReport();
+    auto wall_begin = std::chrono::steady_clock::now();
+    Session session(options, report);
+    session.Run();
+    report->wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_begin).count();
+
+    auto over = [&](const char* what, int64_t value, int64_t budget) {
+        if (value > budget) report->Violation("%s %lld ms exceeds budget %lld ms", what,
+            static_cast<long long>(value), static_cast<long long>(budget));
+    };
+    over("final p95", report->final_p95_ms, options.final_p95_budget_ms);
+    over("display p95", report->display_p95_ms, options.display_p95_budget_ms);
+    over("slot advance stall", report->max_stall_ms, options.tick_ms + options.stall_margin_ms);
+
+    size_t sentences = report->shown + report->shed;
+    if (sentences > 0 && report->shed > options.max_shed_ratio * sentences) {
+        report->Violation("shed %zu of %zu translations, budget %.1f%%",
+            report->shed, sentences, options.max_shed_ratio * 100);
+    }
+    if (report->shown > 0 && report->lost > options.max_lost_ratio * report->shown) {
+        report->Violation("%zu of %zu translations overwritten before reaching the active slot, budget %.1f%%",
+            report->lost, report->shown, options.max_lost_ratio * 100);
+    }
+    if (report->partial_allocs > options.max_partial_allocs) {
+        report->Violation("%llu heap allocations on the steady-state partial display path, budget %llu",
+            static_cast<unsigned long long>(report->partial_allocs),
+            static_cast<unsigned long long>(options.max_partial_allocs));
+    }
+    if (report->shown == 0) report->Violation("no translation reached the display");
+    return report->Passed();
+}
+
+int RunSimulationCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    SimulationOptions options;
+    ArgParser()
+        .Option(L"--hours", &options.hours)
+        .Option(L"--seed", &options.seed)
+        .Parse(argc, argv);
+
+    SimulationReport r;
+    RunSimulation(options, &r);
+
+    printf("[Sim] simulated=%.0fs wall=%.2fs utterances=%zu partials=%zu finals=%zu\n",
+        r.simulated_seconds, r.wall_seconds, r.utterances, r.partials, r.finals);
+    printf("[Sim] translate: requests=%zu shown=%zu cache_hits=%zu shed=%zu lost=%zu advances=%zu\n",
+        r.requests, r.shown, r.cache_hits, r.shed, r.lost, r.advances);
+    printf("[Sim] steady-state partial allocations=%llu\n", static_cast<unsigned long long>(r.partial_allocs));
+    printf("[Sim] final ms: p50=%lld p95=%lld max=%lld\n",
+        static_cast<long long>(r.final_p50_ms), static_cast<long long>(r.final_p95_ms),
+        static_cast<long long>(r.final_max_ms));
+    printf("[Sim] display ms: p50=%lld p95=%lld p99=%lld max=%lld, max stall=%lld\n",
+        static_cast<long long>(r.display_p50_ms), static_cast<long long>(r.display_p95_ms),
+        static_cast<long long>(r.display_p99_ms), static_cast<long long>(r.display_max_ms),
+        static_cast<long long>(r.max_stall_ms));
+    return PrintVerdict("Sim", r);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 确定性仿真：虚拟时钟驱动脚本化语音与脚本化翻译后端，合成的音频经过与 RecognizeLoop 相同的
+// AudioHistory / DecodeScheduler / SpeechSplitter / LoadGovernor（只有 VAD 与解码按脚本模拟），
+// 再经过真实的 SentenceStitcher / TranslationFanout / DispatchQueue / FlowController，
+// 数小时的会话在数秒内跑完，并检查延迟预算与滚动行为。同一二进制、同一种子结果完全相同
+struct SimulationOptions {
+    double hours = 2.0;
+    uint32_t seed = 1;
+
+    // 脚本化语音
+    int32_t utterance_min_ms = 800;
+    int32_t utterance_max_ms = 9000;
+    int32_t pause_min_ms = 200;
+    int32_t pause_max_ms = 3000;
+    double words_per_second = 2.5;
+    double repeat_ratio = 0.1;          // 重复出现的常用短句比例，检验译文缓存
+    double word_gap_ratio = 0.6;        // 词后带停顿的比例，其余连读
+    int32_t word_gap_ms = 120;
+
+    // 识别时序，与 RecognizerOptions 的默认值一致
+    int32_t chunk_ms = 20;
+    int32_t preroll_ms = 320;
+    int32_t partial_interval_ms = 200;
+    int32_t min_silence_ms = 150;
+    int32_t split_target_ms = 3000;
+    int32_t split_max_ms = 6000;
+    double decode_rtf = 0.15;           // 解码耗时 / 解码的音频时长
+
+    // 脚本化翻译
+    int32_t translate_base_ms = 300;
+    int32_t translate_jitter_ms = 400;
+    double translate_spike_ratio = 0.02;
+    int32_t translate_spike_ms = 12000; // 超过显示截止时间，用于检验迟到只落盘
+    int32_t translate_window = 2;       // 同时在途的请求数上限
+    int32_t tick_ms = 1000;             // MainForm 的刷新定时器
+
+    // 预算，超出即判失败
+    int32_t final_p95_budget_ms = 1500;     // 语音结束 -> 最终识别结果
+    int32_t display_p95_budget_ms = 2500;   // 语音结束 -> 译文进入显示槽
+    // 满足滚动条件后 active 仍未滚动的最长时间：滚动只在刷新定时器上发生，预算为 tick_ms 加此余量
+    int32_t stall_margin_ms = 500;
+    double max_shed_ratio = 0.05;           // 错过显示截止时间、没能上屏的翻译占比
+    double max_lost_ratio = 0.02;           // 译文在 next 槽里被覆盖、从未滚到 active 的占比
+    // 预热之后，识别片段进入显示槽并回调渲染的路径上允许的堆分配次数。只覆盖 FlowController：
+    // 脚本识别器不经过消息总线，识别线程的投递与显示文本的宽字符转换由 --soak 检查
+    int32_t alloc_warmup_s = 60;
+    uint64_t max_partial_allocs = 0;
+};
+
+struct SimulationReport : CheckReport {
+    double simulated_seconds = 0;
+    double wall_seconds = 0;
+    size_t utterances = 0;
+    size_t partials = 0;
+    size_t finals = 0;
+    size_t requests = 0;                // 提交给翻译后端的请求
+    size_t cache_hits = 0;              // 上屏语言的缓存命中
+    size_t shown = 0;                   // 进入显示槽的译文
+    size_t shed = 0;
+    size_t lost = 0;
+    size_t advances = 0;
+    uint64_t partial_allocs = 0;        // 预热后片段显示路径上的堆分配次数
+
+    int64_t final_p50_ms = 0, final_p95_ms = 0, final_max_ms = 0;
+    int64_t display_p50_ms = 0, display_p95_ms = 0, display_p99_ms = 0, display_max_ms = 0;
+    int64_t max_stall_ms = 0;
+
+};
+
+bool RunSimulation(const SimulationOptions& options, SimulationReport* report);
+
+// 命令行入口：InstantTrans.exe --simulate [--hours H] [--seed N]
+// 全部预算满足时返回 0，否则返回 1
+int RunSimulationCommandLine(int argc, wchar_t** argv);
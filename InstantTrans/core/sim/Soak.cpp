@@ -0,0 +1,478 @@
+#define NOMINMAX
+#include "Soak.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <unordered_map>
+
+#include <Windows.h>
+
+#include "controller/FlowController.h"
+#include "controller/SentenceStitcher.h"
+#include "controller/TranscriptStore.h"
+#include "core/ipc/MessageBus.h"
+#include "core/metrics/AllocStats.h"
+#include "core/metrics/Log.h"
+#include "core/metrics/Metrics.h"
+#include "core/output/TranscriptWriter.h"
+#include "core/recoginize/ModelFiles.h"
+#include "core/recoginize/ReplaySource.h"
+#include "core/recoginize/SpeechRecognize.h"
+#include "core/translate/TranslationFanout.h"
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+const wchar_t kWindowClass[] = L"InstantTransSoak";
+
+// 预热后各采样点的最小二乘斜率，换算为每小时
+template <typename Value>
+double SlopePerHour(const std::vector<SoakSample>& samples, size_t from, Value value)
+{
+    const size_t n = samples.size() - from;
+    if (n < 2) return 0;
+    double mx = 0, my = 0;
+    for (size_t i = from; i < samples.size(); ++i) {
+        mx += samples[i].elapsed_s;
+        my += static_cast<double>(value(samples[i]));
+    }
+    mx /= n;
+    my /= n;
+    double sxx = 0, sxy = 0;
+    for (size_t i = from; i < samples.size(); ++i) {
+        double dx = samples[i].elapsed_s - mx;
+        sxx += dx * dx;
+        sxy += dx * (static_cast<double>(value(samples[i])) - my);
+    }
+    return sxx > 0 ? sxy / sxx * 3600.0 : 0;
+}
+
+// [from, to) 中有译文的窗口的 p95 中位数
+int64_t MedianP95(const std::vector<SoakSample>& samples, size_t from, size_t to)
+{
+    std::vector<int64_t> v;
+    for (size_t i = from; i < to; ++i) {
+        if (samples[i].e2e_p95_ms > 0) v.push_back(samples[i].e2e_p95_ms);
+    }
+    if (v.empty()) return 0;
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+// 无界面的会话：只收消息的窗口代替主窗口，消息经 MessageBus 投递、在本线程上处理，
+// 与 MainForm 走同一条路径（池化的消息、显示槽、拼句、扇出、落盘、历史记录）
+class SoakRunner {
+public:
+    SoakRunner(const SoakOptions& options, SoakReport* report)
+        : options_(options), report_(report) {
+        auto& registry = metrics::Registry::Instance();
+        decode_final_ = registry.GetHistogram("instanttrans_decode_seconds", "Offline decode time", "kind=\"final\"");
+        ingest_queued_ = registry.GetGauge("instanttrans_ingest_queued_samples", "16kHz samples waiting for the recognizer");
+        // 与 MainForm::OnFlowUpdate 相同：文本变化的槽转换到各自的宽字符缓冲
+        for (int i = 0; i < 4; ++i) {
+            shown_text_[i].reserve(512);
+            shown_wide_[i].reserve(512);
+        }
+        flow_.SetUpdateCallback([this](const DisplaySlot& active, const DisplaySlot& next) {
+            const std::string* texts[4] = { &active.Recog(), &active.Trans(), &next.Recog(), &next.Trans() };
+            for (int i = 0; i < 4; ++i) {
+                if (shown_text_[i] == *texts[i]) continue;
+                shown_text_[i] = *texts[i];
+                Utf8ToWStringInto(shown_text_[i], &shown_wide_[i]);
+            }
+        });
+    }
+
+    void Run();
+
+private:
+    static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+
+    void OnRecognition(const RecognitionMessage& msg);
+    void OnTranslation(const TranslationMessage& msg);
+    void Sample(double elapsed_s);
+    void Evaluate();
+
+    SoakOptions options_;
+    SoakReport* report_;
+    HWND hwnd_ = nullptr;
+    FILE* csv_ = nullptr;
+
+    MessageBus bus_;
+    FlowController flow_;
+    SentenceStitcher stitcher_;
+    std::unique_ptr<TranscriptStore> store_;
+    std::unique_ptr<TranslationBackend> translator_;
+    std::unique_ptr<TranslationFanout> fanout_;
+    std::string display_lang_;
+
+    uint64_t next_request_id_ = 0;
+    std::unordered_map<uint64_t, SteadyClock::time_point> submitted_;   // 请求 id -> 最终结果发布时刻
+    uint64_t finals_ = 0;
+    uint64_t translations_ = 0;
+    uint64_t expired_ = 0;
+    uint64_t partials_ = 0;
+    uint64_t partial_allocs_ = 0;
+    const SpeechRecognizer* recognizer_ = nullptr;
+    uint64_t last_post_allocs_ = 0;   // 上个采样点时识别线程投递片段的累计分配
+    std::string shown_text_[4];
+    std::wstring shown_wide_[4];
+
+    metrics::Histogram e2e_;
+    metrics::Histogram::Snapshot e2e_mark_;
+    metrics::Histogram* decode_final_;
+    metrics::Histogram::Snapshot decode_mark_;
+    metrics::Gauge* ingest_queued_;
+    uint64_t last_allocations_ = 0;
+    double last_elapsed_s_ = 0;
+};
+
+LRESULT CALLBACK SoakRunner::WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+{
+    auto self = reinterpret_cast<SoakRunner*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+    if (self && msg == WM_APP_RECOG) {
+        // 取回、处理、放回池中整个过程的分配都计入
+        uint64_t allocs_before = metrics::ThreadAllocations();
+        bool partial = false;
+        {
+            auto p = MessageBus::TakeRecognition(wparam);
+            partial = !p->is_final;
+            self->OnRecognition(*p);
+        }
+        if (partial) {
+            ++self->partials_;
+            self->partial_allocs_ += metrics::ThreadAllocations() - allocs_before;
+        }
+        return 0;
+    }
+    if (self && msg == WM_APP_TRANS) {
+        auto p = MessageBus::TakeTranslation(wparam);
+        self->OnTranslation(*p);
+        return 0;
+    }
+    return DefWindowProcW(hwnd, msg, wparam, lparam);
+}
+
+void SoakRunner::Run()
+{
+    {
+        recording::Reader probe;
+        if (!probe.Open(options_.recording) || probe.Index().empty()) {
+            report_->Violation("cannot read recording %s", WStringToUtf8(options_.recording).c_str());
+            return;
+        }
+    }
+
+    WNDCLASSEXW wc = { sizeof(wc) };
+    wc.lpfnWndProc = &SoakRunner::WndProc;
+    wc.hInstance = GetModuleHandleW(nullptr);
+    wc.lpszClassName = kWindowClass;
+    RegisterClassExW(&wc);
+    hwnd_ = CreateWindowExW(0, kWindowClass, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, wc.hInstance, nullptr);
+    if (!hwnd_) {
+        report_->Violation("cannot create the message window");
+        return;
+    }
+    SetWindowLongPtrW(hwnd_, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+    bus_.SetUIWindow(hwnd_);
+
+    const std::wstring dir = GetExeDirectory() + L"\\soak";
+    CreateDirectoryW(dir.c_str(), nullptr);
+    std::wstring csv_path = options_.csv_path.empty() ? GetExeDirectory() + L"\\soak.csv" : options_.csv_path;
+    if (_wfopen_s(&csv_, csv_path.c_str(), L"w") != 0) csv_ = nullptr;
+    if (csv_) {
+        fprintf(csv_, "elapsed_s,rss_mb,live_allocs,allocs_per_s,handles,ingest_queue_ms,bus_inflight,"
+            "outstanding,finals,translations,partials,partial_allocs,e2e_p50_ms,e2e_p95_ms,decode_p95_ms\n");
+    }
+
+    TranscriptWriterOptions writer_options;
+    writer_options.directory = dir;
+    TranscriptWriter writer(writer_options);
+    writer.Start(L"soak");
+    bus_.AddRecognitionListener([&writer](const RecognitionMessage& msg) { writer.Submit(msg); });
+
+    TranscriptStore::Options store_options;
+    store_options.spill_path = dir + L"\\history.txt";
+    store_ = std::make_unique<TranscriptStore>(store_options);
+
+    translator_ = CreateTranslationBackend(TranslationBackendFromEnvironment());
+    TranslationFanout::Options fanout_options;
+    fanout_options.langs = TargetLanguagesFromEnvironment();
+    fanout_ = std::make_unique<TranslationFanout>(translator_.get(), fanout_options);
+    display_lang_ = fanout_->Languages().front();
+    for (const std::string& lang : fanout_->Languages()) {
+        fanout_->Subscribe(lang, [this](const LanguageResult& result) {
+            TranslationMessage tmsg;
+            tmsg.recog_text = result.source_text;
+            tmsg.trans_text = result.text;
+            tmsg.lang = result.lang;
+            tmsg.id = result.id;
+            tmsg.first_id = result.merged_ids.empty() ? result.id : result.merged_ids.front();
+            tmsg.late = result.late;
+            bus_.PostTranslation(std::move(tmsg));
+            });
+    }
+    if (!translator_->Start()) report_->Violation("translation backend failed to start");
+
+    ReplayOptions replay_options;
+    replay_options.speed = options_.speed;
+    replay_options.loop = true;
+    auto source = std::make_unique<ReplaySource>(options_.recording, replay_options);
+    const ReplaySource* replay = source.get();
+    SpeechRecognizer recognizer(&bus_);
+    recognizer.SwitchSource(std::move(source));
+    recognizer.Start();
+    recognizer_ = &recognizer;
+
+    // 采样点本身不应造成增长：预先留足容量
+    const auto interval = std::chrono::seconds(std::max(1, options_.sample_seconds));
+    report_->samples.reserve(static_cast<size_t>(options_.hours * 3600 / interval.count()) + 2);
+    const auto begin = SteadyClock::now();
+    const auto end = begin + std::chrono::duration_cast<SteadyClock::duration>(
+        std::chrono::duration<double>(options_.hours * 3600));
+    auto next_sample = begin + interval;
+    e2e_mark_ = e2e_.Take();
+    decode_mark_ = decode_final_->Take();
+    last_allocations_ = metrics::GetAllocStats().allocations;
+
+    while (true) {
+        auto now = SteadyClock::now();
+        if (now >= next_sample) {
+            Sample(std::chrono::duration<double>(now - begin).count());
+            next_sample += interval;
+        }
+        if (now >= end) break;
+
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(std::min(next_sample, end) - now).count();
+        MsgWaitForMultipleObjects(0, nullptr, FALSE, static_cast<DWORD>(std::max<int64_t>(wait, 1)), QS_ALLINPUT);
+        MSG msg;
+        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
+        }
+    }
+
+    report_->loops = replay->Loops();
+    recognizer.Stop();
+    recognizer_ = nullptr;
+    translator_->Stop();
+    writer.Stop();
+    bus_.DetachUIWindow();
+    fanout_.reset();
+    translator_.reset();
+    DestroyWindow(hwnd_);
+    UnregisterClassW(kWindowClass, wc.hInstance);
+    if (csv_) fclose(csv_);
+
+    Evaluate();
+}
+
+void SoakRunner::OnRecognition(const RecognitionMessage& msg)
+{
+    if (!msg.is_final) {
+        flow_.OnRecognitionFragment(msg.recog_text);
+        return;
+    }
+    ++finals_;
+
+    std::string text = stitcher_.Push(msg.recog_text, msg.continues);
+    if (text.empty()) return;
+
+    TranslationRequest request;
+    request.id = ++next_request_id_;
+    request.text = std::move(text);
+    request.priority = TranslationPriority::kActiveFinal;
+    request.deadline = SteadyClock::now() + FlowController::kDisplayTimeout;
+    request.display_only = true;   // soak 不写字幕文件
+    submitted_[request.id] = msg.ts;
+    fanout_->Submit(std::move(request));
+}
+
+void SoakRunner::OnTranslation(const TranslationMessage& msg)
+{
+    if (msg.lang != display_lang_) return;
+    ++translations_;
+
+    // 合并请求的结果覆盖 [first_id, id] 内的全部句子；迟到的只落盘，不计入上屏延迟
+    auto now = SteadyClock::now();
+    for (uint64_t id = msg.first_id; id <= msg.id; ++id) {
+        auto it = submitted_.find(id);
+        if (it == submitted_.end()) continue;
+        if (msg.late) ++expired_;
+        else e2e_.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            now - it->second).count()));
+        submitted_.erase(it);
+    }
+    // 与 MainForm 一致：迟到或没有译文的不上屏也不进历史
+    if (msg.late || msg.trans_text.empty()) return;
+    flow_.OnTranslationReady(msg.recog_text, msg.trans_text);
+
+    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    store_->Append(msg.recog_text, msg.trans_text, now_ms);
+}
+
+void SoakRunner::Sample(double elapsed_s)
+{
+    // 两倍截止时间仍未回来的请求（如后端失败未回调）不再等待
+    auto expire_before = SteadyClock::now() - 2 * FlowController::kDisplayTimeout;
+    for (auto it = submitted_.begin(); it != submitted_.end();) {
+        if (it->second < expire_before) {
+            it = submitted_.erase(it);
+            ++expired_;
+        }
+        else {
+            ++it;
+        }
+    }
+
+    SoakSample s;
+    s.elapsed_s = elapsed_s;
+    s.rss_mb = GetProcessRss() / (1024.0 * 1024.0);
+
+    metrics::AllocStats alloc = metrics::GetAllocStats();
+    s.live_allocs = alloc.Live();
+    double dt = std::max(1e-3, elapsed_s - last_elapsed_s_);
+    s.allocs_per_s = static_cast<uint64_t>((alloc.allocations - last_allocations_) / dt);
+    last_allocations_ = alloc.allocations;
+    last_elapsed_s_ = elapsed_s;
+
+    DWORD handles = 0;
+    GetProcessHandleCount(GetCurrentProcess(), &handles);
+    s.handles = handles;
+    s.ingest_queue_ms = ingest_queued_->Value() / 16;
+    s.bus_inflight = MessageBus::InFlight()->Value();
+    s.outstanding = static_cast<int64_t>(submitted_.size());
+    s.finals = finals_;
+    s.translations = translations_;
+    s.partials = partials_;
+    // 片段路径两端：识别线程交给总线，“UI”线程取回、进入显示槽并转换显示文本
+    uint64_t post_allocs = recognizer_ ? recognizer_->PartialPostAllocations() : last_post_allocs_;
+    s.partial_allocs = partial_allocs_ + (post_allocs - last_post_allocs_);
+    last_post_allocs_ = post_allocs;
+    partials_ = 0;
+    partial_allocs_ = 0;
+
+    metrics::Histogram::Snapshot e2e = e2e_.Take();
+    metrics::Histogram::Snapshot e2e_window = e2e.Since(e2e_mark_);
+    e2e_mark_ = std::move(e2e);
+    s.e2e_p50_ms = static_cast<int64_t>(e2e_window.Percentile(0.5) / 1000);
+    s.e2e_p95_ms = static_cast<int64_t>(e2e_window.Percentile(0.95) / 1000);
+
+    metrics::Histogram::Snapshot decode = decode_final_->Take();
+    s.decode_p95_ms = static_cast<int64_t>(decode.Since(decode_mark_).Percentile(0.95) / 1000);
+    decode_mark_ = std::move(decode);
+
+    report_->samples.push_back(s);
+
+    if (csv_) {
+        fprintf(csv_, "%.0f,%.1f,%llu,%llu,%llu,%lld,%lld,%lld,%llu,%llu,%llu,%llu,%lld,%lld,%lld\n",
+            s.elapsed_s, s.rss_mb, static_cast<unsigned long long>(s.live_allocs),
+            static_cast<unsigned long long>(s.allocs_per_s), static_cast<unsigned long long>(s.handles),
+            static_cast<long long>(s.ingest_queue_ms), static_cast<long long>(s.bus_inflight),
+            static_cast<long long>(s.outstanding), static_cast<unsigned long long>(s.finals),
+            static_cast<unsigned long long>(s.translations), static_cast<unsigned long long>(s.partials),
+            static_cast<unsigned long long>(s.partial_allocs), static_cast<long long>(s.e2e_p50_ms),
+            static_cast<long long>(s.e2e_p95_ms), static_cast<long long>(s.decode_p95_ms));
+        fflush(csv_);
+    }
+    printf("[Soak] t=%.0fs rss=%.1fMB live=%llu handles=%llu queue=%lldms finals=%llu e2e_p95=%lldms\n",
+        s.elapsed_s, s.rss_mb, static_cast<unsigned long long>(s.live_allocs),
+        static_cast<unsigned long long>(s.handles), static_cast<long long>(s.ingest_queue_ms),
+        static_cast<unsigned long long>(s.finals), static_cast<long long>(s.e2e_p95_ms));
+    fflush(stdout);
+}
+
+void SoakRunner::Evaluate()
+{
+    const std::vector<SoakSample>& samples = report_->samples;
+    size_t from = 0;
+    while (from < samples.size() && samples[from].elapsed_s < options_.warmup_minutes * 60.0) ++from;
+    const size_t n = samples.size() - from;
+    if (n < 4) {
+        report_->Violation("only %zu samples after warmup, run longer or sample more often", n);
+        return;
+    }
+
+    report_->rss_mb_per_hour = SlopePerHour(samples, from, [](const SoakSample& s) { return s.rss_mb; });
+    report_->live_allocs_per_hour = SlopePerHour(samples, from, [](const SoakSample& s) { return s.live_allocs; });
+    report_->handles_per_hour = SlopePerHour(samples, from, [](const SoakSample& s) { return s.handles; });
+    if (report_->rss_mb_per_hour > options_.max_rss_mb_per_hour)
+        report_->Violation("RSS grows %.1f MB/h, limit %.1f", report_->rss_mb_per_hour, options_.max_rss_mb_per_hour);
+    if (report_->live_allocs_per_hour > options_.max_live_allocs_per_hour)
+        report_->Violation("live allocations grow %.0f/h, limit %.0f", report_->live_allocs_per_hour, options_.max_live_allocs_per_hour);
+    if (report_->handles_per_hour > options_.max_handles_per_hour)
+        report_->Violation("handles grow %.1f/h, limit %.1f", report_->handles_per_hour, options_.max_handles_per_hour);
+
+    const size_t quarter = std::max<size_t>(1, n / 4);
+    report_->early_p95_ms = MedianP95(samples, from, from + quarter);
+    report_->late_p95_ms = MedianP95(samples, samples.size() - quarter, samples.size());
+    if (report_->early_p95_ms > 0
+        && report_->late_p95_ms > report_->early_p95_ms * options_.max_latency_growth
+        && report_->late_p95_ms - report_->early_p95_ms >= options_.latency_floor_ms)
+        report_->Violation("end-to-end p95 drifted from %lld ms to %lld ms",
+            static_cast<long long>(report_->early_p95_ms), static_cast<long long>(report_->late_p95_ms));
+
+    SoakSample peak;
+    uint64_t partials = 0, partial_allocs = 0;
+    for (size_t i = from; i < samples.size(); ++i) {
+        partials += samples[i].partials;
+        partial_allocs += samples[i].partial_allocs;
+        peak.ingest_queue_ms = std::max(peak.ingest_queue_ms, samples[i].ingest_queue_ms);
+        peak.bus_inflight = std::max(peak.bus_inflight, samples[i].bus_inflight);
+        peak.outstanding = std::max(peak.outstanding, samples[i].outstanding);
+    }
+    if (peak.ingest_queue_ms > options_.max_ingest_queue_ms)
+        report_->Violation("ingest queue reached %lld ms", static_cast<long long>(peak.ingest_queue_ms));
+    if (peak.bus_inflight > options_.max_bus_inflight)
+        report_->Violation("%lld bus messages waiting for the UI thread", static_cast<long long>(peak.bus_inflight));
+    if (peak.outstanding > options_.max_outstanding_translations)
+        report_->Violation("%lld translations outstanding", static_cast<long long>(peak.outstanding));
+    if (partial_allocs > options_.max_partial_allocs)
+        report_->Violation("%llu heap allocations over %llu partials on the recognizer and UI threads after warmup",
+            static_cast<unsigned long long>(partial_allocs), static_cast<unsigned long long>(partials));
+    if (translations_ == 0) report_->Violation("no translation came back");
+}
+
+} // namespace
+
+bool RunSoak(const SoakOptions& options, SoakReport* report)
+{
+    *report = SoakReport();
+    SoakRunner runner(options, report);
+    runner.Run();
+    return report->Passed();
+}
+
+int RunSoakCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    SoakOptions options;
+    ArgParser()
+        .Option(L"--hours", &options.hours)
+        .Option(L"--speed", &options.speed)
+        .Option(L"--sample-seconds", &options.sample_seconds)
+        .Option(L"--warmup-minutes", &options.warmup_minutes)
+        .Option(L"--csv", &options.csv_path)
+        .Positional(&options.recording)
+        .Parse(argc, argv);
+    if (options.recording.empty()) {
+        printf("usage: InstantTrans.exe --soak <recording.itrec> [--hours H] [--speed X] "
+            "[--sample-seconds S] [--warmup-minutes M] [--csv path]\n");
+        return 2;
+    }
+
+    SoakReport r;
+    RunSoak(options, &r);
+
+    printf("[Soak] samples=%zu loops=%llu rss=%+.1fMB/h live_allocs=%+.0f/h handles=%+.1f/h\n",
+        r.samples.size(), static_cast<unsigned long long>(r.loops),
+        r.rss_mb_per_hour, r.live_allocs_per_hour, r.handles_per_hour);
+    printf("[Soak] e2e p95: early=%lldms late=%lldms\n",
+        static_cast<long long>(r.early_p95_ms), static_cast<long long>(r.late_p95_ms));
+    return PrintVerdict("Soak", r);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 长时间运行测试：无界面地跑完整管线（回放采集 -> 识别 -> 消息总线 -> 拼句 -> 扇出翻译 -> 落盘），
+// 录音循环回放，翻译走 INSTANTTRANS_GATEWAYS 指向的网关或桩：
+//
+//   go run ./cmd/ratelimit-stub -rate 50 -burst 50 -latency 200ms
+//   InstantTrans.exe --soak session.itrec --hours 8
+//
+// 定期采样内存、分配、句柄、队列深度与延迟分位，结束时按斜率与前后对比判断漂移；
+// 同时检查稳态下识别片段从识别线程投递、经总线取回、进入显示槽到转换显示文本不做堆分配
+struct SoakOptions {
+    std::wstring recording;          // SessionRecorder 录下的 .itrec
+    double hours = 8.0;
+    double speed = 1.0;              // 回放倍速，> 1 时同样时长内识别负载更高
+    int32_t sample_seconds = 60;
+    int32_t warmup_minutes = 10;     // 模型加载、缓存与池填满期间的增长不计入漂移
+    std::wstring csv_path;           // 每个采样点一行；为空时写到程序目录下的 soak.csv
+
+    // 漂移阈值：按预热后采样点的线性回归斜率计
+    double max_rss_mb_per_hour = 8.0;
+    double max_live_allocs_per_hour = 20000.0;
+    double max_handles_per_hour = 20.0;
+    // 后 1/4 时段的窗口 p95 中位数相对前 1/4 的倍数；增长量不足 latency_floor_ms 时不算
+    double max_latency_growth = 1.5;
+    int64_t latency_floor_ms = 200;
+    // 任一采样点超出即判失败
+    int64_t max_ingest_queue_ms = 2000;
+    int64_t max_bus_inflight = 1000;
+    int64_t max_outstanding_translations = 256;
+    // 预热后片段路径上允许的堆分配总数：识别线程把结果交给总线（不含 sherpa-onnx 内部），
+    // “UI”线程取回、进入显示槽并转换显示文本
+    uint64_t max_partial_allocs = 0;
+};
+
+struct SoakSample {
+    double elapsed_s = 0;
+    double rss_mb = 0;
+    uint64_t live_allocs = 0;
+    uint64_t allocs_per_s = 0;
+    uint64_t handles = 0;
+    int64_t ingest_queue_ms = 0;     // 等待识别的音频
+    int64_t bus_inflight = 0;        // 已投递、尚未被“UI”线程取走的消息
+    int64_t outstanding = 0;         // 已提交、尚未回来的翻译
+    uint64_t finals = 0;
+    uint64_t translations = 0;
+    uint64_t partials = 0;
+    uint64_t partial_allocs = 0;     // 本采样窗口内片段路径上的堆分配次数，识别线程与“UI”线程之和
+    int64_t e2e_p50_ms = 0;          // 最终识别结果发布 -> 译文回到“UI”线程，本采样窗口内
+    int64_t e2e_p95_ms = 0;
+    int64_t decode_p95_ms = 0;       // 最终结果解码耗时，本采样窗口内
+};
+
+struct SoakReport : CheckReport {
+    std::vector<SoakSample> samples;
+    double rss_mb_per_hour = 0;
+    double live_allocs_per_hour = 0;
+    double handles_per_hour = 0;
+    int64_t early_p95_ms = 0;
+    int64_t late_p95_ms = 0;
+    uint64_t loops = 0;              // 录音重放的次数
+};
+
+bool RunSoak(const SoakOptions& options, SoakReport* report);
+
+// 命令行入口：InstantTrans.exe --soak <recording.itrec> [--hours H] [--speed X]
+//   [--sample-seconds S] [--warmup-minutes M] [--csv path]
+// 没有漂移时返回 0，否则返回 1
+int RunSoakCommandLine(int argc, wchar_t** argv);
@@ -0,0 +1,173 @@
+#define NOMINMAX
+#include "TranslateBench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include <Windows.h>
+
+#include "core/metrics/Log.h"
+#include "core/translate/TranslationBackend.h"
+
+namespace {
+
+const char* kDefaultSentences[] = {
+    "Good morning everyone, let's get started.",
+    "The quarterly numbers are better than we expected.",
+    "Can you share your screen so we can all see the chart?",
+    "I think we should move the release to next week.",
+    "Thanks, that was really helpful.",
+    "Let me know if you have any questions about the new process.",
+};
+
+int64_t Percentile(std::vector<int64_t> v, double p)
+{
+    if (v.empty()) return 0;
+    size_t k = std::min(v.size() - 1, static_cast<size_t>(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+bool LoadSentences(const std::wstring& path, std::vector<std::string>* sentences)
+{
+    if (path.empty()) {
+        sentences->assign(std::begin(kDefaultSentences), std::end(kDefaultSentences));
+        return true;
+    }
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) sentences->push_back(line);
+    }
+    return !sentences->empty();
+}
+
+void RunBackend(const TranslateBenchOptions& options, const std::string& name,
+    const std::vector<std::string>& sentences, TranslateBenchResult* result)
+{
+    result->backend = name;
+    std::unique_ptr<TranslationBackend> backend = CreateTranslationBackend(
+        name == "local" ? TranslationBackendType::kLocal : TranslationBackendType::kWebSocket);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_set<uint64_t> pending;
+    std::vector<int64_t> latency_ms;
+    backend->SetResultCallback([&](const TranslationResult& r) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // 合并的请求共用一次翻译，按最后一句的延迟计
+        uint64_t n = 1 + r.merged_ids.size();
+        pending.erase(r.id);
+        for (uint64_t id : r.merged_ids) pending.erase(id);
+        bool ok = r.ok && !r.translations.empty() && !r.translations.front().text.empty();
+        if (ok) {
+            result->ok += n;
+            if (latency_ms.empty()) result->first_ms = r.latency_us / 1000;
+            latency_ms.push_back(r.latency_us / 1000);
+        }
+        else {
+            result->failed += n;
+        }
+        cv.notify_all();
+    });
+    result->started = backend->Start();
+    if (!result->started) return;
+
+    for (int32_t i = 0; i < options.requests; ++i) {
+        TranslationRequest request;
+        request.id = static_cast<uint64_t>(i) + 1;
+        request.text = sentences[static_cast<size_t>(i) % sentences.size()];
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.insert(request.id);
+        }
+        backend->Submit(std::move(request));
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.interval_ms));
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait_for(lock, std::chrono::milliseconds(options.drain_ms), [&] { return pending.empty(); });
+        result->failed += pending.size();
+    }
+    backend->Stop();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    result->p50_ms = Percentile(latency_ms, 0.50);
+    result->p95_ms = Percentile(latency_ms, 0.95);
+    result->max_ms = Percentile(latency_ms, 1.0);
+    LOG_INFO("TranslateBench", "%s: ok=%llu failed=%llu p50=%lldms p95=%lldms", name.c_str(),
+        static_cast<unsigned long long>(result->ok), static_cast<unsigned long long>(result->failed),
+        static_cast<long long>(result->p50_ms), static_cast<long long>(result->p95_ms));
+}
+
+} // namespace
+
+bool RunTranslateBench(const TranslateBenchOptions& options, TranslateBenchReport* report)
+{
+    *report = TranslateBenchReport();
+    std::vector<std::string> sentences;
+    if (!LoadSentences(options.sentences, &sentences)) return false;
+
+    for (const std::string& name : options.backends) {
+        TranslateBenchResult result;
+        RunBackend(options, name, sentences, &result);
+        report->results.push_back(result);
+    }
+    for (const TranslateBenchResult& r : report->results) {
+        if (!r.started) report->Violation("%s: backend did not start", r.backend.c_str());
+        else if (r.failed > 0)
+            report->Violation("%s: %llu of %d sentences got no translation", r.backend.c_str(),
+                static_cast<unsigned long long>(r.failed), options.requests);
+    }
+    return true;
+}
+
+int RunTranslateBenchCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    TranslateBenchOptions options;
+    bool backend_set = false;
+    bool bad_backend = false;
+    ArgParser()
+        .Option(L"--backend", [&](const wchar_t* name) {
+            if (!backend_set) options.backends.clear();
+            backend_set = true;
+            if (wcscmp(name, L"local") == 0) options.backends.push_back("local");
+            else if (wcscmp(name, L"ws") == 0) options.backends.push_back("ws");
+            else bad_backend = true;
+        })
+        .Option(L"--requests", &options.requests)
+        .Option(L"--interval-ms", &options.interval_ms)
+        .Positional(&options.sentences)
+        .Parse(argc, argv);
+    if (bad_backend || options.requests <= 0 || options.interval_ms < 0) {
+        printf("usage: InstantTrans.exe --translate-bench [sentences.txt] [--backend local|ws] [--requests N] "
+            "[--interval-ms M]\n");
+        return 2;
+    }
+
+    TranslateBenchReport r;
+    if (!RunTranslateBench(options, &r)) {
+        printf("[TranslateBench] cannot read sentences\n");
+        return 2;
+    }
+
+    printf("[TranslateBench] %7s %6s %7s %9s %8s %8s %8s\n", "backend", "ok", "failed", "first(ms)", "p50(ms)",
+        "p95(ms)", "max(ms)");
+    for (const TranslateBenchResult& x : r.results) {
+        printf("[TranslateBench] %7s %6llu %7llu %9lld %8lld %8lld %8lld\n", x.backend.c_str(),
+            static_cast<unsigned long long>(x.ok), static_cast<unsigned long long>(x.failed),
+            static_cast<long long>(x.first_ms), static_cast<long long>(x.p50_ms), static_cast<long long>(x.p95_ms),
+            static_cast<long long>(x.max_ms));
+    }
+    return PrintVerdict("TranslateBench", r);
+}
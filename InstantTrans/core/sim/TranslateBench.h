@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 翻译后端基准：同一组句子按字幕节奏分别提交给本地 Marian 后端与网关后端，比较提交到结果的延迟：
+//
+//   InstantTrans.exe --translate-bench sentences.txt --interval-ms 300
+//
+// 网关地址取 INSTANTTRANS_GATEWAYS，本地模型取程序目录下的 opus-mt-en-zh
+struct TranslateBenchOptions {
+    std::wstring sentences;          // UTF-8 文本，每行一句；为空时用内置的几句
+    std::vector<std::string> backends = { "local", "ws" };
+    int32_t requests = 200;          // 每个后端提交的句数，句子循环使用
+    int32_t interval_ms = 300;       // 提交间隔，接近连续说话时 final 的节奏
+    int32_t drain_ms = 30000;        // 全部提交后等待结果的上限
+};
+
+struct TranslateBenchResult {
+    std::string backend;
+    bool started = false;
+    uint64_t ok = 0;
+    uint64_t failed = 0;             // 含超时未回调
+    int64_t first_ms = 0;            // 第一句的延迟，本地后端含预热
+    int64_t p50_ms = 0;
+    int64_t p95_ms = 0;
+    int64_t max_ms = 0;
+};
+
+struct TranslateBenchReport : CheckReport {
+    std::vector<TranslateBenchResult> results;
+};
+
+// 句子文件读取失败返回 false
+bool RunTranslateBench(const TranslateBenchOptions& options, TranslateBenchReport* report);
+
+// 命令行入口：InstantTrans.exe --translate-bench [sentences.txt] [--backend local|ws] [--requests N]
+//   [--interval-ms M]
+// 每个后端都能启动且所有句子都有译文时返回 0，否则返回 1
+int RunTranslateBenchCommandLine(int argc, wchar_t** argv);
@@ -0,0 +1,257 @@
+#define NOMINMAX
+#include "VadBench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include <Windows.h>
+
+#include "core/metrics/Log.h"
+#include "core/recoginize/ModelFiles.h"
+#include "core/recoginize/SessionRecorder.h"
+#include "core/recoginize/SileroVad.h"
+#include "core/recoginize/SpeechRecognize.h"
+#include "core/recoginize/ThreadTuning.h"
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+// 每 20ms 一块，与 RecognizerOptions::chunk_ms 一致
+const int32_t kChunkSamples = recording::kSampleRate / 50;
+const auto kChunkPeriod = std::chrono::milliseconds(20);
+// 录音最多读入前 10 分钟，各路从不同位置开始循环
+const size_t kMaxAudioSamples = static_cast<size_t>(recording::kSampleRate) * 600;
+
+const char* const kModes[] = { "sherpa", "private", "shared" };
+
+// 一路的判决轨迹，逐路比较用
+struct StreamTrace {
+    std::string detected;                                  // 每个窗口送入后的 IsDetected
+    std::vector<std::pair<int64_t, size_t>> segments;      // 语音段起点与长度
+    std::vector<int64_t> latency_us;
+};
+
+int64_t ProcessCpu100ns()
+{
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0;
+    auto ticks = [](const FILETIME& t) {
+        return (static_cast<int64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return ticks(kernel) + ticks(user);
+}
+
+std::vector<float> LoadAudio(const std::wstring& path)
+{
+    if (path.empty()) return ThreadTuning::MakeCalibrationClip(recording::kSampleRate, 30.0f);
+
+    std::vector<float> audio;
+    recording::Reader reader;
+    if (!reader.Open(path)) {
+        LOG_ERROR("VadBench", "cannot open recording %s", WStringToUtf8(path).c_str());
+        return audio;
+    }
+    recording::Chunk chunk;
+    while (audio.size() < kMaxAudioSamples && reader.Next(&chunk))
+        audio.insert(audio.end(), chunk.samples.begin(), chunk.samples.end());
+    return audio;
+}
+
+void DrainSegments(VadStream& vad, StreamTrace* trace)
+{
+    while (!vad.IsEmpty()) {
+        const VadSegment& segment = vad.Front();
+        trace->segments.emplace_back(segment.start, segment.samples.size());
+        vad.Pop();
+    }
+}
+
+// 两条轨迹一致时返回空串，否则描述第一处差异
+std::string CompareTraces(const StreamTrace& a, const StreamTrace& b)
+{
+    char text[128];
+    size_t n = std::min(a.detected.size(), b.detected.size());
+    auto diff = std::mismatch(a.detected.begin(), a.detected.begin() + n, b.detected.begin());
+    if (diff.first != a.detected.begin() + n || a.detected.size() != b.detected.size()) {
+        snprintf(text, sizeof(text), "detection differs at window %zu",
+            static_cast<size_t>(diff.first - a.detected.begin()));
+        return text;
+    }
+    if (a.segments != b.segments) {
+        snprintf(text, sizeof(text), "segments differ (%zu vs %zu)", a.segments.size(), b.segments.size());
+        return text;
+    }
+    return std::string();
+}
+
+bool RunMode(const VadBenchOptions& options, const std::vector<float>& audio, int32_t n, const std::string& mode,
+    VadBenchResult* result, std::vector<StreamTrace>* traces)
+{
+    const SileroVadConfig config = SpeechRecognizer::VadConfig();
+    SileroVadEngineOptions engine_options;
+    engine_options.model = config.model;
+    engine_options.gather_ms = options.gather_ms;
+    engine_options.max_batch = std::max(engine_options.max_batch, n);
+
+    std::shared_ptr<SileroVadEngine> shared;
+    if (mode == "shared") {
+        shared = std::make_shared<SileroVadEngine>(engine_options);
+        if (!shared->Load()) return false;
+    }
+    std::vector<std::unique_ptr<VadStream>> streams;
+    for (int32_t i = 0; i < n; ++i) {
+        std::shared_ptr<SileroVadEngine> engine = shared;
+        if (mode == "private") {
+            engine = std::make_shared<SileroVadEngine>(engine_options);
+            if (!engine->Load()) return false;
+        }
+        streams.push_back(std::make_unique<VadStream>(config, engine));
+        if (!streams.back()->Valid()) return false;
+    }
+
+    const int64_t total = static_cast<int64_t>(options.seconds * recording::kSampleRate);
+    const int32_t window_size = SileroVadEngine::kWindowSize;
+    traces->assign(n, StreamTrace());
+    std::mt19937 rng(20240601);
+    std::vector<std::thread> threads;
+    const auto start = SteadyClock::now() + std::chrono::milliseconds(200);
+    const int64_t cpu_before = ProcessCpu100ns();
+    for (int32_t i = 0; i < n; ++i) {
+        // 各路错开音频起点与节拍相位，模拟互不同步的音源；相位对各方式相同
+        const size_t offset = audio.size() * i / n;
+        const auto phase = std::chrono::microseconds(rng() % 20000);
+        threads.emplace_back([&, i, offset, phase] {
+            VadStream& vad = *streams[i];
+            StreamTrace& trace = (*traces)[i];
+            trace.detected.reserve(static_cast<size_t>(total / window_size + 1));
+            trace.latency_us.reserve(static_cast<size_t>(total / window_size + 1));
+            std::vector<float> window(window_size);
+            size_t pos = offset;
+            int64_t available = 0;
+            int64_t fed = 0;
+            auto due = start + phase;
+            while (available < total) {
+                std::this_thread::sleep_until(due);
+                due += kChunkPeriod;
+                available += kChunkSamples;
+                for (; fed + window_size <= available; fed += window_size) {
+                    for (float& sample : window) {
+                        sample = audio[pos];
+                        pos = (pos + 1) % audio.size();
+                    }
+                    auto t0 = SteadyClock::now();
+                    vad.AcceptWaveform(window.data(), window_size);
+                    trace.latency_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                        SteadyClock::now() - t0).count());
+                    trace.detected.push_back(vad.IsDetected() ? '1' : '0');
+                    DrainSegments(vad, &trace);
+                }
+            }
+            vad.Flush();
+            DrainSegments(vad, &trace);
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    const double wall_s = std::chrono::duration<double>(SteadyClock::now() - start).count();
+    const double cpu_s = (ProcessCpu100ns() - cpu_before) / 1e7;
+
+    std::vector<int64_t> latency;
+    result->streams = n;
+    result->mode = mode;
+    result->cpu_percent = wall_s > 0 ? cpu_s / wall_s / n * 100 : 0;
+    for (const StreamTrace& trace : *traces) {
+        result->windows += trace.detected.size();
+        result->segments += trace.segments.size();
+        latency.insert(latency.end(), trace.latency_us.begin(), trace.latency_us.end());
+    }
+    if (!latency.empty()) {
+        auto p95 = latency.begin() + latency.size() * 95 / 100;
+        std::nth_element(latency.begin(), p95, latency.end());
+        result->window_p95_us = *p95;
+    }
+    if (shared) result->mean_batch = shared->Stats().MeanBatch();
+    return true;
+}
+
+std::vector<int32_t> ParseCounts(const std::wstring& text)
+{
+    std::vector<int32_t> counts;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t comma = text.find(L',', pos);
+        if (comma == std::wstring::npos) comma = text.size();
+        int32_t n = _wtoi(text.substr(pos, comma - pos).c_str());
+        if (n > 0) counts.push_back(n);
+        pos = comma + 1;
+    }
+    return counts;
+}
+
+} // namespace
+
+bool RunVadBench(const VadBenchOptions& options, VadBenchReport* report)
+{
+    const std::vector<float> audio = LoadAudio(options.recording);
+    if (audio.empty()) return false;
+
+    for (int32_t n : options.streams) {
+        std::vector<StreamTrace> traces[3];
+        for (int m = 0; m < 3; ++m) {
+            VadBenchResult result;
+            if (!RunMode(options, audio, n, kModes[m], &result, &traces[m])) {
+                LOG_ERROR("VadBench", "cannot create %s VAD", kModes[m]);
+                return false;
+            }
+            LOG_INFO("VadBench", "streams=%d mode=%s cpu=%.2f%% p95=%lldus",
+                n, kModes[m], result.cpu_percent, static_cast<long long>(result.window_p95_us));
+            report->results.push_back(result);
+        }
+
+        int32_t sherpa_diffs = 0;
+        for (int32_t i = 0; i < n; ++i) {
+            std::string diff = CompareTraces(traces[1][i], traces[2][i]);
+            if (!diff.empty()) report->Violation("streams=%d stream %d: shared vs private %s", n, i, diff.c_str());
+            if (!CompareTraces(traces[0][i], traces[1][i]).empty()) ++sherpa_diffs;
+        }
+        // sherpa-onnx 按 batch=1 推理，概率末位可能不同，恰好落在门限上时判决会差一个窗口，只记录不判失败
+        if (sherpa_diffs > 0)
+            LOG_INFO("VadBench", "streams=%d: %d stream(s) differ from sherpa-onnx VAD", n, sherpa_diffs);
+    }
+    return true;
+}
+
+int RunVadBenchCommandLine(int argc, wchar_t** argv)
+{
+    AttachParentConsole();
+
+    VadBenchOptions options;
+    ArgParser()
+        .Option(L"--streams", [&](const wchar_t* value) { options.streams = ParseCounts(value); })
+        .Option(L"--seconds", &options.seconds)
+        .Option(L"--gather-ms", &options.gather_ms)
+        .Positional(&options.recording)
+        .Parse(argc, argv);
+    if (options.streams.empty() || options.seconds <= 0) {
+        printf("usage: InstantTrans.exe --vad-bench [recording.itrec] [--streams 1,8,32] "
+            "[--seconds S] [--gather-ms M]\n");
+        return 2;
+    }
+
+    VadBenchReport r;
+    if (!RunVadBench(options, &r)) {
+        printf("[VadBench] cannot load audio or VAD model\n");
+        return 2;
+    }
+
+    printf("[VadBench] %7s %8s %12s %10s %9s %8s\n", "streams", "mode", "cpu/stream", "p95(us)", "segments", "batch");
+    for (const VadBenchResult& x : r.results) {
+        printf("[VadBench] %7d %8s %11.2f%% %10lld %9llu %8.1f\n", x.streams, x.mode.c_str(), x.cpu_percent,
+            static_cast<long long>(x.window_p95_us), static_cast<unsigned long long>(x.segments), x.mean_batch);
+    }
+    return PrintVerdict("VadBench", r);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CommandLine.h"
+
+// 多路 VAD 基准：每路一个线程按实时节奏每 20ms 送一块音频，分别测三种方式的 VAD CPU：
+//   sherpa   每路一个 sherpa-onnx VAD（现状）
+//   private  每路一个 SileroVadEngine，不与其它路拼批
+//   shared   所有路共用一个 SileroVadEngine
+// 同时逐路比较 private 与 shared 的判决与语音段，任何不一致都判失败：
+//
+//   InstantTrans.exe --vad-bench session.itrec --streams 1,8,32 --seconds 20
+struct VadBenchOptions {
+    std::wstring recording;          // SessionRecorder 录下的 .itrec；为空时用合成的校准片段
+    std::vector<int32_t> streams = { 1, 8, 32 };
+    double seconds = 20.0;           // 每种方式每个路数的运行时长
+    int32_t gather_ms = 8;           // SileroVadEngineOptions::gather_ms
+};
+
+struct VadBenchResult {
+    int32_t streams = 0;
+    std::string mode;
+    double cpu_percent = 0;          // 每路占单核的百分比（进程 CPU 时间 / 墙钟 / 路数）
+    uint64_t windows = 0;
+    uint64_t segments = 0;
+    double mean_batch = 0;           // 仅 shared
+    int64_t window_p95_us = 0;       // 单个窗口从送入到得到判决，含凑批等待
+};
+
+// violations 为 private 与 shared 判决不一致的流
+struct VadBenchReport : CheckReport {
+    std::vector<VadBenchResult> results;
+};
+
+// 模型加载失败返回 false
+bool RunVadBench(const VadBenchOptions& options, VadBenchReport* report);
+
+// 命令行入口：InstantTrans.exe --vad-bench [recording.itrec] [--streams 1,8,32] [--seconds S] [--gather-ms M]
+// 逐路结果一致时返回 0，否则返回 1
+int RunVadBenchCommandLine(int argc, wchar_t** argv);
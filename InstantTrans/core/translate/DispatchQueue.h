@@ -0,0 +1,104 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <deque>
+
+#include "TranslationBackend.h"
+
+// 翻译派发队列：按优先级分道，道内先进先出；总是先取最高优先级道的队首
+// T 需有 TranslationRequest 类型的 request 成员
+template <typename T>
+class DispatchQueue {
+public:
+    void Push(T item) { Lane(item).push_back(std::move(item)); }
+
+    // 重发的请求放回所在道的队首
+    void PushFront(T item) { Lane(item).push_front(std::move(item)); }
+
+    bool Empty() const { return Size() == 0; }
+
+    size_t Size() const {
+        size_t n = 0;
+        for (const auto& lane : lanes_) n += lane.size();
+        return n;
+    }
+
+    // 最高优先级的非空道，队列为空时不可调用
+    std::deque<T>& FrontLane() {
+        for (auto& lane : lanes_) {
+            if (!lane.empty()) return lane;
+        }
+        return lanes_[kLanes - 1];
+    }
+
+    T& Front() { return FrontLane().front(); }
+
+    T PopFront() {
+        std::deque<T>& lane = FrontLane();
+        T item = std::move(lane.front());
+        lane.pop_front();
+        return item;
+    }
+
+    // 移除满足 pred 的条目并交给 on_removed，返回移除数
+    template <typename Pred, typename F>
+    size_t RemoveIf(Pred pred, F on_removed) {
+        size_t removed = 0;
+        for (auto& lane : lanes_) {
+            for (auto it = lane.begin(); it != lane.end();) {
+                if (pred(*it)) {
+                    on_removed(std::move(*it));
+                    it = lane.erase(it);
+                    ++removed;
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+        return removed;
+    }
+
+    // 已过显示截止时间的请求：只上屏的已无用处，移出队列交给 on_dropped；
+    // 其余先交给 on_demoted，再降到后台道队尾，不再挤占能上屏的句子，但照常翻译落盘
+    template <typename Drop, typename Demote>
+    void ShedExpired(std::chrono::steady_clock::time_point now, Drop on_dropped, Demote on_demoted) {
+        std::deque<T> demoted;
+        RemoveIf([now](const T& item) { return IsExpired(item.request, now); },
+            [&](T&& item) {
+                if (item.request.display_only) on_dropped(std::move(item));
+                else demoted.push_back(std::move(item));
+            });
+        for (T& item : demoted) {
+            on_demoted(item);
+            item.request.priority = TranslationPriority::kBackgroundFinal;
+            item.request.deadline = {};
+            item.request.late = true;
+            Push(std::move(item));
+        }
+    }
+
+    // priority 道超过 max 条时从最早的开始移出，交给 on_removed
+    template <typename F>
+    void TrimLane(TranslationPriority priority, size_t max, F on_removed) {
+        std::deque<T>& lane = lanes_[static_cast<size_t>(priority)];
+        while (lane.size() > max) {
+            on_removed(std::move(lane.front()));
+            lane.pop_front();
+        }
+    }
+
+    void Clear() {
+        for (auto& lane : lanes_) lane.clear();
+    }
+
+private:
+    static const size_t kLanes = static_cast<size_t>(TranslationPriority::kCount);
+
+    std::deque<T>& Lane(const T& item) {
+        size_t lane = static_cast<size_t>(item.request.priority);
+        return lanes_[lane < kLanes ? lane : kLanes - 1];
+    }
+
+    std::deque<T> lanes_[kLanes];
+};
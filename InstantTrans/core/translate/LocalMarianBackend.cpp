@@ -0,0 +1,499 @@
+#define NOMINMAX
+#include "LocalMarianBackend.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <nlohmann/json.hpp>
+#include <onnxruntime_cxx_api.h>
+
+#include "core/metrics/Log.h"
+#include "core/metrics/Metrics.h"
+#include "core/recoginize/ModelFiles.h"
+
+static const char* kSpaceMark = "\xE2\x96\x81";   // U+2581，SentencePiece 的词首标记
+
+static bool ReadFile(const std::wstring& path, std::string& out)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+// UTF-8 首字节对应的字符长度
+static size_t Utf8Length(unsigned char c)
+{
+    if (c < 0x80) return 1;
+    if ((c >> 5) == 0x6) return 2;
+    if ((c >> 4) == 0xE) return 3;
+    if ((c >> 3) == 0x1E) return 4;
+    return 1;
+}
+
+// protobuf varint；越界返回 false
+static bool ReadVarint(const std::string& buf, size_t* pos, uint64_t* value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 64 && *pos < buf.size(); shift += 7) {
+        unsigned char b = static_cast<unsigned char>(buf[(*pos)++]);
+        *value |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// 跳过一个字段的值；不认识的 wire type 返回 false
+static bool SkipField(const std::string& buf, size_t* pos, uint32_t wire_type)
+{
+    uint64_t n = 0;
+    switch (wire_type) {
+    case 0: return ReadVarint(buf, pos, &n);
+    case 1: *pos += 8; break;
+    case 2: if (!ReadVarint(buf, pos, &n)) return false; *pos += static_cast<size_t>(n); break;
+    case 5: *pos += 4; break;
+    default: return false;
+    }
+    return *pos <= buf.size();
+}
+
+// 从 SentencePiece 的 ModelProto（source.spm）中取出普通词片的分数：
+// ModelProto.pieces = 1，SentencePiece { piece = 1; score = 2 (float); type = 3 }，
+// 只保留 NORMAL(1) 与 USER_DEFINED(4)，控制符与 <unk> 不参与切分
+static bool ReadSpmScores(const std::string& buf, std::unordered_map<std::string, float>* scores)
+{
+    size_t pos = 0;
+    while (pos < buf.size()) {
+        uint64_t key = 0;
+        if (!ReadVarint(buf, &pos, &key)) return false;
+        if (key != ((1 << 3) | 2)) {
+            if (!SkipField(buf, &pos, static_cast<uint32_t>(key & 7))) return false;
+            continue;
+        }
+        uint64_t len = 0;
+        if (!ReadVarint(buf, &pos, &len) || pos + len > buf.size()) return false;
+        const size_t end = pos + static_cast<size_t>(len);
+        std::string piece;
+        float score = 0;
+        uint64_t type = 1;
+        while (pos < end) {
+            uint64_t field = 0;
+            if (!ReadVarint(buf, &pos, &field)) return false;
+            if (field == ((1 << 3) | 2)) {
+                uint64_t n = 0;
+                if (!ReadVarint(buf, &pos, &n) || pos + n > end) return false;
+                piece.assign(buf, pos, static_cast<size_t>(n));
+                pos += static_cast<size_t>(n);
+            }
+            else if (field == ((2 << 3) | 5) && pos + 4 <= end) {
+                memcpy(&score, buf.data() + pos, 4);
+                pos += 4;
+            }
+            else if (field == ((3 << 3) | 0)) {
+                if (!ReadVarint(buf, &pos, &type)) return false;
+            }
+            else if (!SkipField(buf, &pos, static_cast<uint32_t>(field & 7))) {
+                return false;
+            }
+        }
+        pos = end;
+        if ((type == 1 || type == 4) && !piece.empty()) (*scores)[piece] = score;
+    }
+    return !scores->empty();
+}
+
+LocalMarianBackend::LocalMarianBackend(const LocalMarianOptions& options) : options_(options)
+{
+}
+
+LocalMarianBackend::~LocalMarianBackend()
+{
+    Stop();
+}
+
+bool LocalMarianBackend::Start()
+{
+    if (!encoder_ && !LoadModel()) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stop_) return true;
+    stop_ = false;
+    for (int32_t i = 0; i < std::max(1, options_.workers); ++i) {
+        workers_.emplace_back(&LocalMarianBackend::WorkerLoop, this);
+    }
+    return true;
+}
+
+void LocalMarianBackend::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) return;
+        stop_ = true;
+        queue_.Clear();
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+    workers_.clear();
+    LogShedStats();
+}
+
+void LocalMarianBackend::Submit(TranslationRequest request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) return;
+        queue_.Push({ std::move(request), std::chrono::steady_clock::now() });
+        CountSubmitted();
+    }
+    cv_.notify_one();
+}
+
+bool LocalMarianBackend::LoadModel()
+{
+    const std::wstring& dir = options_.model_dir;
+
+    std::string text;
+    if (!ReadFile(dir + L"\\vocab.json", text)) {
+        LOG_ERROR("LocalMT", "vocab.json not found");
+        return false;
+    }
+    try {
+        auto vocab = nlohmann::json::parse(text);
+        for (auto it = vocab.begin(); it != vocab.end(); ++it) {
+            int64_t id = it.value().get<int64_t>();
+            vocab_[it.key()] = id;
+            if (static_cast<size_t>(id) >= pieces_.size()) pieces_.resize(static_cast<size_t>(id) + 1);
+            pieces_[static_cast<size_t>(id)] = it.key();
+            max_piece_bytes_ = std::max(max_piece_bytes_, it.key().size());
+        }
+        auto unk = vocab_.find("<unk>");
+        if (unk != vocab_.end()) unk_id_ = unk->second;
+
+        // 有 source.spm 时按其中的 unigram 分数做 Viterbi 切分，与 SentencePiece 的编码一致
+        if (ReadFile(dir + L"\\source.spm", text)) {
+            std::unordered_map<std::string, float> scores;
+            if (ReadSpmScores(text, &scores)) {
+                for (auto& kv : scores) {
+                    if (vocab_.count(kv.first)) {
+                        min_score_ = std::min(min_score_, kv.second);
+                        scores_.insert(std::move(kv));
+                    }
+                }
+            }
+            else {
+                LOG_WARN("LocalMT", "source.spm could not be parsed, falling back to longest-prefix tokenization");
+            }
+        }
+        if (scores_.empty())
+            LOG_WARN("LocalMT", "no source.spm scores, tokenizing by longest prefix; translations may degrade");
+
+        if (ReadFile(dir + L"\\config.json", text)) {
+            auto config = nlohmann::json::parse(text);
+            eos_id_ = config.value("eos_token_id", eos_id_);
+            pad_id_ = config.value("pad_token_id", pad_id_);
+            decoder_start_id_ = config.value("decoder_start_token_id", pad_id_);
+            max_length_ = config.value("max_length", max_length_);
+        }
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("LocalMT", "failed to parse vocab/config: %s", e.what());
+        return false;
+    }
+
+    auto load_begin = std::chrono::steady_clock::now();
+    try {
+        env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "InstantTransMT");
+        Ort::SessionOptions session_options;
+        session_options.SetIntraOpNumThreads(options_.intra_threads);
+        session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+
+        std::wstring encoder_path = dir + L"\\encoder_model.onnx";
+        std::wstring decoder_path = dir + L"\\decoder_model.onnx";
+        encoder_ = std::make_unique<Ort::Session>(*env_, encoder_path.c_str(), session_options);
+        decoder_ = std::make_unique<Ort::Session>(*env_, decoder_path.c_str(), session_options);
+    }
+    catch (const Ort::Exception& e) {
+        LOG_ERROR("LocalMT", "failed to load model: %s", e.what());
+        encoder_.reset();
+        decoder_.reset();
+        return false;
+    }
+
+    auto load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - load_begin).count();
+    LOG_INFO("LocalMT", "model loaded in %lld ms, vocab=%zu rss=%zu MB",
+        static_cast<long long>(load_ms), pieces_.size(), GetProcessRss() / (1024 * 1024));
+    return true;
+}
+
+void LocalMarianBackend::WorkerLoop()
+{
+    metrics::Histogram* latency = metrics::Registry::Instance().GetHistogram(
+        "instanttrans_translate_latency_seconds", "Submit-to-result translation latency", "backend=\"local\"");
+    metrics::Histogram* batch_time = metrics::Registry::Instance().GetHistogram(
+        "instanttrans_local_mt_batch_seconds", "Local MT time per batch");
+
+    std::vector<Pending> batch;
+    std::vector<Pending> dropped;
+    std::vector<std::string> texts;
+    for (;;) {
+        batch.clear();
+        dropped.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || !queue_.Empty(); });
+            if (stop_) break;
+
+            // 首条到达后短暂等待，把同时完成的句子凑成一批
+            auto deadline = queue_.Front().submitted + std::chrono::milliseconds(options_.batch_wait_ms);
+            cv_.wait_until(lock, deadline, [this] {
+                return stop_ || queue_.Size() >= static_cast<size_t>(options_.max_batch);
+            });
+            if (stop_) break;
+
+            // 积压时已滚出显示区的句子：只上屏的丢弃，要落盘的让给后面的句子，稍后翻译
+            queue_.ShedExpired(std::chrono::steady_clock::now(),
+                [&](Pending&& p) { dropped.push_back(std::move(p)); },
+                [this](const Pending& p) { CountDemoted(p.request); });
+            while (!queue_.Empty() && batch.size() < static_cast<size_t>(options_.max_batch)) {
+                batch.push_back(queue_.PopFront());
+            }
+        }
+
+        for (Pending& p : dropped) Drop(p.request, {}, "expired");
+        if (batch.empty()) continue;
+
+        texts.clear();
+        for (const Pending& p : batch) texts.push_back(p.request.text);
+
+        std::vector<std::string> outputs;
+        {
+            metrics::ScopedTimer timer(batch_time);
+            outputs = TranslateBatch(texts);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            TranslationResult result;
+            result.id = batch[i].request.id;
+            result.source_text = std::move(batch[i].request.text);
+            result.ok = i < outputs.size() && !outputs[i].empty();
+            // 一个模型只有一种目标语言
+            for (const std::string& lang : batch[i].request.langs_to) {
+                TranslatedText t;
+                t.lang = lang;
+                if (lang == options_.lang_to && i < outputs.size()) t.text = outputs[i];
+                result.translations.push_back(std::move(t));
+            }
+            result.latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                now - batch[i].submitted).count();
+            latency->Record(static_cast<uint64_t>(result.latency_us));
+            Deliver(result, batch[i].request);
+        }
+    }
+}
+
+std::vector<int64_t> LocalMarianBackend::Encode(const std::string& text) const
+{
+    // 按空白切词，每个词前加 ▁；有分数时做 unigram Viterbi，否则在词表上做最长前缀匹配
+    std::vector<int64_t> ids;
+    std::string word;
+    auto flush_word = [&]() {
+        if (word.empty()) return;
+        std::string piece_src = kSpaceMark + word;
+        if (!scores_.empty()) {
+            EncodeWord(piece_src, &ids);
+            word.clear();
+            return;
+        }
+        size_t pos = 0;
+        while (pos < piece_src.size()) {
+            size_t best_len = 0;
+            int64_t best_id = unk_id_;
+            size_t limit = std::min(max_piece_bytes_, piece_src.size() - pos);
+            for (size_t len = limit; len > 0; --len) {
+                auto it = vocab_.find(piece_src.substr(pos, len));
+                if (it != vocab_.end()) {
+                    best_len = len;
+                    best_id = it->second;
+                    break;
+                }
+            }
+            if (best_len == 0) best_len = Utf8Length(static_cast<unsigned char>(piece_src[pos]));
+            ids.push_back(best_id);
+            pos += best_len;
+        }
+        word.clear();
+    };
+
+    for (char c : text) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') flush_word();
+        else word += c;
+    }
+    flush_word();
+
+    if (ids.size() > static_cast<size_t>(options_.max_source_tokens - 1))
+        ids.resize(static_cast<size_t>(options_.max_source_tokens - 1));
+    ids.push_back(eos_id_);
+    return ids;
+}
+
+void LocalMarianBackend::EncodeWord(const std::string& word, std::vector<int64_t>* ids) const
+{
+    // best[i]：切到字节 i 的最大分数；词表外的单个字符记为 <unk>，分数比最低的词片再低 10（同 SentencePiece）
+    const float unk_score = min_score_ - 10.0f;
+    const size_t n = word.size();
+    std::vector<float> best(n + 1, -1e30f);
+    std::vector<size_t> from(n + 1, 0);
+    std::vector<int64_t> piece_id(n + 1, unk_id_);
+    best[0] = 0;
+    for (size_t begin = 0; begin < n; begin += Utf8Length(static_cast<unsigned char>(word[begin]))) {
+        if (best[begin] <= -1e30f) continue;
+        const size_t char_end = std::min(n, begin + Utf8Length(static_cast<unsigned char>(word[begin])));
+        if (best[begin] + unk_score > best[char_end]) {
+            best[char_end] = best[begin] + unk_score;
+            from[char_end] = begin;
+            piece_id[char_end] = unk_id_;
+        }
+        const size_t limit = std::min(max_piece_bytes_, n - begin);
+        for (size_t len = 1; len <= limit; ++len) {
+            auto it = scores_.find(word.substr(begin, len));
+            if (it == scores_.end()) continue;
+            const size_t end = begin + len;
+            if (best[begin] + it->second > best[end]) {
+                best[end] = best[begin] + it->second;
+                from[end] = begin;
+                piece_id[end] = vocab_.at(it->first);
+            }
+        }
+    }
+
+    const size_t first = ids->size();
+    for (size_t end = n; end > 0; end = from[end]) ids->push_back(piece_id[end]);
+    std::reverse(ids->begin() + static_cast<std::ptrdiff_t>(first), ids->end());
+}
+
+std::string LocalMarianBackend::Decode(const std::vector<int64_t>& ids) const
+{
+    std::string out;
+    for (int64_t id : ids) {
+        if (id == eos_id_ || id == pad_id_ || id < 0 || static_cast<size_t>(id) >= pieces_.size()) continue;
+        const std::string& piece = pieces_[static_cast<size_t>(id)];
+        if (piece.compare(0, 3, kSpaceMark) == 0) {
+            if (!out.empty()) out += ' ';
+            out.append(piece, 3, std::string::npos);
+        }
+        else {
+            out += piece;
+        }
+    }
+    return out;
+}
+
+std::vector<std::string> LocalMarianBackend::TranslateBatch(const std::vector<std::string>& texts)
+{
+    std::vector<std::string> outputs(texts.size());
+    if (texts.empty() || !encoder_ || !decoder_) return outputs;
+
+    const int64_t batch = static_cast<int64_t>(texts.size());
+    std::vector<std::vector<int64_t>> sources(texts.size());
+    size_t src_len = 0;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        sources[i] = Encode(texts[i]);
+        src_len = std::max(src_len, sources[i].size());
+    }
+
+    // 右侧补 pad，attention_mask 标出有效位置
+    std::vector<int64_t> input_ids(batch * src_len, pad_id_);
+    std::vector<int64_t> attention_mask(batch * src_len, 0);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        std::copy(sources[i].begin(), sources[i].end(), input_ids.begin() + i * src_len);
+        std::fill_n(attention_mask.begin() + i * src_len, sources[i].size(), 1);
+    }
+
+    try {
+        Ort::MemoryInfo memory = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        std::array<int64_t, 2> src_shape{ batch, static_cast<int64_t>(src_len) };
+
+        Ort::Value encoder_inputs[2] = {
+            Ort::Value::CreateTensor<int64_t>(memory, input_ids.data(), input_ids.size(), src_shape.data(), 2),
+            Ort::Value::CreateTensor<int64_t>(memory, attention_mask.data(), attention_mask.size(), src_shape.data(), 2),
+        };
+        const char* encoder_in_names[] = { "input_ids", "attention_mask" };
+        const char* encoder_out_names[] = { "last_hidden_state" };
+        auto encoder_out = encoder_->Run(Ort::RunOptions{ nullptr },
+            encoder_in_names, encoder_inputs, 2, encoder_out_names, 1);
+        // 编码结果在各步之间复用，每步只包一层不拥有数据的张量
+        auto hidden_shape = encoder_out[0].GetTensorTypeAndShapeInfo().GetShape();
+        float* hidden = encoder_out[0].GetTensorMutableData<float>();
+        size_t hidden_count = encoder_out[0].GetTensorTypeAndShapeInfo().GetElementCount();
+
+        // 逐步贪心解码，整批共用一次 Run；已结束的行继续补 pad
+        const size_t max_len = std::min<size_t>(static_cast<size_t>(max_length_), src_len * 2 + 16);
+        std::vector<std::vector<int64_t>> targets(texts.size(), std::vector<int64_t>{ decoder_start_id_ });
+        std::vector<bool> finished(texts.size(), false);
+        size_t remaining = texts.size();
+        std::vector<int64_t> decoder_ids;
+
+        const char* decoder_in_names[] = { "encoder_attention_mask", "input_ids", "encoder_hidden_states" };
+        const char* decoder_out_names[] = { "logits" };
+
+        for (size_t step = 1; step < max_len && remaining > 0; ++step) {
+            decoder_ids.clear();
+            for (const auto& t : targets) decoder_ids.insert(decoder_ids.end(), t.begin(), t.end());
+            std::array<int64_t, 2> tgt_shape{ batch, static_cast<int64_t>(step) };
+
+            Ort::Value decoder_inputs[3] = {
+                Ort::Value::CreateTensor<int64_t>(memory, attention_mask.data(), attention_mask.size(), src_shape.data(), 2),
+                Ort::Value::CreateTensor<int64_t>(memory, decoder_ids.data(), decoder_ids.size(), tgt_shape.data(), 2),
+                Ort::Value::CreateTensor<float>(memory, hidden, hidden_count, hidden_shape.data(), hidden_shape.size()),
+            };
+            auto decoder_out = decoder_->Run(Ort::RunOptions{ nullptr },
+                decoder_in_names, decoder_inputs, 3, decoder_out_names, 1);
+
+            auto shape = decoder_out[0].GetTensorTypeAndShapeInfo().GetShape();
+            const int64_t vocab_size = shape[2];
+            const float* logits = decoder_out[0].GetTensorData<float>();
+
+            for (size_t b = 0; b < targets.size(); ++b) {
+                if (finished[b]) {
+                    targets[b].push_back(pad_id_);
+                    continue;
+                }
+                const float* row = logits + (b * step + (step - 1)) * vocab_size;
+                int64_t best = eos_id_;
+                float best_score = -1e30f;
+                for (int64_t v = 0; v < vocab_size; ++v) {
+                    // Marian 不会生成 pad
+                    if (v == pad_id_) continue;
+                    if (row[v] > best_score) {
+                        best_score = row[v];
+                        best = v;
+                    }
+                }
+                targets[b].push_back(best);
+                if (best == eos_id_) {
+                    finished[b] = true;
+                    --remaining;
+                }
+            }
+        }
+
+        for (size_t b = 0; b < targets.size(); ++b) {
+            targets[b].erase(targets[b].begin());   // 去掉 decoder_start
+            outputs[b] = Decode(targets[b]);
+        }
+    }
+    catch (const Ort::Exception& e) {
+        LOG_ERROR("LocalMT", "inference failed: %s", e.what());
+    }
+    return outputs;
+}
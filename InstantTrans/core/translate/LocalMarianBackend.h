@@ -0,0 +1,86 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "TranslationBackend.h"
+#include "DispatchQueue.h"
+
+namespace Ort {
+struct Env;
+struct Session;
+}
+
+struct LocalMarianOptions {
+    // 目录下需有 optimum 导出的 encoder_model.onnx / decoder_model.onnx，以及 vocab.json、config.json；
+    // 建议同时放入 source.spm，否则分词退回最长前缀匹配
+    std::wstring model_dir;
+    std::string lang_to = "zh";      // 模型的目标语言，请求里的其它语言返回空译文
+    int32_t workers = 1;             // 推理线程数，每个线程一次处理一批
+    int32_t intra_threads = 2;       // 每次 Run 的 ONNX intra-op 线程数
+    int32_t max_batch = 8;           // 一批最多句数
+    int32_t batch_wait_ms = 15;      // 首条请求到达后等待凑批的时间
+    int32_t max_source_tokens = 256; // 超长输入截断
+};
+
+// 本地 Marian（opus-mt）机器翻译：批量编码，整批逐步贪心解码
+// 解码器为无 KV cache 的导出，每步重算整个前缀；对字幕这类短句代价可接受
+// 凑批时按优先级取句，已过显示截止时间的不再进入推理
+class LocalMarianBackend : public TranslationBackend {
+public:
+    explicit LocalMarianBackend(const LocalMarianOptions& options);
+    ~LocalMarianBackend() override;
+
+    bool Start() override;
+    void Stop() override;
+    void Submit(TranslationRequest request) override;
+    const char* Name() const override { return "local"; }
+
+    // 同步翻译一批（工作线程调用，也可用于离线评测）
+    std::vector<std::string> TranslateBatch(const std::vector<std::string>& texts);
+
+private:
+    struct Pending {
+        TranslationRequest request;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    bool LoadModel();
+    void WorkerLoop();
+
+    std::vector<int64_t> Encode(const std::string& text) const;
+    // 一个带 ▁ 的词按 unigram 分数做 Viterbi 切分，追加到 ids
+    void EncodeWord(const std::string& word, std::vector<int64_t>* ids) const;
+    std::string Decode(const std::vector<int64_t>& ids) const;
+
+    LocalMarianOptions options_;
+
+    std::unique_ptr<Ort::Env> env_;
+    std::unique_ptr<Ort::Session> encoder_;
+    std::unique_ptr<Ort::Session> decoder_;
+
+    // 词表来自 vocab.json；source.spm 存在时读出各词片的 unigram 分数，按 SentencePiece 的 Viterbi 切分，
+    // 缺失时退回最长前缀贪心切分，切分与训练时不同，译文质量会下降。两种方式都不做 NFKC 规范化，
+    // 全角字符与兼容字符按原样切分
+    std::unordered_map<std::string, int64_t> vocab_;
+    std::unordered_map<std::string, float> scores_;
+    float min_score_ = 0;
+    std::vector<std::string> pieces_;
+    size_t max_piece_bytes_ = 0;
+    int64_t unk_id_ = 1;
+    int64_t eos_id_ = 0;
+    int64_t pad_id_ = 0;
+    int64_t decoder_start_id_ = 0;
+    int32_t max_length_ = 256;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    DispatchQueue<Pending> queue_;
+    bool stop_ = true;
+    std::vector<std::thread> workers_;
+};
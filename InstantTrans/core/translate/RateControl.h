@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// 客户端发送节奏控制，与网关的限流对齐：
+// TokenBucket 控制长期速率不超过服务端预算，AimdController 控制并发窗口和速率折扣
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket(double rate_per_sec, double burst)
+        : rate_(rate_per_sec), burst_(burst), tokens_(burst), last_(Clock::now()) {}
+
+    bool TryTake(Clock::time_point now) {
+        Refill(now);
+        if (tokens_ < 1.0) return false;
+        tokens_ -= 1.0;
+        return true;
+    }
+
+    void SetRate(double rate_per_sec) { rate_ = rate_per_sec; }
+    double Rate() const { return rate_; }
+
+private:
+    void Refill(Clock::time_point now) {
+        if (now <= last_) return;
+        tokens_ = std::min(burst_, tokens_ + std::chrono::duration<double>(now - last_).count() * rate_);
+        last_ = now;
+    }
+
+    double rate_;
+    double burst_;
+    double tokens_;
+    Clock::time_point last_;
+};
+
+// 加性增、乘性减：成功且 RTT 未明显膨胀时窗口每轮 +1，被拒绝/超时/RTT 膨胀时窗口与速率减半
+// 一个 RTT 内多次拥塞信号只减一次，避免同一批在途请求把窗口压到底
+class AimdController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        double initial_window = 2;
+        double min_window = 1;
+        double max_window = 8;
+        double decrease = 0.5;          // 乘性减因子
+        double rate_increase = 0.02;    // 每次成功速率折扣恢复的量
+        double min_rate_scale = 0.1;
+        double rtt_inflation = 2.0;     // RTT 超过基线的倍数视为排队
+        int32_t rtt_samples = 32;       // 基线取最近这么多次的最小 RTT
+    };
+
+    AimdController() : AimdController(Options()) {}
+    explicit AimdController(const Options& opt)
+        : opt_(opt), window_(opt.initial_window), rtt_window_(std::max(1, std::min(opt.rtt_samples, kMaxSamples))) {}
+
+    void OnSuccess(int64_t rtt_us, Clock::time_point now) {
+        // 环形缓冲只用前 rtt_window_ 格，写入与求最小值的范围一致
+        rtt_[rtt_next_++ % rtt_window_] = rtt_us;
+        rtt_count_ = std::min(rtt_count_ + 1, rtt_window_);
+        srtt_us_ = srtt_us_ == 0 ? rtt_us : (srtt_us_ * 7 + rtt_us) / 8;
+
+        int64_t base = BaseRtt();
+        if (rtt_count_ >= 4 && rtt_us > base * opt_.rtt_inflation) {
+            Decrease(now);
+            return;
+        }
+        window_ = std::min(opt_.max_window, window_ + 1.0 / window_);
+        rate_scale_ = std::min(1.0, rate_scale_ + opt_.rate_increase);
+    }
+
+    // 服务端拒绝或超时
+    void OnCongestion(Clock::time_point now) { Decrease(now); }
+
+    int32_t Window() const { return static_cast<int32_t>(window_); }
+    double RateScale() const { return rate_scale_; }
+    int64_t BaseRtt() const {
+        if (rtt_count_ == 0) return 0;
+        return *std::min_element(rtt_, rtt_ + rtt_count_);
+    }
+
+private:
+    static constexpr int32_t kMaxSamples = 64;
+
+    void Decrease(Clock::time_point now) {
+        auto rtt = std::chrono::microseconds(std::max<int64_t>(srtt_us_, 100000));
+        if (now - last_decrease_ < rtt) return;
+        last_decrease_ = now;
+        window_ = std::max(opt_.min_window, window_ * opt_.decrease);
+        rate_scale_ = std::max(opt_.min_rate_scale, rate_scale_ * opt_.decrease);
+    }
+
+    Options opt_;
+    double window_;
+    double rate_scale_ = 1.0;
+    int32_t rtt_window_;
+    int64_t rtt_[kMaxSamples] = {};
+    uint32_t rtt_next_ = 0;
+    int32_t rtt_count_ = 0;
+    int64_t srtt_us_ = 0;
+    Clock::time_point last_decrease_{};
+};
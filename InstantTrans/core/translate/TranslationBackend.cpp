@@ -0,0 +1,144 @@
+#include "TranslationBackend.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "LocalMarianBackend.h"
+#include "WebSocketBackend.h"
+#include "core/metrics/Log.h"
+#include "core/metrics/Metrics.h"
+#include "core/recoginize/ModelFiles.h"
+
+static const char* kGatewayUrl = "ws://127.0.0.1:8080/ws";
+static const wchar_t* kLocalModelDir = L"\\opus-mt-en-zh";
+
+static metrics::Counter* ShedCounter(const char* reason)
+{
+    return metrics::Registry::Instance().GetCounter("instanttrans_translate_shed_total",
+        "Translation requests dropped before sending",
+        std::string("reason=\"") + reason + "\"");
+}
+
+static metrics::Counter* LateCounter(const char* reason)
+{
+    return metrics::Registry::Instance().GetCounter("instanttrans_translate_late_total",
+        "Translations that missed the display deadline and were written to disk only",
+        std::string("reason=\"") + reason + "\"");
+}
+
+void TranslationBackend::Deliver(TranslationResult& result, const TranslationRequest& request)
+{
+    // 降级时已按 demoted 计过数
+    result.late = request.late || IsExpired(request, clock_->Now());
+    if (result.late && !request.late) {
+        static metrics::Counter* late = LateCounter("late");
+        late->Add();
+        late_.fetch_add(1, std::memory_order_relaxed);
+    }
+    Deliver(result);
+}
+
+void TranslationBackend::CountDemoted(const TranslationRequest& request)
+{
+    static metrics::Counter* demoted = LateCounter("demoted");
+    demoted->Add();
+    demoted_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranslationBackend::Drop(TranslationRequest& request, std::vector<uint64_t> merged_ids, const char* reason)
+{
+    ShedCounter(reason)->Add(1 + merged_ids.size());
+    dropped_.fetch_add(1 + merged_ids.size(), std::memory_order_relaxed);
+
+    TranslationResult result;
+    result.id = request.id;
+    result.source_text = std::move(request.text);
+    result.ok = false;
+    for (const std::string& lang : request.langs_to) result.translations.push_back({ lang, std::string() });
+    result.merged_ids = std::move(merged_ids);
+    result.late = true;
+    Deliver(result);
+}
+
+TranslationBackend::ShedStats TranslationBackend::GetShedStats() const
+{
+    ShedStats st;
+    st.submitted = submitted_.load(std::memory_order_relaxed);
+    st.dropped = dropped_.load(std::memory_order_relaxed);
+    st.demoted = demoted_.load(std::memory_order_relaxed);
+    st.late = late_.load(std::memory_order_relaxed);
+    return st;
+}
+
+void TranslationBackend::LogShedStats() const
+{
+    ShedStats st = GetShedStats();
+    if (st.submitted == 0) return;
+    LOG_INFO("Translate", "[%s] submitted=%llu dropped=%llu missed deadline: demoted=%llu late=%llu (%.1f%%)", Name(),
+        static_cast<unsigned long long>(st.submitted), static_cast<unsigned long long>(st.dropped),
+        static_cast<unsigned long long>(st.demoted), static_cast<unsigned long long>(st.late),
+        100.0 * (st.dropped + st.demoted + st.late) / st.submitted);
+}
+
+TranslationBackendType TranslationBackendFromEnvironment()
+{
+    char value[16] = { 0 };
+    size_t len = 0;
+    if (getenv_s(&len, value, sizeof(value), "INSTANTTRANS_TRANSLATOR") == 0 && len > 0
+        && _stricmp(value, "local") == 0) {
+        return TranslationBackendType::kLocal;
+    }
+    return TranslationBackendType::kWebSocket;
+}
+
+// 逗号分隔的环境变量，去掉各项两端空格和空项
+static std::vector<std::string> ListFromEnvironment(const char* name)
+{
+    std::vector<std::string> items;
+    char value[1024] = { 0 };
+    size_t len = 0;
+    if (getenv_s(&len, value, sizeof(value), name) == 0 && len > 0) {
+        std::string list = value;
+        size_t begin = 0;
+        while (begin <= list.size()) {
+            size_t end = list.find(',', begin);
+            if (end == std::string::npos) end = list.size();
+            std::string item = list.substr(begin, end - begin);
+            item.erase(0, item.find_first_not_of(' '));
+            item.erase(item.find_last_not_of(' ') + 1);
+            if (!item.empty()) items.push_back(item);
+            begin = end + 1;
+        }
+    }
+    return items;
+}
+
+std::vector<std::string> GatewayUrlsFromEnvironment()
+{
+    std::vector<std::string> urls = ListFromEnvironment("INSTANTTRANS_GATEWAYS");
+    if (urls.empty()) urls.push_back(kGatewayUrl);
+    return urls;
+}
+
+std::vector<std::string> TargetLanguagesFromEnvironment()
+{
+    std::vector<std::string> langs;
+    for (std::string& lang : ListFromEnvironment("INSTANTTRANS_TARGET_LANGS")) {
+        if (std::find(langs.begin(), langs.end(), lang) == langs.end()) langs.push_back(std::move(lang));
+    }
+    if (langs.empty()) langs.push_back("zh");
+    return langs;
+}
+
+std::unique_ptr<TranslationBackend> CreateTranslationBackend(TranslationBackendType type)
+{
+    if (type == TranslationBackendType::kLocal) {
+        LocalMarianOptions options;
+        options.model_dir = GetExeDirectory() + kLocalModelDir;
+        return std::make_unique<LocalMarianBackend>(options);
+    }
+    WebSocketOptions options;
+    options.urls = GatewayUrlsFromEnvironment();
+    return std::make_unique<WebSocketBackend>(options);
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/sim/Clock.h"
+
+// 数值越小越先派发
+enum class TranslationPriority {
+    kActiveFinal = 0,       // 当前显示音源的最终结果
+    kBackgroundFinal,       // 其它音源（只落盘、不上屏）的最终结果，以及错过显示截止时间、还要落盘的句子
+    kCount,
+};
+
+struct TranslationRequest {
+    uint64_t id = 0;
+    std::string text;
+    std::string lang_from = "en";
+    // 同一句一次请求翻译成多个目标语言，后端不必为每种语言各发一次
+    std::vector<std::string> langs_to = { "zh" };
+    TranslationPriority priority = TranslationPriority::kActiveFinal;
+    // 显示截止时间：之后句子已滚出显示区，只约束上屏；仍在排队的降到后台道照常翻译，
+    // 迟到的结果标记 late 回调，只落盘。默认不设
+    std::chrono::steady_clock::time_point deadline{};
+    // 结果只上屏、不落盘：过了截止时间还在排队就直接丢弃，不再发送
+    bool display_only = false;
+    bool late = false;   // 排队期间已过截止时间，被降到后台道
+};
+
+inline bool IsExpired(const TranslationRequest& request, std::chrono::steady_clock::time_point now) {
+    return request.deadline != std::chrono::steady_clock::time_point{} && now > request.deadline;
+}
+
+struct TranslatedText {
+    std::string lang;
+    std::string text;   // 失败或后端不支持该语言时为空
+};
+
+struct TranslationResult {
+    uint64_t id = 0;
+    std::string source_text;
+    // 与请求的 langs_to 一一对应、顺序相同
+    std::vector<TranslatedText> translations;
+    bool ok = false;
+    int64_t latency_us = 0;   // 从 Submit 到结果产生
+    // 限流时排队的相邻请求会合并成一次翻译：结果记在最后一个请求的 id 上，
+    // 被合并的较早请求列在这里，不再单独回调
+    std::vector<uint64_t> merged_ids;
+    bool late = false;   // 晚于显示截止时间：订阅者只落盘，不上屏
+};
+
+// 翻译后端：Submit 立即返回，结果在后端自己的线程上通过回调交回
+// 调用方（UI）不再等待网络或推理
+class TranslationBackend {
+public:
+    using ResultCallback = std::function<void(const TranslationResult&)>;
+
+    // 过载时丢弃的工作量，以及错过显示截止时间、只落盘的句子
+    struct ShedStats {
+        uint64_t submitted = 0;
+        uint64_t dropped = 0;   // 发送前丢弃：只上屏的请求已过截止时间，或后台道已满
+        uint64_t demoted = 0;   // 排队期间过了截止时间，降到后台道照常翻译
+        uint64_t late = 0;      // 发送时未过期，但结果晚于截止时间
+    };
+
+    virtual ~TranslationBackend() = default;
+
+    // 须在 Start 前设置
+    void SetResultCallback(ResultCallback cb) { callback_ = std::move(cb); }
+    // 截止时间按此时钟判断，须在 Start 前设置
+    void SetClock(Clock* clock) { clock_ = clock; }
+
+    virtual bool Start() = 0;
+    // 丢弃尚未开始的请求并等待工作线程退出
+    virtual void Stop() = 0;
+    virtual void Submit(TranslationRequest request) = 0;
+    // 用作指标标签
+    virtual const char* Name() const = 0;
+
+    ShedStats GetShedStats() const;
+
+protected:
+    void Deliver(const TranslationResult& result) {
+        if (callback_) callback_(result);
+    }
+
+    // 按 request 的截止时间标记 result.late 后回调：过期译文只落盘，不挤掉屏幕上更新的内容
+    void Deliver(TranslationResult& result, const TranslationRequest& request);
+
+    void CountSubmitted() { submitted_.fetch_add(1, std::memory_order_relaxed); }
+    void CountDemoted(const TranslationRequest& request);
+    // 发送前丢弃的请求按 reason 计数，以 ok = false、late 的结果回调，订阅者据此收尾但不上屏
+    void Drop(TranslationRequest& request, std::vector<uint64_t> merged_ids, const char* reason);
+    // Stop 时输出本次运行丢弃和错过截止时间的工作量
+    void LogShedStats() const;
+
+    Clock* clock_ = &Clock::System();
+
+private:
+    ResultCallback callback_;
+    std::atomic<uint64_t> submitted_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+    std::atomic<uint64_t> demoted_{ 0 };
+    std::atomic<uint64_t> late_{ 0 };
+};
+
+enum class TranslationBackendType {
+    kWebSocket,   // 经网关转发到远端
+    kLocal,       // 本地 ONNX Runtime 推理，完全离线
+};
+
+// 环境变量 INSTANTTRANS_TRANSLATOR=local 时使用本地后端，默认 WebSocket
+TranslationBackendType TranslationBackendFromEnvironment();
+
+// 环境变量 INSTANTTRANS_GATEWAYS 为逗号分隔的网关地址列表，未设置时使用本机网关
+std::vector<std::string> GatewayUrlsFromEnvironment();
+
+// 环境变量 INSTANTTRANS_TARGET_LANGS 为逗号分隔的目标语言列表，第一个用于上屏，默认 zh
+std::vector<std::string> TargetLanguagesFromEnvironment();
+
+std::unique_ptr<TranslationBackend> CreateTranslationBackend(TranslationBackendType type);
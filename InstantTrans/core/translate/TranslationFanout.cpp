@@ -0,0 +1,131 @@
+#include "TranslationFanout.h"
+
+bool TranslationCache::Get(const std::string& key, std::string* text)
+{
+    auto it = index_.find(key);
+    if (it == index_.end()) return false;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    *text = it->second->second;
+    return true;
+}
+
+void TranslationCache::Put(const std::string& key, const std::string& text)
+{
+    if (capacity_ == 0) return;
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        it->second->second = text;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    lru_.emplace_front(key, text);
+    index_[key] = lru_.begin();
+    if (lru_.size() > capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+TranslationFanout::TranslationFanout(TranslationBackend* backend, const Options& options)
+    : backend_(backend), options_(options)
+{
+    auto& registry = metrics::Registry::Instance();
+    for (const std::string& lang : options_.langs) {
+        std::string labels = "lang=\"" + lang + "\"";
+        languages_.push_back(Language{ lang, TranslationCache(options_.cache_entries), {},
+            registry.GetCounter("instanttrans_translate_cache_hits_total",
+                "Fan-out lookups served from the per-language translation cache", labels),
+            registry.GetCounter("instanttrans_translate_cache_misses_total",
+                "Fan-out lookups that needed a backend translation", labels),
+            registry.GetGauge("instanttrans_translate_cache_hit_ratio_permille",
+                "Per-language translation cache hit ratio since start", labels) });
+    }
+    skipped_ = registry.GetCounter("instanttrans_translate_fanout_skipped_total",
+        "Finals whose every target language was cached, so no backend request was sent");
+
+    backend_->SetResultCallback([this](const TranslationResult& result) { OnResult(result); });
+}
+
+void TranslationFanout::Subscribe(const std::string& lang, Subscriber subscriber)
+{
+    Language* language = Find(lang);
+    if (language) language->subscribers.push_back(std::move(subscriber));
+}
+
+TranslationFanout::Language* TranslationFanout::Find(const std::string& lang)
+{
+    for (Language& language : languages_) {
+        if (language.lang == lang) return &language;
+    }
+    return nullptr;
+}
+
+void TranslationFanout::Publish(Language& language, const LanguageResult& result)
+{
+    for (const Subscriber& subscriber : language.subscribers) subscriber(result);
+}
+
+void TranslationFanout::Submit(TranslationRequest request)
+{
+    request.lang_from = options_.lang_from;
+    request.langs_to.clear();
+
+    // 命中的语言直接回调，未命中的语言合成一个请求
+    std::vector<LanguageResult> hits;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        for (Language& language : languages_) {
+            LanguageResult hit;
+            ++language.lookups;
+            if (language.cache.Get(request.text, &hit.text)) {
+                ++language.hit_count;
+                language.hits->Add();
+                hit.id = request.id;
+                hit.lang = language.lang;
+                hit.source_text = request.text;
+                hit.ok = true;
+                hit.cached = true;
+                hits.push_back(std::move(hit));
+            }
+            else {
+                language.misses->Add();
+                request.langs_to.push_back(language.lang);
+            }
+            language.hit_ratio->Set(static_cast<int64_t>(language.hit_count * 1000 / language.lookups));
+        }
+    }
+
+    for (const LanguageResult& hit : hits) Publish(*Find(hit.lang), hit);
+
+    if (request.langs_to.empty()) {
+        skipped_->Add();
+        return;
+    }
+    backend_->Submit(std::move(request));
+}
+
+void TranslationFanout::OnResult(const TranslationResult& result)
+{
+    std::vector<std::pair<Language*, LanguageResult>> outputs;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        for (const TranslatedText& t : result.translations) {
+            Language* language = Find(t.lang);
+            if (!language) continue;
+
+            LanguageResult out;
+            out.id = result.id;
+            out.merged_ids = result.merged_ids;
+            out.lang = t.lang;
+            out.source_text = result.source_text;
+            out.text = t.text;
+            out.ok = result.ok && !t.text.empty();
+            out.late = result.late;
+            // 合并请求的源文本是几句拼接，缓存后只有完全相同的拼接才会命中，无害
+            if (out.ok) language->cache.Put(result.source_text, t.text);
+            outputs.emplace_back(language, std::move(out));
+        }
+    }
+
+    for (auto& output : outputs) Publish(*output.first, output.second);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TranslationBackend.h"
+#include "core/metrics/Metrics.h"
+
+// 单一语言的译文缓存：按源文本 LRU 淘汰
+class TranslationCache {
+public:
+    explicit TranslationCache(size_t capacity) : capacity_(capacity) {}
+
+    bool Get(const std::string& key, std::string* text);
+    void Put(const std::string& key, const std::string& text);
+
+private:
+    using Entry = std::pair<std::string, std::string>;
+    size_t capacity_;
+    std::list<Entry> lru_;   // 表头为最近使用
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+// 某个目标语言的一条译文，交给该语言的订阅者
+struct LanguageResult {
+    uint64_t id = 0;
+    std::vector<uint64_t> merged_ids;
+    std::string lang;
+    std::string source_text;
+    std::string text;
+    bool ok = false;
+    bool cached = false;
+    bool late = false;   // 晚于显示截止时间，只落盘不上屏
+};
+
+// 一次识别结果扇出到多个目标语言：识别只跑一遍，
+// 各语言先查自己的缓存，未命中的语言合成一个多目标请求交给后端，结果按语言分发给订阅者
+class TranslationFanout {
+public:
+    using Subscriber = std::function<void(const LanguageResult&)>;
+
+    struct Options {
+        std::string lang_from = "en";   // 识别模型的语言，缓存按源文本索引
+        std::vector<std::string> langs = { "zh" };
+        size_t cache_entries = 512;   // 每种语言的缓存条数
+    };
+
+    // 接管 backend 的结果回调，须在 backend->Start() 前构造
+    TranslationFanout(TranslationBackend* backend, const Options& options);
+
+    // 须在提交前订阅；回调在提交线程（缓存命中）或后端线程上调用
+    void Subscribe(const std::string& lang, Subscriber subscriber);
+
+    // request.lang_from / langs_to 由配置决定，调用方只需填 id、text、优先级与截止时间
+    void Submit(TranslationRequest request);
+
+    const std::vector<std::string>& Languages() const { return options_.langs; }
+
+private:
+    struct Language {
+        std::string lang;
+        TranslationCache cache;
+        std::vector<Subscriber> subscribers;
+        metrics::Counter* hits;
+        metrics::Counter* misses;
+        metrics::Gauge* hit_ratio;
+        uint64_t lookups = 0;
+        uint64_t hit_count = 0;
+    };
+
+    void OnResult(const TranslationResult& result);
+    Language* Find(const std::string& lang);
+    void Publish(Language& language, const LanguageResult& result);
+
+    TranslationBackend* backend_;
+    Options options_;
+    std::vector<Language> languages_;   // 构造后不再增删，可无锁查找
+    std::mutex cache_mutex_;            // 保护各语言的缓存与命中统计
+    metrics::Counter* skipped_;
+};
@@ -1,53 +1,96 @@
 #include "WSHelper.h"
 
+#include <mutex>
+
 #include <nlohmann/json.hpp>
+
+#include "core/metrics/Log.h"
+#include "core/metrics/Metrics.h"
+
+namespace {
+
+// 按 JSON 规则转义并加引号；UTF-8 原样输出，控制字符写成 \u00XX
+void AppendJsonString(std::string* out, const std::string& s)
+{
+    static const char kHex[] = "0123456789abcdef";
+    out->push_back('"');
+    for (unsigned char c : s) {
+        switch (c) {
+        case '"': *out += "\\\""; break;
+        case '\\': *out += "\\\\"; break;
+        case '\b': *out += "\\b"; break;
+        case '\f': *out += "\\f"; break;
+        case '\n': *out += "\\n"; break;
+        case '\r': *out += "\\r"; break;
+        case '\t': *out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                *out += "\\u00";
+                out->push_back(kHex[c >> 4]);
+                out->push_back(kHex[c & 0xf]);
+            }
+            else {
+                out->push_back(static_cast<char>(c));
+            }
+        }
+    }
+    out->push_back('"');
+}
+
+} // namespace
+
 namespace WebSocketClient {
 
-    //  WebSocket 
-    CURL* WS_Connect(const std::string& url) {
+    // 建立 WebSocket 连接
+    CURL* WS_Connect(const std::string& url, int32_t connect_timeout_ms) {
         CURLcode res;
         CURL* curl = nullptr;
 
-        curl_global_init(CURL_GLOBAL_DEFAULT);
+        // curl_global_init 不是线程安全的，每次连接都初始化/清理还会反复装卸 TLS 后端；
+        // 进程内只初始化一次，不做清理，由进程退出回收
+        static std::once_flag global_init;
+        std::call_once(global_init, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
         curl = curl_easy_init();
         if (!curl) {
-            std::cerr << "[WS] curl_easy_init() failed\n";
+            LOG_ERROR("WS", "curl_easy_init() failed");
             return nullptr;
         }
 
-        // WebSocket ģʽ
+        // WebSocket 模式
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 2L); // WebSocket ģʽ
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, nullptr); // ʹͨ HTTP дص
+        curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 2L); // WebSocket 模式
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, nullptr); // 不使用普通 HTTP 写回调
+        if (connect_timeout_ms > 0)
+            curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(connect_timeout_ms));
 
         res = curl_easy_perform(curl);
         if (res != CURLE_OK) {
-            std::cerr << "[WS] Connection failed: " << curl_easy_strerror(res) << std::endl;
+            LOG_ERROR("WS", "Connection failed: %s", curl_easy_strerror(res));
             curl_easy_cleanup(curl);
-            curl_global_cleanup();
             return nullptr;
         }
 
-        std::cout << "[WS] Connected to " << url << std::endl;
+        LOG_INFO("WS", "Connected to %s", url.c_str());
         return curl;
     }
 
-    //  WebSocket Ϣ
+    // 发送 WebSocket 消息
     bool WS_Send(CURL* curl, const std::string& message, unsigned int flags) {
         if (!curl) return false;
         size_t bytes_sent = 0;
 
         CURLcode res = curl_ws_send(curl, message.c_str(), message.size(), &bytes_sent, 0, flags);
         if (res != CURLE_OK) {
-            std::cerr << "[WS] Send failed: " << curl_easy_strerror(res) << std::endl;
+            LOG_ERROR("WS", "Send failed: %s", curl_easy_strerror(res));
             return false;
         }
 
-        std::cout << "[WS] Sent (" << bytes_sent << " bytes): " << message << std::endl;
+        // 每条消息一行，只在 trace 级别输出，默认不格式化
+        LOG_TRACE("WS", "Sent (%zu bytes): %s", bytes_sent, message.c_str());
         return true;
     }
 
-    //  WebSocket Ϣȴ
+    // 接收 WebSocket 消息（阻塞等待）
     bool WS_Receive(CURL* curl, std::string& out_message) {
         if (!curl) return false;
 
@@ -62,50 +105,93 @@ namespace WebSocketClient {
                 continue;
             }
             else if (res != CURLE_OK) {
-                std::cerr << "[WS] Receive failed: " << curl_easy_strerror(res) << std::endl;
+                LOG_ERROR("WS", "Receive failed: %s", curl_easy_strerror(res));
                 return false;
             }
 
             out_message.assign(buffer, recv_len);
-            std::cout << "[WS] Received: " << out_message << std::endl;
+            LOG_TRACE("WS", "Received: %s", out_message.c_str());
+            return true;
+        }
+    }
+
+    bool WS_TryReceive(CURL* curl, std::string& out_message, bool& received) {
+        received = false;
+        if (!curl) return false;
+
+        char buffer[4096];
+        size_t recv_len = 0;
+        const struct curl_ws_frame* frame = nullptr;
+
+        out_message.clear();
+        for (;;) {
+            CURLcode res = curl_ws_recv(curl, buffer, sizeof(buffer), &recv_len, &frame);
+            if (res == CURLE_AGAIN) {
+                // 帧的后续分片尚未到达时继续等，否则表示当前没有消息
+                if (out_message.empty()) return true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            if (res != CURLE_OK) {
+                LOG_ERROR("WS", "Receive failed: %s", curl_easy_strerror(res));
+                return false;
+            }
+
+            out_message.append(buffer, recv_len);
+            if (frame && frame->bytesleft > 0) continue;
+
+            received = true;
+            LOG_TRACE("WS", "Received: %s", out_message.c_str());
             return true;
         }
     }
 
-    // ر WebSocket 
+    // 关闭 WebSocket 连接
     void WS_Close(CURL* curl) {
         if (!curl) return;
 
-        //  RFC 6455 ͹ر֡
+        // 按 RFC 6455 发送关闭帧
         size_t sent = 0;
         curl_ws_send(curl, "", 0, &sent, 0, CURLWS_CLOSE);
 
         curl_easy_cleanup(curl);
-        curl_global_cleanup();
-        std::cout << "[WS] Connection closed.\n";
+        LOG_INFO("WS", "Connection closed.");
     }
 
     bool SendTranslateOnce(
         CURL* curl,
         const std::string& client_id,
         const std::string& lang_from,
-        const std::string& lang_to,
+        const std::vector<std::string>& langs_to,
         const std::string& source_text,
         std::string& out_request_id
     ) {
-        if (!curl) return false;
+        if (!curl || langs_to.empty()) return false;
 
         out_request_id = GenerateUUID();
 
-        nlohmann::json payload = {
-            {"client_id", client_id},
-            {"request_id", out_request_id},
-            {"lang_from", lang_from},
-            {"lang_to", lang_to},
-            {"source_text", source_text}
-        };
-
-        std::string json_msg = payload.dump();
+        // 直接拼到本线程复用的缓冲里，与 nlohmann::json::dump 的输出一致，但不建中间对象
+        thread_local std::string json_msg;
+        json_msg.clear();
+        json_msg += "{\"client_id\":";
+        AppendJsonString(&json_msg, client_id);
+        json_msg += ",\"lang_from\":";
+        AppendJsonString(&json_msg, lang_from);
+        json_msg += ",\"lang_to\":";
+        AppendJsonString(&json_msg, langs_to.front());
+        if (langs_to.size() > 1) {
+            json_msg += ",\"langs_to\":[";
+            for (size_t i = 0; i < langs_to.size(); ++i) {
+                if (i > 0) json_msg += ',';
+                AppendJsonString(&json_msg, langs_to[i]);
+            }
+            json_msg += ']';
+        }
+        json_msg += ",\"request_id\":";
+        AppendJsonString(&json_msg, out_request_id);
+        json_msg += ",\"source_text\":";
+        AppendJsonString(&json_msg, source_text);
+        json_msg += '}';
 
         size_t bytes_sent = 0;
         CURLcode rc = curl_ws_send(
@@ -118,8 +204,7 @@ namespace WebSocketClient {
         );
 
         if (rc != CURLE_OK) {
-            std::cerr << "[WS] Send failed: "
-                << curl_easy_strerror(rc) << std::endl;
+            LOG_ERROR("WS", "Send failed: %s", curl_easy_strerror(rc));
             return false;
         }
 
@@ -136,8 +221,15 @@ namespace WebSocketClient {
     ) {
         if (!curl) return false;
 
+        static metrics::Histogram* rtt = metrics::Registry::Instance().GetHistogram(
+            "instanttrans_translate_rtt_seconds", "Translation request round trip through the gateway");
+        static metrics::Counter* failures = metrics::Registry::Instance().GetCounter(
+            "instanttrans_translate_failures_total", "Translation requests that failed to send or receive");
+
+        metrics::ScopedTimer timer(rtt);
         std::string request_id;
-        if (!SendTranslateOnce(curl, client_id, lang_from, lang_to, source_text, request_id)) {
+        if (!SendTranslateOnce(curl, client_id, lang_from, { lang_to }, source_text, request_id)) {
+            failures->Add();
             return false;
         }
 
@@ -154,8 +246,8 @@ namespace WebSocketClient {
             }
 
             if (rc != CURLE_OK) {
-                std::cerr << "[WS] Receive failed: "
-                    << curl_easy_strerror(rc) << std::endl;
+                LOG_ERROR("WS", "Receive failed: %s", curl_easy_strerror(rc));
+                failures->Add();
                 return false;
             }
 
@@ -175,7 +267,7 @@ namespace WebSocketClient {
 
             }
             catch (...) {
-                std::cerr << "[WS] JSON parse error: " << json_msg << std::endl;
+                LOG_WARN("WS", "JSON parse error: %s", json_msg.c_str());
             }
         }
     }
@@ -4,6 +4,7 @@
 #include <string>
 #include <thread>
 #include <chrono>
+#include <vector>
 #include <curl/curl.h>
 
 namespace WebSocketClient {
@@ -27,25 +28,31 @@ namespace WebSocketClient {
 
 		return std::string(buffer);
 	}
-	//  WebSocket 
-	CURL* WS_Connect(const std::string& url);
+	// 建立 WebSocket 连接
+	// connect_timeout_ms 为 0 时使用 libcurl 默认值
+	CURL* WS_Connect(const std::string& url, int32_t connect_timeout_ms = 0);
 
-	//  WebSocket Ϣ
+	// 发送 WebSocket 消息
 	bool WS_Send(CURL* curl, const std::string& message, unsigned int flags = CURLWS_TEXT);
 
-	//  WebSocket Ϣȴ
+	// 接收 WebSocket 消息（阻塞等待）
 	bool WS_Receive(CURL* curl, std::string& out_message);
 
-	// ر WebSocket 
+	// 非阻塞接收：没有数据时 received 为 false 并立即返回；连接出错返回 false
+	bool WS_TryReceive(CURL* curl, std::string& out_message, bool& received);
+
+	// 关闭 WebSocket 连接
 	void WS_Close(CURL* curl);
 
+	// 多个目标语言时 lang_to 填第一个并附带 langs_to，网关在 results 中按语言返回；
+	// 只认 lang_to 的旧网关仍能正常返回第一个语言
 	bool SendTranslateOnce(
 		CURL* curl,
 		const std::string& client_id,
 		const std::string& lang_from,
-		const std::string& lang_to,
+		const std::vector<std::string>& langs_to,
 		const std::string& source_text,
-		std::string& out_request_id   // <<<  request_id
+		std::string& out_request_id   // <<< 新增：输出 request_id
 	);
 
 	bool SendTranslateAndReceive(
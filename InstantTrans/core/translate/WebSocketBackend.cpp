@@ -0,0 +1,433 @@
+#define NOMINMAX
+#include "WebSocketBackend.h"
+
+#include <algorithm>
+
+#include <nlohmann/json.hpp>
+
+#include "core/metrics/Log.h"
+
+// 两侧都是 ASCII 字母数字时补一个空格，中日文直接拼接
+static void AppendText(std::string* out, const std::string& next)
+{
+    if (next.empty()) return;
+    if (!out->empty()) {
+        unsigned char a = static_cast<unsigned char>(out->back());
+        unsigned char b = static_cast<unsigned char>(next.front());
+        if (a < 0x80 && b < 0x80 && a != ' ' && b != ' ') out->push_back(' ');
+    }
+    out->append(next);
+}
+
+// 回复字段类型不对时按缺省处理：nlohmann::json 的 get/value 遇到类型不符会抛异常
+static std::string StringField(const nlohmann::json& obj, const std::string& key)
+{
+    auto it = obj.find(key);
+    return it != obj.end() && it->is_string() ? it->get<std::string>() : std::string();
+}
+
+static int64_t IntField(const nlohmann::json& obj, const char* key)
+{
+    auto it = obj.find(key);
+    return it != obj.end() && it->is_number_integer() ? it->get<int64_t>() : 0;
+}
+
+WebSocketBackend::WebSocketBackend(const WebSocketOptions& options)
+    : options_(options), client_id_(WebSocketClient::GenerateUUID()),
+    bucket_(options.rate_per_sec, options.burst), aimd_(options.aimd)
+{
+    auto& registry = metrics::Registry::Instance();
+    latency_ = registry.GetHistogram(
+        "instanttrans_translate_latency_seconds", "Submit-to-result translation latency", "backend=\"ws\"");
+    rejections_ = registry.GetCounter(
+        "instanttrans_translate_rejections_total", "Requests rejected by the gateway rate limiter");
+    merged_ = registry.GetCounter(
+        "instanttrans_translate_merged_total", "Queued finals merged into an earlier request");
+    failures_ = registry.GetCounter(
+        "instanttrans_translate_failures_total", "Translation requests that failed to send or receive");
+    window_gauge_ = registry.GetGauge(
+        "instanttrans_translate_window", "AIMD in-flight request window");
+    rate_gauge_ = registry.GetGauge(
+        "instanttrans_translate_rate_millirps", "Client-side token bucket rate, requests per 1000 s");
+    queued_gauge_ = registry.GetGauge(
+        "instanttrans_translate_queued", "Translation requests waiting for send budget");
+    gateway_cache_hits_ = registry.GetCounter(
+        "instanttrans_gateway_cache_hits_total", "Target languages the gateway served from its translation cache");
+    gateway_cache_misses_ = registry.GetCounter(
+        "instanttrans_gateway_cache_misses_total", "Target languages the gateway had to translate");
+    gateway_cache_ratio_ = registry.GetGauge(
+        "instanttrans_gateway_cache_hit_ratio_permille", "Gateway translation cache hit ratio since start");
+
+    for (const std::string& url : options_.urls) {
+        Endpoint ep;
+        ep.url = url;
+        std::string labels = "endpoint=\"" + url + "\"";
+        ep.up = registry.GetGauge("instanttrans_gateway_up", "Gateway endpoint connected (1) or down (0)", labels);
+        ep.ewma_gauge = registry.GetGauge("instanttrans_gateway_latency_ewma_milliseconds",
+            "Smoothed round trip per gateway endpoint", labels);
+        ep.failovers = registry.GetCounter("instanttrans_gateway_failovers_total",
+            "Requests moved to another endpoint after this one failed", labels);
+        endpoints_.push_back(std::move(ep));
+    }
+}
+
+WebSocketBackend::~WebSocketBackend()
+{
+    Stop();
+}
+
+bool WebSocketBackend::Start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stop_) return true;
+    if (endpoints_.empty()) return false;
+    stop_ = false;
+    worker_ = std::thread(&WebSocketBackend::WorkerLoop, this);
+    return true;
+}
+
+void WebSocketBackend::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) return;
+        stop_ = true;
+        queue_.Clear();
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+    LogShedStats();
+}
+
+void WebSocketBackend::Submit(TranslationRequest request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) return;
+        Pending p;
+        p.request = std::move(request);
+        p.submitted = p.queued = Clock::now();
+        queue_.Push(std::move(p));
+        CountSubmitted();
+    }
+    cv_.notify_one();
+}
+
+WebSocketBackend::Pending WebSocketBackend::TakeMergedLocked()
+{
+    std::deque<Pending>& lane = queue_.FrontLane();
+    Pending head = std::move(lane.front());
+    lane.pop_front();
+
+    // 还在排队的都是因为预算不足没能发出的，合并后只消耗一个令牌；只在同一优先级道内合并
+    while (!lane.empty()) {
+        Pending& next = lane.front();
+        if (next.request.lang_from != head.request.lang_from || next.request.langs_to != head.request.langs_to
+            || head.request.text.size() + next.request.text.size() + 1 > options_.max_merge_bytes) break;
+
+        head.merged_ids.push_back(head.request.id);
+        head.merged_ids.insert(head.merged_ids.end(), next.merged_ids.begin(), next.merged_ids.end());
+        AppendText(&head.request.text, next.request.text);
+        head.request.id = next.request.id;
+        head.submitted = std::min(head.submitted, next.submitted);
+        head.queued = std::min(head.queued, next.queued);
+        head.attempts = std::max(head.attempts, next.attempts);
+        // 合并后的请求要等最后一句的截止时间；任一句不设截止时间则整体不设
+        if (head.request.deadline != Clock::time_point{} && next.request.deadline != Clock::time_point{})
+            head.request.deadline = std::max(head.request.deadline, next.request.deadline);
+        else
+            head.request.deadline = Clock::time_point{};
+        head.request.display_only = head.request.display_only && next.request.display_only;
+        head.request.late = head.request.late && next.request.late;
+        lane.pop_front();
+    }
+    return head;
+}
+
+void WebSocketBackend::Fail(Pending& pending, const char* reason)
+{
+    LOG_WARN("WS", "translation request %llu failed: %s",
+        static_cast<unsigned long long>(pending.request.id), reason);
+    failures_->Add();
+
+    TranslationResult result;
+    result.id = pending.request.id;
+    result.source_text = std::move(pending.request.text);
+    result.ok = false;
+    for (const std::string& lang : pending.request.langs_to) result.translations.push_back({ lang, std::string() });
+    result.merged_ids = std::move(pending.merged_ids);
+    result.latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - pending.submitted).count();
+    Deliver(result, pending.request);
+}
+
+void WebSocketBackend::Retry(Pending pending, const char* reason)
+{
+    if (pending.attempts >= options_.max_attempts) {
+        Fail(pending, reason);
+        return;
+    }
+    RequeueFront(std::move(pending));
+}
+
+void WebSocketBackend::RequeueFront(Pending pending)
+{
+    pending.queued = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.PushFront(std::move(pending));
+}
+
+void WebSocketBackend::DropEndpoint(Endpoint& ep, const char* reason)
+{
+    LOG_WARN("WS", "endpoint %s down: %s", ep.url.c_str(), reason);
+    WebSocketClient::WS_Close(ep.curl);
+    ep.curl = nullptr;
+    ep.up->Set(0);
+    ep.retry_at = Clock::now() + ep.backoff;
+    ep.backoff = std::min(ep.backoff * 2, std::chrono::milliseconds(options_.max_backoff_ms));
+
+    for (auto& kv : ep.in_flight) {
+        ep.failovers->Add();
+        ++ep.failed_over;
+        Retry(std::move(kv.second.pending), reason);
+    }
+    ep.in_flight.clear();
+}
+
+WebSocketBackend::Endpoint* WebSocketBackend::Route()
+{
+    // 没有样本的实例按已采样实例 EWMA 的中位数估计，都没有样本时只按在途数比较；
+    // 不能记 0 分，否则未采样的实例在拿到第一个回复前会吸走所有请求
+    std::vector<double> sampled;
+    for (const Endpoint& ep : endpoints_) {
+        if (ep.ewma_ms > 0) sampled.push_back(ep.ewma_ms);
+    }
+    double prior = 1;
+    if (!sampled.empty()) {
+        std::nth_element(sampled.begin(), sampled.begin() + sampled.size() / 2, sampled.end());
+        prior = sampled[sampled.size() / 2];
+    }
+
+    Endpoint* best = nullptr;
+    double best_score = 0;
+    for (Endpoint& ep : endpoints_) {
+        if (!ep.curl) continue;
+        double score = (ep.ewma_ms > 0 ? ep.ewma_ms : prior) * (ep.in_flight.size() + 1);
+        if (!best || score < best_score) {
+            best = &ep;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+std::vector<WebSocketBackend::EndpointStats> WebSocketBackend::GetEndpointStats() const
+{
+    std::vector<EndpointStats> stats;
+    for (const Endpoint& ep : endpoints_)
+        stats.push_back({ ep.url, ep.sent, ep.answered, ep.failed_over, ep.ewma_ms });
+    return stats;
+}
+
+size_t WebSocketBackend::InFlightCount() const
+{
+    size_t n = 0;
+    for (const Endpoint& ep : endpoints_) n += ep.in_flight.size();
+    return n;
+}
+
+void WebSocketBackend::Receive(Endpoint& ep)
+{
+    while (ep.curl) {
+        std::string message;
+        bool received = false;
+        if (!WebSocketClient::WS_TryReceive(ep.curl, message, received)) {
+            DropEndpoint(ep, "connection lost");
+            return;
+        }
+        if (!received) return;
+
+        nlohmann::json resp = nlohmann::json::parse(message, nullptr, false);
+        if (resp.is_discarded() || !resp.is_object()) continue;
+        auto it = ep.in_flight.find(StringField(resp, "request_id"));
+        if (it == ep.in_flight.end()) continue;
+
+        Clock::time_point now = Clock::now();
+        InFlight item = std::move(it->second);
+        ep.in_flight.erase(it);
+
+        if (StringField(resp, "error") == "rate_limited") {
+            // 服务端预算已用完：窗口与速率减半，按建议时间暂停，请求放回队首重发，退回这次发送计的尝试次数
+            rejections_->Add();
+            aimd_.OnCongestion(now);
+            paused_until_ = std::max(paused_until_,
+                now + std::chrono::milliseconds(IntField(resp, "retry_after_ms")));
+            --item.pending.attempts;
+            RequeueFront(std::move(item.pending));
+            continue;
+        }
+
+        int64_t rtt_us = std::chrono::duration_cast<std::chrono::microseconds>(now - item.sent).count();
+        aimd_.OnSuccess(rtt_us, now);
+        double rtt_ms = rtt_us / 1000.0;
+        ep.ewma_ms = ep.ewma_ms == 0 ? rtt_ms : ep.ewma_ms + options_.ewma_alpha * (rtt_ms - ep.ewma_ms);
+        ep.ewma_gauge->Set(static_cast<int64_t>(ep.ewma_ms));
+        ep.backoff = std::chrono::milliseconds(250);
+        ++ep.answered;
+
+        TranslationResult result;
+        result.id = item.pending.request.id;
+        result.source_text = std::move(item.pending.request.text);
+        // 多目标请求按语言取 results，只回 result 的旧网关只有第一个语言
+        const nlohmann::json* results = resp.contains("results") && resp["results"].is_object()
+            ? &resp["results"] : nullptr;
+        for (const std::string& lang : item.pending.request.langs_to) {
+            TranslatedText t;
+            t.lang = lang;
+            if (results) t.text = StringField(*results, lang);
+            else if (result.translations.empty()) t.text = StringField(resp, "result");
+            result.translations.push_back(std::move(t));
+        }
+        // 不回 cached_langs 的旧网关按全部未命中计
+        size_t cached = resp.contains("cached_langs") && resp["cached_langs"].is_array() ? resp["cached_langs"].size() : 0;
+        CountGatewayCache(cached, item.pending.request.langs_to.size());
+        result.ok = true;
+        result.merged_ids = std::move(item.pending.merged_ids);
+        result.latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            now - item.pending.submitted).count();
+        latency_->Record(static_cast<uint64_t>(result.latency_us));
+        Deliver(result, item.pending.request);
+    }
+}
+
+void WebSocketBackend::CountGatewayCache(size_t cached, size_t langs)
+{
+    size_t hits = std::min(cached, langs);
+    gateway_cache_hits_->Add(hits);
+    gateway_cache_misses_->Add(langs - hits);
+    gateway_cache_hit_count_ += hits;
+    gateway_cache_lookups_ += langs;
+    if (gateway_cache_lookups_ > 0)
+        gateway_cache_ratio_->Set(static_cast<int64_t>(gateway_cache_hit_count_ * 1000 / gateway_cache_lookups_));
+}
+
+void WebSocketBackend::WorkerLoop()
+{
+    const auto timeout = std::chrono::milliseconds(options_.request_timeout_ms);
+    const auto poll = std::chrono::milliseconds(10);
+
+    for (;;) {
+        std::vector<Pending> timed_out;
+        std::vector<std::pair<Pending, const char*>> dropped;
+        std::vector<Pending> to_send;
+        bool has_work = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (queue_.Empty() && InFlightCount() == 0) cv_.wait(lock, [this] { return stop_ || !queue_.Empty(); });
+            else cv_.wait_for(lock, poll, [this] { return stop_; });
+            if (stop_) break;
+
+            Clock::time_point now = Clock::now();
+            // 过了显示截止时间的句子已不在屏幕上：只上屏的不再发送，要落盘的让给后面的句子，稍后翻译
+            queue_.ShedExpired(now, [&](Pending&& p) { dropped.emplace_back(std::move(p), "expired"); },
+                [this](const Pending& p) { CountDemoted(p.request); });
+            queue_.TrimLane(TranslationPriority::kBackgroundFinal, options_.max_background_queued,
+                [&](Pending&& p) { dropped.emplace_back(std::move(p), "overflow"); });
+            // 后台道的句子不上屏，等多久都要落盘，排队超时只约束上屏道；
+            // 服务端要求的暂停不算排队时间，暂停结束后才开始计时
+            queue_.RemoveIf([&](const Pending& p) {
+                    return p.request.priority == TranslationPriority::kActiveFinal
+                        && now - std::max(p.queued, paused_until_) > timeout;
+                },
+                [&](Pending&& p) { timed_out.push_back(std::move(p)); });
+
+            bool connected = std::any_of(endpoints_.begin(), endpoints_.end(),
+                [](const Endpoint& ep) { return ep.curl != nullptr; });
+            if (connected) {
+                size_t queued_before = queue_.Size();
+                size_t in_flight = InFlightCount();
+                while (!queue_.Empty() && now >= paused_until_
+                    && static_cast<int32_t>(in_flight + to_send.size()) < aimd_.Window()
+                    && bucket_.TryTake(now)) {
+                    to_send.push_back(TakeMergedLocked());
+                }
+                size_t taken = queued_before - queue_.Size();
+                if (taken > to_send.size()) merged_->Add(taken - to_send.size());
+            }
+            has_work = !queue_.Empty() || !to_send.empty();
+            queued_gauge_->Set(static_cast<int64_t>(queue_.Size()));
+        }
+
+        for (Pending& p : timed_out) Fail(p, "timed out waiting for send budget");
+        for (auto& d : dropped) Drop(d.first.request, std::move(d.first.merged_ids), d.second);
+
+        // 有待发请求时把到期的实例连上，池里的每个实例都保持一条连接
+        if (has_work) {
+            for (Endpoint& ep : endpoints_) {
+                if (ep.curl || Clock::now() < ep.retry_at) continue;
+                ep.curl = WebSocketClient::WS_Connect(ep.url, options_.connect_timeout_ms);
+                if (ep.curl) {
+                    ep.up->Set(1);
+                }
+                else {
+                    // 握手被拒绝（429）或实例不可用：指数退避
+                    ep.retry_at = Clock::now() + ep.backoff;
+                    ep.backoff = std::min(ep.backoff * 2, std::chrono::milliseconds(options_.max_backoff_ms));
+                }
+            }
+        }
+
+        for (Pending& p : to_send) {
+            Endpoint* ep = Route();
+            if (!ep) {
+                RequeueFront(std::move(p));
+                continue;
+            }
+            std::string request_id;
+            ++p.attempts;
+            if (!WebSocketClient::SendTranslateOnce(ep->curl, client_id_, p.request.lang_from, p.request.langs_to,
+                p.request.text, request_id)) {
+                --p.attempts;
+                ep->failovers->Add();
+                ++ep->failed_over;
+                DropEndpoint(*ep, "send failed");
+                RequeueFront(std::move(p));
+                continue;
+            }
+            ++ep->sent;
+            ep->in_flight.emplace(std::move(request_id), InFlight{ std::move(p), Clock::now() });
+        }
+
+        for (Endpoint& ep : endpoints_) Receive(ep);
+
+        // 在途超时：视为拥塞，并把该实例的延迟估计拉高，后续请求优先去别的实例
+        Clock::time_point now = Clock::now();
+        for (Endpoint& ep : endpoints_) {
+            for (auto it = ep.in_flight.begin(); it != ep.in_flight.end();) {
+                if (now - it->second.sent > timeout) {
+                    aimd_.OnCongestion(now);
+                    ep.ewma_ms = std::max(ep.ewma_ms, static_cast<double>(options_.request_timeout_ms));
+                    ep.ewma_gauge->Set(static_cast<int64_t>(ep.ewma_ms));
+                    ep.failovers->Add();
+                    ++ep.failed_over;
+                    Retry(std::move(it->second.pending), "no response");
+                    it = ep.in_flight.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        bucket_.SetRate(options_.rate_per_sec * aimd_.RateScale());
+        window_gauge_->Set(aimd_.Window());
+        rate_gauge_->Set(static_cast<int64_t>(bucket_.Rate() * 1000));
+    }
+
+    for (Endpoint& ep : endpoints_) {
+        if (ep.curl) WebSocketClient::WS_Close(ep.curl);
+        ep.curl = nullptr;
+        ep.in_flight.clear();
+        ep.up->Set(0);
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "TranslationBackend.h"
+#include "DispatchQueue.h"
+#include "RateControl.h"
+#include "WSHelper.h"
+#include "core/metrics/Metrics.h"
+
+struct WebSocketOptions {
+    // 网关实例列表，每个实例保持一条连接
+    std::vector<std::string> urls;
+    // 与网关 rate_limit.message_limit 对齐（默认 120 次/分钟）
+    double rate_per_sec = 2.0;
+    double burst = 4;
+    AimdController::Options aimd;
+    size_t max_merge_bytes = 400;       // 排队请求合并后的最大长度
+    int32_t request_timeout_ms = 10000; // 排队（仅上屏道）或在途超过此时长视为失败
+    size_t max_background_queued = 256; // 后台道排队上限，超出时丢弃最早的
+    int32_t max_backoff_ms = 8000;      // 连接失败（含握手被 429 拒绝）后的最长重连间隔
+    int32_t connect_timeout_ms = 3000;
+    int32_t max_attempts = 2;           // 连接断开/超时后换实例重发的总尝试次数
+    double ewma_alpha = 0.2;            // 实例延迟 EWMA 的平滑系数
+};
+
+// 现有网关协议的后端：一个工作线程持有到各网关实例的连接池
+// 每个请求路由到 EWMA 延迟 ×（在途数 + 1）最小的实例，未采样的实例按其它实例的中位数估计；
+// 实例断开时在途请求透明地转到其它实例重发
+// 令牌桶限制长期速率，AIMD 控制总在途请求数；预算不足时排队的 final 合并成一次请求
+// 排队按优先级分道：过了显示截止时间的请求，只上屏的发送前丢弃，要落盘的降到后台道；
+// 后台道不受排队超时约束，但有长度上限
+class WebSocketBackend : public TranslationBackend {
+public:
+    explicit WebSocketBackend(const WebSocketOptions& options);
+    ~WebSocketBackend() override;
+
+    bool Start() override;
+    void Stop() override;
+    void Submit(TranslationRequest request) override;
+    const char* Name() const override { return "ws"; }
+
+    struct EndpointStats {
+        std::string url;
+        uint64_t sent = 0;          // 发往该实例的请求（含重发）
+        uint64_t answered = 0;      // 收到的成功回复
+        uint64_t failed_over = 0;   // 因该实例断开或超时而改发别处的请求
+        double ewma_ms = 0;
+    };
+    // 各实例的路由统计；工作线程独占这些字段，须在 Stop 之后调用
+    std::vector<EndpointStats> GetEndpointStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        TranslationRequest request;
+        Clock::time_point submitted;
+        Clock::time_point queued;       // 最近一次进入队列的时刻，排队超时按它计算
+        std::vector<uint64_t> merged_ids;
+        int32_t attempts = 0;
+    };
+
+    struct InFlight {
+        Pending pending;
+        Clock::time_point sent;
+    };
+
+    struct Endpoint {
+        std::string url;
+        CURL* curl = nullptr;
+        std::unordered_map<std::string, InFlight> in_flight;   // 按网关 request_id 索引
+        double ewma_ms = 0;                                     // 0 表示还没有样本
+        Clock::time_point retry_at{};
+        std::chrono::milliseconds backoff{ 250 };
+        uint64_t sent = 0;
+        uint64_t answered = 0;
+        uint64_t failed_over = 0;
+
+        metrics::Gauge* up = nullptr;
+        metrics::Gauge* ewma_gauge = nullptr;
+        metrics::Counter* failovers = nullptr;
+    };
+
+    void WorkerLoop();
+
+    // 最高优先级道的队首请求与其后同语言对的请求合并，调用方持有 mutex_
+    Pending TakeMergedLocked();
+    void Fail(Pending& pending, const char* reason);
+
+    // 连接断开：标记实例不可用，在途请求换实例重发
+    void DropEndpoint(Endpoint& ep, const char* reason);
+    // 尝试次数未用完的请求放回队首，否则按失败交回
+    void Retry(Pending pending, const char* reason);
+    void RequeueFront(Pending pending);
+    // 选出得分最低的已连接实例，没有时返回 nullptr
+    Endpoint* Route();
+    void Receive(Endpoint& ep);
+    // 按回复里的 cached_langs 统计网关侧译文缓存的命中率
+    void CountGatewayCache(size_t cached, size_t langs);
+    size_t InFlightCount() const;
+
+    WebSocketOptions options_;
+    std::string client_id_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    DispatchQueue<Pending> queue_;
+    bool stop_ = true;
+    std::thread worker_;
+
+    // 以下只在工作线程上访问
+    std::vector<Endpoint> endpoints_;
+    TokenBucket bucket_;
+    AimdController aimd_;
+    Clock::time_point paused_until_{};
+    uint64_t gateway_cache_hit_count_ = 0;
+    uint64_t gateway_cache_lookups_ = 0;
+
+    metrics::Histogram* latency_;
+    metrics::Counter* rejections_;
+    metrics::Counter* merged_;
+    metrics::Counter* failures_;
+    metrics::Gauge* window_gauge_;
+    metrics::Gauge* rate_gauge_;
+    metrics::Gauge* queued_gauge_;
+    metrics::Counter* gateway_cache_hits_;
+    metrics::Counter* gateway_cache_misses_;
+    metrics::Gauge* gateway_cache_ratio_;
+};
@@ -1,14 +1,23 @@
 #pragma once
 #include <string>
 #include <chrono>
+#include <cstdint>
 
 struct RecognitionMessage {
-    std::string recog_text;   // ʶ𵽵ıƬΣ
-    bool is_final = false;    // Ƿʶβ/
+    std::string recog_text;   // 识别到的文本（可能是片段）
+    bool is_final = false;    // 是否识别出“句尾”/完整句子
+    bool continues = false;   // 长语音切分出的块，同一语音段后面还有最终结果（句子可能跨块）
     std::chrono::steady_clock::time_point ts = std::chrono::steady_clock::now();
+    std::string source_id;         // 产生该识别结果的音源
+    int64_t audio_begin_ms = 0;    // 音频时钟：相对本次会话开始的采样时间，不受识别延迟影响
+    int64_t audio_end_ms = 0;
 };
 
 struct TranslationMessage {
-    std::string recog_text;   // Ӧʶı
-    std::string trans_text;   // 
+    std::string recog_text;   // 对应的完整识别文本
+    std::string trans_text;   // 翻译结果
+    std::string lang;         // 目标语言
+    uint64_t id = 0;          // 翻译请求 id
+    uint64_t first_id = 0;    // 限流合并时最早被合并的请求 id，未合并时等于 id
+    bool late = false;        // 晚于显示截止时间，只落盘不上屏
 };
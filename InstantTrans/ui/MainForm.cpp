@@ -1,15 +1,39 @@
 //MainForm.cpp
 #include "MainForm.h"
 
+// 超过此时长未到达的译文对应的句子已滚出两行显示区，与 FlowController 的显示超时一致
+static const std::chrono::seconds kTranslationDeadline = FlowController::kDisplayTimeout;
+// 保留音频时间的句子数，远大于可能同时在途的翻译数
+static const size_t kMaxAudioSpans = 256;
+// 窗口常开但没人说话时，运行中或停止后这么久就卸载识别模型，只保留 VAD
+static const int32_t kModelUnloadMs = 5 * 60 * 1000;
 
 MainForm::MainForm(MessageBus* bus):bus_(bus) {
     flow_.SetUpdateCallback([this](const DisplaySlot& a, const DisplaySlot& b) {
-        // UI ص UI ߳УPostMessage ѱ֤
+        // UI 回调：在 UI 线程中（PostMessage 已保证）
         this->OnFlowUpdate(a, b);
         });
-    recognizer = std::make_shared<SpeechRecognizer>(bus_);
-    
-    clientid = WebSocketClient::GenerateUUID();
+    for (int i = 0; i < 4; ++i) {
+        m_shownText[i].reserve(512);
+        m_shownWide[i].reserve(512);
+    }
+    RecognizerOptions recognizer_options;
+    recognizer_options.idle_unload_ms = kModelUnloadMs;
+    recognizer_options.stopped_unload_ms = kModelUnloadMs;
+    recognizer = std::make_shared<SpeechRecognizer>(bus_, recognizer_options);
+
+    TranscriptStore::Options history_options;
+    history_options.spill_path = GetExeDirectory() + L"\\transcript_history.txt";
+    transcript_ = std::make_unique<TranscriptStore>(history_options);
+    history_provider_ = std::make_unique<TranscriptListProvider>(transcript_.get());
+
+    TranscriptWriterOptions writer_options;
+    writer_options.directory = GetExeDirectory() + L"\\transcripts";
+    writer_ = std::make_unique<TranscriptWriter>(writer_options);
+    bus_->AddRecognitionListener([this](const RecognitionMessage& msg) {
+        // 在识别线程上调用，Submit 只做入队
+        writer_->Submit(msg);
+        });
 }
 
 MainForm::~MainForm()
@@ -33,24 +57,62 @@ void MainForm::OnInitWindow()
 
     bus_->SetUIWindow(static_cast<HWND>(this->GetWindowHandle()));
 
-    //ڳʼɣԽбFormĳʼ
+    //窗口初始化完成，可以进行本Form的初始化
     m_pLabelActiveRecog = dynamic_cast<ui::Label*>(FindControl(L"origin_text1"));
     m_pLabelActiveTrans = dynamic_cast<ui::Label*>(FindControl(L"trans_text1"));
     m_pLabelNextRecog = dynamic_cast<ui::Label*>(FindControl(L"origin_text2"));
     m_pLabelNextTrans = dynamic_cast<ui::Label*>(FindControl(L"trans_text2"));
 
+    m_pHistoryList = dynamic_cast<ui::VirtualListBox*>(FindControl(L"history_list"));
+    if (m_pHistoryList) m_pHistoryList->SetDataProvider(history_provider_.get());
+
     m_pBtnAction = dynamic_cast<ui::Button*>(FindControl(L"actionbtn"));
     m_pBtnAction->AttachClick(std::bind(&MainForm::onSwitchState, this, std::placeholders::_1));
+
+    // 本地模型缺失或加载失败时退回网关
+    TranslationBackendType backend = TranslationBackendFromEnvironment();
+    if (!StartTranslator(backend) && backend != TranslationBackendType::kWebSocket)
+        StartTranslator(TranslationBackendType::kWebSocket);
     
     //SetTimer(static_cast<HWND>(this->GetWindowHandle()), 1, 1000, nullptr);
 }
 
+bool MainForm::StartTranslator(TranslationBackendType type)
+{
+    fanout_.reset();
+    translator_ = CreateTranslationBackend(type);
+
+    TranslationFanout::Options fanout_options;
+    fanout_options.langs = TargetLanguagesFromEnvironment();
+    fanout_ = std::make_unique<TranslationFanout>(translator_.get(), fanout_options);
+    display_lang_ = fanout_->Languages().front();
+
+    // 每种语言一个订阅者，结果经 bus_ 回到 UI 线程后按语言分发
+    for (const std::string& lang : fanout_->Languages()) {
+        fanout_->Subscribe(lang, [this](const LanguageResult& result) {
+            // 在翻译后端线程上调用；缓存命中时在 UI 线程上同步调用
+            TranslationMessage tmsg;
+            tmsg.recog_text = result.source_text;
+            tmsg.trans_text = result.text;
+            tmsg.lang = result.lang;
+            tmsg.id = result.id;
+            tmsg.first_id = result.merged_ids.empty() ? result.id : result.merged_ids.front();
+            tmsg.late = result.late;
+            if (bus_) bus_->PostTranslation(std::move(tmsg));
+            });
+    }
+    return translator_->Start();
+}
+
 void MainForm::OnPreCloseWindow()
 {
     if (m_runningstate)
     {
         recognizer->Stop();
+        writer_->Stop();
     }
+    if (translator_) translator_->Stop();
+    bus_->DetachUIWindow();
 
     __super::OnPreCloseWindow();
 }
@@ -58,15 +120,13 @@ void MainForm::OnPreCloseWindow()
 LRESULT MainForm::OnWindowMessage(UINT uMsg, WPARAM wParam, LPARAM lParam, bool& bHandled)
 {
     if (uMsg == WM_APP_RECOG) {
-        auto p = reinterpret_cast<RecognitionMessage*>(wParam);
+        auto p = MessageBus::TakeRecognition(wParam);
         OnRecognitionMessage(*p);
-        delete p;
         return 0;
     }
     else if (uMsg == WM_APP_TRANS) {
-        auto p = reinterpret_cast<TranslationMessage*>(wParam);
+        auto p = MessageBus::TakeTranslation(wParam);
         OnTranslationMessage(*p);
-        delete p;
         return 0;
     }
     else if (uMsg == WM_TIMER)
@@ -86,48 +146,94 @@ void MainForm::OnTimerImpl(WPARAM wParam, LPARAM lParam)
 }
 
 void MainForm::OnRecognitionMessage(const RecognitionMessage& msg) {
-    //  msg.is_final == true -> ̣߳ʶ̣߳
+    // 如果 msg.is_final == true -> 启动翻译请求线程（避免阻塞识别线程）
     if (!msg.is_final) {
-        // Ƭθ ->  flow  next slotbottom
+        // 片段更新 -> 交给 flow 的 next slot（bottom）
         flow_.OnRecognitionFragment(msg.recog_text);
     }
     else {
-        // final첽
-        std::string recog = msg.recog_text;
-
-        std::string trans;
-        bool ok = WebSocketClient::SendTranslateAndReceive(
-            ws,
-            clientid,
-            "en",
-            "zh",
-            recog,
-            trans
-        );
-        if (trans.empty())
-            trans = "Hello InstantTrans";
-        TranslationMessage tmsg;
-        tmsg.recog_text = recog;
-        tmsg.trans_text = trans;
-        // ѷ UI bus_
-        if (bus_) bus_->PostTranslation(tmsg);
+        // 长语音切出的块先按句子边界拼接，半句不单独送翻译
+        int64_t begin_ms = stitcher_.HasPending() ? held_begin_ms_ : msg.audio_begin_ms;
+        std::string text = stitcher_.Push(msg.recog_text, msg.continues);
+        held_begin_ms_ = stitcher_.HasPending() ? msg.audio_begin_ms : 0;
+        if (text.empty()) {
+            held_begin_ms_ = begin_ms;
+            return;
+        }
+
+        // final：按语言查缓存，未命中的语言合成一个请求交给后端，结果异步回到 OnTranslationMessage
+        TranslationRequest request;
+        request.id = ++next_request_id_;
+        request.text = std::move(text);
+        audio_spans_.push_back({ request.id, begin_ms, msg.audio_end_ms });
+        if (audio_spans_.size() > kMaxAudioSpans) audio_spans_.pop_front();
+        // 上屏的音源优先；其它音源只落盘，排在后面
+        request.priority = msg.source_id == recognizer->SourceId()
+            ? TranslationPriority::kActiveFinal : TranslationPriority::kBackgroundFinal;
+        // 截止时间只约束上屏；后台音源不上屏，多晚都要落盘
+        if (request.priority == TranslationPriority::kActiveFinal)
+            request.deadline = std::chrono::steady_clock::now() + kTranslationDeadline;
+        // 字幕文件没能打开时译文只上屏，过了截止时间就不必再翻
+        request.display_only = !writer_->Running();
+        fanout_->Submit(std::move(request));
     }
 }
 
 void MainForm::OnTranslationMessage(const TranslationMessage& msg) {
-    // 뵽 UIѾ UI ̣߳
-    // ֪ѷŵ next slotֱ flow 
+    // 翻译到达 UI（已经在 UI 线程）
+    WriteTranslation(msg);
+    // 迟到的译文对应的句子已滚出显示区，只落盘
+    if (msg.late || msg.lang != display_lang_) return;
+    // 后端没有给出译文：不上屏也不进历史，next 里的原文片段按显示超时滚走
+    if (msg.trans_text.empty()) return;
+
+    // 告知流控器：把翻译放到 next slot（或直接让 flow 决定）
     flow_.OnTranslationReady(msg.recog_text, msg.trans_text);
+
+    // 追加到历史记录：虚表只重填可见行，UI 开销与会议时长无关
+    uint64_t first_before = transcript_->FirstIndex();
+    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    transcript_->Append(msg.recog_text, msg.trans_text, now_ms);
+    history_provider_->OnAppended(first_before);
+    if (m_pHistoryList) m_pHistoryList->EndDown();
+}
+
+void MainForm::WriteTranslation(const TranslationMessage& msg)
+{
+    if (msg.trans_text.empty() || audio_spans_.empty()) return;
+    // id 连续递增，按与队首的差值直接定位
+    auto find = [this](uint64_t id) -> const AudioSpan* {
+        uint64_t first = audio_spans_.front().id;
+        if (id < first || id - first >= audio_spans_.size()) return nullptr;
+        return &audio_spans_[static_cast<size_t>(id - first)];
+    };
+    const AudioSpan* begin = find(msg.first_id);
+    const AudioSpan* end = find(msg.id);
+    if (!end) return;
+
+    RecognitionMessage entry;
+    entry.is_final = true;
+    entry.source_id = "translation-" + msg.lang;
+    entry.recog_text = msg.trans_text;
+    entry.audio_begin_ms = begin ? begin->begin_ms : end->begin_ms;
+    entry.audio_end_ms = end->end_ms;
+    writer_->Submit(entry);
 }
 
 void MainForm::OnFlowUpdate(const DisplaySlot& active, const DisplaySlot& next) {
-    //   activenext  recog/trans д DuiLib  Label ؼ
-     m_pLabelActiveRecog->SetText(ui::StringConvert::UTF8ToWString(active.recog));
-     m_pLabelActiveTrans->SetText(ui::StringConvert::UTF8ToWString(active.trans));
-     m_pLabelNextRecog->SetText(ui::StringConvert::UTF8ToWString(next.recog));
-     m_pLabelNextTrans->SetText(ui::StringConvert::UTF8ToWString(next.trans));
+    //  把 active、next 的 recog/trans 写进 DuiLib 的 Label 控件，文本未变化的跳过
+    ui::Label* labels[4] = { m_pLabelActiveRecog, m_pLabelActiveTrans, m_pLabelNextRecog, m_pLabelNextTrans };
+    const std::string* texts[4] = { &active.Recog(), &active.Trans(), &next.Recog(), &next.Trans() };
+    for (int i = 0; i < 4; ++i) {
+        if (m_shownText[i] == *texts[i]) continue;
+        m_shownText[i] = *texts[i];
+        // 转换到各 Label 自己的宽字符缓冲，容量够用时不分配
+        Utf8ToWStringInto(m_shownText[i], &m_shownWide[i]);
+        labels[i]->SetText(m_shownWide[i]);
+    }
     // TODO:
-    // ˹active 滻ʱл
+    // 如果发生了滚动（active 替换），做动画或即时切换
 }
 
 void MainForm::Tick() {
@@ -142,20 +248,36 @@ bool MainForm::onSwitchState(const ui::EventArgs& args)
     {
         m_runningstate = true;
 
-        ws = WebSocketClient::WS_Connect("ws://127.0.0.1:8080/ws");
-        m_pBtnAction->SetText(L"ֹͣ");
+        m_pBtnAction->SetText(L"停止");
 
+        // 每次启动一组新的字幕文件，音频时钟也从 0 开始
+        SYSTEMTIME st;
+        GetLocalTime(&st);
+        wchar_t session[64];
+        swprintf(session, 64, L"session-%04d%02d%02d-%02d%02d%02d",
+            st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
+        writer_->Start(session);
+
+        // 录音与字幕放在同一目录、同一文件名前缀；指定了回放文件时用它代替回环采集
+        const std::string& source_id = recognizer->SourceId();
+        recognizer->SetRecordingPath(RecordingEnabledFromEnvironment()
+            ? GetExeDirectory() + L"\\transcripts\\" + session + L"-"
+                + std::wstring(source_id.begin(), source_id.end()) + L".itrec"
+            : std::wstring());
+        std::wstring replay = ReplayPathFromEnvironment();
+        if (!replay.empty()) recognizer->SwitchSource(std::make_unique<ReplaySource>(replay));
+
+        stitcher_.Reset();
         recognizer->Start();
     }
     else
     {
         m_runningstate = false;
 
-        WebSocketClient::WS_Close(ws);
-
-        m_pBtnAction->SetText(L"");
+        m_pBtnAction->SetText(L"启动");
 
         recognizer->Stop();
+        writer_->Stop();
     }
     return true;
 }
\ No newline at end of file
@@ -6,12 +6,20 @@
 #include "duilib/duilib.h"
 
 #include "controller/FlowController.h"
+#include "controller/SentenceStitcher.h"
+#include "controller/TranscriptStore.h"
+#include "ui/TranscriptListProvider.h"
 #include "types/types.h"
 #include "core/ipc/MessageBus.h"
 #include "core/recoginize/SpeechRecognize.h"
-#include "core/translate/WSHelper.h"
+#include "core/recoginize/ReplaySource.h"
+#include "core/output/TranscriptWriter.h"
+#include "core/translate/TranslationBackend.h"
+#include "core/translate/TranslationFanout.h"
 
-/** Ӧóʵ
+#include <deque>
+
+/** 应用程序的主窗口实现
 */
 class MainForm : public ui::WindowImplBase
 {
@@ -20,19 +28,19 @@ public:
     MainForm(MessageBus* bus);
     virtual ~MainForm() override;
 
-    /**  ʱãʵԻȡƤĿ¼
-    * @return ʵֲشƤĿ¼
+    /**  创建窗口时被调用，由子类实现用以获取窗口皮肤目录
+    * @return 子类需实现并返回窗口皮肤目录
     */
     virtual DString GetSkinFolder() override;
 
-    /**  ʱãʵԻȡƤ XML ļ
-    * @return ʵֲشƤ XML ļ
-    *         صݣXMLļݣַ'<'Ϊʼַ
-    *         ļ·'<'ַʼַļҪGetSkinFolder()·ܹҵ
+    /**  创建窗口时被调用，由子类实现用以获取窗口皮肤 XML 描述文件
+    * @return 子类需实现并返回窗口皮肤 XML 描述文件
+    *         返回的内容，可以是XML文件内容（以字符'<'为开始的字符串），
+    *         或者是文件路径（不是以'<'字符开始的字符串），文件要在GetSkinFolder()路径中能够找到
     */
     virtual DString GetSkinFile() override;
 
-    /** ڴԺô˺һЩʼĹ
+    /** 当窗口创建完成以后调用此函数，供子类中做一些初始化的工作
     */
     virtual void OnInitWindow() override;
 
@@ -46,7 +54,7 @@ public:
 
     void OnTranslationMessage(const TranslationMessage& msg);
 
-    /** UI»ص
+    /** UI更新回调
     */
     void OnFlowUpdate(const DisplaySlot& active, const DisplaySlot& next);
 
@@ -57,22 +65,54 @@ public:
     bool onSwitchState(const ui::EventArgs& args);
 
 private:
-    // ؼָ
+    // 创建并启动翻译后端，失败返回 false
+    bool StartTranslator(TranslationBackendType type);
+
+    // 译文按语言写入各自的字幕文件
+    void WriteTranslation(const TranslationMessage& msg);
+
+    // 控件指针
      ui::Label* m_pLabelActiveRecog = nullptr;
      ui::Label* m_pLabelActiveTrans = nullptr;
      ui::Label* m_pLabelNextRecog = nullptr;
      ui::Label* m_pLabelNextTrans = nullptr;
 
      ui::Button* m_pBtnAction = nullptr;
+     ui::VirtualListBox* m_pHistoryList = nullptr;
 
      FlowController flow_;
      MessageBus* bus_;
      std::shared_ptr<SpeechRecognizer> recognizer;
 
+     // 历史记录：有界内存的 arena 存储 + 只渲染可见行的虚表
+     std::unique_ptr<TranscriptStore> transcript_;
+     std::unique_ptr<TranscriptListProvider> history_provider_;
+
+     // 字幕/转写落盘，经 MessageBus 旁路订阅识别结果
+     std::unique_ptr<TranscriptWriter> writer_;
+
+     // 上一次写入各 Label 的文本，未变化时跳过 SetText；宽字符缓冲逐个 Label 复用
+     std::string m_shownText[4];
+     std::wstring m_shownWide[4];
+
      bool m_runningstate = false;
 
-     CURL* ws = NULL;
-     std::string clientid = "";
+     // 翻译在后端线程上完成，结果经 bus_ 回到 UI 线程
+     std::unique_ptr<TranslationBackend> translator_;
+     // 一次识别扇出到所有目标语言，第一个语言上屏
+     std::unique_ptr<TranslationFanout> fanout_;
+     std::string display_lang_;
+     uint64_t next_request_id_ = 0;
+     SentenceStitcher stitcher_;
+
+     // 最近提交翻译的句子的音频时间，译文落盘时按请求 id 取回；只在 UI 线程访问
+     struct AudioSpan {
+         uint64_t id;
+         int64_t begin_ms;
+         int64_t end_ms;
+     };
+     std::deque<AudioSpan> audio_spans_;
+     int64_t held_begin_ms_ = 0;   // 拼句暂存的半句的起始时间
 };
 
 #endif //EXAMPLES_MAIN_FORM_H_
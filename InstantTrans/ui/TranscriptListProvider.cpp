@@ -0,0 +1,58 @@
+#include "TranscriptListProvider.h"
+
+TranscriptListProvider::TranscriptListProvider(const TranscriptStore* store) :store_(store)
+{
+}
+
+ui::Control* TranscriptListProvider::CreateElement(ui::VirtualListBox* pVirtualListBox)
+{
+    ui::Window* pWindow = pVirtualListBox->GetWindow();
+    ui::ListBoxItem* pItem = new ui::ListBoxItem(pWindow);
+    pItem->SetAttribute(_T("width"), _T("stretch"));
+    pItem->SetAttribute(_T("height"), _T("44"));
+
+    ui::Label* pRecog = new ui::Label(pWindow);
+    pRecog->SetAttribute(_T("width"), _T("stretch"));
+    pRecog->SetAttribute(_T("height"), _T("22"));
+    pRecog->SetAttribute(_T("text_align"), _T("left,vcenter"));
+
+    ui::Label* pTrans = new ui::Label(pWindow);
+    pTrans->SetAttribute(_T("width"), _T("stretch"));
+    pTrans->SetAttribute(_T("height"), _T("22"));
+    pTrans->SetAttribute(_T("margin"), _T("0,22,0,0"));
+    pTrans->SetAttribute(_T("text_align"), _T("left,vcenter"));
+
+    pItem->AddItem(pRecog);
+    pItem->AddItem(pTrans);
+    return pItem;
+}
+
+bool TranscriptListProvider::FillElement(ui::Control* pControl, size_t nElementIndex)
+{
+    ui::ListBoxItem* pItem = dynamic_cast<ui::ListBoxItem*>(pControl);
+    if (pItem == nullptr || nElementIndex >= store_->Size()) {
+        return false;
+    }
+
+    // 只有可见行才做 UTF-8 -> UTF-16 转换
+    TranscriptEntryView entry = store_->At(nElementIndex);
+    ui::Label* pRecog = dynamic_cast<ui::Label*>(pItem->GetItemAt(0));
+    ui::Label* pTrans = dynamic_cast<ui::Label*>(pItem->GetItemAt(1));
+    if (pRecog) pRecog->SetText(ui::StringConvert::UTF8ToWString(std::string(entry.recog)));
+    if (pTrans) pTrans->SetText(ui::StringConvert::UTF8ToWString(std::string(entry.trans)));
+    return true;
+}
+
+size_t TranscriptListProvider::GetElementCount() const
+{
+    return store_->Size();
+}
+
+void TranscriptListProvider::OnAppended(uint64_t first_index_before)
+{
+    EmitCountChanged();
+    // 最旧的块溢出到磁盘后，所有行的位置前移，可见行需要重新填充
+    if (store_->FirstIndex() != first_index_before && store_->Size() > 0) {
+        EmitDataChanged(0, store_->Size() - 1);
+    }
+}
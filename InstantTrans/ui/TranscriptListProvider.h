@@ -0,0 +1,35 @@
+#ifndef UI_TRANSCRIPT_LIST_PROVIDER_H_
+#define UI_TRANSCRIPT_LIST_PROVIDER_H_
+
+// duilib
+#include "duilib/duilib.h"
+
+#include "controller/TranscriptStore.h"
+
+/** 历史记录虚表的数据源：只为可见行创建/填充控件，追加记录时只通知数量变化
+*/
+class TranscriptListProvider : public ui::VirtualListBoxElement
+{
+public:
+    explicit TranscriptListProvider(const TranscriptStore* store);
+
+    virtual ui::Control* CreateElement(ui::VirtualListBox* pVirtualListBox) override;
+    virtual bool FillElement(ui::Control* pControl, size_t nElementIndex) override;
+    virtual size_t GetElementCount() const override;
+
+    virtual void SetElementSelected(size_t nElementIndex, bool bSelected) override {}
+    virtual bool IsElementSelected(size_t nElementIndex) const override { return false; }
+    virtual void GetSelectedElements(std::vector<size_t>& selectedIndexs) const override { selectedIndexs.clear(); }
+    virtual bool IsMultiSelect() const override { return false; }
+    virtual void SetMultiSelect(bool bMultiSelect) override {}
+
+    /** 记录追加后调用
+    * @param [in] first_index_before 追加前内存中第一条记录的序号，用于判断是否发生了溢出
+    */
+    void OnAppended(uint64_t first_index_before);
+
+private:
+    const TranscriptStore* store_;
+};
+
+#endif //UI_TRANSCRIPT_LIST_PROVIDER_H_
@@ -0,0 +1,158 @@
+package main
+
+// 本地限流桩：协议与网关相同，按可配置速率放行翻译请求，超出时回 rate_limited。
+// 用于验证客户端的令牌桶 + AIMD 控制能否贴着限额持续发送而不被拒绝。
+//
+//	go run ./cmd/ratelimit-stub -rate 2 -burst 4 -latency 300ms
+//	然后把 InstantTrans 的网关地址指向 ws://127.0.0.1:8080/ws
+//
+// 多实例故障转移：起几个不同延迟/故障率的桩，再用 INSTANTTRANS_GATEWAYS 指向它们
+//
+//	go run ./cmd/ratelimit-stub -addr :8081 -latency 100ms
+//	go run ./cmd/ratelimit-stub -addr :8082 -latency 400ms -jitter 200ms
+//	go run ./cmd/ratelimit-stub -addr :8083 -latency 100ms -drop 0.05
+//	set INSTANTTRANS_GATEWAYS=ws://127.0.0.1:8081/ws,ws://127.0.0.1:8082/ws,ws://127.0.0.1:8083/ws
+//	InstantTrans.exe --gateway-bench   // 自检路由、故障转移与请求不丢，见 core/sim/GatewayBench.h
+//
+// 多目标语言：set INSTANTTRANS_TARGET_LANGS=zh,ja,de，桩按 langs_to 逐语言回 results
+
+import (
+	"encoding/json"
+	"flag"
+	"log"
+	"math/rand"
+	"net/http"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/gorilla/websocket"
+	"translategateway/internal/types"
+)
+
+var (
+	addr    = flag.String("addr", ":8080", "listen address")
+	rate    = flag.Float64("rate", 2, "accepted requests per second (all clients)")
+	burst   = flag.Float64("burst", 4, "token bucket capacity")
+	latency = flag.Duration("latency", 300*time.Millisecond, "simulated translation latency")
+	jitter  = flag.Duration("jitter", 0, "extra random latency, uniform in [0, jitter)")
+	drop    = flag.Float64("drop", 0, "probability of closing the connection instead of answering")
+)
+
+var upgrader = websocket.Upgrader{
+	CheckOrigin: func(r *http.Request) bool { return true },
+}
+
+// 全局令牌桶
+type bucket struct {
+	mu     sync.Mutex
+	tokens float64
+	last   time.Time
+}
+
+func (b *bucket) allow() (bool, time.Duration) {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	now := time.Now()
+	b.tokens += now.Sub(b.last).Seconds() * *rate
+	if b.tokens > *burst {
+		b.tokens = *burst
+	}
+	b.last = now
+	if b.tokens >= 1 {
+		b.tokens--
+		return true, 0
+	}
+	return false, time.Duration((1 - b.tokens) / *rate * float64(time.Second))
+}
+
+var (
+	limiter  = &bucket{tokens: 0, last: time.Now()}
+	accepted atomic.Int64
+	rejected atomic.Int64
+	dropped  atomic.Int64
+)
+
+func serve(w http.ResponseWriter, r *http.Request) {
+	conn, err := upgrader.Upgrade(w, r, nil)
+	if err != nil {
+		log.Println("[Stub] Upgrade error:", err)
+		return
+	}
+	defer conn.Close()
+
+	var writeMu sync.Mutex
+	send := func(resp *types.TranslateResponse) {
+		data, _ := json.Marshal(resp)
+		writeMu.Lock()
+		defer writeMu.Unlock()
+		conn.WriteMessage(websocket.TextMessage, data)
+	}
+
+	for {
+		_, msg, err := conn.ReadMessage()
+		if err != nil {
+			return
+		}
+		var req types.TranslateRequest
+		if err := json.Unmarshal(msg, &req); err != nil {
+			continue
+		}
+		resp := types.TranslateResponse{
+			ClientID:  req.ClientID,
+			RequestID: req.RequestID,
+			LangFrom:  req.LangFrom,
+			LangTo:    req.LangTo,
+		}
+
+		if *drop > 0 && rand.Float64() < *drop {
+			// 模拟实例故障：在途请求全部丢失
+			dropped.Add(1)
+			return
+		}
+
+		ok, wait := limiter.allow()
+		if !ok {
+			rejected.Add(1)
+			resp.Error = "rate_limited"
+			resp.RetryAfterMs = wait.Milliseconds()
+			send(&resp)
+			continue
+		}
+		accepted.Add(1)
+		delay := *latency
+		if *jitter > 0 {
+			delay += time.Duration(rand.Int63n(int64(*jitter)))
+		}
+		go func() {
+			time.Sleep(delay)
+			resp.Result = "[stub] " + req.SourceText
+			if len(req.LangsTo) > 0 {
+				resp.Results = make(map[string]string, len(req.LangsTo))
+				for _, lang := range req.LangsTo {
+					resp.Results[lang] = "[stub " + lang + "] " + req.SourceText
+				}
+			}
+			send(&resp)
+		}()
+	}
+}
+
+func main() {
+	flag.Parse()
+	limiter.tokens = *burst
+
+	go func() {
+		var lastAccepted int64
+		for range time.Tick(5 * time.Second) {
+			a := accepted.Load()
+			log.Printf("[Stub] accepted=%d rejected=%d dropped=%d rate=%.2f/s (limit %.2f/s)",
+				a, rejected.Load(), dropped.Load(), float64(a-lastAccepted)/5, *rate)
+			lastAccepted = a
+		}
+	}()
+
+	http.HandleFunc("/ws", serve)
+	log.Printf("[Stub] listening on %s, rate=%.2f/s burst=%.0f latency=%s", *addr, *rate, *burst, *latency)
+	log.Fatal(http.ListenAndServe(*addr, nil))
+}
@@ -55,6 +55,10 @@ type RateLimit struct {
 	Window      string   `yaml:"window"`
 	GlobalLimit int      `yaml:"global_limit"`
 	WhiteList   []string `yaml:"whitelist"`
+
+	// 单个客户端的翻译请求限流（按消息计），0 表示不限
+	MessageLimit  int    `yaml:"message_limit"`
+	MessageWindow string `yaml:"message_window"`
 }
 
 // LoadConfig loads config.yaml and unmarshals it into Config struct
@@ -13,3 +13,8 @@ func KeyUserTasks(userID string) string {
 func KeyTranslateCache(hash string) string {
 	return fmt.Sprintf("translate:cache:%s", hash)
 }
+
+// 每个目标语言一份缓存，同一句扇出到多个语言时各自命中
+func KeyTranslateLangCache(langTo, hash string) string {
+	return fmt.Sprintf("translate:cache:%s:%s", langTo, hash)
+}
@@ -15,6 +15,8 @@ type TaskResult struct {
 	CreatedAt  int64  `json:"createdAt"`
 	LangFrom   string `json:"lang_from"`
 	LangTo     string `json:"lang_to"`
+
+	Results map[string]string `json:"results,omitempty"` // 多目标请求的各语言译文
 }
 
 func SaveTaskResult(task *TaskResult, ttl time.Duration) error {
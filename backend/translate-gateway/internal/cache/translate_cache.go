@@ -12,3 +12,11 @@ func GetCachedTranslation(hash string) (string, error) {
 func SaveCachedTranslation(hash, text string, ttl time.Duration) error {
 	return RDB().Set(context.Background(), KeyTranslateCache(hash), text, ttl).Err()
 }
+
+func GetCachedLangTranslation(langTo, hash string) (string, error) {
+	return RDB().Get(context.Background(), KeyTranslateLangCache(langTo, hash)).Result()
+}
+
+func SaveCachedLangTranslation(langTo, hash, text string, ttl time.Duration) error {
+	return RDB().Set(context.Background(), KeyTranslateLangCache(langTo, hash), text, ttl).Err()
+}
@@ -6,6 +6,17 @@ type TranslateRequest struct {
 	SourceText string `json:"source_text"`
 	LangFrom   string `json:"lang_from"`
 	LangTo     string `json:"lang_to"`
+
+	// 多目标语言：非空时按语言逐一翻译，结果放在 TranslateResponse.Results；LangTo 为其中第一个
+	LangsTo []string `json:"langs_to,omitempty"`
+}
+
+// TargetLangs 返回本次请求的全部目标语言
+func (r *TranslateRequest) TargetLangs() []string {
+	if len(r.LangsTo) > 0 {
+		return r.LangsTo
+	}
+	return []string{r.LangTo}
 }
 
 type TranslateResponse struct {
@@ -14,4 +25,14 @@ type TranslateResponse struct {
 	LangFrom  string `json:"lang_from"`
 	LangTo    string `json:"lang_to"`
 	Result    string `json:"result"`
+
+	// 多目标请求的各语言译文，按语言索引；Result 同时填第一个语言，兼容旧客户端
+	Results map[string]string `json:"results,omitempty"`
+
+	// 直接取自网关译文缓存、没有调用翻译服务的语言，客户端据此统计缓存命中率
+	CachedLangs []string `json:"cached_langs,omitempty"`
+
+	// 被限流时 Error 为 "rate_limited"，客户端应在 RetryAfterMs 之后重发
+	Error        string `json:"error,omitempty"`
+	RetryAfterMs int64  `json:"retry_after_ms,omitempty"`
 }
@@ -2,6 +2,8 @@ package worker
 
 import (
 	"context"
+	"crypto/sha256"
+	"encoding/hex"
 	"fmt"
 	"log"
 	"time"
@@ -26,24 +28,44 @@ func StartWorker(natsURL string) {
 	err = natsClient.SubscribeTranslate(func(request *types.TranslateRequest) {
 		fmt.Printf("[Worker] Received: %s\n", request.SourceText)
 
-		result, err := client.Translate(context.Background(), &translator.TranslateRequest{
-			ID:       "demo-1",
-			FromLang: "ja",
-			ToLang:   "zh",
-			Text:     request.SourceText,
-		})
-		if err != nil {
-			log.Fatal(err)
+		// 同一句扇出到多个目标语言：各语言先查自己的缓存，未命中的才调用翻译服务
+		langs := request.TargetLangs()
+		hash := hashText(request.LangFrom + "\n" + request.SourceText)
+		results := make(map[string]string, len(langs))
+		var cachedLangs []string
+		for _, lang := range langs {
+			if text, err := cache.GetCachedLangTranslation(lang, hash); err == nil {
+				results[lang] = text
+				cachedLangs = append(cachedLangs, lang)
+				continue
+			}
+			result, err := client.Translate(context.Background(), &translator.TranslateRequest{
+				ID:       request.RequestID,
+				FromLang: request.LangFrom,
+				ToLang:   lang,
+				Text:     request.SourceText,
+			})
+			if err != nil {
+				log.Printf("[Worker] translate %s failed: %v", lang, err)
+				continue
+			}
+			results[lang] = result.Text
+			_ = cache.SaveCachedLangTranslation(lang, hash, result.Text, 7*24*time.Hour)
 		}
 
-		fmt.Println("Translation result:", result.Text)
+		fmt.Println("Translation result:", results)
 
 		res := types.TranslateResponse{
 			RequestID: request.RequestID,
 			ClientID:  request.ClientID,
-			Result:    result.Text,
+			Result:    results[langs[0]],
 			LangFrom:  request.LangFrom,
 			LangTo:    request.LangTo,
+
+			CachedLangs: cachedLangs,
+		}
+		if len(request.LangsTo) > 0 {
+			res.Results = results
 		}
 		// 发布到 translate 队列
 		err = natsClient.PublishResult(&res)
@@ -55,7 +77,8 @@ func StartWorker(natsURL string) {
 			TaskID:     request.RequestID,
 			UserID:     request.ClientID,
 			SourceText: request.SourceText,
-			ResultText: result.Text,
+			ResultText: res.Result,
+			Results:    res.Results,
 			LangFrom:   request.LangFrom,
 			LangTo:     request.LangTo,
 			Status:     "done",
@@ -79,3 +102,8 @@ func handleTranslationResult(task *cache.TaskResult) {
 	//hash := hashText(task.SourceText)
 	//_ = cache.SaveCachedTranslation(hash, task.ResultText, 7*24*time.Hour)
 }
+
+func hashText(text string) string {
+	sum := sha256.Sum256([]byte(text))
+	return hex.EncodeToString(sum[:])
+}
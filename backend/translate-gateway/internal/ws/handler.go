@@ -5,7 +5,9 @@ import (
 	"encoding/json"
 	"fmt"
 	"log"
+	"net"
 	"net/http"
+	"strconv"
 	"time"
 	"translategateway/config"
 	"translategateway/internal/cache"
@@ -21,54 +23,106 @@ type Handler struct {
 	Hub    *Hub
 	Nats   *nats.NatsClient
 	Config *config.Config
+
+	// 连接级（IP + 全局）与消息级限流器，启动时创建一次
+	connLimiter    limiter.RateLimiter
+	messageLimiter limiter.RateLimiter
+	connWindow     time.Duration
+	messageWindow  time.Duration
 }
 
 var upgrader = websocket.Upgrader{
 	CheckOrigin: func(r *http.Request) bool { return true },
 }
 
-func (h *Handler) ServeWS(w http.ResponseWriter, r *http.Request) {
-	conn, err := upgrader.Upgrade(w, r, nil)
-	if err != nil {
-		log.Println("[WS] Upgrade error:", err)
-		return
-	}
+// NewHandler 创建 Handler 并初始化限流器
+func NewHandler(hub *Hub, nc *nats.NatsClient, cfg *config.Config) (*Handler, error) {
+	h := &Handler{Hub: hub, Nats: nc, Config: cfg}
 
-	// 对ip做过滤
-	cfgLimiter := h.Config.Limiter
-	window, _ := time.ParseDuration(cfgLimiter.Window)
+	cfgLimiter := cfg.Limiter
+	h.connWindow, _ = time.ParseDuration(cfgLimiter.Window)
 
 	// 创建基础限流器
-	baseLimiter, err := limiter.NewRateLimiter(cfgLimiter.Mode, cfgLimiter.Limit, window, h.Config.Redis)
+	baseLimiter, err := limiter.NewRateLimiter(cfgLimiter.Mode, cfgLimiter.Limit, h.connWindow, cfg.Redis)
 	if err != nil {
-		panic(err)
+		return nil, err
 	}
 
 	// 包裹全局限流
-	globalLimiter, err := limiter.NewGlobalLimiter(
+	h.connLimiter, err = limiter.NewGlobalLimiter(
 		baseLimiter,
-		fmt.Sprintf("%s:%d", h.Config.Redis.Single.Host, h.Config.Redis.Single.Port),
-		h.Config.Redis.Single.Password,
+		fmt.Sprintf("%s:%d", cfg.Redis.Single.Host, cfg.Redis.Single.Port),
+		cfg.Redis.Single.Password,
 		cfgLimiter.GlobalLimit,
-		window,
+		h.connWindow,
 		cfgLimiter.WhiteList,
 	)
 	if err != nil {
-		panic(err)
+		return nil, err
 	}
 
-	if globalLimiter.Allow(context.Background(), conn.RemoteAddr().String()) {
-		client := &Client{
-			Conn: conn,
-			Hub:  h.Hub,
-			Send: make(chan []byte, 256),
+	if cfgLimiter.MessageLimit > 0 {
+		h.messageWindow, _ = time.ParseDuration(cfgLimiter.MessageWindow)
+		if h.messageWindow <= 0 {
+			h.messageWindow = h.connWindow
 		}
+		h.messageLimiter = limiter.NewMemoryLimiter(cfgLimiter.MessageLimit, h.messageWindow)
+	}
+	return h, nil
+}
+
+// 限流 key 与配置中的白名单格式一致："ip:<地址>"，不含端口
+func ipKey(r *http.Request) string {
+	host, _, err := net.SplitHostPort(r.RemoteAddr)
+	if err != nil {
+		host = r.RemoteAddr
+	}
+	return "ip:" + host
+}
+
+func (h *Handler) ServeWS(w http.ResponseWriter, r *http.Request) {
+	// 超限时在握手阶段回 429，不影响其它连接
+	if h.connLimiter != nil && !h.connLimiter.Allow(context.Background(), ipKey(r)) {
+		w.Header().Set("Retry-After", strconv.Itoa(int(h.connWindow.Seconds())))
+		http.Error(w, "exceed global limit", http.StatusTooManyRequests)
+		log.Printf("[WS] Rejected connection from %s: exceed global limit", r.RemoteAddr)
+		return
+	}
 
-		// 启动读写循环
-		go client.readPump(h.handleTranslateRequest)
-		go client.writePump()
-	} else {
-		log.Fatal("exceed global limit")
+	conn, err := upgrader.Upgrade(w, r, nil)
+	if err != nil {
+		log.Println("[WS] Upgrade error:", err)
+		return
+	}
+
+	client := &Client{
+		Conn: conn,
+		Hub:  h.Hub,
+		Send: make(chan []byte, 256),
+	}
+
+	// 启动读写循环
+	go client.readPump(h.handleTranslateRequest)
+	go client.writePump()
+}
+
+// 消息级限流：直接回 rate_limited，由客户端退避后重发
+func (h *Handler) rejectRateLimited(c *Client, req *types.TranslateRequest) {
+	response := types.TranslateResponse{
+		ClientID:     req.ClientID,
+		RequestID:    req.RequestID,
+		LangFrom:     req.LangFrom,
+		LangTo:       req.LangTo,
+		Error:        "rate_limited",
+		RetryAfterMs: h.messageWindow.Milliseconds() / int64(h.Config.Limiter.MessageLimit),
+	}
+	data, err := json.Marshal(&response)
+	if err != nil {
+		return
+	}
+	select {
+	case c.Send <- data:
+	default:
 	}
 }
 
@@ -88,6 +142,7 @@ func (h *Handler) handleTranslateRequest(c *Client, msg []byte) {
 			LangFrom:  task.LangFrom,
 			LangTo:    task.LangTo,
 			Result:    task.ResultText,
+			Results:   task.Results,
 		}
 		h.Hub.SendToClient(&response, task.UserID)
 		return
@@ -107,6 +162,11 @@ func (h *Handler) handleTranslateRequest(c *Client, msg []byte) {
 		req.RequestID = uuid.NewString()
 	}
 
+	if h.messageLimiter != nil && !h.messageLimiter.Allow(context.Background(), "client:"+c.ID) {
+		h.rejectRateLimited(c, &req)
+		return
+	}
+
 	log.Printf("[Worker] Received: client=%s, requestID=%s, text=%s",
 		req.ClientID, req.RequestID, req.SourceText)
 
@@ -36,10 +36,9 @@ func main() {
 	worker.StartWorker("nats://127.0.0.1:4222")
 
 	// ============ 3. 启动 WebSocket Handler ============
-	handler := &ws.Handler{
-		Hub:    hub,
-		Nats:   nc,
-		Config: cfg,
+	handler, err := ws.NewHandler(hub, nc, cfg)
+	if err != nil {
+		log.Fatalf("❌ Failed to create limiter: %v", err)
 	}
 	// WebSocket endpoint
 	http.HandleFunc("/ws", handler.ServeWS)